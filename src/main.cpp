@@ -15,6 +15,7 @@
 #include "src/imagedata/imagesourcemodel.h"
 #include "src/imagedata/imageprovider.h"
 #include "src/utils/filetrashhelper.h"
+#include "src/utils/metrics.h"
 #include "src/qmlWidget.h"
 #include "config.h"
 
@@ -29,6 +30,7 @@
 #include "thumbnailview/imagedatamodel.h"
 #include "thumbnailview/thumbnailmodel.h"
 #include "thumbnailview/qimageitem.h"
+#include "thumbnailview/atlasimageitem.h"
 
 #include <DGuiApplicationHelper>
 #include <DApplication>
@@ -195,6 +197,7 @@ int main(int argc, char *argv[])
     qmlRegisterUncreatableType<Types>(uriAlbum, 1, 0, "Types", "Cannot instantiate the Types class");
     qmlRegisterUncreatableType<Roles>(uriAlbum, 1, 0, "Roles", "Cannot instantiate the Roles class");
     qmlRegisterType<QImageItem>(uriAlbum, 1, 0, "QImageItem");
+    qmlRegisterType<AtlasImageItem>(uriAlbum, 1, 0, "AtlasImageItem");
     qmlRegisterType<QmlWidget>(uriAlbum, 1, 0, "QmlWidget");
 
     engine.load(QUrl(QStringLiteral("qrc:/qml/main.qml")));
@@ -203,6 +206,8 @@ int main(int argc, char *argv[])
 
     // 设置DBus接口
     ApplicationAdaptor adaptor(&fileControl);
+    // kill -USR1 时输出性能指标到日志
+    MetricsRegistry::instance()->installSignalDump();
     QDBusConnection::sessionBus().registerService("com.deepin.album");
     QDBusConnection::sessionBus().registerObject("/", &fileControl);
 
@@ -43,8 +43,20 @@ Item {
     property Item videoLabel: null
     property int nDuration: GStatus.animationDuration
 
-    // 缩略图本体
-    Album.QImageItem {
+    // 阴影，与缩略图显示区域一致，向下偏移
+    Rectangle {
+        anchors.centerIn: image
+        anchors.horizontalCenterOffset: -0.5
+        anchors.verticalCenterOffset: 1.3
+        width: image.clipWidth
+        height: image.clipHeight
+        radius: image.radius
+        color: Qt.rgba(0, 0, 0, 0.1)
+        visible: !image.null
+    }
+
+    // 缩略图本体，圆角及比例切换时的裁剪由场景图节点直接完成，不使用 layer 及遮罩，保持纹理图集的合批绘制
+    Album.AtlasImageItem {
         id: image
         anchors.centerIn: parent
         width: parent.width - 14
@@ -54,9 +66,26 @@ Item {
             gridView.bRefresh
             modelData.thumbnail
         }
-        fillMode: Album.QImageItem.PreserveAspectFit
-        visible: false
-        layer.enabled: true
+        fillMode: Album.AtlasImageItem.PreserveAspectFit
+        radius: 10
+        clipWidth: paintedWidth
+        clipHeight: paintedHeight
+
+        Behavior on clipWidth {
+            enabled: GStatus.enableRatioAnimation
+            NumberAnimation {
+                duration: nDuration
+                easing.type: Easing.OutExpo // 缓动类型
+            }
+        }
+
+        Behavior on clipHeight {
+            enabled: GStatus.enableRatioAnimation
+            NumberAnimation {
+                duration: nDuration
+                easing.type: Easing.OutExpo // 缓动类型
+            }
+        }
     }
 
     // 图片保存完成，缩略图区域重新加载当前图片
@@ -69,64 +98,6 @@ Item {
         }
     }
 
-    //圆角遮罩Rectangle
-    Rectangle {
-        id: maskRec
-        anchors.centerIn: parent
-        width: image.width
-        height: image.height
-
-        color:"transparent"
-        Rectangle {
-            anchors.centerIn: parent
-            width: image.paintedWidth
-            height: image.paintedHeight
-            color:"black"
-            radius: 10
-
-            Behavior on width {
-                enabled: GStatus.enableRatioAnimation
-                NumberAnimation {
-                    duration: nDuration
-                    easing.type: Easing.OutExpo // 缓动类型
-                }
-            }
-
-            Behavior on height {
-                enabled: GStatus.enableRatioAnimation
-                NumberAnimation {
-                    duration: nDuration
-                    easing.type: Easing.OutExpo // 缓动类型
-                }
-            }
-        }
-
-        visible: false
-    }
-
-    DropShadow {
-        anchors.fill: opacityMask
-
-        horizontalOffset: -0.5
-        verticalOffset: 1.3
-
-        radius: 1.0
-        samples: radius * 2 + 1
-        spread: 0.01
-
-        smooth: true
-        opacity: 0.1
-
-        source: opacityMask
-    }
-
-    OpacityMask{
-        id: opacityMask
-        anchors.fill: maskRec
-        source: image
-        maskSource: maskRec
-    }
-
     //border and shadow
     Rectangle {
         id: borderRect
@@ -17,6 +17,8 @@ import "./Control/Animation"
 FadeInoutAnimation {
     anchors.fill: parent
     property int lastWidth: 0
+    //进度窗口取消按钮的处理函数，为空时不可取消
+    property var cancelProgressHandler: null
 
     //rename窗口
     NewAlbumDialog {
@@ -171,6 +173,14 @@ FadeInoutAnimation {
     StandardProgressDialog {
         id: idStandardProgressDialog
         z: leftSidebar.z + 1
+
+        //设备导入、导出可取消，已完成的部分保留
+        onCanceled: {
+            if (cancelProgressHandler)
+                cancelProgressHandler()
+            setDetail(qsTr("Canceling..."))
+            cancelable = false
+        }
     }
 
     //拖拽导入
@@ -247,6 +257,42 @@ FadeInoutAnimation {
             showProgress(title, content)
         }
     
+        // 收到设备导入开始消息，可取消
+        function onSigDeviceImportStart() {
+            onSigImportStart()
+            setProgressCancelHandler(function() { albumControl.stopImportFromMountDevice() })
+        }
+
+        // 收到设备导入速度消息
+        function onSigImportSpeed(bytesPerSecond, remainSeconds) {
+            showProgressSpeed(bytesPerSecond, remainSeconds)
+        }
+
+        // 收到导出开始消息，可取消
+        function onSigExportStart() {
+            var title = qsTr("Exporting...")
+            var content = qsTr("Exported:") + "0"
+            showProgress(title, content)
+            setProgressCancelHandler(function() { albumControl.stopExport() })
+        }
+
+        // 收到导出进度消息
+        function onSigExportProgress(value, max) {
+            var contentS = qsTr("Exported:") + qsTr("%1/%2").arg(value).arg(max)
+            idStandardProgressDialog.setContent(contentS)
+            idStandardProgressDialog.setProgress(max > 0 ? value * 100 / max : 100, 100)
+        }
+
+        // 收到导出速度消息
+        function onSigExportSpeed(bytesPerSecond, remainSeconds) {
+            showProgressSpeed(bytesPerSecond, remainSeconds)
+        }
+
+        // 收到导出完成消息，结果提示由发起导出的界面处理
+        function onSigExportFinished(bSuccess) {
+            delayTimer.start()
+        }
+
         // 收到导入进度消息
         function onSigImportProgress(value, max) {
             var prevS = qsTr("Imported:")
@@ -314,9 +360,40 @@ FadeInoutAnimation {
         titleAlubmRect.enabled = false
     }
 
+    function setProgressCancelHandler(handler) {
+        cancelProgressHandler = handler
+        idStandardProgressDialog.cancelable = true
+    }
+
+    // 可取消的任务显示速度及剩余时间，取消后不再更新
+    function showProgressSpeed(bytesPerSecond, remainSeconds) {
+        if (!idStandardProgressDialog.cancelable)
+            return
+        idStandardProgressDialog.setDetail(qsTr("%1/s, %2 left").arg(formatBytes(bytesPerSecond)).arg(formatDuration(remainSeconds)))
+    }
+
+    // 数据量显示，如 "1.5 MB"
+    function formatBytes(bytes) {
+        var units = ["B", "KB", "MB", "GB"]
+        var index = 0
+        while (bytes >= 1024 && index < units.length - 1) {
+            bytes /= 1024
+            index++
+        }
+        return (index === 0 ? bytes : bytes.toFixed(1)) + " " + units[index]
+    }
+
+    // 剩余时间显示，如 "01:05"
+    function formatDuration(seconds) {
+        var minutes = Math.floor(seconds / 60)
+        var secs = seconds % 60
+        return (minutes < 10 ? "0" : "") + minutes + ":" + (secs < 10 ? "0" : "") + secs
+    }
+
     function closeProgress() {
         // 关闭对话框并恢复界面状态
         idStandardProgressDialog.close()
+        cancelProgressHandler = null
         leftSidebar.enabled = true
         thumbnailImage.enabled = true
         titleAlubmRect.enabled = true
@@ -31,6 +31,8 @@ Item {
     property bool canPrint: true
 
     property var selectedUrls: GStatus.selectedPaths
+    // 后台导出进行中，导出完成后提示结果
+    property bool waitExportResult: false
 
     // block menu on `Device` view
     property bool blockOnDevice: GStatus.currentViewType === Album.Types.ViewDevice
@@ -115,11 +117,8 @@ Item {
     // 执行导出图片
     function excuteExport() {
         if (GStatus.selectedPaths.length > 1) {
-            var bRet = albumControl.getFolders(GStatus.selectedPaths)
-            if (bRet)
-                DTK.sendMessage(thumbnailImage, qsTr("Export successful"), "notify_checked")
-            else
-                DTK.sendMessage(thumbnailImage, qsTr("Export failed"), "warning")
+            // 导出在后台执行，结果在 onSigExportFinished 中提示
+            waitExportResult = albumControl.getFolders(GStatus.selectedPaths)
         } else {
             exportdig.setParameter(GStatus.selectedPaths[0], window)
             exportdig.show()
@@ -211,4 +210,17 @@ Item {
         GControl.setImageFiles(allUrls, url)
         videoInfomationDig.show()
     }
+
+    Connections {
+        target: albumControl
+        function onSigExportFinished(bSuccess) {
+            if (!waitExportResult)
+                return
+            waitExportResult = false
+            if (bSuccess)
+                DTK.sendMessage(thumbnailImage, qsTr("Export successful"), "notify_checked")
+            else
+                DTK.sendMessage(thumbnailImage, qsTr("Export failed"), "warning")
+        }
+    }
 }
@@ -18,6 +18,10 @@ FloatingPanel {
     //原生属性-结束
 
     //自定义属性-开始
+    //是否显示取消按钮
+    property bool cancelable: false
+    //点击取消按钮
+    signal canceled()
     //自定义属性-结束
 
     //窗口布局-开始
@@ -50,15 +54,31 @@ FloatingPanel {
             opacity: 0
         }
 
-        //标签-内容
-        Label {
-            id: labelContent
-            Layout.alignment: Qt.AlignLeft
+        RowLayout {
             Layout.fillWidth: true
             Layout.preferredHeight: 20
-            font: DTK.fontManager.t6
-            text: ""
-            color: "#424241"
+            spacing: 10
+
+            //标签-内容
+            Label {
+                id: labelContent
+                Layout.alignment: Qt.AlignLeft
+                Layout.fillWidth: true
+                Layout.preferredHeight: 20
+                font: DTK.fontManager.t6
+                text: ""
+                color: "#424241"
+            }
+
+            //标签-速度、剩余时间等附加信息
+            Label {
+                id: labelDetail
+                Layout.alignment: Qt.AlignRight
+                Layout.preferredHeight: 20
+                font: DTK.fontManager.t6
+                text: ""
+                color: "#424241"
+            }
         }
 
         Rectangle {
@@ -111,6 +131,27 @@ FloatingPanel {
             }
         }
     }
+
+    //取消按钮，位于拖动区域之上
+    ActionButton {
+        visible: idWindow.cancelable
+        anchors {
+            top: parent.top
+            topMargin: 10
+            right: parent.right
+            rightMargin: 10
+        }
+        width: 24
+        height: 24
+        icon.name: "window_close"
+        icon.width: 12
+        icon.height: 12
+        ToolTip.visible: hovered
+        ToolTip.text: qsTr("Cancel")
+        onClicked: {
+            idWindow.canceled()
+        }
+    }
     //事件处理-结束
 
     //自定义函数-开始
@@ -138,6 +179,11 @@ FloatingPanel {
         labelContent.text = text
     }
 
+    //设置附加信息
+    function setDetail(text) {
+        labelDetail.text = text
+    }
+
     //设置进度
     function setProgress(value, max) {
         idProgressBar.to = max
@@ -148,6 +194,8 @@ FloatingPanel {
     function clear() {
         labelTitle.text = ""
         labelContent.text = ""
+        labelDetail.text = ""
+        cancelable = false
         idProgressBar.to = 100
         idProgressBar.value = 0
     }
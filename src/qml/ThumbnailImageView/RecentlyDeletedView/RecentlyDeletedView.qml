@@ -286,6 +286,14 @@ BaseView {
             showAnimation.start()
     }
 
+    // 后台维护回收站完成(如启动时清理过期项目)后刷新
+    Connections {
+        target: albumControl
+        function onSigTrashChanged() {
+            flushRecentDelView()
+        }
+    }
+
     Component.onCompleted: {
         GStatus.sigFlushRecentDelView.connect(flushRecentDelView)
         deleteDialog.sigDoAllDeleteImg.connect(runAllDeleteImg)
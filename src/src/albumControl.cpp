@@ -4,9 +4,18 @@
 
 #include "albumControl.h"
 #include "dbmanager/dbmanager.h"
+#include "dbmanager/dbmanagerasync.h"
+#include "dbmanager/trashmaintainer.h"
 #include "fileMonitor/fileinotifygroup.h"
 #include "imageengine/imageenginethread.h"
+#include "imageengine/thumbnailpregenerator.h"
+#include "imageengine/thumbnailcachegc.h"
 #include "utils/devicehelper.h"
+#include "utils/devicefileindex.h"
+#include "utils/perceptualhashindex.h"
+#include "unionimage/filetypecache.h"
+#include "unionimage/baseutils.h"
+#include "utils/workscheduler.h"
 
 #include <DDialog>
 #include <DMessageBox>
@@ -34,6 +43,14 @@ static QMap<QString, const char *> i18nMap {
     {"data", "Data Disk"}
 };
 const QString ddeI18nSym = QStringLiteral("_dde_");
+// 启动后开始相似图片索引的延时
+const int sc_PerceptualHashIndexDelay = 30 * 1000;
+const int sc_ThumbnailPregenerateDelay = 10 * 1000;
+// 启动后开始缩略图缓存清理的延时及定时清理的间隔
+const int sc_ThumbnailCacheGCDelay = 2 * 60 * 1000;
+const int sc_ThumbnailCacheGCInterval = 6 * 60 * 60 * 1000;
+// 文件类型判断结果定时写入数据库的间隔
+const int sc_FileTypeCacheSaveInterval = 60 * 1000;
 
 static std::initializer_list<std::pair<QString, QString>> opticalmediakeys {
     {"optical",                "Optical"},
@@ -125,6 +142,13 @@ AlbumControl::AlbumControl(QObject *parent)
 {
     initMonitor();
     initDeviceMonitor();
+    initFileTypeCache();
+    initPerceptualHashIndex();
+    initThumbnailPregenerator();
+    initThumbnailCacheGC();
+    //后台维护回收站，打开回收站及显示数量时直接使用结果，维护完成后通知界面刷新
+    connect(TrashMaintainer::instance(), &TrashMaintainer::changed, this, &AlbumControl::sigTrashChanged, Qt::QueuedConnection);
+    TrashMaintainer::instance()->refreshAsync();
 
     connect(DGuiApplicationHelper::instance(), &DGuiApplicationHelper::newProcessInstance, this, &AlbumControl::onNewAPPOpen);
 }
@@ -134,6 +158,72 @@ AlbumControl::~AlbumControl()
 
 }
 
+void AlbumControl::initFileTypeCache()
+{
+    // 后台载入上次保存的文件类型判断结果，并删除文件已不存在的记录
+    WorkScheduler::instance()->submit(WorkScheduler::Background, []() {
+        const QStringList missing = LibUnionImage_NameSpace::FileTypeCache::instance()->restore(DBManager::instance()->getFileTypeRecords());
+        DBManager::instance()->removeFileTypeRecords(missing);
+    });
+
+    // 运行期间定时在后台分批写回变更，异常退出时只丢失最近一次间隔内的结果；退出时写回剩余部分
+    QTimer *timer = new QTimer(this);
+    timer->setInterval(sc_FileTypeCacheSaveInterval);
+    connect(timer, &QTimer::timeout, this, []() {
+        WorkScheduler::instance()->submit(WorkScheduler::Background, []() {
+            saveFileTypeCache();
+        });
+    });
+    timer->start();
+
+    connect(qApp, &QCoreApplication::aboutToQuit, this, []() {
+        saveFileTypeCache();
+    });
+}
+
+void AlbumControl::saveFileTypeCache()
+{
+    LibUnionImage_NameSpace::FileTypeCache *cache = LibUnionImage_NameSpace::FileTypeCache::instance();
+    DBManager::instance()->insertFileTypeRecords(cache->takeDirtyRecords());
+    DBManager::instance()->removeFileTypeRecords(cache->takeRemovedPaths());
+}
+
+void AlbumControl::initPerceptualHashIndex()
+{
+    // 启动后延时索引，避免与首屏缩略图加载争抢IO；导入完成后索引新增图片
+    QTimer::singleShot(sc_PerceptualHashIndexDelay, this, []() {
+        PerceptualHashIndex::instance()->startIndexing();
+    });
+    connect(this, &AlbumControl::sigImportFinished, this, []() {
+        PerceptualHashIndex::instance()->startIndexing();
+    });
+}
+
+void AlbumControl::initThumbnailPregenerator()
+{
+    // 首屏缩略图加载完成后再开始；导入完成后为新增图片生成缩略图
+    QTimer::singleShot(sc_ThumbnailPregenerateDelay, this, []() {
+        ThumbnailPregenerator::instance()->start();
+    });
+    connect(this, &AlbumControl::sigImportFinished, this, []() {
+        ThumbnailPregenerator::instance()->start();
+    });
+}
+
+void AlbumControl::initThumbnailCacheGC()
+{
+    // 预生成及首屏加载完成后再清理，长时间运行时定时清理
+    QTimer::singleShot(sc_ThumbnailCacheGCDelay, this, []() {
+        ThumbnailCacheGC::instance()->start();
+    });
+    QTimer *timer = new QTimer(this);
+    timer->setInterval(sc_ThumbnailCacheGCInterval);
+    connect(timer, &QTimer::timeout, this, []() {
+        ThumbnailCacheGC::instance()->start();
+    });
+    timer->start();
+}
+
 AlbumControl *AlbumControl::instance()
 {
     if (!m_instance) {
@@ -380,7 +470,7 @@ bool AlbumControl::importAllImagesAndVideos(const QStringList &paths, const int
     ImportImagesThread *imagesthread = new ImportImagesThread;
     imagesthread->setData(paths, UID);
     imagesthread->setNotifyUI(notifyUI);
-    QThreadPool::globalInstance()->start(imagesthread);
+    WorkScheduler::instance()->start(WorkScheduler::BulkIO, imagesthread);
 
     return true;
 }
@@ -392,7 +482,7 @@ bool AlbumControl::importAllImagesAndVideosUrl(const QList<QUrl> &paths, const i
 
     ImportImagesThread *imagesthread = new ImportImagesThread;
     imagesthread->setData(paths, UID, checkRepeat);
-    QThreadPool::globalInstance()->start(imagesthread);
+    WorkScheduler::instance()->start(WorkScheduler::BulkIO, imagesthread);
 
     return true;
 }
@@ -702,7 +792,7 @@ void AlbumControl::startMonitor()
         QFileInfo info(eachItem);
         int uid = customAutoImportUIDAndPaths.key(eachItem);
         if (!info.exists() || !info.isDir()) {
-            DBManager::instance()->removeCustomAutoImportPath(customAutoImportUIDAndPaths.key(eachItem));
+            DBManagerAsync::instance()->submit([uid](DBManager *db) { db->removeCustomAutoImportPath(uid); });
             continue;
         }
 
@@ -732,7 +822,7 @@ void AlbumControl::startMonitor()
 
         //4.删除不存在的路径
         if (!deleteFiles.isEmpty()) {
-            DBManager::instance()->removeImgInfos(deleteFiles);
+            DBManagerAsync::instance()->removeImgInfos(deleteFiles);
         }
 
         //5.执行导入
@@ -752,7 +842,7 @@ void AlbumControl::startMonitor()
             needDeletes << path;
         }
     }
-    DBManager::instance()->removeImgInfos(needDeletes);
+    DBManagerAsync::instance()->removeImgInfos(needDeletes);
 }
 
 bool AlbumControl::checkIfNotified(const QString &dirPath)
@@ -762,10 +852,10 @@ bool AlbumControl::checkIfNotified(const QString &dirPath)
 
 void AlbumControl::slotMonitorChanged(QStringList fileAdd, QStringList fileDelete, QString album, int UID)
 {
-    //直接删除图片
-    DBManager::instance()->removeImgInfos(fileDelete);
+    //直接删除图片，监控目录批量变化时在数据库线程中合并写入，不阻塞界面
+    DBManagerAsync::instance()->removeImgInfos(fileDelete);
     AlbumDBType atype = AlbumDBType::AutoImport;
-    DBManager::instance()->insertIntoAlbum(UID, fileAdd, atype);
+    DBManagerAsync::instance()->insertIntoAlbum(UID, fileAdd, atype);
 
     DBImgInfoList dbInfos;
     for (QString path : fileAdd) {
@@ -775,13 +865,13 @@ void AlbumControl::slotMonitorChanged(QStringList fileAdd, QStringList fileDelet
         info.albumUID = QString::number(UID);
         dbInfos << info;
     }
-    //导入图片数据库ImageTable3
-    DBManager::instance()->insertImgInfos(dbInfos);
-
-    emit sigRefreshCustomAlbum(UID);
-    emit sigRefreshImportAlbum();
-    emit sigRefreshAllCollection();
-
+    //导入图片数据库ImageTable3，写入完成后再刷新界面
+    DBManagerAsync::instance()->insertImgInfos(dbInfos);
+    DBManagerAsync::instance()->flush().then(this, [this, UID]() {
+        emit sigRefreshCustomAlbum(UID);
+        emit sigRefreshImportAlbum();
+        emit sigRefreshAllCollection();
+    });
 }
 
 void AlbumControl::slotMonitorDestroyed(int UID)
@@ -1392,7 +1482,6 @@ bool AlbumControl::addCustomAlbumInfos(int albumId, const QList<QUrl> &urls)
             }
         }
     }
-    bool bRet = false;
     QStringList paths;
     for (QUrl url : urls) {
         paths << url2localPath(url);
@@ -1405,9 +1494,16 @@ bool AlbumControl::addCustomAlbumInfos(int albumId, const QList<QUrl> &urls)
     } else {
         atype = Custom;
     }
-    bRet = DBManager::instance()->insertIntoAlbum(albumId, paths, atype);
-    emit sigRefreshCustomAlbum(albumId);
-    return bRet;
+    //写入完成后再刷新相册界面，不阻塞界面线程
+    DBManagerAsync::instance()->run([albumId, paths, atype](DBManager *db) {
+        return db->insertIntoAlbum(albumId, paths, atype);
+    }).then(this, [this, albumId](bool bRet) {
+        if (!bRet) {
+            qWarning() << "Add custom album infos failed, album:" << albumId;
+        }
+        emit sigRefreshCustomAlbum(albumId);
+    });
+    return true;
 }
 
 int AlbumControl::getAllCount(const int &filterType)
@@ -1451,19 +1547,20 @@ void AlbumControl::insertTrash(const QList< QUrl > &paths)
             infos << insertInfo;
         }
     }
-    DBManager::instance()->insertTrashImgInfos(infos, true);
+    DBManagerAsync::instance()->submit([infos](DBManager *db) { db->insertTrashImgInfos(infos, true); });
 
-    // notify show progress end
+    //新增删除主相册数据库，写入完成后再通知进度结束及刷新界面
     int count = tmpList.size();
-    emit sigDeleteProgress(count + 1, count);
+    DBManagerAsync::instance()->removeImgInfos(tmpList).then(this, [this, count]() {
+        // notify show progress end
+        emit sigDeleteProgress(count + 1, count);
 
-    //新增删除主相册数据库
-    DBManager::instance()->removeImgInfos(tmpList);
-    // 通知前端刷新相关界面，包括自定义相册/我的收藏/合集-所有项目/已导入
-    sigRefreshCustomAlbum(-1);
-    sigRefreshAllCollection();
-    sigRefreshImportAlbum();
-    sigRefreshSearchView();
+        // 通知前端刷新相关界面，包括自定义相册/我的收藏/合集-所有项目/已导入
+        sigRefreshCustomAlbum(-1);
+        sigRefreshAllCollection();
+        sigRefreshImportAlbum();
+        sigRefreshSearchView();
+    });
 }
 
 void AlbumControl::removeTrashImgInfos(const QList< QUrl > &paths)
@@ -1472,7 +1569,7 @@ void AlbumControl::removeTrashImgInfos(const QList< QUrl > &paths)
     for (QUrl path : paths) {
         localPaths << url2localPath(path);
     }
-    DBManager::instance()->removeTrashImgInfos(localPaths);
+    DBManagerAsync::instance()->submit([localPaths](DBManager *db) { db->removeTrashImgInfos(localPaths); });
 }
 
 QStringList AlbumControl::recoveryImgFromTrash(const QStringList &paths)
@@ -1484,7 +1581,7 @@ QStringList AlbumControl::recoveryImgFromTrash(const QStringList &paths)
         else
             localPaths << path.toString();
     }
-    return DBManager::instance()->recoveryImgFromTrash(localPaths);
+    return DBManagerAsync::instance()->call([&](DBManager *db) { return db->recoveryImgFromTrash(localPaths); });
 }
 
 void AlbumControl::deleteImgFromTrash(const QStringList &paths)
@@ -1496,7 +1593,12 @@ void AlbumControl::deleteImgFromTrash(const QStringList &paths)
         else
             localPaths << path.toString();
     }
-    DBManager::instance()->removeTrashImgInfos(localPaths);
+    //删除完成后通知最近删除界面刷新
+    DBManagerAsync::instance()->submit([localPaths](DBManager *db) {
+        db->removeTrashImgInfos(localPaths);
+    }).then(this, [this]() {
+        emit sigTrashChanged();
+    });
 }
 
 void AlbumControl::insertCollection(const QList< QUrl > &paths)
@@ -1514,8 +1616,8 @@ void AlbumControl::insertCollection(const QList< QUrl > &paths)
 void AlbumControl::createAlbum(const QString &newName)
 {
     QString createAlbumName = getNewAlbumName(newName);
-    int createUID = DBManager::instance()->createAlbum(createAlbumName, QStringList(" "));
-    DBManager::instance()->insertIntoAlbum(createUID, QStringList(" "));
+    int createUID = DBManagerAsync::instance()->call([&](DBManager *db) { return db->createAlbum(createAlbumName, QStringList(" ")); });
+    DBManagerAsync::instance()->call([&](DBManager *db) { return db->insertIntoAlbum(createUID, QStringList(" ")); });
 }
 
 QList<int> AlbumControl::getAllNormlAutoImportAlbumId()
@@ -1611,64 +1713,35 @@ QString AlbumControl::getCustomAlbumByUid(const int &index)
 
 DBImgInfoList AlbumControl::getTrashInfos(const int &filterType)
 {
-    DBImgInfoList allTrashInfos = DBManager::instance()->getAllTrashInfos_getRemainDays();
-    QDateTime currentTime = QDateTime::currentDateTime();
-    DBImgInfoList list;
-    for (int i = allTrashInfos.size() - 1; i >= 0; i--) {
-        DBImgInfo pinfo = allTrashInfos.at(i);
-        if (!QFile::exists(pinfo.filePath) &&
-                !QFile::exists(getDeleteFullPath(pinfo.pathHash, pinfo.getFileNameFromFilePath()))) {
-            allTrashInfos.removeAt(i);
-        } else if (pinfo.remainDays <= 0) {
-            list << pinfo;
-            allTrashInfos.removeAt(i);
-        } else if (pinfo.itemType == ItemTypePic) {
-            if (filterType == 2) {
-                allTrashInfos.removeAt(i);
-            }
-        } else if (pinfo.itemType == ItemTypeVideo) {
-            if (filterType == 1) {
-                allTrashInfos.removeAt(i);
-            }
-        }
+    const DBImgInfoList allTrashInfos = TrashMaintainer::instance()->infos();
+    if (filterType != 1 && filterType != 2) {
+        return allTrashInfos;
     }
-    //清理删除时间过长图片
-    if (!list.isEmpty()) {
-        QStringList image_list;
-        for (DBImgInfo info : list) {
-            image_list << info.filePath;
+
+    DBImgInfoList list;
+    for (const DBImgInfo &pinfo : allTrashInfos) {
+        if ((pinfo.itemType == ItemTypePic && filterType == 2) || (pinfo.itemType == ItemTypeVideo && filterType == 1)) {
+            continue;
         }
-        DBManager::instance()->removeTrashImgInfosNoSignal(image_list);
+        list << pinfo;
     }
-    return allTrashInfos;
+    return list;
 }
 
 DBImgInfoList AlbumControl::getTrashInfos2(const int &filterType)
 {
-    DBImgInfoList allTrashInfos = DBManager::instance()->getAllTrashInfos_getRemainDays();
-    QDateTime currentTime = QDateTime::currentDateTime();
+    const DBImgInfoList allTrashInfos = TrashMaintainer::instance()->infos();
+    if (filterType == ItemTypeNull) {
+        return allTrashInfos;
+    }
+
     DBImgInfoList list;
-    for (int i = allTrashInfos.size() - 1; i >= 0; i--) {
-        DBImgInfo pinfo = allTrashInfos.at(i);
-        if (!QFile::exists(pinfo.filePath) &&
-                !QFile::exists(getDeleteFullPath(pinfo.pathHash, pinfo.getFileNameFromFilePath()))) {
-            allTrashInfos.removeAt(i);
-        } else if (pinfo.remainDays <= 0) {
+    for (const DBImgInfo &pinfo : allTrashInfos) {
+        if (pinfo.itemType == filterType) {
             list << pinfo;
-            allTrashInfos.removeAt(i);
-        } else if (pinfo.itemType != filterType && filterType != ItemTypeNull) {
-            allTrashInfos.removeAt(i);
         }
     }
-    //清理删除时间过长图片
-    if (!list.isEmpty()) {
-        QStringList image_list;
-        for (DBImgInfo info : list) {
-            image_list << info.filePath;
-        }
-        DBManager::instance()->removeTrashImgInfosNoSignal(image_list);
-    }
-    return allTrashInfos;
+    return list;
 }
 
 DBImgInfoList AlbumControl::getCollectionInfos()
@@ -1743,22 +1816,13 @@ bool AlbumControl::photoHaveAddedToCustomAlbum(int albumId, const QString &path)
 
 int AlbumControl::getCustomAlbumInfoConut(const int &albumId, const int &filterType)
 {
-    int rePicVideoConut = 0;
-    DBImgInfoList dbInfoList = DBManager::instance()->getInfosByAlbum(albumId, false);
-    for (DBImgInfo info : dbInfoList) {
-        QVariantMap tmpMap;
-        if (info.itemType == ItemTypePic) {
-            if (filterType == 2) {
-                continue ;
-            }
-        } else if (info.itemType == ItemTypeVideo) {
-            if (filterType == 1) {
-                continue ;
-            }
-        }
-        rePicVideoConut++;
+    ItemType type = ItemTypeNull;
+    if (filterType == 2) {
+        type = ItemTypeVideo;
+    } else if (filterType == 1) {
+        type = ItemTypePic;
     }
-    return rePicVideoConut;
+    return DBManager::instance()->getItemsCountByAlbum(albumId, type);
 }
 
 int AlbumControl::getAllInfoConut(const int &filterType)
@@ -1775,20 +1839,20 @@ int AlbumControl::getAllInfoConut(const int &filterType)
 
 int AlbumControl::getTrashInfoConut(const int &filterType)
 {
-    DBImgInfoList allTrashInfos;
+    //缓存有效时使用维护后的数量，否则按 TrashTable3 的类型索引计数
     if (filterType == 0)
-        allTrashInfos = getTrashInfos2(ItemTypeNull);
+        return TrashMaintainer::instance()->count(ItemTypeNull);
     else if (filterType == 1)
-        allTrashInfos = getTrashInfos2(ItemTypePic);
+        return TrashMaintainer::instance()->count(ItemTypePic);
     else if (filterType == 2)
-        allTrashInfos = getTrashInfos2(ItemTypeVideo);
+        return TrashMaintainer::instance()->count(ItemTypeVideo);
 
-    return allTrashInfos.size();
+    return 0;
 }
 
 void AlbumControl::removeAlbum(int UID)
 {
-    DBManager::instance()->removeAlbum(UID);
+    DBManagerAsync::instance()->call([&](DBManager *db) { return db->removeAlbum(UID); });
 }
 
 void AlbumControl::removeFromAlbum(int UID, const QStringList &paths)
@@ -1807,12 +1871,12 @@ void AlbumControl::removeFromAlbum(int UID, const QStringList &paths)
         localPaths << url2localPath(path);
     }
 
-    DBManager::instance()->removeCustomAlbumIdByPaths(UID, localPaths);
+    DBManagerAsync::instance()->call([&](DBManager *db) { return db->removeCustomAlbumIdByPaths(UID, localPaths); });
 
-    DBManager::instance()->removeFromAlbum(UID, localPaths, atype);
+    DBManagerAsync::instance()->call([&](DBManager *db) { return db->removeFromAlbum(UID, localPaths, atype); });
 
     // 删除信息使更新显示时不显示该图片
-    DBManager::instance()->removeImgInfos(localPaths);
+    DBManagerAsync::instance()->call([&](DBManager *db) { return db->removeImgInfos(localPaths); });
 }
 
 bool AlbumControl::insertIntoAlbum(int UID, const QStringList &paths)
@@ -1826,9 +1890,9 @@ bool AlbumControl::insertIntoAlbum(int UID, const QStringList &paths)
         localPaths << url2localPath(path);
     }
 
-    DBManager::instance()->addCustomAlbumIdByPaths(UID, localPaths);
+    DBManagerAsync::instance()->call([&](DBManager *db) { return db->addCustomAlbumIdByPaths(UID, localPaths); });
 
-    return DBManager::instance()->insertIntoAlbum(UID, localPaths, atype);
+    return DBManagerAsync::instance()->call([&](DBManager *db) { return db->insertIntoAlbum(UID, localPaths, atype); });
 }
 
 bool AlbumControl::insertImportIntoAlbum(int UID, const QStringList &paths)
@@ -1841,27 +1905,29 @@ bool AlbumControl::insertImportIntoAlbum(int UID, const QStringList &paths)
     for (QString path : paths) {
         localPaths << url2localPath(path);
     }
-    return DBManager::instance()->insertIntoAlbum(UID, localPaths, atype);
+    return DBManagerAsync::instance()->call([&](DBManager *db) { return db->insertIntoAlbum(UID, localPaths, atype); });
 }
 
 void AlbumControl::updateInfoPath(const QString &oldPath, const QString &newPath)
 {
     auto oldLocalPath = url2localPath(oldPath);
     auto newLocalPath = url2localPath(newPath);
-    bool ok = DBManager::instance()->updateImgPath(oldLocalPath, newLocalPath);
-
-    if (ok) {
-        // 通知前端刷新相关界面，包括自定义相册/我的收藏/合集-所有项目/已导入
-        sigRefreshCustomAlbum(-1);
-        sigRefreshAllCollection();
-        sigRefreshImportAlbum();
-        sigRefreshSearchView();
-    }
+    DBManagerAsync::instance()->run([oldLocalPath, newLocalPath](DBManager *db) {
+        return db->updateImgPath(oldLocalPath, newLocalPath);
+    }).then(this, [this](bool ok) {
+        if (ok) {
+            // 通知前端刷新相关界面，包括自定义相册/我的收藏/合集-所有项目/已导入
+            sigRefreshCustomAlbum(-1);
+            sigRefreshAllCollection();
+            sigRefreshImportAlbum();
+            sigRefreshSearchView();
+        }
+    });
 }
 
 bool AlbumControl::renameAlbum(int UID, const QString &newName)
 {
-    DBManager::instance()->renameAlbum(UID, newName);
+    DBManagerAsync::instance()->call([&](DBManager *db) { return db->renameAlbum(UID, newName); });
     return true;
 }
 
@@ -1975,10 +2041,10 @@ bool AlbumControl::saveAsImage(const QString &path, const QString &saveName, int
             }
             //目标位置与原图位置不同则先删除再复制
             if (QFile::remove(savePath)) {
-                bRet = QFile::copy(localPath, savePath);
+                bRet = Libutils::base::copyFileFast(localPath, savePath);
             }
         } else {
-            bRet = QFile::copy(localPath, savePath);
+            bRet = Libutils::base::copyFileFast(localPath, savePath);
         }
     } else {
         QImage m_saveImage;
@@ -2007,7 +2073,6 @@ QString AlbumControl::getFolder()
 
 bool AlbumControl::getFolders(const QStringList &paths)
 {
-    bool bRet = true;
     QFileDialog dialog;
     QString fileDir;
     dialog.setDirectory(QStandardPaths::writableLocation(QStandardPaths::HomeLocation));
@@ -2017,37 +2082,15 @@ bool AlbumControl::getFolders(const QStringList &paths)
     if (dialog.exec()) {
         fileDir = dialog.selectedFiles().first();
     }
-    QStringList localPaths;
-    for (QString path : paths) {
-        localPaths << url2localPath(path);
+    if (fileDir.isEmpty()) {
+        return false;
     }
-    if (!fileDir.isEmpty()) {
-
-        for (QString path : localPaths) {
 
-            QString savePath = fileDir + "/" + QFileInfo(path).completeBaseName() + "." + QFileInfo(path).completeSuffix();
-            QFileInfo fileinfo(savePath);
-            if (fileinfo.exists() && !fileinfo.isDir()) {
-                //目标位置与原图位置相同则直接返回
-                if (path == savePath) {
-                    return true;
-                }
-                //目标位置与原图位置不同则先删除再复制
-                if (QFile::remove(savePath)) {
-                    bRet = QFile::copy(path, savePath);
-                }
-            } else {
-                bRet = QFile::copy(path, savePath);
-            }
-        }
-
-    }
-    return bRet;
+    return startExport(paths, fileDir);
 }
 
 bool AlbumControl::exportFolders(const QStringList &paths, const QString &dir)
 {
-    bool bRet = true;
     QFileDialog dialog;
     QString fileDir;
     dialog.setDirectory(QStandardPaths::writableLocation(QStandardPaths::HomeLocation));
@@ -2057,36 +2100,36 @@ bool AlbumControl::exportFolders(const QStringList &paths, const QString &dir)
     if (dialog.exec()) {
         fileDir = dialog.selectedFiles().first();
     }
+    if (fileDir.isEmpty()) {
+        return false;
+    }
+
+    return startExport(paths, fileDir + "/" + dir);
+}
+
+void AlbumControl::stopExport()
+{
+    emit sigStopExport();
+}
+
+bool AlbumControl::startExport(const QStringList &paths, const QString &targetDir)
+{
     QStringList localPaths;
     for (QString path : paths) {
         localPaths << url2localPath(path);
     }
-    if (!fileDir.isEmpty()) {
-
-        QString newDir = fileDir + "/" + dir;
-        QDir a;
-        a.mkdir(newDir);
-
+    if (localPaths.isEmpty()) {
+        return false;
+    }
 
-        for (QString path : localPaths) {
+    //发送导出开始信号
+    emit sigExportStart();
 
-            QString savePath = newDir + "/" + QFileInfo(path).completeBaseName() + "." + QFileInfo(path).completeSuffix();
-            QFileInfo fileinfo(savePath);
-            if (fileinfo.exists() && !fileinfo.isDir()) {
-                //目标位置与原图位置相同则直接返回
-                if (path == savePath) {
-                    return true;
-                }
-                //目标位置与原图位置不同则先删除再复制
-                if (QFile::remove(savePath)) {
-                    bRet = QFile::copy(path, savePath);
-                }
-            } else {
-                bRet = QFile::copy(path, savePath);
-            }
-        }
-    }
-    return bRet;
+    //采用线程池执行导出，结果通过 sigExportFinished 通知
+    ExportFilesThread *exportThread = new ExportFilesThread;
+    exportThread->setData(localPaths, targetDir);
+    WorkScheduler::instance()->start(WorkScheduler::BulkIO, exportThread);
+    return true;
 }
 
 void AlbumControl::openDeepinMovie(const QString &path)
@@ -2285,51 +2328,59 @@ void AlbumControl::loadDeviceAlbumInfoAsync(const QString &devicePath)
     }
 
     m_PhonePicFileMap.insert(devicePath, nullptr);
-    QThreadPool::globalInstance()->start([=](){
+    // 设备标识需在主线程获取
+    const QString deviceKey = DeviceFileIndex::deviceKeyForPath(devicePath);
+    WorkScheduler::instance()->submit(WorkScheduler::BulkIO, [=](){
         // Notify load device info
         Q_EMIT deviceAlbumInfoLoadStart(devicePath);
 
-        //获取所选文件类型过滤器
-        QStringList filters;
-        for (QString i : LibUnionImage_NameSpace::unionImageSupportFormat()) {
-            filters << "*." + i;
-        }
-        for (QString i : LibUnionImage_NameSpace::videoFiletypes()) {
-            filters << "*." + i;
-        }
-
-        //定义迭代器并设置过滤器，包括子目录：QDirIterator::Subdirectories
-        QDirIterator dir_iterator(devicePath,
-                                  filters,
-                                  QDir::Files/* | QDir::NoSymLinks*/,
-                                  QDirIterator::Subdirectories);
-
-        DeviceInfoPtr devicePtr = DeviceInfoPtr::create();
-        while (dir_iterator.hasNext()) {
-            dir_iterator.next();
-
-            ItemType type;
-            QString filePath = dir_iterator.filePath();
-            if (LibUnionImage_NameSpace::isImage(filePath)) {
-                type = ItemTypePic;
-                devicePtr->picCount++;
-            } else if (LibUnionImage_NameSpace::isVideo(filePath)) {
-                type = ItemTypeVideo;
-                devicePtr->videoCount++;
-            } else {
-                continue;
+        // GUI thread, notify update data, finished 为 false 时为扫描过程中的部分结果
+        auto publish = [=](const DeviceFileIndex::FileTypeMap &fileTypeMap, bool finished) {
+            DeviceInfoPtr devicePtr = DeviceInfoPtr::create();
+            devicePtr->fileTypeMap = fileTypeMap;
+            for (auto itr = fileTypeMap.constBegin(); itr != fileTypeMap.constEnd(); ++itr) {
+                if (ItemTypePic == itr.value()) {
+                    devicePtr->picCount++;
+                } else if (ItemTypeVideo == itr.value()) {
+                    devicePtr->videoCount++;
+                }
             }
 
-            devicePtr->fileTypeMap.insert(filePath, type);
-        }
-
-        // GUI thread, notify update data
-        QMetaObject::invokeMethod(qApp, [=](){
+            QMetaObject::invokeMethod(qApp, [=](){
+                // 扫描过程中设备已卸载，丢弃结果
+                if (!m_PhonePicFileMap.contains(devicePath)) {
+                    return;
+                }
                 m_PhonePicFileMap.insert(devicePath, devicePtr);
-                
-                Q_EMIT deviceAlbumInfoLoadFinished(devicePath);
+
+                if (finished) {
+                    Q_EMIT deviceAlbumInfoLoadFinished(devicePath);
+                } else {
+                    Q_EMIT deviceAlbumInfoLoadProgress(devicePath);
+                }
                 Q_EMIT deviceAlbumInfoCountChanged(devicePath, devicePtr->picCount, devicePtr->videoCount);
             }, Qt::QueuedConnection);
+        };
+
+        // 先展示上次保存的索引，再增量扫描变化的目录
+        DeviceFileIndex index(devicePath, deviceKey);
+        DeviceFileIndex::FileTypeMap cachedMap = index.load();
+        if (!cachedMap.isEmpty()) {
+            publish(cachedMap, false);
+        }
+
+        // 无历史索引时，扫描过程中周期性刷新已扫描到的文件
+        DeviceFileIndex::FileTypeMap fileTypeMap;
+        if (cachedMap.isEmpty()) {
+            fileTypeMap = index.scan([=](const DeviceFileIndex::FileTypeMap &partialMap) {
+                publish(partialMap, false);
+            });
+        } else {
+            fileTypeMap = index.scan();
+        }
+        index.save();
+
+        publish(fileTypeMap, true);
     });
 }
 
@@ -2405,73 +2456,56 @@ QList<int> AlbumControl::getPicVideoCountFromPaths(const QStringList &paths, con
 
 void AlbumControl::importFromMountDevice(const QStringList &paths, const int &index)
 {
-    //采用线程执行导入
-    QThread *thread = QThread::create([ = ] {
-        QStringList localPaths;
-        for (QString path : paths)
-        {
-            localPaths << url2localPath(path);
-        }
-        QStringList newPathList;
-        DBImgInfoList dbInfos;
-        QString strHomePath = QDir::homePath();
-        //获取系统现在的时间
-        QString strDate = QDateTime::currentDateTime().toString("yyyy-MM-dd");
-        QString basePath = QString("%1%2%3/%4").arg(strHomePath, "/Pictures/", tr("Pictures"), strDate);
-        QDir dir;
-        if (!dir.exists(basePath))
-        {
-            dir.mkpath(basePath);
-        }
-        for (QString strPath : localPaths)
-        {
-            //取出文件名称
-            QStringList pathList = strPath.split("/", Qt::SkipEmptyParts);
-            QStringList nameList = pathList.last().split(".", Qt::SkipEmptyParts);
-            QString strNewPath = QString("%1%2%3%4%5%6").arg(basePath, "/", nameList.first(),
-                                                             QString::number(QDateTime::currentDateTime().toMSecsSinceEpoch()), ".", nameList.last());
-            //判断新路径下是否存在目标文件，若不存在，继续循环
-            if (!dir.exists(strPath)) {
-                continue;
-            }
-            //判断新路径下是否存在目标文件，若存在，先删除掉
-            if (dir.exists(strNewPath)) {
-                dir.remove(strNewPath);
-            }
-            newPathList << strNewPath;
-            QFileInfo fi(strNewPath);
-            //复制失败的图片不算在成功导入
-            if (QFile::copy(strPath, strNewPath)) {
-                dbInfos << getDBInfo(strNewPath, LibUnionImage_NameSpace::isVideo(strNewPath));
-            } else {
-                newPathList.removeOne(strNewPath);
-            }
+    QStringList localPaths;
+    for (QString path : paths) {
+        localPaths << url2localPath(path);
+    }
+    if (localPaths.isEmpty()) {
+        return;
+    }
 
-        }
-        if (!dbInfos.isEmpty())
-        {
-            QStringList pathslist;
-            int idblen = dbInfos.length();
-            for (int i = 0; i < idblen; i++) {
-                if (m_bneedstop) {
-                    return;
-                }
-                pathslist << dbInfos[i].filePath;
-            }
+    //发送导入开始信号
+    emit sigDeviceImportStart();
 
+    //采用线程池执行导入，有限并发拷贝、按内容去重、分批写入数据库
+    DeviceImportThread *importThread = new DeviceImportThread;
+    importThread->setData(localPaths, index);
+    WorkScheduler::instance()->start(WorkScheduler::BulkIO, importThread);
+}
 
-            DBManager::instance()->insertImgInfos(dbInfos);
-            if (index > 0) {
-                DBManager::instance()->insertIntoAlbum(index, pathslist);
-                emit sigRefreshCustomAlbum(index);
-            }
-            emit sigRefreshImportAlbum();
-            emit sigRefreshAllCollection();
-        }
-    });
-    thread->start();
-    connect(thread, &QThread::destroyed, thread, &QObject::deleteLater);
+void AlbumControl::stopImportFromMountDevice()
+{
+    emit sigStopDeviceImport();
+}
 
+QStringList AlbumControl::getSimilarImages(const QString &url, int radius)
+{
+    if (radius < 0) {
+        radius = PerceptualHashIndex::DefaultRadius;
+    }
+
+    QStringList urls;
+    for (const QString &path : PerceptualHashIndex::instance()->findSimilar(url2localPath(url), radius)) {
+        urls << "file://" + path;
+    }
+    return urls;
+}
+
+QVariantList AlbumControl::getDuplicateGroups(int radius)
+{
+    if (radius < 0) {
+        radius = PerceptualHashIndex::DefaultRadius;
+    }
+
+    QVariantList groups;
+    for (const QStringList &group : PerceptualHashIndex::instance()->findDuplicates(radius)) {
+        QStringList urls;
+        for (const QString &path : group) {
+            urls << "file://" + path;
+        }
+        groups << urls;
+    }
+    return groups;
 }
 
 QString AlbumControl::getYearCoverPath(const QString &year)
@@ -2490,21 +2524,10 @@ QStringList AlbumControl::getDayPaths(const QString &day)
 
 int AlbumControl::getDayInfoCount(const QString &day, const int &filterType)
 {
-    int rePicVideoConut = 0;
-    QStringList list = getDayPaths(day);
-    for (QString path : list) {
-        QVariantMap tmpMap;
-        if (LibUnionImage_NameSpace::isImage(url2localPath(path))) {
-            if (filterType == ItemTypePic) {
-                rePicVideoConut++;
-            }
-        } else if (LibUnionImage_NameSpace::isVideo(url2localPath(path))) {
-            if (filterType == ItemTypeVideo) {
-                rePicVideoConut++;
-            }
-        }
+    if (filterType != ItemTypePic && filterType != ItemTypeVideo) {
+        return 0;
     }
-    return rePicVideoConut;
+    return DBManager::instance()->getDayCount(day, static_cast<ItemType>(filterType));
 }
 
 //获取日期
@@ -2538,7 +2561,7 @@ QStringList AlbumControl::getImportAlubumAllNames()
 
 void AlbumControl::removeCustomAutoImportPath(int uid)
 {
-    return DBManager::instance()->removeCustomAutoImportPath(uid);
+    return DBManagerAsync::instance()->call([&](DBManager *db) { return db->removeCustomAutoImportPath(uid); });
 }
 
 void AlbumControl::createNewCustomAutoImportAlbum(const QString &path)
@@ -2554,7 +2577,7 @@ void AlbumControl::createNewCustomAutoImportAlbum(const QString &path)
 
     //自定义自动导入路径的相册名是文件夹最后一级的名字
     QString albumName = folder.split('/').last();
-    int UID = DBManager::instance()->createNewCustomAutoImportPath(folder, albumName);
+    int UID = DBManagerAsync::instance()->call([&](DBManager *db) { return db->createNewCustomAutoImportPath(folder, albumName); });
 
     QStringList urls;
     urls << QUrl::fromLocalFile(folder).toString();
@@ -2566,8 +2589,8 @@ QString AlbumControl::getVideoTime(const QString &path)
     if (!LibUnionImage_NameSpace::isVideo(url2localPath(path)))
         return "00:00";
 
-    //采用线程执行导入
-    QThread *thread = QThread::create([ = ] {
+    //在调度器中读取视频信息，避免每次调用都新建线程
+    WorkScheduler::instance()->submit(WorkScheduler::Visible, [ = ] {
         m_mutex.lock();
         QString reString;
         reString = MovieService::instance()->getMovieInfo(QUrl(path)).duration;
@@ -2584,8 +2607,6 @@ QString AlbumControl::getVideoTime(const QString &path)
         emit sigRefreashVideoTime(path, reString);
         m_mutex.unlock();
     });
-    thread->start();
-    connect(thread, &QThread::destroyed, thread, &QObject::deleteLater);
     return "00:00";
 }
 
@@ -145,7 +145,7 @@ public:
     //获得最近删除的相册的全部info  , 0:全部 1:图片 2:视频
     Q_INVOKABLE QVariantMap getTrashAlbumInfos(const int &filterType = 0);
 
-    //添加到自定义相册
+    //添加到自定义相册，写入在数据库线程中异步完成，完成后发出 sigRefreshCustomAlbum
     Q_INVOKABLE bool addCustomAlbumInfos(int albumId, const QList <QUrl> &urls);
 
     //根据自定义相册id获取相册名称
@@ -204,12 +204,15 @@ public:
     //获得选择路径
     Q_INVOKABLE QString getFolder();
 
-    //选择路径导出视频
+    //选择路径导出文件，后台异步导出，未选择路径时返回false
     Q_INVOKABLE bool getFolders(const QStringList &paths);
 
-    //选择路径导出文件及目录
+    //选择路径导出文件及目录，后台异步导出，未选择路径时返回false
     Q_INVOKABLE bool exportFolders(const QStringList &paths, const QString &dir);
 
+    //取消正在进行的导出，已导出的文件保留，重新导出到同一目录时跳过
+    Q_INVOKABLE void stopExport();
+
     //用影院打开视频
     Q_INVOKABLE void openDeepinMovie(const QString &path);
 
@@ -248,12 +251,21 @@ public:
     DBImgInfoList getDeviceAlbumInfoList(const QString &devicePath, const int &filterType = 0, bool *loading = nullptr);
     Q_SIGNAL void deviceAlbumInfoLoadStart(const QString &devicePath);
     Q_SIGNAL void deviceAlbumInfoLoadFinished(const QString &devicePath);
+    // 扫描过程中(或使用历史索引)已加载部分设备数据
+    Q_SIGNAL void deviceAlbumInfoLoadProgress(const QString &devicePath);
 
     Q_INVOKABLE void getDeviceAlbumInfoCountAsync(const QString &devicePath);
     Q_SIGNAL void deviceAlbumInfoCountChanged(const QString &devicePath, int picCount, int videoCount);
 
     //手机照片导入 0为已导入，1-n为自定义相册
     Q_INVOKABLE void importFromMountDevice(const QStringList &paths, const int &index = 0);
+    //取消正在进行的设备导入，已完成的批次保留
+    Q_INVOKABLE void stopImportFromMountDevice();
+
+    //获取与 url 相似的图片，radius 为感知哈希的汉明距离，小于0时使用默认值
+    Q_INVOKABLE QStringList getSimilarImages(const QString &url, int radius = -1);
+    //获取所有相似图片分组，每组为相似图片的url列表
+    Q_INVOKABLE QVariantList getDuplicateGroups(int radius = -1);
 
     //获取年封面图片路径
     Q_INVOKABLE QString getYearCoverPath(const QString &year);
@@ -367,6 +379,20 @@ public:
     //初始化设备监控
     void initDeviceMonitor();
 
+    //载入文件类型判断缓存
+    void initFileTypeCache();
+    //将文件类型判断缓存的变更写入数据库
+    static void saveFileTypeCache();
+
+    //启动相似图片索引
+    void initPerceptualHashIndex();
+
+    //启动缩略图后台预生成
+    void initThumbnailPregenerator();
+
+    //启动缩略图缓存清理
+    void initThumbnailCacheGC();
+
     //寻找手机里面是否有图片
     bool findPicturePathByPhone(QString &path);
 
@@ -395,6 +421,8 @@ private:
     void getAllBlockDeviceName();
     void updateBlockDeviceName(const QString &blks);
     void onUnMountedExecute(const QString &deviceKey, DeviceType type);
+    //启动后台导出线程，将 paths 导出到 targetDir
+    bool startExport(const QStringList &paths, const QString &targetDir);
 
 signals:
     void sigRefreshAllCollection();
@@ -404,14 +432,32 @@ signals:
 
     //导入开始信号
     void sigImportStart();
+    //设备导入开始信号，设备导入可取消并通知速度
+    void sigDeviceImportStart();
     //导入进度信号
     void sigImportProgress(int value, int max = 100);
     //导入完成信号
     void sigImportFinished();
     //导入失败
     void sigImportFailed(int error);
+    //导入速度，bytesPerSecond:拷贝速度，remainSeconds:预计剩余时间
+    void sigImportSpeed(qint64 bytesPerSecond, int remainSeconds);
+    //通知设备导入线程停止
+    void sigStopDeviceImport();
+    //导出开始信号
+    void sigExportStart();
+    //导出进度信号
+    void sigExportProgress(int value, int max);
+    //导出速度，bytesPerSecond:拷贝速度，remainSeconds:预计剩余时间
+    void sigExportSpeed(qint64 bytesPerSecond, int remainSeconds);
+    //导出完成信号，bSuccess:全部文件导出成功
+    void sigExportFinished(bool bSuccess);
+    //通知导出线程停止
+    void sigStopExport();
     //删除进度信号
     void sigDeleteProgress(int value, int max = 100);
+    //回收站数据在后台维护后变化
+    void sigTrashChanged();
 
     //自定义相册删除
     void sigDeleteCustomAlbum(int UID);
@@ -3,7 +3,9 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "configsetter.h"
+#include "utils/settingsstore.h"
 
+#include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
@@ -38,7 +40,11 @@ void LibConfigSetter::loadConfig(imageViewerSpace::ImgViewerType type)
         return;
 
     m_viewType = type;
-    m_settings = new QSettings(imageViewerSpace::ImgViewerTypeAlbum == type ? CONFIG_PATH_ALBUM : CONFIG_PATH_IMAGE_VIEWER, QSettings::IniFormat, this);
+    delete m_store;
+    m_store = new SettingsStore(imageViewerSpace::ImgViewerTypeAlbum == type ? CONFIG_PATH_ALBUM : CONFIG_PATH_IMAGE_VIEWER, this);
+    connect(qApp, &QCoreApplication::aboutToQuit, m_store, [this]() {
+        flush();
+    });
 
     if (imageViewerSpace::ImgViewerTypeAlbum == type) {
         if (!contains("", "loadDayView"))
@@ -62,36 +68,33 @@ void LibConfigSetter::loadConfig(imageViewerSpace::ImgViewerType type)
 //    }
 }
 
+QString LibConfigSetter::settingsKey(const QString &group, const QString &key)
+{
+    return group.isEmpty() ? key : group + "/" + key;
+}
+
 void LibConfigSetter::setValue(const QString &group, const QString &key, const QVariant &value)
 {
-    m_settings->beginGroup(group);
-    m_settings->setValue(key, value);
-    m_settings->endGroup();
+    if (m_store) {
+        m_store->setValue(settingsKey(group, key), value);
+    }
 
     emit valueChanged(group, key, value);
 }
 
 QVariant LibConfigSetter::value(const QString &group, const QString &key, const QVariant &defaultValue)
 {
-    QMutexLocker locker(&m_mutex);
-
-    QVariant value;
-    m_settings->beginGroup(group);
-    value = m_settings->value(key, defaultValue);
-    m_settings->endGroup();
-
-    return value;
+    return m_store ? m_store->value(settingsKey(group, key), defaultValue) : defaultValue;
 }
 
 bool LibConfigSetter::contains(const QString &group, const QString &key)
 {
-    QMutexLocker locker(&m_mutex);
-
-    bool bContains = false;
-    QVariant value;
-    m_settings->beginGroup(group);
-    bContains = m_settings->contains(key);
-    m_settings->endGroup();
+    return m_store && m_store->contains(settingsKey(group, key));
+}
 
-    return bContains;
+void LibConfigSetter::flush()
+{
+    if (m_store) {
+        m_store->flush();
+    }
 }
@@ -8,9 +8,13 @@
 #include "unionimage/unionimage_global.h"
 
 #include <QObject>
-#include <QSettings>
-#include <QMutex>
+#include <QVariant>
 
+class SettingsStore;
+
+/**
+ * @brief 配置文件读写，配置项保存在内存中(SettingsStore)，读取不加锁，修改合并后在后台写回
+ */
 class LibConfigSetter : public QObject
 {
     Q_OBJECT
@@ -22,6 +26,8 @@ public:
     QVariant value(const QString &group, const QString &key,
                    const QVariant &defaultValue = QVariant());
     bool contains(const QString &group, const QString &key);
+    // 立即写回未保存的修改，退出时自动调用
+    void flush();
 
 signals:
     void valueChanged(const QString &group, const QString &key,
@@ -32,10 +38,11 @@ private:
     ~LibConfigSetter() override;
 
 private:
+    static QString settingsKey(const QString &group, const QString &key);
+
     imageViewerSpace::ImgViewerType m_viewType;
     static LibConfigSetter *m_setter;
-    QSettings *m_settings;
-    QMutex m_mutex;
+    SettingsStore *m_store = nullptr;
 };
 
 #endif // CONFIGSETTER_H
@@ -4,6 +4,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "dbmanager.h"
+#include "utils/metrics.h"
 //#include "application.h"
 //#include "controller/signalmanager.h"
 #include "unionimage/baseutils.h"
@@ -50,6 +51,7 @@ DBManager::DBManager(QObject *parent)
 
 const QStringList DBManager::getAllPaths(const ItemType &filterType) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     QStringList paths;
 
@@ -81,6 +83,7 @@ const QStringList DBManager::getAllPaths(const ItemType &filterType) const
 
 const DBImgInfoList DBManager::getAllInfos(int loadCount)const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     DBImgInfoList infos;
     m_query->setForwardOnly(true);
@@ -108,6 +111,7 @@ const DBImgInfoList DBManager::getAllInfos(int loadCount)const
 
 const DBImgInfoList DBManager::getAllInfosSort(const ItemType &filterType) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     DBImgInfoList infos;
     m_query->setForwardOnly(true);
@@ -136,6 +140,7 @@ const DBImgInfoList DBManager::getAllInfosSort(const ItemType &filterType) const
 
 const DBImgInfoList DBManager::getAllInfosByUID(QString UID) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     DBImgInfoList infos;
     m_query->setForwardOnly(true);
@@ -161,6 +166,7 @@ const DBImgInfoList DBManager::getAllInfosByUID(QString UID) const
 
 const QList<QDateTime> DBManager::getAllTimelines() const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     QList<QDateTime> times;
     m_query->setForwardOnly(true);
@@ -176,6 +182,7 @@ const QList<QDateTime> DBManager::getAllTimelines() const
 
 const DBImgInfoList DBManager::getInfosByTimeline(const QDateTime &timeline, const ItemType &filterType) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     DBImgInfoList infos;
     m_query->setForwardOnly(true);
@@ -204,6 +211,7 @@ const DBImgInfoList DBManager::getInfosByTimeline(const QDateTime &timeline, con
 
 const QList<QDateTime> DBManager::getImportTimelines() const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     QList<QDateTime> importtimes;
 
@@ -219,6 +227,7 @@ const QList<QDateTime> DBManager::getImportTimelines() const
 
 const DBImgInfoList DBManager::getInfosByImportTimeline(const QDateTime &timeline, const ItemType &filterType) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     DBImgInfoList infos;
     m_query->setForwardOnly(true);
@@ -249,6 +258,7 @@ const DBImgInfoList DBManager::getInfosByImportTimeline(const QDateTime &timelin
 
 const DBImgInfo DBManager::getInfoByPath(const QString &path) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     DBImgInfoList list = getImgInfos("FilePath", path, true);
     if (list.count() < 1) {
         return DBImgInfo();
@@ -259,11 +269,66 @@ const DBImgInfo DBManager::getInfoByPath(const QString &path) const
 
 const DBImgInfoList DBManager::getInfosByPath(const QString &path) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     return getImgInfos("FilePath", path, true);
 }
 
+const QString DBManager::getPathByDataHash(const QString &dataHash) const
+{
+    ALBUM_METRICS_FUNCTION("db");
+    QString path;
+    if (dataHash.isEmpty()) {
+        return path;
+    }
+
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    bool b = m_query->prepare("SELECT FilePath FROM ImageTable3 WHERE DataHash = :DataHash LIMIT 1");
+    m_query->bindValue(":DataHash", dataHash);
+    if (!b || !m_query->exec()) {
+        qDebug() << m_query->lastError();
+    } else if (m_query->next()) {
+        path = m_query->value(0).toString();
+    }
+    return path;
+}
+
+const QStringList DBManager::getUnhashedPathsByFileName(const QString &fileName) const
+{
+    ALBUM_METRICS_FUNCTION("db");
+    QStringList paths;
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    bool b = m_query->prepare("SELECT DISTINCT FilePath FROM ImageTable3 WHERE FileName = :FileName "
+                              "AND (DataHash IS NULL OR DataHash = '')");
+    m_query->bindValue(":FileName", fileName);
+    if (!b || !m_query->exec()) {
+        qDebug() << m_query->lastError();
+        return paths;
+    }
+
+    while (m_query->next()) {
+        paths << m_query->value(0).toString();
+    }
+    return paths;
+}
+
+void DBManager::updateDataHash(const QString &path, const QString &dataHash)
+{
+    ALBUM_METRICS_FUNCTION("db");
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    bool b = m_query->prepare("UPDATE ImageTable3 SET DataHash = :DataHash WHERE PathHash = :PathHash");
+    m_query->bindValue(":DataHash", dataHash);
+    m_query->bindValue(":PathHash", LibUnionImage_NameSpace::hashByString(path));
+    if (!b || !m_query->exec()) {
+        qDebug() << m_query->lastError();
+    }
+}
+
 int DBManager::getImgsCount(const ItemType &filterType) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
 
     m_query->setForwardOnly(true);
@@ -294,15 +359,33 @@ int DBManager::getImgsCount(const ItemType &filterType) const
 
 void DBManager::insertImgInfos(const DBImgInfoList &infos)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     if (!m_query->exec("BEGIN IMMEDIATE TRANSACTION")) {
 //        qDebug() << query.lastError();
     }
-    QString qs("REPLACE INTO ImageTable3 (PathHash, FilePath, FileName, Time, "
-               "ChangeTime, ImportTime, FileType, UID) VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+    //已存在的记录只更新基本信息，未传入内容hash时保留原有值，文件修改过(ChangeTime变化)时清空两种hash以便重新计算
+    QString qs("INSERT INTO ImageTable3 (PathHash, FilePath, FileName, Time, "
+               "ChangeTime, ImportTime, FileType, DataHash, UID) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?) "
+               "ON CONFLICT(PathHash, UID) DO UPDATE SET "
+               "FilePath = excluded.FilePath, FileName = excluded.FileName, Time = excluded.Time, "
+               "ImportTime = excluded.ImportTime, FileType = excluded.FileType, "
+               "DataHash = COALESCE(NULLIF(excluded.DataHash, ''), "
+               "CASE WHEN excluded.ChangeTime IS ImageTable3.ChangeTime THEN ImageTable3.DataHash END), "
+               "PerceptualHash = CASE WHEN excluded.ChangeTime IS ImageTable3.ChangeTime THEN ImageTable3.PerceptualHash END, "
+               "ChangeTime = excluded.ChangeTime");
 
     if (!m_query->prepare(qs)) {
+        //UPSERT 依赖 (PathHash, UID) 唯一约束，迁移失败或SQLite过旧时回退为整行替换
+        qWarning() << "Prepare image upsert failed, fallback to REPLACE:" << m_query->lastError();
+        qs = "REPLACE INTO ImageTable3 (PathHash, FilePath, FileName, Time, "
+             "ChangeTime, ImportTime, FileType, DataHash, UID) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        if (!m_query->prepare(qs)) {
+            qWarning() << "Prepare image replace failed:" << m_query->lastError();
+            m_query->exec("ROLLBACK");
+            return;
+        }
     }
 
     for (const auto &info : infos) {
@@ -313,9 +396,10 @@ void DBManager::insertImgInfos(const DBImgInfoList &infos)
         m_query->addBindValue(info.changeTime);
         m_query->addBindValue(info.importTime);
         m_query->addBindValue(info.itemType);
+        m_query->addBindValue(info.dataHash);
         m_query->addBindValue(info.albumUID);
         if (!m_query->exec()) {
-            ;
+            qWarning() << "Insert image info failed:" << info.filePath << m_query->lastError();
         }
     }
 
@@ -330,8 +414,198 @@ void DBManager::insertImgInfos(const DBImgInfoList &infos)
 //    emit dApp->signalM->imagesInserted();
 }
 
+const QList<LibUnionImage_NameSpace::FileTypeRecord> DBManager::getFileTypeRecords() const
+{
+    ALBUM_METRICS_FUNCTION("db");
+    QList<LibUnionImage_NameSpace::FileTypeRecord> records;
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    if (!m_query->exec("SELECT FilePath, ModifyTime, FileSize, Known, Flags, ImageType FROM FileTypeTable")) {
+        qDebug() << m_query->lastError();
+        return records;
+    }
+
+    while (m_query->next()) {
+        LibUnionImage_NameSpace::FileTypeRecord record;
+        record.filePath = m_query->value(0).toString();
+        record.modified = m_query->value(1).toLongLong();
+        record.size = m_query->value(2).toLongLong();
+        record.known = m_query->value(3).toInt();
+        record.flags = m_query->value(4).toInt();
+        record.imageType = m_query->value(5).toInt();
+        records << record;
+    }
+    return records;
+}
+
+void DBManager::insertFileTypeRecords(const QList<LibUnionImage_NameSpace::FileTypeRecord> &records)
+{
+    ALBUM_METRICS_FUNCTION("db");
+    if (records.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    if (!m_query->exec("BEGIN IMMEDIATE TRANSACTION")) {
+    }
+
+    if (!m_query->prepare("REPLACE INTO FileTypeTable (FilePath, ModifyTime, FileSize, Known, Flags, ImageType) "
+                          "VALUES (?, ?, ?, ?, ?, ?)")) {
+    }
+
+    for (const auto &record : records) {
+        m_query->addBindValue(record.filePath);
+        m_query->addBindValue(record.modified);
+        m_query->addBindValue(record.size);
+        m_query->addBindValue(record.known);
+        m_query->addBindValue(record.flags);
+        m_query->addBindValue(record.imageType);
+        if (!m_query->exec()) {
+            ;
+        }
+    }
+
+    if (!m_query->exec("COMMIT")) {
+    }
+}
+
+void DBManager::removeFileTypeRecords(const QStringList &paths)
+{
+    ALBUM_METRICS_FUNCTION("db");
+    if (paths.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    if (!m_query->exec("BEGIN IMMEDIATE TRANSACTION")) {
+    }
+
+    if (!m_query->prepare("DELETE FROM FileTypeTable WHERE FilePath = ?")) {
+    }
+
+    for (const QString &path : paths) {
+        m_query->addBindValue(path);
+        if (!m_query->exec()) {
+            ;
+        }
+    }
+
+    if (!m_query->exec("COMMIT")) {
+    }
+}
+
+const QList<QPair<QString, quint64>> DBManager::getPerceptualHashes() const
+{
+    ALBUM_METRICS_FUNCTION("db");
+    QList<QPair<QString, quint64>> hashes;
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    if (!m_query->exec("SELECT DISTINCT FilePath, PerceptualHash FROM ImageTable3 WHERE PerceptualHash IS NOT NULL")) {
+        qDebug() << m_query->lastError();
+        return hashes;
+    }
+
+    while (m_query->next()) {
+        hashes << qMakePair(m_query->value(0).toString(), static_cast<quint64>(m_query->value(1).toLongLong()));
+    }
+    return hashes;
+}
+
+const QStringList DBManager::getPathsWithoutPerceptualHash() const
+{
+    ALBUM_METRICS_FUNCTION("db");
+    QStringList paths;
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    bool b = m_query->prepare("SELECT DISTINCT FilePath FROM ImageTable3 WHERE PerceptualHash IS NULL AND FileType = :type");
+    m_query->bindValue(":type", ItemTypePic);
+    if (!b || !m_query->exec()) {
+        qDebug() << m_query->lastError();
+        return paths;
+    }
+
+    while (m_query->next()) {
+        paths << m_query->value(0).toString();
+    }
+    return paths;
+}
+
+const QList<QPair<QString, QString>> DBManager::getPathsByImportTime() const
+{
+    ALBUM_METRICS_FUNCTION("db");
+    QList<QPair<QString, QString>> paths;
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    if (!m_query->exec("SELECT DISTINCT FilePath, ImportTime, Time FROM ImageTable3 ORDER BY ImportTime DESC, Time DESC")) {
+        qDebug() << m_query->lastError();
+        return paths;
+    }
+
+    while (m_query->next()) {
+        paths << qMakePair(m_query->value(0).toString(), m_query->value(1).toString());
+    }
+    return paths;
+}
+
+void DBManager::updatePerceptualHashes(const QList<QPair<QString, quint64>> &hashes)
+{
+    ALBUM_METRICS_FUNCTION("db");
+    if (hashes.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    if (!m_query->exec("BEGIN IMMEDIATE TRANSACTION")) {
+    }
+
+    if (!m_query->prepare("UPDATE ImageTable3 SET PerceptualHash = ? WHERE PathHash = ?")) {
+    }
+
+    // sqlite 整数为有符号64位，按位保存
+    for (const auto &item : hashes) {
+        m_query->addBindValue(static_cast<qint64>(item.second));
+        m_query->addBindValue(LibUnionImage_NameSpace::hashByString(item.first));
+        if (!m_query->exec()) {
+            ;
+        }
+    }
+
+    if (!m_query->exec("COMMIT")) {
+    }
+}
+
+void DBManager::clearPerceptualHashes(const QStringList &paths)
+{
+    ALBUM_METRICS_FUNCTION("db");
+    if (paths.isEmpty()) {
+        return;
+    }
+
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    if (!m_query->exec("BEGIN IMMEDIATE TRANSACTION")) {
+    }
+
+    if (!m_query->prepare("UPDATE ImageTable3 SET PerceptualHash = NULL WHERE PathHash = ?")) {
+    }
+
+    for (const QString &path : paths) {
+        m_query->addBindValue(LibUnionImage_NameSpace::hashByString(path));
+        if (!m_query->exec()) {
+            ;
+        }
+    }
+
+    if (!m_query->exec("COMMIT")) {
+    }
+}
+
 void DBManager::removeImgInfos(const QStringList &paths)
 {
+    ALBUM_METRICS_FUNCTION("db");
     if (paths.isEmpty()) {
         return;
     }
@@ -384,6 +658,7 @@ void DBManager::removeImgInfos(const QStringList &paths)
 
 void DBManager::removeImgInfosNoSignal(const QStringList &paths)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     if (paths.isEmpty()) {
         return;
@@ -426,6 +701,7 @@ void DBManager::removeImgInfosNoSignal(const QStringList &paths)
 
 const QList<std::pair<int, QString>> DBManager::getAllAlbumNames(AlbumDBType atype) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     QList<std::pair<int, QString>> list;
     m_query->setForwardOnly(true);
@@ -546,6 +822,7 @@ bool DBManager::defaultNotifyPathExists(int UID)
 
 const QStringList DBManager::getPathsByAlbum(int UID) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     QStringList list;
     m_query->setForwardOnly(true);
@@ -566,6 +843,7 @@ const QStringList DBManager::getPathsByAlbum(int UID) const
 
 const DBImgInfoList DBManager::getInfosByAlbum(int UID, bool needTimeData, ItemType itemType) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     DBImgInfoList infos;
     m_query->setForwardOnly(true);
@@ -617,31 +895,35 @@ const DBImgInfoList DBManager::getInfosByAlbum(int UID, bool needTimeData, ItemT
 
 int DBManager::getItemsCountByAlbum(int UID, const ItemType &type) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     int count = 0;
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
-    bool b = m_query->prepare("SELECT i.FileType "
-                              "FROM ImageTable3 AS i, AlbumTable3 AS a "
-                              "WHERE i.PathHash=a.PathHash "
-                              "AND a.UID=:UID ");
+    //与 getInfosByAlbum 一致按路径去重，在数据库中计数而不取出全部数据
+    QString fileTypeQuery;
+    if (type == ItemTypePic || type == ItemTypeVideo) {
+        fileTypeQuery = "AND i.FileType=:Type";
+    }
+    bool b = m_query->prepare(QString("SELECT COUNT(DISTINCT i.FilePath) "
+                                      "FROM AlbumTable3 AS a, ImageTable3 AS i "
+                                      "WHERE a.UID=:UID "
+                                      "AND i.PathHash=a.PathHash %1").arg(fileTypeQuery));
     m_query->bindValue(":UID", UID);
-    if (!b || ! m_query->exec()) {
-        //    qWarning() << "Get ImgInfo by album failed: " << query.lastError();
-    } else {
-        while (m_query->next()) {
-            ItemType itemType = static_cast<ItemType>(m_query->value(0).toInt());
-            if (type == ItemTypeNull || itemType == type) {
-                count++;
-            }
-        }
+    if (!fileTypeQuery.isEmpty()) {
+        m_query->bindValue(":Type", type);
+    }
+    if (!b || !m_query->exec()) {
+        qWarning() << "Get items count by album failed: " << m_query->lastError();
+    } else if (m_query->next()) {
+        count = m_query->value(0).toInt();
     }
-    qDebug() << __FUNCTION__ << "---count = " << count;
     return count;
 }
 
 //判断是否所有要查询的数据都在要查询的相册中
 bool DBManager::isAllImgExistInAlbum(int UID, const QStringList &paths, AlbumDBType atype) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     QString sql("SELECT COUNT(*) FROM AlbumTable3 WHERE PathHash In ( %1 ) AND UID = :UID AND AlbumDBType =:atype ");
@@ -679,6 +961,7 @@ bool DBManager::isAllImgExistInAlbum(int UID, const QStringList &paths, AlbumDBT
 
 bool DBManager::isImgExistInAlbum(int UID, const QString &path) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     bool b = m_query->prepare("SELECT COUNT(*) FROM AlbumTable3 WHERE PathHash = :hash "
@@ -698,6 +981,7 @@ bool DBManager::isImgExistInAlbum(int UID, const QString &path) const
 
 void DBManager::addCustomAlbumIdByPaths(int UID, const QStringList &paths)
 {
+    ALBUM_METRICS_FUNCTION("db");
     //记录每个图片下关联的相册ID
     QMap<QString, QStringList> path2UidList;
     for (const auto &path : paths) {
@@ -742,6 +1026,7 @@ void DBManager::addCustomAlbumIdByPaths(int UID, const QStringList &paths)
 
 void DBManager::removeCustomAlbumIdByPaths(int UID, const QStringList &paths)
 {
+    ALBUM_METRICS_FUNCTION("db");
     //记录每个图片下关联的相册ID
     QMap<QString, QStringList> path2UidList;
     for (const auto &path : paths) {
@@ -785,6 +1070,7 @@ void DBManager::removeCustomAlbumIdByPaths(int UID, const QStringList &paths)
 
 QString DBManager::getAlbumNameFromUID(int UID) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     bool b = m_query->exec(QString("SELECT DISTINCT AlbumName FROM AlbumTable3 WHERE UID=%1").arg(UID));
@@ -797,6 +1083,7 @@ QString DBManager::getAlbumNameFromUID(int UID) const
 
 AlbumDBType DBManager::getAlbumDBTypeFromUID(int UID) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     bool b = m_query->exec(QString("SELECT DISTINCT AlbumDBType FROM AlbumTable3 WHERE UID=%1").arg(UID));
@@ -809,6 +1096,7 @@ AlbumDBType DBManager::getAlbumDBTypeFromUID(int UID) const
 
 bool DBManager::isAlbumExistInDB(int UID, AlbumDBType atype) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     bool b = m_query->prepare("SELECT COUNT(*) FROM AlbumTable3 WHERE UID = :UID AND AlbumDBType =:atype");
@@ -827,6 +1115,7 @@ bool DBManager::isAlbumExistInDB(int UID, AlbumDBType atype) const
 
 int DBManager::createAlbum(const QString &album, const QStringList &paths, AlbumDBType atype)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     int currentUID = albumMaxUID++;
     QStringList pathHashs;
@@ -867,6 +1156,7 @@ int DBManager::createAlbum(const QString &album, const QStringList &paths, Album
 
 bool DBManager::insertIntoAlbum(int UID, const QStringList &paths, AlbumDBType atype)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
 
@@ -917,6 +1207,7 @@ bool DBManager::insertIntoAlbum(int UID, const QStringList &paths, AlbumDBType a
 
 void DBManager::removeAlbum(int UID)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     if (!m_query->exec(QString("DELETE FROM AlbumTable3 WHERE UID=") + QString::number(UID))) {
     }
@@ -924,6 +1215,7 @@ void DBManager::removeAlbum(int UID)
 
 void DBManager::removeFromAlbum(int UID, const QStringList &paths, AlbumDBType atype)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
 
     QStringList pathHashs;
@@ -954,6 +1246,7 @@ void DBManager::removeFromAlbum(int UID, const QStringList &paths, AlbumDBType a
 
 bool DBManager::renameAlbum(int UID, const QString &newAlbum, AlbumDBType atype)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     if (!m_query->exec(QString("UPDATE AlbumTable3 SET AlbumName=\"%1\" WHERE UID=%2 AND AlbumDBType=%3").arg(newAlbum).arg(UID).arg(atype))) {
         return false;
@@ -990,6 +1283,7 @@ const DBImgInfoList DBManager::getInfosByNameTimeline(const QString &value) cons
 
 const DBImgInfoList DBManager::getInfosForKeyword(const QString &keywords) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     const DBImgInfoList list = getInfosByNameTimeline(keywords);
     if (list.count() < 1) {
         return DBImgInfoList();
@@ -1000,6 +1294,7 @@ const DBImgInfoList DBManager::getInfosForKeyword(const QString &keywords) const
 
 const DBImgInfoList DBManager::getTrashInfosForKeyword(const QString &keywords) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     DBImgInfoList infos;
     m_query->setForwardOnly(true);
@@ -1027,6 +1322,7 @@ const DBImgInfoList DBManager::getTrashInfosForKeyword(const QString &keywords)
 
 const DBImgInfoList DBManager::getInfosForKeyword(int UID, const QString &keywords) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
 
     DBImgInfoList infos;
@@ -1056,6 +1352,7 @@ const DBImgInfoList DBManager::getInfosForKeyword(int UID, const QString &keywor
 
 bool DBManager::updateImgPath(const QString &oldPath, const QString &newPath)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QString oldHash = LibUnionImage_NameSpace::hashByString(oldPath);
     QString newHash = LibUnionImage_NameSpace::hashByString(newPath);
 
@@ -1105,6 +1402,7 @@ bool DBManager::updateImgPath(const QString &oldPath, const QString &newPath)
 
 const QMultiMap<QString, QString> DBManager::getAllPathAlbumNames() const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
 
     QMultiMap<QString, QString> infos;
@@ -1167,6 +1465,7 @@ const DBImgInfoList DBManager::getImgInfos(const QString &key, const QString &va
 
 bool DBManager::checkCustomAutoImportPathIsNotified(const QString &path)
 {
+    ALBUM_METRICS_FUNCTION("db");
     //检查是否是默认路径，这一段不涉及数据库操作，不需要加锁
     auto defaultPath = getDefaultNotifyPaths();
     auto pathsList = std::get<0>(defaultPath);
@@ -1207,6 +1506,7 @@ bool DBManager::checkCustomAutoImportPathIsNotified(const QString &path)
 
 int DBManager::createNewCustomAutoImportPath(const QString &path, const QString &albumName)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
 
     //1.新建相册
@@ -1229,6 +1529,7 @@ int DBManager::createNewCustomAutoImportPath(const QString &path, const QString
 
 void DBManager::removeCustomAutoImportPath(int UID)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
 
@@ -1299,6 +1600,7 @@ void DBManager::removeCustomAutoImportPath(int UID)
 
 QMap <int, QString> DBManager::getAllCustomAutoImportUIDAndPath()
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMap <int, QString> result;
 
     QMutexLocker mutex(&m_dbMutex);
@@ -1317,6 +1619,7 @@ QMap <int, QString> DBManager::getAllCustomAutoImportUIDAndPath()
 
 QStringList DBManager::getAllCustomAutoImportNames()
 {
+    ALBUM_METRICS_FUNCTION("db");
     QStringList result;
 
     QMutexLocker mutex(&m_dbMutex);
@@ -1349,6 +1652,11 @@ void DBManager::checkDatabase()
     }
     m_query = new QSqlQuery(db);
 
+    // WAL 模式下只读连接的快照读取不阻塞写入，写入也不阻塞读取；该模式保存在数据库文件中
+    if (!m_query->exec("PRAGMA journal_mode=WAL")) {
+        qWarning() << "Enable WAL failed:" << m_query->lastError();
+    }
+
     // 创建Table的语句都是加了IF NOT EXISTS的，直接运行就可以了
     // 注释里面的是实际我们希望的类型，而下面的SQL语句是SQLite3接受的类型
 
@@ -1368,6 +1676,7 @@ void DBManager::checkDatabase()
                                    "FileType INTEGER, "
                                    "DataHash TEXT, "
                                    "UID TEXT, "
+                                   "PerceptualHash INTEGER, "
                                    "primary key(PathHash, UID))"));
     if (!b) {
         qDebug() << "b CREATE TABLE exec failed.";
@@ -1420,6 +1729,21 @@ void DBManager::checkDatabase()
         qDebug() << "d CREATE TABLE exec failed.";
     }
 
+    // FileTypeTable
+    //////////////////////////////////////////////////////////////////////////////////////
+    //FilePath            | ModifyTime | FileSize | Known   | Flags   | ImageType         //
+    //TEXT primari key    | INTEGER    | INTEGER  | INTEGER | INTEGER | INTEGER           //
+    //////////////////////////////////////////////////////////////////////////////////////
+    if (!m_query->exec(QString("CREATE TABLE IF NOT EXISTS FileTypeTable ( "
+                               "FilePath TEXT primary key, "
+                               "ModifyTime INTEGER, "
+                               "FileSize INTEGER, "
+                               "Known INTEGER, "
+                               "Flags INTEGER, "
+                               "ImageType INTEGER)"))) {
+        qDebug() << "FileTypeTable CREATE TABLE exec failed.";
+    }
+
     // 判断ImageTable3中是否有ChangeTime字段
     QString strSqlImage = QString::fromLocal8Bit("select sql from sqlite_master where name = \"ImageTable3\" and sql like \"%ChangeTime%\"");
     bool q = m_query->exec(strSqlImage);
@@ -1482,6 +1806,17 @@ void DBManager::checkDatabase()
         }
     }
 
+    // 判断ImageTable3中是否有PerceptualHash字段，根据图片内容产生的感知哈希，为空表示尚未计算
+    QString strPerceptualHash = QString::fromLocal8Bit(
+                                    "select * from sqlite_master where name = 'ImageTable3' and sql like '%PerceptualHash%'");
+    if (m_query->exec(strPerceptualHash)) {
+        if (!m_query->next()) {
+            if (m_query->exec(QString("ALTER TABLE \"ImageTable3\" ADD COLUMN \"PerceptualHash\" INTEGER"))) {
+                qDebug() << "add PerceptualHash success";
+            }
+        }
+    }
+
     // 判断AlbumTable3中是否有AlbumDBType字段
     QString strSqlDBType = QString::fromLocal8Bit("select * from sqlite_master where name = \"AlbumTable3\" and sql like \"%AlbumDBType%\"");
     if (m_query->exec(strSqlDBType) && !m_query->next()) {
@@ -1626,9 +1961,42 @@ void DBManager::checkDatabase()
     if (!m_query->exec("CREATE INDEX IF NOT EXISTS image_hash_uid_index ON ImageTable3 (PathHash, UID)")) {
     }
 
+    //insertImgInfos 的 UPSERT 需要 (PathHash, UID) 唯一约束，旧版本数据库中的表可能没有，去重后补建唯一索引
+    if (m_query->exec("SELECT COUNT(*) FROM pragma_index_list('ImageTable3') WHERE \"unique\" = 1") && m_query->next()
+            && m_query->value(0).toInt() == 0) {
+        if (!m_query->exec("DELETE FROM ImageTable3 WHERE rowid NOT IN "
+                           "(SELECT MAX(rowid) FROM ImageTable3 GROUP BY PathHash, UID)")) {
+            qWarning() << "Remove duplicate image rows failed:" << m_query->lastError();
+        }
+        if (!m_query->exec("CREATE UNIQUE INDEX IF NOT EXISTS image_hash_uid_unique_index ON ImageTable3 (PathHash, UID)")) {
+            qWarning() << "Create image unique index failed:" << m_query->lastError();
+        }
+    }
+
     if (!m_query->exec("CREATE INDEX IF NOT EXISTS trash_hash_index ON TrashTable3 (PathHash)")) {
     }
 
+    if (!m_query->exec("CREATE INDEX IF NOT EXISTS image_datahash_index ON ImageTable3 (DataHash)")) {
+    }
+
+    //设备导入时按文件名查找图库中尚未计算内容hash的文件
+    if (!m_query->exec("CREATE INDEX IF NOT EXISTS image_filename_index ON ImageTable3 (FileName)")) {
+    }
+
+    //年、月聚合按拍摄时间范围查询
+    if (!m_query->exec("CREATE INDEX IF NOT EXISTS image_time_index ON ImageTable3 (Time)")) {
+    }
+
+    //按类型、相册计数
+    if (!m_query->exec("CREATE INDEX IF NOT EXISTS image_filetype_index ON ImageTable3 (FileType)")) {
+    }
+
+    if (!m_query->exec("CREATE INDEX IF NOT EXISTS trash_filetype_index ON TrashTable3 (FileType)")) {
+    }
+
+    if (!m_query->exec("CREATE INDEX IF NOT EXISTS album_uid_hash_index ON AlbumTable3 (UID, PathHash)")) {
+    }
+
     //新版删除需求的数据表策略
     //1.沿用老版的TrashTable3表，不做任何改变
     //2.PathHash作为存放在deepin-album-delete下的文件名，但是为了方便用户维修电脑，把原始文件名带在后面
@@ -1740,6 +2108,7 @@ void DBManager::insertSpUID(const QString &albumName, AlbumDBType astype, SpUID
 
 const DBImgInfoList DBManager::getAllTrashInfos(bool needTimeData) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     DBImgInfoList infos;
     m_query->setForwardOnly(true);
@@ -1785,6 +2154,7 @@ const DBImgInfoList DBManager::getAllTrashInfos(bool needTimeData) const
 
 const DBImgInfoList DBManager::getAllTrashInfos_getRemainDays() const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     DBImgInfoList infos;
     m_query->setForwardOnly(true);
@@ -1810,6 +2180,7 @@ const DBImgInfoList DBManager::getAllTrashInfos_getRemainDays() const
 
 void DBManager::insertTrashImgInfos(const DBImgInfoList &infos, bool showWaitDialog)
 {
+    ALBUM_METRICS_FUNCTION("db");
     if (infos.isEmpty()) {
         return;
     }
@@ -1889,6 +2260,7 @@ void DBManager::insertTrashImgInfos(const DBImgInfoList &infos, bool showWaitDia
     if (!m_query->exec("COMMIT")) {
         qDebug() << "COMMIT failed.";
     }
+    ++m_trashRevision;
 
     mutex.unlock();
 
@@ -1898,6 +2270,7 @@ void DBManager::insertTrashImgInfos(const DBImgInfoList &infos, bool showWaitDia
 
 void DBManager::removeTrashImgInfos(const QStringList &paths)
 {
+    ALBUM_METRICS_FUNCTION("db");
     if (paths.isEmpty()) {
         return;
     }
@@ -1927,6 +2300,7 @@ void DBManager::removeTrashImgInfos(const QStringList &paths)
     if (!m_query->exec("COMMIT")) {
 //            qDebug() << "COMMIT failed.";
     }
+    ++m_trashRevision;
 
     //删除deepin-album-delete下的缓存文件
     for (int i = 0; i != paths.size(); ++i) {
@@ -1940,6 +2314,7 @@ void DBManager::removeTrashImgInfos(const QStringList &paths)
 
 QStringList DBManager::recoveryImgFromTrash(const QStringList &paths)
 {
+    ALBUM_METRICS_FUNCTION("db");
     if (paths.isEmpty()) {
         return QStringList();
     }
@@ -2101,6 +2476,7 @@ QStringList DBManager::recoveryImgFromTrash(const QStringList &paths)
         }
         if (!m_query->exec("COMMIT")) {
         }
+        ++m_trashRevision;
 
         //恢复前对数据拆分
         DBImgInfoList recoverInfos;
@@ -2176,6 +2552,7 @@ QStringList DBManager::recoveryImgFromTrash(const QStringList &paths)
 
 void DBManager::removeTrashImgInfosNoSignal(const QStringList &paths)
 {
+    ALBUM_METRICS_FUNCTION("db");
     if (paths.isEmpty()) {
         return;
     }
@@ -2188,7 +2565,7 @@ void DBManager::removeTrashImgInfosNoSignal(const QStringList &paths)
         pathHashs << LibUnionImage_NameSpace::hashByString(path);
     }
 
-    //从AlbumTable3删除
+    //从AlbumTable3及TrashTable3删除，在同一个事务中完成
     m_query->setForwardOnly(true);
     if (!m_query->exec("BEGIN IMMEDIATE TRANSACTION")) {
 //        qDebug() << "begin transaction failed.";
@@ -2201,14 +2578,7 @@ void DBManager::removeTrashImgInfosNoSignal(const QStringList &paths)
         if (!m_query->exec()) {
         }
     }
-    if (!m_query->exec("COMMIT")) {
-//        qDebug() << "COMMIT failed.";
-    }
 
-    //从TrashTable3删除
-    if (!m_query->exec("BEGIN IMMEDIATE TRANSACTION")) {
-//        qDebug() << "begin transaction failed.";
-    }
     qs = "DELETE FROM TrashTable3 WHERE PathHash=:hash";
     if (!m_query->prepare(qs)) {
     }
@@ -2220,6 +2590,7 @@ void DBManager::removeTrashImgInfosNoSignal(const QStringList &paths)
     if (!m_query->exec("COMMIT")) {
 //        qDebug() << "COMMIT failed.";
     }
+    ++m_trashRevision;
 
     //删除deepin-album-delete下的缓存文件
     for (int i = 0; i != paths.size(); ++i) {
@@ -2230,6 +2601,7 @@ void DBManager::removeTrashImgInfosNoSignal(const QStringList &paths)
 
 const DBImgInfo DBManager::getTrashInfoByPath(const QString &path) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     DBImgInfoList list = getTrashImgInfos("FilePath", path);
     if (list.count() != 1) {
         return DBImgInfo();
@@ -2240,6 +2612,7 @@ const DBImgInfo DBManager::getTrashInfoByPath(const QString &path) const
 
 const DBImgInfoList DBManager::getTrashImgInfos(const QString &key, const QString &value) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     DBImgInfoList infos;
     m_query->setForwardOnly(true);
@@ -2267,20 +2640,27 @@ const DBImgInfoList DBManager::getTrashImgInfos(const QString &key, const QStrin
     return infos;
 }
 
-int DBManager::getTrashImgsCount() const
+int DBManager::getTrashImgsCount(const ItemType &filterType) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
-    if (m_query->exec("SELECT COUNT(*) FROM TrashTable3")) {
-        m_query->first();
-        int count = m_query->value(0).toInt();
-        return count;
+    bool b = false;
+    if (filterType == ItemTypePic || filterType == ItemTypeVideo) {
+        b = m_query->prepare("SELECT COUNT(*) FROM TrashTable3 WHERE FileType = :Type");
+        m_query->bindValue(":Type", filterType);
+    } else {
+        b = m_query->prepare("SELECT COUNT(*) FROM TrashTable3");
+    }
+    if (b && m_query->exec() && m_query->next()) {
+        return m_query->value(0).toInt();
     }
     return 0;
 }
 
 int DBManager::getAlbumImgsCount(int UID) const
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     if (m_query->exec(QString("SELECT COUNT(*) FROM AlbumTable3 WHERE UID=%1 AND PathHash<>\"%2\"")
@@ -2294,6 +2674,7 @@ int DBManager::getAlbumImgsCount(int UID) const
 
 QDateTime DBManager::getFileImportTime(const QString &path)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     QDateTime result;
@@ -2306,6 +2687,7 @@ QDateTime DBManager::getFileImportTime(const QString &path)
 
 QStringList DBManager::getYearPaths(const QString &year, int maxCount)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     QStringList result;
@@ -2320,6 +2702,7 @@ QStringList DBManager::getYearPaths(const QString &year, int maxCount)
 
 QStringList DBManager::getYears()
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     QStringList result;
@@ -2334,6 +2717,7 @@ QStringList DBManager::getYears()
 
 int DBManager::getYearCount(const QString &year)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     int result = 0;
@@ -2345,8 +2729,26 @@ int DBManager::getYearCount(const QString &year)
     return result;
 }
 
+/**
+ * @brief 年聚合内容版本：图片数量、最近导入时间及最近修改时间，任一变化即认为该年的图片有增删或变更，
+ *      用于判断缓存的年视图封面是否失效
+ */
+QString DBManager::getYearVersion(const QString &year)
+{
+    ALBUM_METRICS_FUNCTION("db");
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    QString result;
+    QString str = QString("SELECT COUNT(*), MAX(ImportTime), MAX(ChangeTime) FROM ImageTable3 WHERE Time between \"%1-01-01T00:00:00.000\" AND \"%1-12-31T23:59:59.999\"").arg(year);
+    if (m_query->exec(str) && m_query->first()) {
+        result = QString("%1/%2/%3").arg(m_query->value(0).toInt()).arg(m_query->value(1).toString()).arg(m_query->value(2).toString());
+    }
+    return result;
+}
+
 QStringList DBManager::getMonthPaths(const QString &year, const QString &month, int maxCount)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     QStringList result;
@@ -2361,6 +2763,7 @@ QStringList DBManager::getMonthPaths(const QString &year, const QString &month,
 
 QStringList DBManager::getMonths()
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     QStringList result;
@@ -2375,6 +2778,7 @@ QStringList DBManager::getMonths()
 
 int DBManager::getMonthCount(const QString &year, const QString &month)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     int result = 0;
@@ -2388,6 +2792,7 @@ int DBManager::getMonthCount(const QString &year, const QString &month)
 
 DBImgInfoList DBManager::getInfosByDay(const QString &day)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     DBImgInfoList infos;
@@ -2409,6 +2814,7 @@ DBImgInfoList DBManager::getInfosByDay(const QString &day)
 
 QStringList DBManager::getDayPaths(const QString &day)
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     QStringList result;
@@ -2421,8 +2827,34 @@ QStringList DBManager::getDayPaths(const QString &day)
     return result;
 }
 
+/**
+ * @brief 指定日期的数量，ItemTypeNull 为全部。
+ *      时间以 "yyyy-MM-ddTHH:mm:ss" 格式存储，按范围查询以使用 Time 索引
+ */
+int DBManager::getDayCount(const QString &day, const ItemType &filterType)
+{
+    ALBUM_METRICS_FUNCTION("db");
+    QMutexLocker mutex(&m_dbMutex);
+    m_query->setForwardOnly(true);
+    QString fileTypeQuery;
+    if (filterType == ItemTypePic || filterType == ItemTypeVideo) {
+        fileTypeQuery = "AND FileType = :Type";
+    }
+    bool b = m_query->prepare(QString("SELECT COUNT(*) FROM ImageTable3 WHERE Time >= :Begin AND Time < :End %1").arg(fileTypeQuery));
+    m_query->bindValue(":Begin", day + "T");
+    m_query->bindValue(":End", day + "U");
+    if (!fileTypeQuery.isEmpty()) {
+        m_query->bindValue(":Type", filterType);
+    }
+    if (b && m_query->exec() && m_query->next()) {
+        return m_query->value(0).toInt();
+    }
+    return 0;
+}
+
 QStringList DBManager::getDays()
 {
+    ALBUM_METRICS_FUNCTION("db");
     QMutexLocker mutex(&m_dbMutex);
     m_query->setForwardOnly(true);
     QStringList result;
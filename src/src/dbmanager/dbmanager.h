@@ -27,6 +27,7 @@
 #include <mutex>
 #include <QReadWriteLock>
 #include "unionimage/unionimage_global.h"
+#include "unionimage/filetypecache.h"
 //#include "connectionpool.h"
 
 
@@ -89,6 +90,12 @@ public:
     const DBImgInfoList     getTrashInfosForKeyword(const QString &keywords) const;
     const DBImgInfoList     getInfosForKeyword(int UID, const QString &keywords) const;
     bool                    updateImgPath(const QString &oldPath, const QString &newPath);
+    //根据文件内容hash查找已导入的文件路径，不存在时返回空
+    const QString           getPathByDataHash(const QString &dataHash) const;
+    //根据文件名查找尚未记录内容hash的文件路径(非设备导入途径加入图库的文件)
+    const QStringList       getUnhashedPathsByFileName(const QString &fileName) const;
+    //补记文件内容hash
+    void                    updateDataHash(const QString &path, const QString &dataHash);
 
     //CustomAutoImportPathTable
     //检查当前的自定义自动导入路径是否已经被监控，检查内容包括是否是子文件夹和是否是默认导入路径
@@ -139,7 +146,9 @@ public:
     void                    removeTrashImgInfosNoSignal(const QStringList &paths);
     const DBImgInfo         getTrashInfoByPath(const QString &path) const;
     const DBImgInfoList     getTrashImgInfos(const QString &key, const QString &value) const;
-    int                     getTrashImgsCount() const;
+    int                     getTrashImgsCount(const ItemType &filterType = ItemTypeNull) const;
+    //回收站数据的修改次数，用于判断缓存的回收站数据是否失效
+    int                     trashRevision() const { return m_trashRevision; }
     int                     getAlbumImgsCount(int UID) const;
     QDateTime               getFileImportTime(const QString &path);
 
@@ -147,6 +156,7 @@ public:
     QStringList             getYearPaths(const QString &year, int maxCount);
     QStringList             getYears();
     int                     getYearCount(const QString &year);
+    QString                 getYearVersion(const QString &year);
     //月聚合数据
     QStringList             getMonthPaths(const QString &year, const QString &month, int maxCount);
     QStringList             getMonths();
@@ -154,7 +164,19 @@ public:
     //日聚合数据
     DBImgInfoList           getInfosByDay(const QString &day);
     QStringList             getDayPaths(const QString &day);
+    int                     getDayCount(const QString &day, const ItemType &filterType = ItemTypeNull);
     QStringList             getDays();
+    //文件类型判断缓存
+    const QList<LibUnionImage_NameSpace::FileTypeRecord> getFileTypeRecords() const;
+    void                    insertFileTypeRecords(const QList<LibUnionImage_NameSpace::FileTypeRecord> &records);
+    void                    removeFileTypeRecords(const QStringList &paths);
+    //感知哈希，用于查找相似图片
+    const QList<QPair<QString, quint64>> getPerceptualHashes() const;
+    const QStringList       getPathsWithoutPerceptualHash() const;
+    void                    updatePerceptualHashes(const QList<QPair<QString, quint64>> &hashes);
+    void                    clearPerceptualHashes(const QStringList &paths);
+    //按导入时间从新到旧排列的文件路径及导入时间，用于后台生成缩略图
+    const QList<QPair<QString, QString>> getPathsByImportTime() const;
 private:
     const DBImgInfoList     getInfosByNameTimeline(const QString &value) const;
     const DBImgInfoList     getImgInfos(const QString &key, const QString &value, bool needTimeData) const;
@@ -168,6 +190,7 @@ private:
     mutable QMutex m_dbMutex; //数据库锁，用于锁定Sqlite数据库的操作权限
     mutable QSqlQuery *m_query; //将数据库查询对象统一到类成员变量，以尝试解决sqlite崩溃问题
     std::atomic_int albumMaxUID; //当前数据库中UID的最大值，用于新建UID用
+    std::atomic_int m_trashRevision{0}; //回收站数据的修改次数
 
     //数据库相关路径
     QString DATABASE_PATH = "";
@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "dbmanagerasync.h"
+#include "utils/metrics.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+DBManagerAsync::DBManagerAsync(QObject *parent)
+    : QObject(parent)
+{
+    // 单线程且不回收，所有任务都在同一个线程中执行
+    m_pool.setMaxThreadCount(1);
+    m_pool.setExpiryTimeout(-1);
+    m_pool.setObjectName("DBManagerAsync");
+
+    if (qApp) {
+        // 退出时写完已提交的数据
+        connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+            sealPendingWrites();
+            m_pool.waitForDone();
+        });
+    }
+}
+
+DBManagerAsync *DBManagerAsync::instance()
+{
+    // 不释放，退出过程中仍可能有操作提交
+    static DBManagerAsync *ins = new DBManagerAsync;
+    return ins;
+}
+
+QFuture<void> DBManagerAsync::insertImgInfos(const DBImgInfoList &infos)
+{
+    WriteOp op;
+    op.kind = InsertImgInfos;
+    op.infos = infos;
+    return enqueueWrite(std::move(op));
+}
+
+QFuture<void> DBManagerAsync::insertIntoAlbum(int UID, const QStringList &paths, AlbumDBType atype)
+{
+    WriteOp op;
+    op.kind = InsertIntoAlbum;
+    op.UID = UID;
+    op.atype = atype;
+    op.paths = paths;
+    return enqueueWrite(std::move(op));
+}
+
+QFuture<void> DBManagerAsync::removeImgInfos(const QStringList &paths)
+{
+    WriteOp op;
+    op.kind = RemoveImgInfos;
+    op.paths = paths;
+    return enqueueWrite(std::move(op));
+}
+
+QFuture<void> DBManagerAsync::flush()
+{
+    return run([](DBManager *) {});
+}
+
+bool DBManagerAsync::waitForDone(int msecs)
+{
+    return m_pool.waitForDone(msecs);
+}
+
+/**
+ * @brief 将写操作加入待写批次，批次中已有可合并的操作时直接合并。
+ *      插入 ImageTable3 与插入 AlbumTable3 互不影响，可以越过彼此合并；
+ *      删除操作同时涉及两张表，作为合并的边界
+ */
+QFuture<void> DBManagerAsync::enqueueWrite(WriteOp &&op)
+{
+    if (op.infos.isEmpty() && op.paths.isEmpty()) {
+        QPromise<void> promise;
+        promise.start();
+        promise.finish();
+        return promise.future();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    bool newBatch = !m_openBatch;
+    if (newBatch) {
+        m_openBatch = std::make_shared<WriteBatch>();
+    }
+
+    QList<WriteOp> &ops = m_openBatch->ops;
+    for (int i = ops.size() - 1; i >= 0; --i) {
+        WriteOp &pending = ops[i];
+        bool sameTarget = pending.kind == op.kind && pending.UID == op.UID && pending.atype == op.atype;
+        if (sameTarget && (RemoveImgInfos != op.kind || i == ops.size() - 1)) {
+            pending.infos += op.infos;
+            pending.paths += op.paths;
+            ALBUM_METRICS_COUNT("db.async.merged", 1);
+            return pending.promise->future();
+        }
+        if (RemoveImgInfos == pending.kind || RemoveImgInfos == op.kind) {
+            break;
+        }
+    }
+
+    op.promise = std::make_shared<QPromise<void>>();
+    op.promise->start();
+    QFuture<void> future = op.promise->future();
+    ops << std::move(op);
+
+    if (newBatch) {
+        std::shared_ptr<WriteBatch> batch = m_openBatch;
+        QtConcurrent::run(&m_pool, [this, batch]() {
+            applyBatch(batch);
+        });
+    }
+    return future;
+}
+
+/**
+ * @brief 结束当前批次的合并，之后的写操作进入新的批次，保证读取与写入按提交顺序执行
+ */
+void DBManagerAsync::sealPendingWrites()
+{
+    QMutexLocker locker(&m_mutex);
+    m_openBatch.reset();
+}
+
+void DBManagerAsync::applyBatch(const std::shared_ptr<WriteBatch> &batch)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_openBatch == batch) {
+            m_openBatch.reset();
+        }
+    }
+
+    ALBUM_METRICS_SCOPE("db.async.batch");
+    DBManager *db = DBManager::instance();
+    for (const WriteOp &op : batch->ops) {
+        switch (op.kind) {
+        case InsertImgInfos:
+            db->insertImgInfos(op.infos);
+            break;
+        case InsertIntoAlbum:
+            db->insertIntoAlbum(op.UID, op.paths, op.atype);
+            break;
+        case RemoveImgInfos:
+            db->removeImgInfos(op.paths);
+            break;
+        }
+        op.promise->finish();
+    }
+}
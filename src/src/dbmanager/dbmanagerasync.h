@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DBMANAGERASYNC_H
+#define DBMANAGERASYNC_H
+
+#include "dbmanager.h"
+
+#include <QFuture>
+#include <QMutex>
+#include <QObject>
+#include <QPromise>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <memory>
+#include <type_traits>
+
+/**
+ * @brief DBManager 的异步接口，数据库操作在独立的数据库线程中依次执行，调用方通过 QFuture 获取结果
+ * @details 写操作先进入待写队列，数据库线程忙碌期间提交的相邻写操作会被合并，
+ *      相同类型(及相同相册)的写入合并为一次 DBManager 调用，即一个事务。
+ *      run()/submit()/call() 与写操作按提交顺序执行：之前提交的写操作已全部完成，之后提交的写操作尚未开始。
+ *
+ *      图片表、相册表、回收站表及自动导入路径的写入都必须经由本接口，
+ *      否则直接写入可能越过尚未执行的异步写入，导致先删除后插入的数据被后执行的删除覆盖。
+ *      界面线程中的写入使用 submit()，在返回的 QFuture 上通过 .then(context, ...) 刷新界面；
+ *      call() 会阻塞调用线程，只用于工作线程，以及 QML 需要在调用返回时立即读取结果的接口。
+ *      以下写入仍直接调用 DBManager：文件类型缓存(FileTypeTable)与感知哈希(PerceptualHash 列)，
+ *      二者只在后台任务中写入，与上述写入不涉及相同的表或列，且结果丢失后会重新计算。
+ */
+class DBManagerAsync : public QObject
+{
+    Q_OBJECT
+public:
+    static DBManagerAsync *instance();
+
+    // 在数据库线程中执行 func(DBManager *)，返回其结果
+    template <typename Func>
+    auto run(Func func) -> QFuture<std::decay_t<std::invoke_result_t<Func, DBManager *>>>
+    {
+        sealPendingWrites();
+        return QtConcurrent::run(&m_pool, [func]() {
+            return func(DBManager::instance());
+        });
+    }
+
+    // 提交 func(DBManager *) 到数据库线程执行，不等待也不返回结果，返回的 QFuture 在执行完成后结束
+    template <typename Func>
+    QFuture<void> submit(Func func)
+    {
+        return run([func](DBManager *db) {
+            func(db);
+        });
+    }
+
+    // 在数据库线程中执行 func(DBManager *) 并等待其完成，返回其结果；不能在数据库线程中调用
+    template <typename Func>
+    auto call(Func func) -> std::decay_t<std::invoke_result_t<Func, DBManager *>>
+    {
+        auto future = run(func);
+        if constexpr (std::is_void_v<std::invoke_result_t<Func, DBManager *>>) {
+            future.waitForFinished();
+        } else {
+            return future.result();
+        }
+    }
+
+    // 合并写入，返回的 QFuture 在所在批次写入完成后结束，被合并的调用返回同一个 QFuture
+    QFuture<void> insertImgInfos(const DBImgInfoList &infos);
+    QFuture<void> insertIntoAlbum(int UID, const QStringList &paths, AlbumDBType atype = AlbumDBType::Custom);
+    QFuture<void> removeImgInfos(const QStringList &paths);
+
+    // 返回的 QFuture 在之前提交的全部操作完成后结束
+    QFuture<void> flush();
+    // 等待已提交的全部操作完成，msecs 小于0时一直等待
+    bool waitForDone(int msecs = -1);
+
+private:
+    explicit DBManagerAsync(QObject *parent = nullptr);
+
+    enum WriteKind {
+        InsertImgInfos,
+        InsertIntoAlbum,
+        RemoveImgInfos
+    };
+
+    struct WriteOp {
+        WriteKind kind;
+        int UID = -1;
+        AlbumDBType atype = AlbumDBType::Custom;
+        DBImgInfoList infos;
+        QStringList paths;
+        std::shared_ptr<QPromise<void>> promise;
+    };
+
+    struct WriteBatch {
+        QList<WriteOp> ops;
+    };
+
+    QFuture<void> enqueueWrite(WriteOp &&op);
+    void sealPendingWrites();
+    void applyBatch(const std::shared_ptr<WriteBatch> &batch);
+
+    QThreadPool m_pool;                             //仅含一个线程，即数据库线程
+    QMutex m_mutex;
+    std::shared_ptr<WriteBatch> m_openBatch;        //尚未开始写入、可继续合并的批次
+};
+
+#endif // DBMANAGERASYNC_H
@@ -0,0 +1,163 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "trashmaintainer.h"
+#include "dbmanager.h"
+#include "dbmanagerasync.h"
+#include "unionimage/baseutils.h"
+#include "utils/metrics.h"
+#include "utils/workscheduler.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+
+TrashMaintainer *TrashMaintainer::instance()
+{
+    static TrashMaintainer ins;
+    return &ins;
+}
+
+TrashMaintainer::TrashMaintainer(QObject *parent)
+    : QObject(parent)
+{
+}
+
+DBImgInfoList TrashMaintainer::infos()
+{
+    refreshIfStale();
+    QMutexLocker locker(&m_mutex);
+    return m_infos;
+}
+
+/**
+ * @brief 回收站数量。缓存有效时返回维护后的数量；缓存失效时在后台重新维护，
+ *      本次直接按类型索引计数(可能包含副本已丢失或已过期的项目)，反映最近的写入，维护完成后 changed() 通知刷新
+ */
+int TrashMaintainer::count(ItemType type)
+{
+    QMutexLocker locker(&m_mutex);
+    if (isStale()) {
+        locker.unlock();
+        refreshAsync();
+        return DBManager::instance()->getTrashImgsCount(type);
+    }
+
+    if (ItemTypePic == type) {
+        return m_picCount;
+    } else if (ItemTypeVideo == type) {
+        return m_videoCount;
+    }
+    return m_infos.size();
+}
+
+void TrashMaintainer::refreshAsync()
+{
+    bool expected = false;
+    if (!m_refreshing.compare_exchange_strong(expected, true)) {
+        return;
+    }
+
+    WorkScheduler::instance()->submit(WorkScheduler::Background, [this]() {
+        refreshNow();
+        m_refreshing = false;
+        emit changed();
+    }, WorkCancelToken(), [this]() {
+        m_refreshing = false;
+    });
+}
+
+void TrashMaintainer::invalidate()
+{
+    QMutexLocker locker(&m_mutex);
+    m_revision = -1;
+}
+
+/**
+ * @brief 缓存失效时在后台重新维护，本次读取仍返回缓存的结果，维护完成后发出 changed() 通知界面刷新
+ */
+void TrashMaintainer::refreshIfStale()
+{
+    bool stale = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        stale = isStale();
+    }
+    if (stale) {
+        refreshAsync();
+    }
+}
+
+// 剩余天数按日期计算，日期变化后需要重新维护；回收站目录中的文件被外部删除时目录修改时间变化
+bool TrashMaintainer::isStale() const
+{
+    return m_revision != DBManager::instance()->trashRevision() || m_date != QDate::currentDate()
+           || m_dirModified != QFileInfo(albumGlobal::DELETE_PATH).lastModified();
+}
+
+/**
+ * @brief 维护回收站数据：回收站副本及原文件均不存在的项目不显示，超过保留期限的项目清理。
+ *      维护过程不持有 m_mutex ，读取方期间仍可获取旧的结果，完成后在锁内替换
+ */
+void TrashMaintainer::refreshNow()
+{
+    ALBUM_METRICS_SCOPE("trash.refresh");
+    QElapsedTimer timer;
+    timer.start();
+
+    //先记录目录修改时间及修改次数，扫描期间的变化在下次读取时重新维护
+    const QDateTime dirModified = QFileInfo(albumGlobal::DELETE_PATH).lastModified();
+    int revision = DBManager::instance()->trashRevision();
+    DBImgInfoList allInfos = DBManager::instance()->getAllTrashInfos_getRemainDays();
+
+    //一次扫描回收站目录，代替逐个判断文件是否存在
+    const QStringList names = QDir(albumGlobal::DELETE_PATH).entryList(QDir::Files | QDir::Hidden);
+    const QSet<QString> deleteFiles(names.begin(), names.end());
+    const int prefixSize = albumGlobal::DELETE_PATH.size() + 1;
+
+    DBImgInfoList infos;
+    QStringList expiredPaths;
+    int picCount = 0;
+    int videoCount = 0;
+    int missingCount = 0;
+    infos.reserve(allInfos.size());
+    for (const DBImgInfo &info : allInfos) {
+        const QString deleteName = Libutils::base::getDeleteFullPath(info.pathHash, info.getFileNameFromFilePath()).mid(prefixSize);
+        if (!deleteFiles.contains(deleteName) && !QFile::exists(info.filePath)) {
+            ++missingCount;
+        } else if (info.remainDays <= 0) {
+            expiredPaths << info.filePath;
+        } else {
+            infos << info;
+            if (ItemTypePic == info.itemType) {
+                ++picCount;
+            } else if (ItemTypeVideo == info.itemType) {
+                ++videoCount;
+            }
+        }
+    }
+
+    //清理删除时间过长图片
+    if (!expiredPaths.isEmpty()) {
+        DBManagerAsync::instance()->call([&](DBManager *db) { return db->removeTrashImgInfosNoSignal(expiredPaths); });
+        //清理本身修改一次，期间若有其他修改，记录的次数仍落后，下次读取时重新维护
+        ++revision;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_infos = infos;
+        m_picCount = picCount;
+        m_videoCount = videoCount;
+        m_revision = revision;
+        m_date = QDate::currentDate();
+        m_dirModified = dirModified;
+    }
+
+    qDebug() << QString("Trash maintained, items:%1 expired:%2 missing:%3 cost:%4ms")
+             .arg(infos.size()).arg(expiredPaths.size()).arg(missingCount).arg(timer.elapsed());
+}
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef TRASHMAINTAINER_H
+#define TRASHMAINTAINER_H
+
+#include "unionimage/unionimage_global.h"
+
+#include <QDate>
+#include <QDateTime>
+#include <QMutex>
+#include <QObject>
+
+#include <atomic>
+
+/**
+ * @brief 回收站数据维护及缓存
+ * @details 读取 TrashTable3 后一次扫描 deepin-album-delete 目录判断回收站副本是否存在，
+ *      副本不存在时才检查原文件；超过保留期限的项目在一个事务中清理。
+ *      结果及各类型数量缓存在内存中，回收站数据有修改、回收站目录有变化(如文件被外部删除)或日期变化时
+ *      在后台重新维护，完成后发出 changed()；回收站界面及数量始终直接返回缓存，读取不会等待维护。
+ *      启动后在后台维护一次。
+ */
+class TrashMaintainer : public QObject
+{
+    Q_OBJECT
+public:
+    static TrashMaintainer *instance();
+
+    // 有效的回收站项目，按删除时间从新到旧
+    DBImgInfoList infos();
+    // 指定类型的项目数量，ItemTypeNull 为全部；缓存失效时为数据库中的计数
+    int count(ItemType type);
+
+    // 在后台维护，完成后发出 changed()
+    void refreshAsync();
+    // 在调用线程中立即维护，不发出 changed()
+    void refreshNow();
+    // 使缓存失效，下次读取时在后台重新维护
+    void invalidate();
+
+signals:
+    // 后台维护完成，在工作线程中发出
+    void changed();
+
+private:
+    explicit TrashMaintainer(QObject *parent = nullptr);
+
+    void refreshIfStale();
+    // 需持有 m_mutex 调用
+    bool isStale() const;
+
+    QMutex m_mutex;
+    DBImgInfoList m_infos;
+    int m_picCount = 0;
+    int m_videoCount = 0;
+    int m_revision = -1;
+    QDate m_date;
+    QDateTime m_dirModified;    // 维护时回收站目录的修改时间
+    std::atomic_bool m_refreshing{false};
+};
+
+#endif // TRASHMAINTAINER_H
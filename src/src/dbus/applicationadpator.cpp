@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "applicationadpator.h"
+#include "../utils/metrics.h"
 
 #include <QUrl>
 
@@ -29,3 +30,21 @@ bool ApplicationAdaptor::openImageFile(const QString &fileName)
 
     return false;
 }
+
+/**
+ * @brief 获取性能指标快照，计数器为数值，直方图为包含 count/sum/max/p50/p90/p99 的字典
+ */
+QVariantMap ApplicationAdaptor::metricsSnapshot()
+{
+    return MetricsRegistry::instance()->snapshot();
+}
+
+QString ApplicationAdaptor::metricsDump()
+{
+    return MetricsRegistry::instance()->dumpText();
+}
+
+void ApplicationAdaptor::resetMetrics()
+{
+    MetricsRegistry::instance()->reset();
+}
@@ -18,6 +18,13 @@ class ApplicationAdaptor : public QDBusAbstractAdaptor
                 "    <method name=\"openImageFile\">\n"
                 "        <arg direction=\"in\" type=\"s\" name=\"fileName\"/>\n"
                 "    </method>\n"
+                "    <method name=\"metricsSnapshot\">\n"
+                "        <arg direction=\"out\" type=\"a{sv}\"/>\n"
+                "    </method>\n"
+                "    <method name=\"metricsDump\">\n"
+                "        <arg direction=\"out\" type=\"s\"/>\n"
+                "    </method>\n"
+                "    <method name=\"resetMetrics\"/>\n"
                 "</interface>\n")
 
 public:
@@ -26,6 +33,12 @@ public:
 public Q_SLOTS:
     // 打开图片文件
     bool openImageFile(const QString &fileName);
+    // 性能指标快照，直方图耗时单位为微秒
+    QVariantMap metricsSnapshot();
+    // 文本格式的性能指标快照
+    QString metricsDump();
+    // 清空已记录的性能指标
+    void resetMetrics();
 
 private:
     FileControl *fileControl = nullptr;
@@ -6,6 +6,7 @@
 #include "fileinotify.h"
 #include "unionimage/unionimage.h"
 #include "dbmanager/dbmanager.h"
+#include "dbmanager/dbmanagerasync.h"
 
 #include <sys/inotify.h>
 #include <dirent.h>
@@ -110,7 +111,7 @@ void FileInotify::getAllPicture(bool isFirst)
     }
 
     if (m_currentDirs.isEmpty()) { //文件夹被删除，清理数据库
-        DBManager::instance()->removeCustomAutoImportPath(m_currentUID);
+        DBManagerAsync::instance()->call([&](DBManager *db) { return db->removeCustomAutoImportPath(m_currentUID); });
         m_deleteFile = DBManager::instance()->getPathsByAlbum(m_currentUID);
         m_newFile.clear();
         emit pathDestroyed(m_currentUID);
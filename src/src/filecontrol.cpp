@@ -6,9 +6,12 @@
 #include "types.h"
 #include "unionimage/unionimage_global.h"
 #include "unionimage/unionimage.h"
+#include "unionimage/filetypecache.h"
 #include "printdialog/printhelper.h"
 #include "ocr/ocrinterface.h"
 #include "imagedata/imageinfo.h"
+#include "imagedata/multiframeindex.h"
+#include "utils/rotateimagehelper.h"
 
 #include <DSysInfo>
 
@@ -41,6 +44,8 @@ const QString SETTINGS_WINSIZE_W_KEY = "WindowWidth";
 const QString SETTINGS_WINSIZE_H_KEY = "WindowHeight";
 // 是否显示导航窗口
 const QString SETTINGS_ENABLE_NAVIGATION = "EnableNavigation";
+// JPEG 旋转时是否仅修改EXIF方向标记(无损旋转)
+const QString SETTINGS_EXIF_ROTATE = "ExifRotate";
 const int MAINWIDGET_MINIMUN_HEIGHT = 300;
 const int MAINWIDGET_MINIMUN_WIDTH = 658;
 
@@ -87,6 +92,7 @@ FileControl::FileControl(QObject *parent)
     m_ocrInterface = new OcrInterface("com.deepin.Ocr", "/com/deepin/Ocr", QDBusConnection::sessionBus(), this);
     m_shortcutViewProcess = new QProcess(this);
     m_config = LibConfigSetter::instance();
+    LibUnionImage_NameSpace::setExifRotateEnabled(m_config->value(SETTINGS_GROUP, SETTINGS_EXIF_ROTATE, true).toBool());
     imageFileWatcher = ImageFileWatcher::instance();
 
     QObject::connect(imageFileWatcher, &ImageFileWatcher::imageFileChanged, this, &FileControl::imageFileChanged);
@@ -109,15 +115,12 @@ FileControl::FileControl(QObject *parent)
                          << "tif"
                          << "tiff";
 
-    // 实时保存旋转后图片太卡，因此采用10ms后延时保存的问题
-    if (!m_tSaveImage) {
-        m_tSaveImage = new QTimer(this);
-        connect(m_tSaveImage, &QTimer::timeout, this, [ = ]() {
-            //保存旋转的图片
-            slotRotatePixCurrent();
-            emit callSavePicDone(QUrl::fromLocalFile(m_currentPath).toString());
-        });
-    }
+    // 旋转任务在线程池中处理，完成后通知相册刷新缩略图
+    connect(RotateImageHelper::instance(), &RotateImageHelper::rotateImageFinished, this, [this](const QString &path, bool ret) {
+        if (ret) {
+            emit callSavePicDone(QUrl::fromLocalFile(path).toString());
+        }
+    });
 }
 
 FileControl::~FileControl()
@@ -144,14 +147,20 @@ QStringList FileControl::getDirImagePath(const QString &path)
 
     // 修复Ｑt带后缀排序错误的问题
     std::sort(m_AllPath.begin(), m_AllPath.end(), compareByFileInfo);
+    QStringList allPaths;
     for (int i = 0; i < m_AllPath.size(); i++) {
         QString tmpPath = m_AllPath.at(i).filePath();
-        if (tmpPath.isEmpty()) {
-            continue;
+        if (!tmpPath.isEmpty()) {
+            allPaths << tmpPath;
         }
-        // 判断是否图片格式
-        if (isImage(tmpPath)) {
-            image_list << QUrl::fromLocalFile(tmpPath).toString();
+    }
+
+    // 批量并行判断是否图片格式，结果按文件变更缓存
+    const QList<bool> imageFlags = LibUnionImage_NameSpace::FileTypeCache::instance()->testFiles(
+                                       allPaths, LibUnionImage_NameSpace::FileTypeCache::Image);
+    for (int i = 0; i < allPaths.size(); i++) {
+        if (imageFlags.at(i)) {
+            image_list << QUrl::fromLocalFile(allPaths.at(i)).toString();
         }
     }
     return image_list;
@@ -437,9 +446,7 @@ void FileControl::ocrImage(const QString &path, int index)
     if (Types::MultiImage != info.type()) {  // 非多页图使用路径直接进行识别
         m_ocrInterface->openFile(localPath);
     } else {  // 多页图需要确定识别哪一页
-        QImageReader imageReader(localPath);
-        imageReader.jumpToImage(index);
-        auto image = imageReader.read();
+        auto image = MultiFrameIndex::instance()->readFrame(localPath, index);
         auto tempDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
         QDir dir(tempDir);
         if (!dir.exists()) {
@@ -1063,53 +1070,18 @@ bool FileControl::rotateFile(const QVariantList &pathList, const int &rotateAnge
 
 bool FileControl::rotateFile(const QString &path, const int &rotateAngel)
 {
-    bool bRet = true;
-    QString localPath = LibUnionImage_NameSpace::localPath(path);
-    if (m_currentPath != localPath) {
-        slotRotatePixCurrent(true);
-        m_currentPath = localPath;
-        m_rotateAngel = rotateAngel;
-    } else {
-        m_rotateAngel += rotateAngel;
-    }
-
-    // 减少频繁的触发旋转进行文件读取写入操作
-    m_tSaveImage->setSingleShot(true);
-    m_tSaveImage->start(100);
-
-    return bRet;
+    // 加入旋转队列，同一文件的连续旋转操作将合并为一次写入
+    RotateImageHelper::instance()->rotateImageFile(LibUnionImage_NameSpace::localPath(path), rotateAngel);
+    return true;
 }
 
 /**
- * @brief 立即保存旋转图片，通过定时器延后触发或图片切换时手动触发
+ * @brief 立即提交等待中的旋转操作，不再等待合并后续操作
  * @note 当前通过保存图片后，监控文件变更触发更新图片的信号
  */
-void FileControl::slotRotatePixCurrent(bool bNotifyExternal/* = false*/)
+void FileControl::slotRotatePixCurrent()
 {
-    // 由QML调用(切换图片)时，停止定时器，防止二次触发
-    if (m_tSaveImage->isActive()) {
-        m_tSaveImage->stop();
-    }
-
-    m_rotateAngel = m_rotateAngel % 360;
-    if (0 != m_rotateAngel) {
-        //20211019修改：特殊位置不执行写入操作
-        imageViewerSpace::PathType pathType = LibUnionImage_NameSpace::getPathType(m_currentPath);
-
-        if (pathType != imageViewerSpace::PathTypeMTP && pathType != imageViewerSpace::PathTypePTP && //安卓手机
-                pathType != imageViewerSpace::PathTypeAPPLE && //苹果手机
-                pathType != imageViewerSpace::PathTypeSAFEBOX && //保险箱
-                pathType != imageViewerSpace::PathTypeRECYCLEBIN) { //回收站
-
-            QString erroMsg;
-            LibUnionImage_NameSpace::rotateImageFIle(m_rotateAngel, m_currentPath, erroMsg);
-
-            // 保存文件后向外部(比如相册缩略图列表)发送图片更新信号，通知外部刷新图片内容
-            if (bNotifyExternal)
-                emit callSavePicDone(QUrl::fromLocalFile(m_currentPath).toString());
-        }
-    }
-    m_rotateAngel = 0;
+    RotateImageHelper::instance()->commitPendingRotations();
 }
 
 void FileControl::setViewerType(imageViewerSpace::ImgViewerType type)
@@ -92,7 +92,7 @@ public:
     //旋转文件 pathList：要旋转的图片路径链表；rotateAngel: > 0 顺时针旋转， < 0 逆时针旋转
     Q_INVOKABLE bool rotateFile(const QVariantList &pathList, const int &rotateAngel);
     Q_INVOKABLE bool rotateFile(const QString &path, const int &rotateAngel);
-    Q_INVOKABLE void slotRotatePixCurrent(bool bNotifyExternal = false); //旋转
+    Q_INVOKABLE void slotRotatePixCurrent(); //立即提交旋转
     Q_INVOKABLE void setViewerType(imageViewerSpace::ImgViewerType type);      // 设置图片查看类型
     Q_INVOKABLE bool isAlbum();                                                // 提供接口，程序是否是相册模式
     Q_INVOKABLE bool checkMimeUrls(const QList<QUrl> &urls);                   // 检查是否可以接受当前的拖拽导入行为
@@ -122,7 +122,7 @@ private:
     QStringList listsupportWallPaper;              // 支持设置壁纸的图片后缀类型
     ImageFileWatcher *imageFileWatcher = nullptr;  // 图片文件变更监控
 
-    QString m_currentPath;                    // 当前操作的旋转图片路径
+    QString m_currentPath;                    // 当前获取详细信息的图片路径
     QMap<QString, QString> m_currentAllInfo;  // 当前图片详细信息
 
     LibConfigSetter *m_config;
@@ -130,9 +130,7 @@ private:
     int m_windowHeight = 0;
     int m_lastSaveWidth = 0;
     int m_lastSaveHeight = 0;
-    int m_rotateAngel = 0;             // 旋转角度
     QTimer *m_tSaveSetting = nullptr;  // 保存配置信息定时器，在指定时间内只保存一次
-    QTimer *m_tSaveImage = nullptr;    // 保存旋转图片定时器，在指定时间内只旋转一次
 
     QImageReader *m_currentReader = nullptr;
     QHash<QString, QString>     m_cacheFileInfo;    // 缓存的图片信息，用于判断图片信息是否变更 QHash<完整路径, url信息>
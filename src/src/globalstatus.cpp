@@ -5,6 +5,10 @@
 #include "globalstatus.h"
 #include "filecontrol.h"
 #include "albumControl.h"
+#include "imageengine/imagedataservice.h"
+
+#include <QGuiApplication>
+#include <QtMath>
 
 static const int sc_MinHeight = 300;           // 窗口最小高度
 static const int sc_MinWidth = 658;            // 窗口最小宽度
@@ -590,6 +594,9 @@ void GlobalStatus::setCellBaseWidth(const qreal& value)
     if (!qFuzzyCompare(m_cellBaseWidth, value)) {
         m_cellBaseWidth = value;
         Q_EMIT cellBaseWidthChanged();
+
+        // 网格会拉伸填满整行，实际宽度最多比基础宽度大约1/4，据此选择缩略图级别
+        ImageDataService::instance()->setThumbnailDisplaySize(qCeil(m_cellBaseWidth * 1.25 * qApp->devicePixelRatio()));
     }
 }
 
@@ -116,6 +116,11 @@ void ImageFileWatcher::clearRotateStatus(const QString &targetPath)
     if (rotateImagePathSet.contains(targetPath)) {
         rotateImagePathSet.remove(targetPath);
     }
+
+    // 旋转结果通过重命名替换原文件，原文件的监控会被移除，需重新追加
+    if (cacheFileInfo.contains(targetPath) && !fileWatcher->files().contains(targetPath) && QFile::exists(targetPath)) {
+        fileWatcher->addPath(targetPath);
+    }
 }
 
 /**
@@ -5,14 +5,16 @@
 #include "imageinfo.h"
 #include "types.h"
 #include "thumbnailcache.h"
+#include "multiframeindex.h"
 #include "unionimage/unionimage.h"
 #include "globalcontrol.h"
+#include "utils/workscheduler.h"
+#include "utils/imagescaler.h"
 
 #include <QSet>
 #include <QSize>
 #include <QFile>
 #include <QImageReader>
-#include <QThreadPool>
 #include <QRunnable>
 #include <QDebug>
 
@@ -88,7 +90,7 @@ private:
     bool aboutToQuit { false };
     QHash<KeyType, ImageInfoData::Ptr> cache;
     QSet<KeyType> waitSet;
-    QScopedPointer<QThreadPool> localPoolPtr;
+    WorkCancelToken cancelToken;  ///< 清空缓存时取消还未启动的加载任务
 };
 Q_GLOBAL_STATIC(ImageInfoCache, CacheInstance)
 
@@ -153,10 +155,10 @@ void LoadImageInfoRunnable::run()
         return;
     }
 
-    QImageReader reader(loadPath);
     if (Types::MultiImage == data->type) {
-        reader.jumpToImage(frameIndex);
-        QImage image = reader.read();
+        // 通过帧索引直接定位，避免每帧都从文件头遍历
+        MultiFrameIndex *frameIndexCache = MultiFrameIndex::instance();
+        QImage image = frameIndexCache->framePreview(loadPath, frameIndex, QSize(100, 100));
         if (image.isNull()) {
             // 数据获取异常
             data->type = Types::DamagedImage;
@@ -164,10 +166,8 @@ void LoadImageInfoRunnable::run()
             return;
         }
 
-        data->size = image.size();
-        data->frameCount = reader.imageCount();
-        // 保存图片比例缩放
-        image = image.scaled(100, 100, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        data->size = frameIndexCache->frameSize(loadPath, frameIndex);
+        data->frameCount = frameIndexCache->frameCount(loadPath);
         // 缓存缩略图信息
         ThumbnailCache::instance()->add(data->path, frameIndex, image);
 
@@ -204,7 +204,7 @@ bool LoadImageInfoRunnable::loadImage(QImage &image, QSize &sourceSize) const
     if (ret) {
         sourceSize = image.size();
         // 保存图片比例缩放
-        image = image.scaled(100, 100, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        image = ImageScaler::scaled(image, QSize(100, 100), Qt::KeepAspectRatioByExpanding);
     } else {
         qWarning() << "Load image " << loadPath << "error:" << error;
     }
@@ -225,17 +225,11 @@ void LoadImageInfoRunnable::notifyFinished(const QString &path, int frameIndex,
 }
 
 ImageInfoCache::ImageInfoCache()
-    : localPoolPtr(new QThreadPool)
 {
-    // 调整后台线程，由于imageprovider部分也存在子线程调用
-    localPoolPtr->setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
-
-    // 退出时清理线程状态
+    // 退出时清理线程状态，执行中的任务由 WorkScheduler 等待结束
     connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
         aboutToQuit = true;
         clearCache();
-
-        localPoolPtr->waitForDone();
     });
 }
 
@@ -275,8 +269,11 @@ void ImageInfoCache::load(const QString &path, int frameIndex, bool reload)
         LoadImageInfoRunnable runnable(path, frameIndex);
         runnable.run();
     } else {
-        LoadImageInfoRunnable *runnable = new LoadImageInfoRunnable(path, frameIndex);
-        localPoolPtr->start(runnable, QThread::LowPriority);
+        // 与 imageprovider 的图像加载共用调度器，优先级低于当前显示的图片
+        WorkScheduler::instance()->submit(WorkScheduler::Prefetch, [path, frameIndex]() {
+            LoadImageInfoRunnable runnable(path, frameIndex);
+            runnable.run();
+        }, cancelToken);
     }
 }
 
@@ -318,7 +315,8 @@ void ImageInfoCache::removeCache(const QString &path, int frameIndex)
 void ImageInfoCache::clearCache()
 {
     // 清理还未启动的线程任务
-    localPoolPtr->clear();
+    cancelToken.cancel();
+    cancelToken = WorkCancelToken();
     waitSet.clear();
     cache.clear();
 }
@@ -532,6 +530,9 @@ void ImageInfo::clearCurrentCache()
         for (int i = 0; i < data->frameCount; ++i) {
             CacheInstance()->removeCache(imageUrl.toLocalFile(), i);
         }
+        if (Types::MultiImage == data->type) {
+            MultiFrameIndex::instance()->remove(imageUrl.toLocalFile());
+        }
     }
 }
 
@@ -543,6 +544,7 @@ void ImageInfo::clearCache()
 {
     CacheInstance()->clearCache();
     ThumbnailCache::instance()->clear();
+    MultiFrameIndex::instance()->clear();
 }
 
 /**
@@ -5,9 +5,10 @@
 #include "imageprovider.h"
 #include "unionimage/unionimage.h"
 #include "imagedata/thumbnailcache.h"
+#include "imagedata/multiframeindex.h"
+#include "utils/workscheduler.h"
+#include "utils/imagescaler.h"
 
-#include <QThread>
-#include <QThreadPool>
 #include <QRunnable>
 #include <QDebug>
 
@@ -50,14 +51,8 @@ static QImage readNormalImage(const QString &imagePath)
  */
 static QImage readMultiImage(const QString &imagePath, int frameIndex)
 {
-    // 重新设置图像读取类
-    QImageReader reader(imagePath);
-
-    if (reader.jumpToImage(frameIndex)) {
-        // 读取图像数据
-        return reader.read();
-    }
-    return QImage();
+    // 通过帧索引直接定位到指定帧
+    return MultiFrameIndex::instance()->readFrame(imagePath, frameIndex);
 }
 
 /**
@@ -169,7 +164,7 @@ void ProviderCache::rotateImageCached(int angle, const QString &imagePath, int f
         imageCache.add(imagePath, frameIndex, image);
 
         // 同样更新缩略图缓存
-        QImage tmpImage = image.scaled(100, 100, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        QImage tmpImage = ImageScaler::scaled(image, QSize(100, 100), Qt::KeepAspectRatioByExpanding);
         ThumbnailCache::instance()->add(imagePath, frameIndex, tmpImage);
     }
 }
@@ -192,6 +187,8 @@ void ProviderCache::removeImageCache(const QString &imagePath)
             _locker.unlock();
         }
     }
+
+    MultiFrameIndex::instance()->remove(imagePath);
 }
 
 /**
@@ -235,7 +232,7 @@ AsyncImageProvider::~AsyncImageProvider() { }
 QQuickImageResponse *AsyncImageProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
 {
     AsyncImageResponse *response = new AsyncImageResponse(this, id, requestedSize);
-    QThreadPool::globalInstance()->start(response, QThread::HighPriority);
+    WorkScheduler::instance()->start(WorkScheduler::Visible, response);
     return response;
 }
 
@@ -246,7 +243,7 @@ void AsyncImageProvider::preloadImage(const QString &filePath)
 {
     AsyncImageResponse *response = new AsyncImageResponse(this, filePath, QSize());
     response->setAutoDelete(true);
-    QThreadPool::globalInstance()->start(response, QThread::TimeCriticalPriority);
+    WorkScheduler::instance()->start(WorkScheduler::Visible, response);
 }
 
 /**
@@ -344,16 +341,22 @@ QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSi
 
     QImage image;
     if (frameIndex) {
-        image = readMultiImage(tempPath, frameIndex);
+        // 多页图仅需缩小后的预览，不保留完整帧图像
+        image = MultiFrameIndex::instance()->framePreview(tempPath, frameIndex, QSize(100, 100));
+        ThumbnailCache::instance()->add(tempPath, frameIndex, image);
+
+        if (size) {
+            *size = MultiFrameIndex::instance()->frameSize(tempPath, frameIndex);
+        }
     } else {
         image = readNormalImage(tempPath);
-    }
-    // 不存在缩略图信息，缓存图片
-    QImage tmpImage = image.scaled(100, 100, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-    ThumbnailCache::instance()->add(tempPath, frameIndex, tmpImage);
+        // 不存在缩略图信息，缓存图片
+        QImage tmpImage = ImageScaler::scaled(image, QSize(100, 100), Qt::KeepAspectRatioByExpanding);
+        ThumbnailCache::instance()->add(tempPath, frameIndex, tmpImage);
 
-    if (size) {
-        *size = image.size();
+        if (size) {
+            *size = image.size();
+        }
     }
     // 调整图像大小
     if (!image.isNull() && image.size() != requestedSize && requestedSize.isValid()) {
@@ -0,0 +1,457 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "multiframeindex.h"
+#include "unionimage/unionimage_global.h"
+#include "utils/imagescaler.h"
+#include "utils/cachefile.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSet>
+#include <QtEndian>
+#include <QDebug>
+
+namespace {
+const quint32 INDEX_MAGIC = 0x4D46494E;    // "MFIN"
+const quint32 INDEX_VERSION = 2;    // 2: 带校验文件头
+const int INDEX_FILE_COUNT = 64;            // 内存中缓存的文件索引数
+const qsizetype PREVIEW_CACHE_BYTES = 32 * 1024 * 1024;
+const int MAX_FRAME_COUNT = 65535;         // 防止损坏文件导致的异常遍历
+
+const quint16 TIFF_TAG_IMAGE_WIDTH = 256;
+const quint16 TIFF_TAG_IMAGE_LENGTH = 257;
+const quint16 TIFF_TYPE_SHORT = 3;
+const quint16 TIFF_TYPE_LONG = 4;
+
+/**
+   @brief 将文件首个 IFD 偏移改写为指定帧 IFD 的只读设备
+   @details TIFF 解码插件打开文件时只读取首个 IFD ，改写文件头后读取的第0帧即为指定帧，
+    无需再从文件头开始遍历 IFD 链。帧数据的偏移均为文件内绝对偏移，其余内容不需要调整。
+ */
+class FrameOffsetDevice : public QIODevice
+{
+public:
+    FrameOffsetDevice(const QString &path, qint64 ifdOffset)
+        : m_file(path)
+        , m_ifdOffset(ifdOffset)
+    {
+    }
+
+    bool open(OpenMode mode) override
+    {
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+
+        m_header = m_file.read(16);
+        if (m_header.size() < 8) {
+            return false;
+        }
+
+        if (!m_header.startsWith("MM") && !m_header.startsWith("II")) {
+            return false;
+        }
+        bool bigEndian = m_header.startsWith("MM");
+        quint16 version = bigEndian ? qFromBigEndian<quint16>(m_header.constData() + 2)
+                                    : qFromLittleEndian<quint16>(m_header.constData() + 2);
+        if (42 == version) {
+            quint32 offset = static_cast<quint32>(m_ifdOffset);
+            bigEndian ? qToBigEndian(offset, m_header.data() + 4) : qToLittleEndian(offset, m_header.data() + 4);
+            m_header.truncate(8);
+        } else if (43 == version && m_header.size() == 16) {
+            quint64 offset = static_cast<quint64>(m_ifdOffset);
+            bigEndian ? qToBigEndian(offset, m_header.data() + 8) : qToLittleEndian(offset, m_header.data() + 8);
+        } else {
+            return false;
+        }
+
+        return QIODevice::open(mode | QIODevice::Unbuffered);
+    }
+
+    qint64 size() const override { return m_file.size(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        qint64 start = pos();
+        if (!m_file.seek(start)) {
+            return -1;
+        }
+        qint64 readSize = m_file.read(data, maxSize);
+        // 覆盖文件头
+        for (qint64 i = start; i < start + readSize && i < m_header.size(); ++i) {
+            data[i - start] = m_header.at(static_cast<int>(i));
+        }
+        return readSize;
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    QFile m_file;
+    qint64 m_ifdOffset;
+    QByteArray m_header;
+};
+
+QImage scaledPreview(const QImage &image, const QSize &size)
+{
+    if (image.isNull() || !size.isValid()) {
+        return image;
+    }
+    return ImageScaler::scaled(image, size, Qt::KeepAspectRatioByExpanding);
+}
+}
+
+MultiFrameIndex::MultiFrameIndex()
+{
+    m_indexCache.setMaxCost(INDEX_FILE_COUNT);
+    m_previewCache.setMaxCost(PREVIEW_CACHE_BYTES);
+}
+
+MultiFrameIndex *MultiFrameIndex::instance()
+{
+    static MultiFrameIndex ins;
+    return &ins;
+}
+
+/**
+   @return 返回 \a path 文件的总帧数
+ */
+int MultiFrameIndex::frameCount(const QString &path)
+{
+    return frames(path).size();
+}
+
+/**
+   @return 返回 \a path 文件第 \a frameIndex 帧的图像大小，帧号越界时返回空大小
+ */
+QSize MultiFrameIndex::frameSize(const QString &path, int frameIndex)
+{
+    QVector<Frame> fileFrames = frames(path);
+    if (frameIndex < 0 || frameIndex >= fileFrames.size()) {
+        return QSize();
+    }
+    return fileFrames.at(frameIndex).size;
+}
+
+/**
+   @brief 读取 \a path 文件第 \a frameIndex 帧的完整图像，TIFF 文件直接定位到帧对应的 IFD
+ */
+QImage MultiFrameIndex::readFrame(const QString &path, int frameIndex)
+{
+    QVector<Frame> fileFrames = frames(path);
+    if (frameIndex < 0 || frameIndex >= fileFrames.size()) {
+        return QImage();
+    }
+
+    const Frame &frame = fileFrames.at(frameIndex);
+    if (frame.ifdOffset >= 0) {
+        FrameOffsetDevice device(path, frame.ifdOffset);
+        if (device.open(QIODevice::ReadOnly)) {
+            QImageReader reader(&device, "tiff");
+            QImage image = reader.read();
+            if (!image.isNull()) {
+                return image;
+            }
+            qWarning() << QString("Read frame %1 of %2 by offset failed: %3").arg(frameIndex).arg(path).arg(reader.errorString());
+        }
+    }
+
+    QImageReader reader(path);
+    if (reader.jumpToImage(frameIndex)) {
+        return reader.read();
+    }
+    return QImage();
+}
+
+/**
+   @brief 读取 \a path 文件第 \a frameIndex 帧缩放至 \a size 的预览图
+   @note 预览图按 (文件, 帧号, 大小) 缓存，调用方通常处于后台线程池中
+ */
+QImage MultiFrameIndex::framePreview(const QString &path, int frameIndex, const QSize &size)
+{
+    PreviewKey key{path, frameIndex, size};
+    QMutexLocker locker(&m_mutex);
+    if (QImage *image = m_previewCache.object(key)) {
+        return *image;
+    }
+    locker.unlock();
+
+    QImage preview = scaledPreview(readFrame(path, frameIndex), size);
+    if (preview.isNull()) {
+        return preview;
+    }
+
+    locker.relock();
+    m_previewCache.insert(key, new QImage(preview), qMax<qsizetype>(1, preview.sizeInBytes()));
+    return preview;
+}
+
+/**
+   @brief 移除 \a path 文件的帧索引及预览缓存，持久化的索引同样移除
+ */
+void MultiFrameIndex::remove(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    m_indexCache.remove(path);
+    const QList<PreviewKey> keys = m_previewCache.keys();
+    for (const PreviewKey &key : keys) {
+        if (key.path == path) {
+            m_previewCache.remove(key);
+        }
+    }
+    locker.unlock();
+
+    QFile::remove(indexFilePath(path));
+}
+
+void MultiFrameIndex::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_indexCache.clear();
+    m_previewCache.clear();
+}
+
+/**
+   @brief 取得 \a path 文件的帧索引，依次查找内存缓存、持久化索引，都不存在或文件已变更时重新解析
+ */
+QVector<MultiFrameIndex::Frame> MultiFrameIndex::frames(const QString &path)
+{
+    QFileInfo info(path);
+    if (!info.exists()) {
+        return {};
+    }
+    qint64 fileSize = info.size();
+    qint64 lastModified = info.lastModified().toMSecsSinceEpoch();
+
+    QMutexLocker locker(&m_mutex);
+    if (FileIndex *cached = m_indexCache.object(path)) {
+        if (cached->fileSize == fileSize && cached->lastModified == lastModified) {
+            return cached->frames;
+        }
+    }
+    locker.unlock();
+
+    FileIndex *index = new FileIndex;
+    if (!loadIndex(path, *index) || index->fileSize != fileSize || index->lastModified != lastModified) {
+        index->fileSize = fileSize;
+        index->lastModified = lastModified;
+        index->frames.clear();
+        if (!parseTiff(path, index->frames) && !scanByReader(path, index->frames)) {
+            delete index;
+            return {};
+        }
+        saveIndex(path, *index);
+    }
+
+    QVector<Frame> result = index->frames;
+    locker.relock();
+    m_indexCache.insert(path, index);
+    return result;
+}
+
+/**
+   @brief 解析 TIFF/BigTIFF 文件头及 IFD 链，仅读取每个 IFD 的目录项，不解码图像数据
+   @return 非 TIFF 文件或文件格式异常时返回 false
+ */
+bool MultiFrameIndex::parseTiff(const QString &path, QVector<Frame> &frames)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    QByteArray order = file.read(2);
+    if ("II" == order) {
+        stream.setByteOrder(QDataStream::LittleEndian);
+    } else if ("MM" == order) {
+        stream.setByteOrder(QDataStream::BigEndian);
+    } else {
+        return false;
+    }
+
+    quint16 version = 0;
+    stream >> version;
+    bool bigTiff = (43 == version);
+    if (!bigTiff && 42 != version) {
+        return false;
+    }
+
+    quint64 offset = 0;
+    if (bigTiff) {
+        quint16 offsetSize = 0;
+        quint16 reserved = 0;
+        stream >> offsetSize >> reserved >> offset;
+        if (8 != offsetSize) {
+            return false;
+        }
+    } else {
+        quint32 offset32 = 0;
+        stream >> offset32;
+        offset = offset32;
+    }
+
+    const qint64 fileSize = file.size();
+    const int entrySize = bigTiff ? 20 : 12;
+    QSet<quint64> visited;
+    while (0 != offset && frames.size() < MAX_FRAME_COUNT) {
+        // IFD 循环引用或越界
+        if (visited.contains(offset) || static_cast<qint64>(offset) >= fileSize || !file.seek(static_cast<qint64>(offset))) {
+            break;
+        }
+        visited.insert(offset);
+
+        quint64 entryCount = 0;
+        if (bigTiff) {
+            stream >> entryCount;
+        } else {
+            quint16 count16 = 0;
+            stream >> count16;
+            entryCount = count16;
+        }
+        if (QDataStream::Ok != stream.status()
+                || entryCount > static_cast<quint64>(fileSize - file.pos()) / entrySize) {
+            break;
+        }
+
+        Frame frame;
+        frame.ifdOffset = static_cast<qint64>(offset);
+        int width = 0;
+        int height = 0;
+        for (quint64 i = 0; i < entryCount; ++i) {
+            quint16 tag = 0;
+            quint16 type = 0;
+            quint64 value = 0;
+            if (bigTiff) {
+                quint64 count = 0;
+                stream >> tag >> type >> count;
+            } else {
+                quint32 count = 0;
+                stream >> tag >> type >> count;
+            }
+
+            // 宽高为单值，SHORT/LONG 类型位于值域的起始位置
+            const int valueFieldSize = bigTiff ? 8 : 4;
+            if (TIFF_TYPE_SHORT == type) {
+                quint16 value16 = 0;
+                stream >> value16;
+                stream.skipRawData(valueFieldSize - 2);
+                value = value16;
+            } else if (TIFF_TYPE_LONG == type && bigTiff) {
+                quint32 value32 = 0;
+                stream >> value32;
+                stream.skipRawData(valueFieldSize - 4);
+                value = value32;
+            } else if (bigTiff) {
+                stream >> value;
+            } else {
+                quint32 value32 = 0;
+                stream >> value32;
+                value = value32;
+            }
+
+            if (TIFF_TAG_IMAGE_WIDTH == tag) {
+                width = static_cast<int>(value);
+            } else if (TIFF_TAG_IMAGE_LENGTH == tag) {
+                height = static_cast<int>(value);
+            }
+        }
+
+        if (bigTiff) {
+            stream >> offset;
+        } else {
+            quint32 offset32 = 0;
+            stream >> offset32;
+            offset = offset32;
+        }
+        if (QDataStream::Ok != stream.status()) {
+            break;
+        }
+
+        frame.size = QSize(width, height);
+        frames.append(frame);
+    }
+
+    return !frames.isEmpty();
+}
+
+/**
+   @brief 非 TIFF 格式的多帧图像，通过 QImageReader 遍历一次获取各帧大小
+ */
+bool MultiFrameIndex::scanByReader(const QString &path, QVector<Frame> &frames)
+{
+    QImageReader reader(path);
+    int count = reader.imageCount();
+    for (int i = 0; i < count && i < MAX_FRAME_COUNT; ++i) {
+        if (!reader.jumpToImage(i)) {
+            break;
+        }
+        Frame frame;
+        frame.size = reader.size();
+        frames.append(frame);
+    }
+
+    return !frames.isEmpty();
+}
+
+/**
+   @return 返回 \a path 文件帧索引的持久化存储路径
+ */
+QString MultiFrameIndex::indexFilePath(const QString &path)
+{
+    QString hash = QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5).toHex();
+    return albumGlobal::CACHE_PATH + "/frameindex/" + hash + ".idx";
+}
+
+bool MultiFrameIndex::loadIndex(const QString &path, FileIndex &index)
+{
+    QByteArray data;
+    if (!CacheFile::readChecked(indexFilePath(path), data)) {
+        return false;
+    }
+
+    QDataStream stream(data);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    stream >> magic >> version;
+    if (INDEX_MAGIC != magic || INDEX_VERSION != version) {
+        return false;
+    }
+
+    stream >> index.fileSize >> index.lastModified >> count;
+    if (count <= 0 || count > MAX_FRAME_COUNT) {
+        return false;
+    }
+
+    index.frames.resize(count);
+    for (Frame &frame : index.frames) {
+        stream >> frame.ifdOffset >> frame.size;
+    }
+    return QDataStream::Ok == stream.status();
+}
+
+void MultiFrameIndex::saveIndex(const QString &path, const FileIndex &index)
+{
+    QString indexPath = indexFilePath(path);
+    QDir().mkpath(QFileInfo(indexPath).absolutePath());
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << INDEX_MAGIC << INDEX_VERSION << index.fileSize << index.lastModified
+           << static_cast<qint32>(index.frames.size());
+    for (const Frame &frame : index.frames) {
+        stream << frame.ifdOffset << frame.size;
+    }
+    if (!CacheFile::writeAtomic(indexPath, CacheFile::addHeader(data))) {
+        qWarning() << "Save frame index failed:" << indexPath;
+    }
+}
@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef MULTIFRAMEINDEX_H
+#define MULTIFRAMEINDEX_H
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+/**
+   @brief 多页图(*.tif)帧索引及帧预览缓存
+   @details QImageReader::jumpToImage() 每次都会从文件头开始遍历 IFD 链，
+    多页图逐帧读取时耗时随帧号线性增长。此处首次访问时解析一次 IFD 链，
+    记录每一帧的 IFD 偏移和大小并持久化保存，后续读取直接定位到指定帧。
+    缩小后的帧预览按 (文件, 帧号, 大小) 缓存，缓存容量按字节数计算。
+   @threadsafe
+ */
+class MultiFrameIndex
+{
+public:
+    // 单帧索引信息
+    struct Frame {
+        qint64 ifdOffset = -1;  ///< IFD 在文件中的偏移，非 TIFF 格式为 -1
+        QSize size;             ///< 帧图像大小
+    };
+
+    static MultiFrameIndex *instance();
+
+    // 文件总帧数，无法读取时返回0
+    int frameCount(const QString &path);
+    // 指定帧的图像大小，无需解码图像数据
+    QSize frameSize(const QString &path, int frameIndex);
+    // 读取指定帧的完整图像
+    QImage readFrame(const QString &path, int frameIndex);
+    // 读取指定帧缩放至 size 的预览图(KeepAspectRatioByExpanding)，结果缓存
+    QImage framePreview(const QString &path, int frameIndex, const QSize &size);
+
+    // 文件变更时移除帧索引及预览缓存
+    void remove(const QString &path);
+    void clear();
+
+private:
+    MultiFrameIndex();
+
+    struct FileIndex {
+        qint64 fileSize = 0;
+        qint64 lastModified = 0;
+        QVector<Frame> frames;
+    };
+
+    struct PreviewKey {
+        QString path;
+        int frameIndex;
+        QSize size;
+
+        bool operator==(const PreviewKey &other) const
+        {
+            return frameIndex == other.frameIndex && size == other.size && path == other.path;
+        }
+        friend size_t qHash(const PreviewKey &key, size_t seed = 0) noexcept
+        {
+            return qHashMulti(seed, key.path, key.frameIndex, key.size.width(), key.size.height());
+        }
+    };
+
+    QVector<Frame> frames(const QString &path);
+    static bool parseTiff(const QString &path, QVector<Frame> &frames);
+    static bool scanByReader(const QString &path, QVector<Frame> &frames);
+    static QString indexFilePath(const QString &path);
+    static bool loadIndex(const QString &path, FileIndex &index);
+    static void saveIndex(const QString &path, const FileIndex &index);
+
+    QMutex m_mutex;
+    QCache<QString, FileIndex> m_indexCache;         ///< 帧索引，按文件数计数
+    QCache<PreviewKey, QImage> m_previewCache;       ///< 帧预览，按字节数计数
+
+    Q_DISABLE_COPY(MultiFrameIndex)
+};
+
+#endif  // MULTIFRAMEINDEX_H
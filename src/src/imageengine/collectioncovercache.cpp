@@ -0,0 +1,153 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "collectioncovercache.h"
+#include "imagedataservice.h"
+#include "movieservice.h"
+#include "dbmanager/dbmanager.h"
+#include "unionimage/unionimage.h"
+#include "unionimage/baseutils.h"
+#include "unionimage/unionimage_global.h"
+#include "utils/imagescaler.h"
+#include "utils/metrics.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QPainter>
+#include <QUrl>
+
+namespace {
+// 拼图的图片数量(2x2)及间隔，与月视图单元格的间隔一致
+const int MOSAIC_COUNT = 4;
+const int MOSAIC_SPACING = 2;
+
+// 从 image 中心裁切出与 size 比例相同的区域并缩放到 size
+QImage centerCropped(const QImage &image, const QSize &size)
+{
+    if (image.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+
+    const QSize cropSize = size.scaled(image.size(), Qt::KeepAspectRatio);
+    const QRect rect(QPoint((image.width() - cropSize.width()) / 2, (image.height() - cropSize.height()) / 2), cropSize);
+    return ImageScaler::cropScaled(image, rect, size);
+}
+}
+
+QString CollectionCoverCache::cacheDir()
+{
+    return albumGlobal::CACHE_PATH + "/collection";
+}
+
+QImage CollectionCoverCache::sourceImage(const QString &path, const QSize &size)
+{
+    ALBUM_METRICS_SCOPE("collection.source");
+    if (LibUnionImage_NameSpace::isVideo(path)) {
+        return MovieService::instance()->getMovieCover(QUrl::fromLocalFile(path));
+    }
+
+    //缩略图缓存中已生成的最大级别足够大时不解码原图，较大级别仅在放大显示后才会生成
+    QImage image;
+    const QString thumbnailPath = Libutils::base::filePathToThumbnailPath(path);
+    const QVector<int> &levels = ImageDataService::thumbnailLevels();
+    for (auto iter = levels.crbegin(); iter != levels.crend(); ++iter) {
+        const QString levelPath = ImageDataService::getLevelPath(thumbnailPath, *iter);
+        if (!QFileInfo::exists(levelPath)) {
+            continue;
+        }
+        if (ImageDataService::loadThumbnailFile(levelPath, image)
+                && image.size().scaled(size, Qt::KeepAspectRatioByExpanding).width() <= image.width()) {
+            ALBUM_METRICS_COUNT("collection.thumbnailHit", 1);
+            return image;
+        }
+        break;
+    }
+
+    //按需要的尺寸解码，JPEG等格式可直接以低分辨率解码
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    const QSize sourceSize = reader.size();
+    if (sourceSize.isValid() && sourceSize.width() > size.width() && sourceSize.height() > size.height()) {
+        reader.setScaledSize(sourceSize.scaled(size, Qt::KeepAspectRatioByExpanding));
+    }
+    image = reader.read();
+    if (image.isNull()) {
+        QString error;
+        LibUnionImage_NameSpace::loadStaticImageFromFile(path, image, error);
+    }
+    return image;
+}
+
+/**
+ * @brief 单张图片直接居中裁切；4张图片时每张居中裁切为四分之一大小，间隔处为白色
+ */
+QImage CollectionCoverCache::createCover(const QStringList &paths, const QSize &size)
+{
+    ALBUM_METRICS_SCOPE("collection.createCover");
+    if (paths.size() < MOSAIC_COUNT) {
+        return centerCropped(sourceImage(paths.first(), size), size);
+    }
+
+    QImage cover(size, QImage::Format_RGB32);
+    cover.fill(Qt::white);
+    const QSize tileSize((size.width() - MOSAIC_SPACING) / 2, (size.height() - MOSAIC_SPACING) / 2);
+    QPainter painter(&cover);
+    for (int i = 0; i < MOSAIC_COUNT; ++i) {
+        const QPoint pos((i % 2) * (size.width() - tileSize.width()), (i / 2) * (size.height() - tileSize.height()));
+        painter.drawImage(pos, centerCropped(sourceImage(paths.at(i), tileSize), tileSize));
+    }
+    painter.end();
+    return cover;
+}
+
+QImage CollectionCoverCache::yearCover(const QString &year, const QSize &size)
+{
+    ALBUM_METRICS_SCOPE("collection.yearCover");
+    QStringList paths = DBManager::instance()->getYearPaths(year, MOSAIC_COUNT);
+    if (paths.isEmpty()) {
+        return QImage();
+    }
+    if (paths.size() < MOSAIC_COUNT) {
+        paths = paths.mid(0, 1);
+    }
+
+    //内容版本：该年图片有增删或变更，或封面图片被修改(如旋转)时变化
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(DBManager::instance()->getYearVersion(year).toUtf8());
+    hash.addData(QString("%1x%2").arg(size.width()).arg(size.height()).toUtf8());
+    for (const QString &path : paths) {
+        hash.addData(path.toUtf8());
+        hash.addData(QByteArray::number(QFileInfo(path).lastModified().toSecsSinceEpoch()));
+    }
+    const QString prefix = QString("year_%1_").arg(year);
+    const QString coverFile = cacheDir() + "/" + prefix + hash.result().toHex().left(16) + ".png";
+
+    QImage cover;
+    if (ImageDataService::loadThumbnailFile(coverFile, cover)) {
+        ALBUM_METRICS_COUNT("collection.coverHit", 1);
+        return cover;
+    }
+
+    cover = createCover(paths, size);
+    if (cover.isNull()) {
+        return cover;
+    }
+
+    //删除该年旧版本的封面
+    QDir dir(cacheDir());
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+    for (const QString &name : dir.entryList({prefix + "*.png"}, QDir::Files)) {
+        dir.remove(name);
+    }
+    if (!ImageDataService::saveThumbnailFile(cover, coverFile)) {
+        qWarning() << "CollectionCoverCache: save year cover failed:" << coverFile;
+    }
+    return cover;
+}
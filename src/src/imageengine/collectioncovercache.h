@@ -0,0 +1,34 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef COLLECTIONCOVERCACHE_H
+#define COLLECTIONCOVERCACHE_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief 年、月视图卡片的封面
+ * @details 年视图封面预先合成后保存在缩略图缓存目录中：该年不少于4张时为2x2拼图，否则为单张图片。
+ *      文件名包含年份及内容版本(该年图片数量、最近导入及修改时间、封面图片及其修改时间)，
+ *      该年的图片有增删或变更时版本变化，重新合成并删除旧版本，否则直接读取，不再解码原图。
+ *      月视图单元格及拼图的每一格优先使用缩略图缓存中的最大级别，尺寸不足时才按需要的尺寸解码原图。
+ */
+class CollectionCoverCache
+{
+public:
+    // 年视图封面，尺寸为 size
+    static QImage yearCover(const QString &year, const QSize &size);
+    // 用于填满 size 的图片，至少覆盖 size (短边对齐)，不保证精确尺寸
+    static QImage sourceImage(const QString &path, const QSize &size);
+
+    // 封面缓存目录
+    static QString cacheDir();
+
+private:
+    static QImage createCover(const QStringList &paths, const QSize &size);
+};
+
+#endif // COLLECTIONCOVERCACHE_H
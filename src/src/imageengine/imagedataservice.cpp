@@ -25,17 +25,42 @@
 #include "dbmanager/dbmanager.h"
 #include "configsetter.h"
 #include "movieservice.h"
+#include "utils/metrics.h"
+#include "utils/workscheduler.h"
+#include "utils/imagescaler.h"
+#include "utils/cachefile.h"
 
 #include <QMetaType>
 #include <QDirIterator>
+#include <QBuffer>
+#include <QImageReader>
 #include <QStandardPaths>
 #include <QSqlDatabase>
 #include <QSqlError>
+#include <QSet>
 #include <QSqlQuery>
+#include <QWaitCondition>
 
 const QString SETTINGS_GROUP = "Thumbnail";
 const QString SETTINGS_DISPLAY_MODE = "ThumbnailMode";
-const int THUMBNAIL_MAX_SIZE = 180;
+// 未设置显示尺寸前使用的缩略图尺寸
+const int THUMBNAIL_DEFAULT_SIZE = 180;
+// 缩略图内存缓存上限，按字节数及数量限制
+const qint64 THUMBNAIL_CACHE_BYTES = 128 * 1024 * 1024;
+const size_t THUMBNAIL_CACHE_COUNT = 500;
+// 缩略图长边与短边之比的上限，超出时限制长边，避免长图缩略图过大
+const int THUMBNAIL_MAX_ASPECT = 3;
+// 方图裁切区域在缩略图文本信息中的键值，格式为 "x,y,w,h"
+const QString THUMBNAIL_CROP_KEY = "AlbumCrop";
+// 原图路径及生成时原图的修改时间，缓存清理时据此判断缩略图是否失效
+const QString THUMBNAIL_SOURCE_KEY = "AlbumSource";
+const QString THUMBNAIL_SOURCE_MODIFIED_KEY = "AlbumSourceModified";
+// 读取缩略图时更新访问时间的最小间隔，缓存清理按访问时间淘汰
+const qint64 THUMBNAIL_TOUCH_INTERVAL = 60 * 60;
+// 正在生成缩略图的图片路径
+static QMutex s_generatingMutex;
+static QWaitCondition s_generatingReleased;
+static QSet<QString> s_generatingPaths;
 
 ImageDataService *ImageDataService::s_ImageDataService = nullptr;
 
@@ -50,9 +75,9 @@ ImageDataService *ImageDataService::instance(QObject *parent)
 
 bool ImageDataService::pathInMap(const QString &path)
 {
-    QString loadModePath = getLoadModePath(path);
-    auto iter = std::find_if(m_AllImageMap.begin(), m_AllImageMap.end(), [loadModePath](const std::pair<QString, QImage> &pr) {
-        return pr.first == loadModePath;
+    QString key = mapKey(path, m_thumbnailLevel);
+    auto iter = std::find_if(m_AllImageMap.begin(), m_AllImageMap.end(), [key](const std::pair<QString, QImage> &pr) {
+        return pr.first == key;
     });
     return iter != m_AllImageMap.end();
 }
@@ -61,10 +86,10 @@ std::pair<QImage, bool> ImageDataService::getImageFromMap(const QString &path)
 {
     QMutexLocker locker(&m_imgDataMutex);
 
-    QString loadModePath = getLoadModePath(path);
+    QString key = mapKey(path, m_thumbnailLevel);
 
-    auto iter = std::find_if(m_AllImageMap.begin(), m_AllImageMap.end(), [loadModePath](const std::pair<QString, QImage> &pr) {
-        return pr.first == loadModePath;
+    auto iter = std::find_if(m_AllImageMap.begin(), m_AllImageMap.end(), [key](const std::pair<QString, QImage> &pr) {
+        return pr.first == key;
     });
     if (iter != m_AllImageMap.end()) {
         return std::make_pair(iter->second, true);
@@ -73,23 +98,46 @@ std::pair<QImage, bool> ImageDataService::getImageFromMap(const QString &path)
     }
 }
 
+QImage ImageDataService::getOtherLevelFromMap(const QString &path)
+{
+    QMutexLocker locker(&m_imgDataMutex);
+
+    //优先使用清晰度最高的级别
+    const QVector<int> &levels = thumbnailLevels();
+    for (auto level = levels.crbegin(); level != levels.crend(); ++level) {
+        QString key = mapKey(path, *level);
+        auto iter = std::find_if(m_AllImageMap.begin(), m_AllImageMap.end(), [key](const std::pair<QString, QImage> &pr) {
+            return pr.first == key;
+        });
+        if (iter != m_AllImageMap.end() && !iter->second.isNull()) {
+            return iter->second;
+        }
+    }
+    return QImage();
+}
+
+QString ImageDataService::mapKey(const QString &path, int level)
+{
+    //缩略图与加载模式无关，切换模式后缓存仍然有效
+    return getLevelPath(path, level);
+}
+
 void ImageDataService::removePathFromMap(const QString &path)
 {
     QMutexLocker locker(&m_imgDataMutex);
 
-    auto iter = std::find_if(m_AllImageMap.begin(), m_AllImageMap.end(), [path](const std::pair<QString, QImage> &pr) {
-        return pr.first == path;
-    });
-    if (iter != m_AllImageMap.end()) {
-        m_AllImageMap.erase(iter);
+    QStringList keys;
+    for (int level : thumbnailLevels()) {
+        keys << mapKey(path, level);
     }
 
-    QString scalPath = getScaledPath(path);
-    iter = std::find_if(m_AllImageMap.begin(), m_AllImageMap.end(), [scalPath](const std::pair<QString, QImage> &pr) {
-        return pr.first == scalPath;
-    });
-    if (iter != m_AllImageMap.end()) {
-        m_AllImageMap.erase(iter);
+    for (auto iter = m_AllImageMap.begin(); iter != m_AllImageMap.end();) {
+        if (keys.contains(iter->first)) {
+            m_mapBytes -= iter->second.sizeInBytes();
+            iter = m_AllImageMap.erase(iter);
+        } else {
+            ++iter;
+        }
     }
 }
 
@@ -98,37 +146,151 @@ void ImageDataService::removeThumbnailFile(const QString &path)
     if (path.isEmpty())
         return;
 
+    for (const QString &thumbnailPath : thumbnailFilePaths(path)) {
+        if (QFile::exists(thumbnailPath))
+            QFile::remove(thumbnailPath);
+    }
+}
+
+QStringList ImageDataService::thumbnailFilePaths(const QString &path)
+{
+    QStringList paths;
     QString thumbnailPath = Libutils::base::filePathToThumbnailPath(path);
-    QString thumbnailScalePath = ImageDataService::instance()->getLoadModePath(thumbnailPath);
-    if (QFile::exists(thumbnailPath))
-        QFile::remove(thumbnailPath);
-    if (QFile::exists(thumbnailScalePath))
-        QFile::remove(thumbnailScalePath);
+    for (int level : thumbnailLevels()) {
+        paths << getLevelPath(thumbnailPath, level);
+    }
+    return paths;
 }
 
-QString ImageDataService::getLoadModePath(const QString &path)
+QRect ImageDataService::thumbnailCropRect(const QImage &thumbnail)
 {
-    if (m_loadMode == 0)
-        return path;
+    const QStringList values = thumbnail.text(THUMBNAIL_CROP_KEY).split(',');
+    if (values.size() == 4) {
+        QRect rect(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
+        if (!rect.isEmpty() && thumbnail.rect().contains(rect)) {
+            return rect;
+        }
+    }
+    return thumbnail.rect();
+}
 
-    return getScaledPath(path);
+void ImageDataService::setThumbnailCropRect(QImage &thumbnail)
+{
+    const int width = thumbnail.width();
+    const int height = thumbnail.height();
+    if (0 == width || 0 == height) {
+        return;
+    }
+
+    //与 ImageScaler::clipToSquare 一致：长宽相差不足10%时保留原比例，否则居中裁切为方图
+    QRect rect = thumbnail.rect();
+    if (qAbs((width - height) * 10 / width) >= 1) {
+        const int side = qMin(width, height);
+        rect = QRect((width - side) / 2, (height - side) / 2, side, side);
+    }
+    thumbnail.setText(THUMBNAIL_CROP_KEY, QString("%1,%2,%3,%4").arg(rect.x()).arg(rect.y()).arg(rect.width()).arg(rect.height()));
 }
 
-QString ImageDataService::getScaledPath(const QString &path)
+QRect ImageDataService::thumbnailDisplayRect(const QImage &thumbnail)
 {
-    QFileInfo fi(path);
-    QString tmpPath = fi.absolutePath() + "/" + fi.fileName().left(fi.fileName().lastIndexOf('.')) + "_scale" + fi.fileName().mid(fi.fileName().lastIndexOf('.'));
-    return tmpPath;
+    return 0 == m_loadMode ? thumbnailCropRect(thumbnail) : thumbnail.rect();
+}
+
+bool ImageDataService::readThumbnailSource(const QString &thumbnailFile, QString &srcPath, qint64 &srcModified)
+{
+    QFile file(thumbnailFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    //跳过校验文件头，文本信息位于图像数据之前，不解码图像也不校验整个文件
+    if (CacheFile::hasHeader(file.peek(CacheFile::headerSize()))) {
+        file.seek(CacheFile::headerSize());
+    }
+
+    QImageReader reader(&file, "PNG");
+    srcPath = reader.text(THUMBNAIL_SOURCE_KEY);
+    bool ok = false;
+    srcModified = reader.text(THUMBNAIL_SOURCE_MODIFIED_KEY).toLongLong(&ok);
+    return !srcPath.isEmpty() && ok;
+}
+
+bool ImageDataService::saveThumbnailFile(const QImage &thumbnail, const QString &thumbnailFile)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    if (!buffer.open(QIODevice::WriteOnly) || !thumbnail.save(&buffer, "PNG")) {
+        return false;
+    }
+    return CacheFile::writeAtomic(thumbnailFile, CacheFile::addHeader(data));
+}
+
+bool ImageDataService::loadThumbnailFile(const QString &thumbnailFile, QImage &thumbnail)
+{
+    QFile file(thumbnailFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const QByteArray data = file.readAll();
+    QByteArray payload;
+    if (CacheFile::hasHeader(data)) {
+        if (!CacheFile::checkHeader(data, payload)) {
+            ALBUM_METRICS_COUNT("thumbnail.corrupt", 1);
+            return false;
+        }
+    } else {
+        payload = data;
+    }
+    return thumbnail.loadFromData(payload, "PNG");
+}
+
+const QVector<int> &ImageDataService::thumbnailLevels()
+{
+    static const QVector<int> levels = {64, 128, 256, 512};
+    return levels;
+}
+
+int ImageDataService::thumbnailLevelForSize(int size)
+{
+    for (int level : thumbnailLevels()) {
+        if (level >= size) {
+            return level;
+        }
+    }
+    return thumbnailLevels().last();
+}
+
+QString ImageDataService::getLevelPath(const QString &thumbnailPath, int level)
+{
+    int dotIndex = thumbnailPath.lastIndexOf('.');
+    if (dotIndex <= thumbnailPath.lastIndexOf('/')) {
+        dotIndex = thumbnailPath.size();
+    }
+    return thumbnailPath.left(dotIndex) + "_" + QString::number(level) + thumbnailPath.mid(dotIndex);
 }
 
-void ImageDataService::addImage(const QString &path, const QImage &image)
+void ImageDataService::setThumbnailDisplaySize(int size)
+{
+    int level = thumbnailLevelForSize(size);
+    if (m_thumbnailLevel.exchange(level) != level) {
+        qDebug() << "ImageDataService::setThumbnailDisplaySize size:" << size << "level:" << level;
+        emit thumbnailLevelChanged();
+    }
+}
+
+int ImageDataService::thumbnailLevel() const
+{
+    return m_thumbnailLevel;
+}
+
+void ImageDataService::addImage(const QString &path, const QImage &image, int level)
 {
     QMutexLocker locker(&m_imgDataMutex);
 
-    QString loadModePath = getLoadModePath(path);
+    QString key = mapKey(path, level < 0 ? m_thumbnailLevel.load() : level);
 
-    auto iter = std::find_if(m_AllImageMap.begin(), m_AllImageMap.end(), [loadModePath](const std::pair<QString, QImage> &pr) {
-        if (pr.first != loadModePath) {
+    auto iter = std::find_if(m_AllImageMap.begin(), m_AllImageMap.end(), [key](const std::pair<QString, QImage> &pr) {
+        if (pr.first != key) {
             return false;
         }
         return true;
@@ -136,12 +298,16 @@ void ImageDataService::addImage(const QString &path, const QImage &image)
 //    QImage m_image = addPadAndScaled(image);
 //    m_image.save("/home/houchengqiu/Desktop/text1.png");
     if (iter != m_AllImageMap.end()) {
+        m_mapBytes += image.sizeInBytes() - iter->second.sizeInBytes();
         iter->second = image;
     } else {
-        m_AllImageMap.push_back(std::make_pair(loadModePath, image));
-        if (m_AllImageMap.size() > 500) {
-            m_AllImageMap.pop_front();
-        }
+        m_AllImageMap.push_back(std::make_pair(key, image));
+        m_mapBytes += image.sizeInBytes();
+    }
+
+    while (m_AllImageMap.size() > 1 && (m_AllImageMap.size() > THUMBNAIL_CACHE_COUNT || m_mapBytes > THUMBNAIL_CACHE_BYTES)) {
+        m_mapBytes -= m_AllImageMap.front().second.sizeInBytes();
+        m_AllImageMap.pop_front();
     }
 }
 
@@ -172,11 +338,8 @@ bool ImageDataService::imageIsLoaded(const QString &path, bool isTrashFile)
 ImageDataService::ImageDataService(QObject *parent) : QObject(parent)
 {
     m_loadMode = 1;
-    readThumbnailManager = new ReadThumbnailManager;
-    readThread = new QThread;
-    readThumbnailManager->moveToThread(readThread);
-    readThread->start();
-    connect(this, &ImageDataService::startImageLoad, readThumbnailManager, &ReadThumbnailManager::readThumbnail);
+    m_thumbnailLevel = thumbnailLevelForSize(THUMBNAIL_DEFAULT_SIZE);
+    readThumbnailManager = new ReadThumbnailManager(this);
 
     //初始化的时候读取上次退出时的状态
     m_loadMode = LibConfigSetter::instance()->value(SETTINGS_GROUP, SETTINGS_DISPLAY_MODE, 0).toInt();
@@ -258,12 +421,11 @@ QImage ImageDataService::getThumnailImageByPathRealTime(const QString &path, boo
     //缓存没找到则加入图片到加载队列
     readThumbnailManager->addLoadPath(realPath);
 
-    //如果加载队列正在休眠，则发信号唤醒，反之不去反复发信号激活队列
-    if (!readThumbnailManager->isRunning()) {
-        emit startImageLoad();
-    }
+    //如果加载队列正在休眠则唤醒，反之不去反复激活队列
+    readThumbnailManager->start();
 
-    return QImage();
+    //当前级别加载完成前，先显示缓存中其它级别的缩略图
+    return getOtherLevelFromMap(realPath);
 }
 
 ReadThumbnailManager::ReadThumbnailManager(QObject *parent)
@@ -283,6 +445,21 @@ void ReadThumbnailManager::addLoadPath(const QString &path)
     mutex.unlock();
 }
 
+void ReadThumbnailManager::start()
+{
+    bool expected = false;
+    if (!runningFlag.compare_exchange_strong(expected, true)) {
+        return;
+    }
+
+    // 缩略图为当前可见内容，与导入等批量任务共用调度器时优先执行
+    WorkScheduler::instance()->submit(WorkScheduler::Visible, [this]() {
+        readThumbnail();
+    }, WorkCancelToken(), [this]() {
+        runningFlag = false;
+    });
+}
+
 void ReadThumbnailManager::readThumbnail()
 {
     int sendCounter = 0; //刷新上层界面指示
@@ -315,60 +492,54 @@ void ReadThumbnailManager::readThumbnail()
             DBManager::m_fileMutex.unlock();
             continue;
         }
+        ALBUM_METRICS_SCOPE("thumbnail.read");
         using namespace LibUnionImage_NameSpace;
         QImage tImg;
         QString srcPath = path;
+        //读取过程中切换显示级别，以开始读取时的级别为准
+        const int level = ImageDataService::instance()->thumbnailLevel();
         QString thumbnailPath = Libutils::base::filePathToThumbnailPath(path);
-        thumbnailPath = ImageDataService::instance()->getLoadModePath(thumbnailPath);
-
-        QFileInfo thumbnailFile(thumbnailPath);
-        QString errMsg;
-        if (thumbnailFile.exists()) {
-            if (!loadStaticImageFromFile(thumbnailPath, tImg, errMsg, "PNG")) {
-                qDebug() << errMsg;
-                //不正常退出导致的缩略图损坏，删除原文件后重新尝试制作
-                QFile::remove(thumbnailPath);
-                if (!loadStaticImageFromFile(srcPath, tImg, errMsg)) {
-                    qDebug() << errMsg;
+        QString levelPath = ImageDataService::getLevelPath(thumbnailPath, level);
+
+        //后台预生成正在处理该图片时等待其完成，之后直接读取生成的文件
+        acquireGenerating(path);
+        bool needGenerate = !QFileInfo::exists(levelPath);
+        if (!needGenerate) {
+            ALBUM_METRICS_COUNT("thumbnail.cacheHit", 1);
+            if (!ImageDataService::loadThumbnailFile(levelPath, tImg)) {
+                qDebug() << "Thumbnail corrupted, regenerate:" << levelPath;
+                //断电等原因导致的缩略图损坏，删除原文件后重新制作
+                QFile::remove(levelPath);
+                needGenerate = true;
+            } else {
+                if (tImg.text(THUMBNAIL_CROP_KEY).isEmpty()) {
+                    ImageDataService::setThumbnailCropRect(tImg);
                 }
-            }
 
-            if (isVideo(srcPath)) {
-                //获取视频信息 demo
-                MovieInfo mi = MovieService::instance()->getMovieInfo(QUrl::fromLocalFile(srcPath));
-                ImageDataService::instance()->addMovieDurationStr(srcPath, mi.duration);
-            }
-        } else {
-            //读图
-            if (isVideo(srcPath)) {
-                tImg = MovieService::instance()->getMovieCover(QUrl::fromLocalFile(srcPath));
-
-                //获取视频信息 demo
-                MovieInfo mi = MovieService::instance()->getMovieInfo(QUrl::fromLocalFile(srcPath));
-                ImageDataService::instance()->addMovieDurationStr(path, mi.duration);
-            } else {
-                if (!loadStaticImageFromFile(srcPath, tImg, errMsg)) {
-                    qDebug() << errMsg;
-                    ImageDataService::instance()->addImage(srcPath, tImg);
-                    DBManager::m_fileMutex.unlock();
-                    continue;
+                //记录访问时间，部分文件系统不更新或延迟更新访问时间
+                const QDateTime now = QDateTime::currentDateTime();
+                if (QFileInfo(levelPath).lastRead().secsTo(now) > THUMBNAIL_TOUCH_INTERVAL) {
+                    QFile file(levelPath);
+                    if (file.open(QIODevice::ReadOnly)) {
+                        file.setFileTime(now, QFileDevice::FileAccessTime);
+                    }
                 }
             }
+        }
 
-            //裁切
-            if (ImageDataService::instance()->getLoadMode() == 0)
-                tImg = clipToRect(tImg);
-            else if (ImageDataService::instance()->getLoadMode() == 1)
-                tImg = addPadAndScaled(tImg);
-
-            Libutils::base::mkMutiDir(thumbnailPath.mid(0, thumbnailPath.lastIndexOf('/')));
+        if (isVideo(srcPath)) {
+            //获取视频信息 demo
+            MovieInfo mi = MovieService::instance()->getMovieInfo(QUrl::fromLocalFile(srcPath));
+            ImageDataService::instance()->addMovieDurationStr(srcPath, mi.duration);
         }
 
-        if (!tImg.isNull() && !thumbnailFile.exists()) {
-            tImg.save(thumbnailPath, "PNG"); //保存裁好的缩略图，下次读的时候直接刷进去
+        if (needGenerate) {
+            ALBUM_METRICS_COUNT("thumbnail.generated", 1);
+            tImg = generateThumbnails(srcPath, thumbnailPath, level);
         }
+        releaseGenerating(path);
 
-        ImageDataService::instance()->addImage(path, tImg);
+        ImageDataService::instance()->addImage(path, tImg, level);
 
         // 成功加载缩略图，通知上层界面刷新
         emit ImageDataService::instance()->gotImage(path);
@@ -381,63 +552,104 @@ void ReadThumbnailManager::readThumbnail()
     }
 
     runningFlag = false; //告诉外面加载队列处于休眠状态
+
+    //退出循环与置为休眠之间新加入的路径，需重新激活队列
+    QMutexLocker locker(&mutex);
+    bool hasPending = !needLoadPath.empty() && !stopFlag;
+    locker.unlock();
+    if (hasPending) {
+        start();
+    }
 }
 
-QImage ReadThumbnailManager::clipToRect(const QImage &src)
+QImage ReadThumbnailManager::generateThumbnails(const QString &srcPath, const QString &thumbnailPath, int level)
 {
-    auto tImg = src;
-
-    if (!tImg.isNull() && 0 != tImg.height() && 0 != tImg.width() && (tImg.height() / tImg.width()) < 10 && (tImg.width() / tImg.height()) < 10) {
-        bool cache_exist = false;
-        if (tImg.height() != THUMBNAIL_MAX_SIZE && tImg.width() != THUMBNAIL_MAX_SIZE) {
-            if (tImg.height() >= tImg.width()) {
-                cache_exist = true;
-                tImg = tImg.scaledToWidth(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            } else if (tImg.height() <= tImg.width()) {
-                cache_exist = true;
-                tImg = tImg.scaledToHeight(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            }
-        }
-        if (!cache_exist) {
-            if ((static_cast<float>(tImg.height()) / (static_cast<float>(tImg.width()))) > 3) {
-                tImg = tImg.scaledToWidth(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            } else {
-                tImg = tImg.scaledToHeight(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            }
+    using namespace LibUnionImage_NameSpace;
+    QImage image;
+    //读图
+    if (isVideo(srcPath)) {
+        image = MovieService::instance()->getMovieCover(QUrl::fromLocalFile(srcPath));
+    } else {
+        QString errMsg;
+        if (!loadStaticImageFromFile(srcPath, image, errMsg)) {
+            qDebug() << errMsg;
+            return QImage();
         }
     }
 
-    if (!tImg.isNull()) {
-        int width = tImg.width();
-        int height = tImg.height();
-        if (abs((width - height) * 10 / width) >= 1) {
-            QRect rect = tImg.rect();
-            int x = rect.x() + width / 2;
-            int y = rect.y() + height / 2;
-            if (width > height) {
-                x = x - height / 2;
-                y = 0;
-                tImg = tImg.copy(x, y, height, height);
-            } else {
-                y = y - width / 2;
-                x = 0;
-                tImg = tImg.copy(x, y, width, width);
-            }
-        }
+    if (image.isNull()) {
+        return image;
     }
 
-    return tImg;
+    //缩放并保存所有级别，下次读的时候直接刷进去
+    Libutils::base::mkMutiDir(thumbnailPath.mid(0, thumbnailPath.lastIndexOf('/')));
+    return saveThumbnailLevels(image, srcPath, thumbnailPath, level);
 }
 
-QImage ReadThumbnailManager::addPadAndScaled(const QImage &src)
+bool ReadThumbnailManager::tryAcquireGenerating(const QString &path)
 {
-    auto result = src.convertToFormat(QImage::Format_RGBA8888);
+    QMutexLocker locker(&s_generatingMutex);
+    if (s_generatingPaths.contains(path)) {
+        return false;
+    }
+    s_generatingPaths.insert(path);
+    return true;
+}
 
-    if (result.height() > result.width()) {
-        result = result.scaledToHeight(THUMBNAIL_MAX_SIZE, Qt::SmoothTransformation);
-    } else {
-        result = result.scaledToWidth(THUMBNAIL_MAX_SIZE, Qt::SmoothTransformation);
+void ReadThumbnailManager::acquireGenerating(const QString &path)
+{
+    QMutexLocker locker(&s_generatingMutex);
+    while (s_generatingPaths.contains(path)) {
+        s_generatingReleased.wait(&s_generatingMutex);
     }
+    s_generatingPaths.insert(path);
+}
+
+void ReadThumbnailManager::releaseGenerating(const QString &path)
+{
+    QMutexLocker locker(&s_generatingMutex);
+    s_generatingPaths.remove(path);
+    s_generatingReleased.wakeAll();
+}
 
+QImage ReadThumbnailManager::saveThumbnailLevels(const QImage &src, const QString &srcPath, const QString &thumbnailPath, int level)
+{
+    ALBUM_METRICS_SCOPE("thumbnail.levels");
+    QImage result;
+    QImage levelImage = src;
+    const qint64 srcModified = QFileInfo(srcPath).lastModified().toSecsSinceEpoch();
+
+    //原图只解码一次，先生成需要的最大级别，较小级别由上一级缩小得到；
+    //大于当前显示级别的缩略图多数不会被使用，放大显示时再生成，已存在的较小级别不再重复写入
+    const int maxLevel = qMax(level, ImageDataService::instance()->thumbnailLevel());
+    const QVector<int> &levels = ImageDataService::thumbnailLevels();
+    for (auto iter = levels.crbegin(); iter != levels.crend(); ++iter) {
+        if (*iter > maxLevel) {
+            continue;
+        }
+        levelImage = scaledToLevel(levelImage, *iter);
+        ImageDataService::setThumbnailCropRect(levelImage);
+        levelImage.setText(THUMBNAIL_SOURCE_KEY, srcPath);
+        levelImage.setText(THUMBNAIL_SOURCE_MODIFIED_KEY, QString::number(srcModified));
+        const QString levelPath = ImageDataService::getLevelPath(thumbnailPath, *iter);
+        if (*iter != level && QFileInfo::exists(levelPath)) {
+            ALBUM_METRICS_COUNT("thumbnail.levelKept", 1);
+        } else if (!ImageDataService::saveThumbnailFile(levelImage, levelPath)) {
+            qWarning() << "ReadThumbnailManager::saveThumbnailLevels save failed:" << thumbnailPath << *iter;
+        }
+        if (*iter == level) {
+            result = levelImage;
+        }
+    }
     return result;
 }
+
+QImage ReadThumbnailManager::scaledToLevel(const QImage &src, int size)
+{
+    //短边缩放到 size ，方图模式裁切后仍有足够的清晰度；长图限制长边，方图显示时短边略小
+    QSize target = src.size().scaled(size, size, Qt::KeepAspectRatioByExpanding);
+    if (qMax(target.width(), target.height()) > size * THUMBNAIL_MAX_ASPECT) {
+        target = src.size().scaled(size * THUMBNAIL_MAX_ASPECT, size * THUMBNAIL_MAX_ASPECT, Qt::KeepAspectRatio);
+    }
+    return ImageScaler::scaled(src, target.expandedTo(QSize(1, 1)));
+}
@@ -27,6 +27,7 @@
 #include <QMutex>
 #include <QThread>
 #include <QQueue>
+#include <QVector>
 #include <deque>
 
 class readThumbnailThread;
@@ -38,7 +39,8 @@ public:
     static ImageDataService *instance(QObject *parent = nullptr);
     explicit ImageDataService(QObject *parent = nullptr);
 
-    void addImage(const QString &path, const QImage &image);
+    // level 为缩略图级别，小于0时使用当前显示级别
+    void addImage(const QString &path, const QImage &image, int level = -1);
     QImage getThumnailImageByPathRealTime(const QString &path, bool isTrashFile, bool bReload = false);
     bool imageIsLoaded(const QString &path, bool isTrashFile);
 
@@ -56,23 +58,46 @@ public:
     //获得当前图片显示的状态
     Q_INVOKABLE int getLoadMode();
 
-    // 根据加载模式获取对应加载图片路径
-    QString getLoadModePath(const QString &path);
-
-    // 获取等比例缩略图存放路径
-    QString getScaledPath(const QString &path);
+    // 缩略图分级尺寸(升序)，生成时一次解码写出不大于当前显示级别的各级，更大的级别在放大显示时生成
+    static const QVector<int> &thumbnailLevels();
+    // 不小于显示尺寸的最小级别，超出最大级别时取最大级别
+    static int thumbnailLevelForSize(int size);
+    // 缩略图文件对应级别的存放路径，如 xxx.png -> xxx_256.png
+    static QString getLevelPath(const QString &thumbnailPath, int level);
+    // 图片对应的全部缩略图文件(所有级别)
+    QStringList thumbnailFilePaths(const QString &path);
+
+    // 缩略图与加载模式无关，按原比例存储，方图模式使用的裁切区域记录在图片文本信息中
+    static QRect thumbnailCropRect(const QImage &thumbnail);
+    static void setThumbnailCropRect(QImage &thumbnail);
+    // 当前加载模式下缩略图的显示区域：方图模式为裁切区域，等比例模式为整张图片
+    QRect thumbnailDisplayRect(const QImage &thumbnail);
+    // 读取缩略图文件记录的原图路径及生成时原图的修改时间(秒)，仅读取文件头，用于缓存清理
+    static bool readThumbnailSource(const QString &thumbnailFile, QString &srcPath, qint64 &srcModified);
+    // 原子写入缩略图文件，PNG数据前附加校验文件头
+    static bool saveThumbnailFile(const QImage &thumbnail, const QString &thumbnailFile);
+    // 读取并校验缩略图文件，写入不完整或已损坏时返回 false ；不带校验文件头的旧文件直接解码
+    static bool loadThumbnailFile(const QString &thumbnailFile, QImage &thumbnail);
+
+    // 设置网格中缩略图的显示像素尺寸，级别变化时通知界面重新获取
+    void setThumbnailDisplaySize(int size);
+    int thumbnailLevel() const;
 
 private slots:
 signals:
     void sigeUpdateListview();
     void gotImage(const QString path);
-    void startImageLoad();
+    void thumbnailLevelChanged();
 public:
 private:
     bool pathInMap(const QString &path);
 
     //QImage:图片，bool:是否是从缓存加载
     std::pair<QImage, bool> getImageFromMap(const QString &path);
+    // 缓存中同一图片其它级别的缩略图，当前级别加载完成前作为占位显示
+    QImage getOtherLevelFromMap(const QString &path);
+    // 缓存键值：图片路径 + 级别
+    QString mapKey(const QString &path, int level);
     // 从缓存清除图片信息
     void removePathFromMap(const QString &path);
 
@@ -86,13 +111,16 @@ private:
     QMutex m_imgDataMutex;
     //QString:原图路径 QImage:缩略图
     std::deque<std::pair<QString, QImage>> m_AllImageMap;
+    // 缓存缩略图占用字节数，不同级别大小差异大，按字节数限制缓存
+    qint64 m_mapBytes = 0;
     QMap<QString, QString> m_movieDurationStrMap;
 
     //加载模式控制
     std::atomic_int m_loadMode;
+    //当前显示的缩略图级别
+    std::atomic_int m_thumbnailLevel;
 
     ReadThumbnailManager *readThumbnailManager;
-    QThread *readThread;
 };
 
 //缩略图读取类
@@ -102,6 +130,8 @@ class ReadThumbnailManager : public QObject
 public:
     explicit ReadThumbnailManager(QObject *parent = nullptr);
     void addLoadPath(const QString &path);
+    // 加载队列处于休眠状态时，在调度器中启动加载
+    void start();
 
     bool isRunning()
     {
@@ -113,14 +143,24 @@ public:
         stopFlag = true;
     }
 
+    // 解码原图，生成并保存不大于 level 及当前显示级别的各级缩略图，返回 level 级别的缩略图，解码失败时返回空图
+    QImage generateThumbnails(const QString &srcPath, const QString &thumbnailPath, int level);
+
+    // 正在生成缩略图的图片，界面加载与后台预生成共用，同一图片不会同时解码两次
+    // 未被占用时占用并返回 true，否则立即返回 false
+    static bool tryAcquireGenerating(const QString &path);
+    // 被占用时等待其他线程生成完成后再占用
+    static void acquireGenerating(const QString &path);
+    static void releaseGenerating(const QString &path);
+
 public slots:
     void readThumbnail();
 
 private:
-    // 将图片裁剪为方图
-    QImage clipToRect(const QImage &src);
-    // 将图片按比例缩小
-    QImage addPadAndScaled(const QImage &src);
+    // 将图片按比例缩小到短边为 size ，过长或过宽的图片限制长边
+    QImage scaledToLevel(const QImage &src, int size);
+    // 由解码后的图片逐级生成并保存不大于 level 及当前显示级别的各级缩略图(已存在的不再写入)，返回 level 级别的缩略图
+    QImage saveThumbnailLevels(const QImage &src, const QString &srcPath, const QString &thumbnailPath, int level);
 private:
     std::deque<QString> needLoadPath;
     QMutex mutex;
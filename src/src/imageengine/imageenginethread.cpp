@@ -4,10 +4,32 @@
 
 #include "imageenginethread.h"
 #include "dbmanager/dbmanager.h"
+#include "dbmanager/dbmanagerasync.h"
 #include "unionimage/unionimage.h"
 #include "albumControl.h"
+#include "unionimage/baseutils.h"
+#include "utils/metrics.h"
+#include "utils/workscheduler.h"
 
+#include <QCoreApplication>
 #include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#include <cstdio>
+
+namespace {
+// 外接设备(尤其是MTP)并发读取过多反而更慢，限制同时拷贝的文件数量
+const int DEVICE_IMPORT_MAX_PARALLEL = 2;
+// 每批写入数据库的文件数量
+const int DEVICE_IMPORT_BATCH_SIZE = 50;
+// 导出清单所在目录(应用缓存目录下)，清单按导出目录区分，全部导出成功后删除，不在用户的导出目录中留下文件
+const QString EXPORT_MANIFEST_DIR = "/export-manifest/";
+// 导出进度及速度通知间隔
+const int EXPORT_REPORT_INTERVAL_MS = 500;
+}
 
 ImageEngineThreadObject::ImageEngineThreadObject()
 {
@@ -87,6 +109,8 @@ bool ImportImagesThread::ifCanStopThread(void *imgobject)
 
 void ImportImagesThread::runDetail()
 {
+    ALBUM_METRICS_SCOPE("import.total");
+
     //相册中本次导入之前已导入的所有路径
     DBImgInfoList oldInfos = AlbumControl::instance()->getAllInfosByUID(QString::number(m_UID));
     QStringList allOldImportedPaths;
@@ -98,16 +122,19 @@ void ImportImagesThread::runDetail()
     QStringList filePaths;
     DBImgInfoList dbInfos;
     //判断是否含有目录
-    for (QString path : m_paths) {
-        //是目录，向下遍历,得到所有文件
-        if (QDir(path).exists()) {
-            QFileInfoList infos = LibUnionImage_NameSpace::getImagesAndVideoInfo(path, true);
+    {
+        ALBUM_METRICS_SCOPE("import.scan");
+        for (QString path : m_paths) {
+            //是目录，向下遍历,得到所有文件
+            if (QDir(path).exists()) {
+                QFileInfoList infos = LibUnionImage_NameSpace::getImagesAndVideoInfo(path, true);
 
-            std::transform(infos.begin(), infos.end(), std::back_inserter(tempPaths), [](const QFileInfo & info) {
-                return info.absoluteFilePath();
-            });
-        } else {//非目录
-            tempPaths << path;
+                std::transform(infos.begin(), infos.end(), std::back_inserter(tempPaths), [](const QFileInfo & info) {
+                    return info.absoluteFilePath();
+                });
+            } else {//非目录
+                tempPaths << path;
+            }
         }
     }
 
@@ -126,6 +153,7 @@ void ImportImagesThread::runDetail()
         //当前文件存在和可读
         QFileInfo info(imagePath);
         if (info.exists() && info.isReadable()) {
+            ALBUM_METRICS_SCOPE("import.parseFile");
             //去掉不支持的图片和视频
             bool bIsVideo = LibUnionImage_NameSpace::isVideo(imagePath);
             if (!bIsVideo && !LibUnionImage_NameSpace::imageSupportRead(imagePath)) {
@@ -165,18 +193,22 @@ void ImportImagesThread::runDetail()
         return lhs.changeTime > rhs.changeTime;
     });
 
-    //导入图片数据库ImageTable3
-    DBManager::instance()->insertImgInfos(dbInfos);
+    {
+        ALBUM_METRICS_SCOPE("import.dbInsert");
+        //导入图片数据库ImageTable3
+        DBManagerAsync::instance()->call([&](DBManager *db) { return db->insertImgInfos(dbInfos); });
 
-    //导入图片数据库AlbumTable3
-    if (m_UID >= 0) {
-        AlbumDBType atype = AlbumDBType::AutoImport;
-        if (m_UID == 0) {
-            atype = AlbumDBType::Favourite;
-        }
+        //导入图片数据库AlbumTable3
+        if (m_UID >= 0) {
+            AlbumDBType atype = AlbumDBType::AutoImport;
+            if (m_UID == 0) {
+                atype = AlbumDBType::Favourite;
+            }
 
-        DBManager::instance()->insertIntoAlbum(m_UID, filePaths, atype);
+            DBManagerAsync::instance()->call([&](DBManager *db) { return db->insertIntoAlbum(m_UID, filePaths, atype); });
+        }
     }
+    ALBUM_METRICS_COUNT("import.files", static_cast<quint64>(filePaths.size()));
 
     //原createNewCustomAutoImportAlbum逻辑
     if (m_UID > 0) {
@@ -190,3 +222,451 @@ void ImportImagesThread::runDetail()
         emit sigImportFinished();
 }
 
+DeviceImportThread::DeviceImportThread()
+{
+    connect(this, &DeviceImportThread::sigImportProgress, AlbumControl::instance(), &AlbumControl::sigImportProgress);
+    connect(this, &DeviceImportThread::sigImportSpeed, AlbumControl::instance(), &AlbumControl::sigImportSpeed);
+    connect(this, &DeviceImportThread::sigImportFinished, AlbumControl::instance(), &AlbumControl::sigImportFinished);
+    connect(this, &DeviceImportThread::sigImportFailed, AlbumControl::instance(), &AlbumControl::sigImportFailed);
+    //通知前端刷新相关界面
+    connect(this, &DeviceImportThread::sigImportFinished, AlbumControl::instance(), &AlbumControl::sigRefreshAllCollection);
+    connect(this, &DeviceImportThread::sigImportFinished, AlbumControl::instance(), &AlbumControl::sigRefreshImportAlbum);
+    connect(this, &DeviceImportThread::sigImportFinished, [=]() {
+        emit AlbumControl::instance()->sigRefreshCustomAlbum(-1);
+    });
+    //取消导入
+    connect(AlbumControl::instance(), &AlbumControl::sigStopDeviceImport, this, [this]() {
+        needStop(nullptr);
+    }, Qt::DirectConnection);
+}
+
+DeviceImportThread::~DeviceImportThread()
+{
+
+}
+
+void DeviceImportThread::setData(const QStringList &paths, const int UID)
+{
+    m_paths = paths;
+    m_UID = UID;
+}
+
+void DeviceImportThread::runDetail()
+{
+    //获取系统现在的时间
+    QString strDate = QDateTime::currentDateTime().toString("yyyy-MM-dd");
+    QString basePath = QString("%1%2%3/%4").arg(QDir::homePath(), "/Pictures/", AlbumControl::tr("Pictures"), strDate);
+    QDir dir;
+    if (!dir.exists(basePath)) {
+        dir.mkpath(basePath);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int finishedCount = 0;
+    int insertedCount = 0;
+    int duplicateCount = 0;
+    int failedCount = 0;
+    bool bDeviceLost = false;
+
+    for (int start = 0; start < m_paths.size(); start += DEVICE_IMPORT_BATCH_SIZE) {
+        if (bneedstop || bDeviceLost) {
+            break;
+        }
+
+        const QStringList batch = m_paths.mid(start, DEVICE_IMPORT_BATCH_SIZE);
+        QVector<CopyResult> results(batch.size());
+        WorkScheduler::instance()->parallelFor(WorkScheduler::BulkIO, batch.size(), [this, &batch, &results, &basePath](int i) {
+            results[i] = copyOne(batch.at(i), basePath);
+        }, DEVICE_IMPORT_MAX_PARALLEL);
+
+        {
+            QMutexLocker locker(&m_reserveMutex);
+            m_reservedPaths.clear();
+        }
+
+        //解析拷贝后的文件信息，按批次写入数据库，中途中断时已完成的批次不会丢失
+        DBImgInfoList dbInfos;
+        QStringList albumPaths;
+        for (const CopyResult &result : results) {
+            switch (result.status) {
+            case CopyResult::Copied: {
+                DBImgInfo info = AlbumControl::instance()->getDBInfo(result.targetPath, LibUnionImage_NameSpace::isVideo(result.targetPath));
+                if (ItemType::ItemTypeNull == info.itemType) {
+                    failedCount++;
+                    break;
+                }
+                info.dataHash = result.dataHash;
+                dbInfos << info;
+                albumPaths << result.targetPath;
+                break;
+            }
+            case CopyResult::Duplicate:
+                //图库中已存在，不再拷贝，仅添加到目标相册
+                duplicateCount++;
+                albumPaths << result.targetPath;
+                break;
+            case CopyResult::SourceLost:
+                bDeviceLost = true;
+                failedCount++;
+                break;
+            case CopyResult::Failed:
+            default:
+                failedCount++;
+                break;
+            }
+        }
+
+        if (!dbInfos.isEmpty()) {
+            DBManagerAsync::instance()->call([&](DBManager *db) { return db->insertImgInfos(dbInfos); });
+            insertedCount += dbInfos.size();
+        }
+        if (m_UID > 0 && !albumPaths.isEmpty()) {
+            DBManagerAsync::instance()->call([&](DBManager *db) { return db->insertIntoAlbum(m_UID, albumPaths); });
+        }
+
+        finishedCount += batch.size();
+        emit sigImportProgress(finishedCount, m_paths.size());
+
+        //根据已拷贝数据量估算速度及剩余时间
+        qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+        qint64 bytesPerSecond = m_copiedBytes * 1000 / elapsed;
+        int remainSeconds = static_cast<int>(elapsed * (m_paths.size() - finishedCount) / finishedCount / 1000);
+        emit sigImportSpeed(bytesPerSecond, remainSeconds);
+    }
+
+    qDebug() << QString("Device import end, total:%1 inserted:%2 duplicate:%3 failed:%4 bytes:%5 elapsed(ms):%6 stopped:%7 deviceLost:%8")
+             .arg(m_paths.size()).arg(insertedCount).arg(duplicateCount).arg(failedCount)
+             .arg(m_copiedBytes.load()).arg(timer.elapsed()).arg(bneedstop).arg(bDeviceLost);
+
+    if (insertedCount == 0 && duplicateCount == 0) {
+        emit sigImportFailed(failedCount);
+        return;
+    }
+
+    emit sigImportFinished();
+}
+
+/**
+ * @brief 拷贝单个文件到 \a basePath 下，在拷贝线程池中执行
+ *      1.根据文件内容hash查询图库，逐块比较确认内容一致后跳过拷贝；图库中没有记录hash的同名文件计算后比较
+ *      2.目标路径下存在相同内容文件(上次导入中断)，直接复用
+ *      3.分块拷贝到临时文件，完成后重命名
+ */
+DeviceImportThread::CopyResult DeviceImportThread::copyOne(const QString &srcPath, const QString &basePath)
+{
+    CopyResult result;
+    if (bneedstop) {
+        return result;
+    }
+
+    QFileInfo srcInfo(srcPath);
+    if (!srcInfo.exists()) {
+        //源文件所在目录也不存在时，认为设备已拔出
+        result.status = srcInfo.dir().exists() ? CopyResult::Failed : CopyResult::SourceLost;
+        return result;
+    }
+
+    result.dataHash = Libutils::base::hashByContent(srcPath);
+    if (result.dataHash.isEmpty()) {
+        return result;
+    }
+
+    //内容hash只采样首尾，命中后逐块比较确认，避免把不同的文件当作重复跳过
+    QString existPath = DBManager::instance()->getPathByDataHash(result.dataHash);
+    if (!existPath.isEmpty() && !Libutils::base::sameFileContent(srcPath, existPath)) {
+        existPath.clear();
+    }
+    if (existPath.isEmpty()) {
+        existPath = findUnhashedDuplicate(srcInfo, result.dataHash);
+    }
+    if (!existPath.isEmpty()) {
+        result.status = CopyResult::Duplicate;
+        result.targetPath = existPath;
+        return result;
+    }
+
+    bool alreadyCopied = false;
+    result.targetPath = reserveTargetPath(basePath, srcInfo, result.dataHash, alreadyCopied);
+    if (alreadyCopied) {
+        result.status = CopyResult::Copied;
+        return result;
+    }
+
+    if (copyFileChunked(srcPath, result.targetPath)) {
+        result.status = CopyResult::Copied;
+    } else if (!QFile::exists(srcPath)) {
+        result.status = CopyResult::SourceLost;
+    }
+    return result;
+}
+
+/**
+ * @brief 图库中通过其他途径导入的文件没有记录内容hash，按文件名查找候选，
+ *      大小一致时计算hash比较并补记，之后的导入可直接按hash命中
+ */
+QString DeviceImportThread::findUnhashedDuplicate(const QFileInfo &srcInfo, const QString &dataHash)
+{
+    for (const QString &path : DBManager::instance()->getUnhashedPathsByFileName(srcInfo.fileName())) {
+        QFileInfo info(path);
+        if (!info.exists() || info.size() != srcInfo.size()) {
+            continue;
+        }
+
+        const QString hash = Libutils::base::hashByContent(path);
+        if (hash.isEmpty()) {
+            continue;
+        }
+        DBManagerAsync::instance()->call([&](DBManager *db) { return db->updateDataHash(path, hash); });
+        if (hash == dataHash && Libutils::base::sameFileContent(srcInfo.absoluteFilePath(), path)) {
+            return path;
+        }
+    }
+    return QString();
+}
+
+/**
+ * @brief 分配不冲突的目标路径，优先使用原始文件名，重名时追加序号。
+ *      若目标路径下已有相同内容的文件，通过 \a alreadyCopied 传出，无需再次拷贝
+ */
+QString DeviceImportThread::reserveTargetPath(const QString &basePath, const QFileInfo &srcInfo, const QString &dataHash, bool &alreadyCopied)
+{
+    const QString fileName = srcInfo.fileName();
+    const qint64 fileSize = srcInfo.size();
+    QFileInfo nameInfo(fileName);
+    QString baseName = nameInfo.completeBaseName();
+    QString suffix = nameInfo.suffix().isEmpty() ? QString() : "." + nameInfo.suffix();
+
+    QMutexLocker locker(&m_reserveMutex);
+    for (int index = 0; ; ++index) {
+        QString candidate = index == 0 ? QString("%1/%2").arg(basePath, fileName)
+                            : QString("%1/%2_%3%4").arg(basePath, baseName, QString::number(index), suffix);
+        if (m_reservedPaths.contains(candidate)) {
+            continue;
+        }
+
+        QFileInfo candidateInfo(candidate);
+        if (candidateInfo.exists()) {
+            if (candidateInfo.size() == fileSize && Libutils::base::hashByContent(candidate) == dataHash
+                    && Libutils::base::sameFileContent(srcInfo.absoluteFilePath(), candidate)) {
+                alreadyCopied = true;
+            } else {
+                continue;
+            }
+        }
+
+        m_reservedPaths << candidate;
+        return candidate;
+    }
+}
+
+/**
+ * @brief 拷贝 \a srcPath 到隐藏的临时文件，完成后重命名为 \a dstPath ，
+ *      每个数据块之间检查取消标记，取消或失败时删除临时文件，不会残留不完整的图片
+ */
+bool DeviceImportThread::copyFileChunked(const QString &srcPath, const QString &dstPath)
+{
+    QFileInfo dstInfo(dstPath);
+    QString tempPath = dstInfo.absolutePath() + "/." + dstInfo.fileName() + ".part";
+
+    //内核拷贝不支持的设备(如MTP)自动回退为分块读写
+    bool bSuccess = Libutils::base::copyFileFast(srcPath, tempPath, [this](qint64 bytes) {
+        m_copiedBytes += bytes;
+        return !bneedstop;
+    });
+
+    if (bSuccess) {
+        bSuccess = QFile::rename(tempPath, dstPath);
+    }
+    if (!bSuccess) {
+        QFile::remove(tempPath);
+    }
+    return bSuccess;
+}
+
+ExportFilesThread::ExportFilesThread()
+{
+    connect(this, &ExportFilesThread::sigExportProgress, AlbumControl::instance(), &AlbumControl::sigExportProgress);
+    connect(this, &ExportFilesThread::sigExportSpeed, AlbumControl::instance(), &AlbumControl::sigExportSpeed);
+    connect(this, &ExportFilesThread::sigExportFinished, AlbumControl::instance(), &AlbumControl::sigExportFinished);
+    //取消导出
+    connect(AlbumControl::instance(), &AlbumControl::sigStopExport, this, [this]() {
+        needStop(nullptr);
+    }, Qt::DirectConnection);
+}
+
+ExportFilesThread::~ExportFilesThread()
+{
+
+}
+
+void ExportFilesThread::setData(const QStringList &paths, const QString &targetDir)
+{
+    m_paths = paths;
+    m_targetDir = targetDir;
+}
+
+void ExportFilesThread::runDetail()
+{
+    QDir().mkpath(m_targetDir);
+
+    //派发前确定每个文件的目标路径，不同目录下的同名文件不会写入同一目标；
+    //分配结果只与文件顺序有关，重新导出同一批文件时目标路径不变，据此跳过上次导出中已完成的文件
+    const QStringList dstPaths = resolveTargetPaths();
+    const QSet<QString> exported = loadManifest();
+    QVector<QPair<QString, QString>> pendingFiles;
+    qint64 totalBytes = 0;
+    for (int i = 0; i < m_paths.size(); ++i) {
+        QFileInfo info(m_paths.at(i));
+        if (exported.contains(QString("%1\t%2").arg(m_paths.at(i)).arg(info.size()))
+                && QFileInfo(dstPaths.at(i)).size() == info.size()) {
+            continue;
+        }
+        pendingFiles << qMakePair(m_paths.at(i), dstPaths.at(i));
+        totalBytes += info.size();
+    }
+
+    //机械硬盘并发写入会导致频繁寻道，按目标磁盘类型限制并发，同时不超过调度器 BulkIO 的线程预算
+    const int parallel = Libutils::base::ioParallelBudget(m_targetDir);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int skippedCount = m_paths.size() - pendingFiles.size();
+    std::atomic<int> finishedCount{0};
+    std::atomic<int> failedCount{0};
+    QMutex reportMutex;
+    qint64 lastReport = 0;
+    auto reportProgress = [&]() {
+        qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+        qint64 bytesPerSecond = m_copiedBytes * 1000 / elapsed;
+        int remainSeconds = bytesPerSecond > 0 ? static_cast<int>((totalBytes - m_copiedBytes) / bytesPerSecond) : 0;
+        emit sigExportProgress(skippedCount + finishedCount, m_paths.size());
+        emit sigExportSpeed(bytesPerSecond, qMax(remainSeconds, 0));
+    };
+
+    //拷贝期间由完成拷贝的线程定时通知进度及速度
+    WorkScheduler::instance()->parallelFor(WorkScheduler::BulkIO, pendingFiles.size(), [&](int i) {
+        const auto &file = pendingFiles.at(i);
+        if (bneedstop || !exportOne(file.first, file.second)) {
+            failedCount++;
+        }
+        finishedCount++;
+
+        QMutexLocker locker(&reportMutex);
+        if (timer.elapsed() - lastReport >= EXPORT_REPORT_INTERVAL_MS) {
+            lastReport = timer.elapsed();
+            reportProgress();
+        }
+    }, parallel);
+    reportProgress();
+
+    qDebug() << QString("Export end, total:%1 skipped:%2 failed:%3 bytes:%4 elapsed(ms):%5 parallel:%6 stopped:%7")
+             .arg(m_paths.size()).arg(skippedCount).arg(failedCount.load()).arg(m_copiedBytes.load())
+             .arg(timer.elapsed()).arg(parallel).arg(bneedstop);
+
+    bool bSuccess = !bneedstop && 0 == failedCount;
+    if (bSuccess) {
+        QFile::remove(manifestPath());
+    }
+    emit sigExportFinished(bSuccess);
+}
+
+/**
+ * @brief 为 m_paths 中的每个文件分配导出目录下的目标路径，与 m_paths 一一对应
+ *      优先使用原始文件名(已存在的同名文件被替换)，与本次导出中之前的文件重名时追加序号
+ */
+QStringList ExportFilesThread::resolveTargetPaths() const
+{
+    QStringList dstPaths;
+    QSet<QString> usedNames;
+    for (const QString &path : m_paths) {
+        QFileInfo nameInfo(path);
+        QString fileName = nameInfo.fileName();
+        QString baseName = nameInfo.completeBaseName();
+        QString suffix = nameInfo.suffix().isEmpty() ? QString() : "." + nameInfo.suffix();
+        for (int index = 1; usedNames.contains(fileName); ++index) {
+            fileName = QString("%1_%2%3").arg(baseName, QString::number(index), suffix);
+        }
+        usedNames.insert(fileName);
+        dstPaths << m_targetDir + "/" + fileName;
+    }
+    return dstPaths;
+}
+
+/**
+ * @brief 导出单个文件到 \a dstPath ，在拷贝线程池中执行
+ *      拷贝到导出目录下的隐藏临时文件，完成后替换同名文件并记录到导出清单；
+ *      临时文件名包含进程号及进程内递增的序号，并发拷贝及同时进行的其他导出不会写入同一文件
+ */
+bool ExportFilesThread::exportOne(const QString &srcPath, const QString &dstPath)
+{
+    static std::atomic<quint64> s_tempSequence{0};
+    QFileInfo srcInfo(srcPath);
+    //目标位置与原图位置相同则无需拷贝
+    if (QFileInfo(dstPath).canonicalFilePath() == srcInfo.canonicalFilePath()) {
+        return true;
+    }
+
+    QString tempPath = m_targetDir + "/." + QFileInfo(dstPath).fileName()
+                       + QString(".%1.%2.part").arg(QCoreApplication::applicationPid()).arg(s_tempSequence++);
+    bool bSuccess = Libutils::base::copyFileFast(srcPath, tempPath, [this](qint64 bytes) {
+        m_copiedBytes += bytes;
+        return !bneedstop;
+    });
+
+    //rename 会直接替换已存在的同名文件
+    if (bSuccess && 0 != std::rename(QFile::encodeName(tempPath).constData(), QFile::encodeName(dstPath).constData())) {
+        bSuccess = false;
+    }
+    if (!bSuccess) {
+        QFile::remove(tempPath);
+        qWarning() << "Export file failed:" << srcPath;
+        return false;
+    }
+
+    appendManifest(srcPath, srcInfo.size());
+    return true;
+}
+
+/**
+ * @brief 导出目录对应的导出清单路径，位于应用缓存目录下，以导出目录路径的hash命名
+ */
+QString ExportFilesThread::manifestPath() const
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + EXPORT_MANIFEST_DIR
+           + Libutils::base::hashByString(QDir::cleanPath(QFileInfo(m_targetDir).absoluteFilePath()));
+}
+
+/**
+ * @brief 读取导出目录对应的导出清单，每行记录一个已导出的文件: 源路径\t文件大小
+ */
+QSet<QString> ExportFilesThread::loadManifest() const
+{
+    QSet<QString> entries;
+    QFile file(manifestPath());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return entries;
+    }
+
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        QString line = stream.readLine();
+        if (!line.isEmpty()) {
+            entries.insert(line);
+        }
+    }
+    return entries;
+}
+
+void ExportFilesThread::appendManifest(const QString &srcPath, qint64 size)
+{
+    QMutexLocker locker(&m_manifestMutex);
+    const QString path = manifestPath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        file.write(QString("%1\t%2\n").arg(srcPath).arg(size).toUtf8());
+    }
+}
@@ -11,10 +11,14 @@
 #include <QThreadPool>
 #include <QRunnable>
 #include <QMutex>
+#include <QSet>
 #include <QUrl>
 #include <QWaitCondition>
 
+#include <atomic>
+
 class ImageEngineThreadObject;
+class QFileInfo;
 
 //这里将QRunnable继承转移到这里，方便将run函数的实现也转移过来
 class ImageEngineThreadObject : public QObject, public QRunnable
@@ -80,4 +84,89 @@ private:
     bool m_checkRepeat = true;
 };
 
+//从外接设备(手机、U盘等)导入线程
+//有限并发拷贝，按内容hash去重，分批写入数据库；中途取消或拔出设备后，已提交的批次保留，重新导入时跳过
+class DeviceImportThread : public ImageEngineThreadObject
+{
+    Q_OBJECT
+public:
+    DeviceImportThread();
+    ~DeviceImportThread() override;
+    void setData(const QStringList &paths, const int UID);
+
+protected:
+    void runDetail() override;
+
+signals:
+    //导入完成信号
+    void sigImportFinished();
+    //导入失败信号
+    void sigImportFailed(int error);
+    //导入进度信号
+    void sigImportProgress(int value, int max = 100);
+    //导入速度信号，bytesPerSecond:拷贝速度，remainSeconds:预计剩余时间
+    void sigImportSpeed(qint64 bytesPerSecond, int remainSeconds);
+
+private:
+    struct CopyResult {
+        enum Status {
+            Failed,         // 拷贝失败
+            Copied,         // 拷贝成功(或上次已拷贝但未写入数据库)
+            Duplicate,      // 图库中已存在相同内容的文件
+            SourceLost,     // 源文件不存在，设备可能已拔出
+        };
+        Status status = Failed;
+        QString targetPath;
+        QString dataHash;
+    };
+
+    CopyResult copyOne(const QString &srcPath, const QString &basePath);
+    QString findUnhashedDuplicate(const QFileInfo &srcInfo, const QString &dataHash);
+    QString reserveTargetPath(const QString &basePath, const QFileInfo &srcInfo, const QString &dataHash, bool &alreadyCopied);
+    bool copyFileChunked(const QString &srcPath, const QString &dstPath);
+
+    QStringList m_paths;            // 所有的本地路径
+    int m_UID = -1;
+
+    QMutex m_reserveMutex;          // 目标文件名分配锁
+    QStringList m_reservedPaths;    // 本批次已分配的目标路径
+    std::atomic<qint64> m_copiedBytes{0};
+};
+
+//导出文件线程
+//按目标磁盘类型限制并发拷贝，优先由内核完成拷贝(reflink/copy_file_range)；
+//已完成的文件记录在目标目录的清单中，中途取消或失败后重新导出到同一目录时跳过
+class ExportFilesThread : public ImageEngineThreadObject
+{
+    Q_OBJECT
+public:
+    ExportFilesThread();
+    ~ExportFilesThread() override;
+    void setData(const QStringList &paths, const QString &targetDir);
+
+protected:
+    void runDetail() override;
+
+signals:
+    //导出进度信号
+    void sigExportProgress(int value, int max);
+    //导出速度信号，bytesPerSecond:拷贝速度，remainSeconds:预计剩余时间
+    void sigExportSpeed(qint64 bytesPerSecond, int remainSeconds);
+    //导出完成信号，bSuccess:全部文件导出成功
+    void sigExportFinished(bool bSuccess);
+
+private:
+    QStringList resolveTargetPaths() const;
+    bool exportOne(const QString &srcPath, const QString &dstPath);
+    QString manifestPath() const;
+    QSet<QString> loadManifest() const;
+    void appendManifest(const QString &srcPath, qint64 size);
+
+    QStringList m_paths;            // 待导出的文件
+    QString m_targetDir;            // 导出目录
+
+    QMutex m_manifestMutex;         // 导出清单写入锁
+    std::atomic<qint64> m_copiedBytes{0};
+};
+
 #endif // IMAGEENGINETHREAD_H
@@ -176,11 +176,37 @@ MovieInfo MovieService::getMovieInfo(const QUrl &url)
 }
 
 QImage MovieService::getMovieCover(const QUrl &url)
+{
+    // 生成过程不加锁，各线程使用独立的缩略图生成器，并发数由 WorkScheduler 限制
+    video_thumbnailer *thumbnailer = acquireThumbnailer();
+    if (thumbnailer == nullptr) {
+        return QImage();
+    }
+
+    thumbnailer->thumbnail_size = static_cast<int>(THUMBNAIL_SIZE);
+    //不取第一帧，与文管影院保持一致
+//    thumbnailer->seek_time = const_cast<char *>(SEEK_TIME);
+    image_data *imageData = m_mvideo_thumbnailer_create_image_data();
+    QString file = QFileInfo(LibUnionImage_NameSpace::localPath(url)).absoluteFilePath();
+    m_mvideo_thumbnailer_generate_thumbnail_to_buffer(thumbnailer, file.toUtf8().data(), imageData);
+    QImage img = QImage::fromData(imageData->image_data_ptr, static_cast<int>(imageData->image_data_size), "png");
+    m_mvideo_thumbnailer_destroy_image_data(imageData);
+
+    releaseThumbnailer(thumbnailer);
+    return img;
+}
+
+/**
+ * @brief 取出空闲的缩略图生成器，不存在时新建，初始化失败时返回 nullptr
+ */
+video_thumbnailer *MovieService::acquireThumbnailer()
 {
     QMutexLocker locker(&m_queuqMutex);
     if (!m_bInitThumb) {
         initThumb();
-        m_mvideo_thumbnailer_destroy_image_data(m_image_data);
+        if (m_image_data != nullptr && m_mvideo_thumbnailer_destroy_image_data != nullptr) {
+            m_mvideo_thumbnailer_destroy_image_data(m_image_data);
+        }
         m_image_data = nullptr;
     }
 
@@ -190,19 +216,21 @@ QImage MovieService::getMovieCover(const QUrl &url)
             || m_mvideo_thumbnailer_destroy_image_data == nullptr
             || m_mvideo_thumbnailer_generate_thumbnail_to_buffer == nullptr
             || m_video_thumbnailer == nullptr) {
-        return QImage();
+        return nullptr;
     }
 
-    m_video_thumbnailer->thumbnail_size = static_cast<int>(THUMBNAIL_SIZE);
-    //不取第一帧，与文管影院保持一致
-//    m_video_thumbnailer->seek_time = const_cast<char *>(SEEK_TIME);
-    m_image_data = m_mvideo_thumbnailer_create_image_data();
-    QString file = QFileInfo(LibUnionImage_NameSpace::localPath(url)).absoluteFilePath();
-    m_mvideo_thumbnailer_generate_thumbnail_to_buffer(m_video_thumbnailer, file.toUtf8().data(), m_image_data);
-    QImage img = QImage::fromData(m_image_data->image_data_ptr, static_cast<int>(m_image_data->image_data_size), "png");
-    m_mvideo_thumbnailer_destroy_image_data(m_image_data);
-    m_image_data = nullptr;
-    return img;
+    if (!m_idleThumbnailers.empty()) {
+        video_thumbnailer *thumbnailer = m_idleThumbnailers.back();
+        m_idleThumbnailers.pop_back();
+        return thumbnailer;
+    }
+    return m_creat_video_thumbnailer();
+}
+
+void MovieService::releaseThumbnailer(video_thumbnailer *thumbnailer)
+{
+    QMutexLocker locker(&m_queuqMutex);
+    m_idleThumbnailers.push_back(thumbnailer);
 }
 
 MovieInfo MovieService::parseFromFile(const QFileInfo &fi)
@@ -333,6 +361,7 @@ void MovieService::initThumb()
 
     m_image_data = m_mvideo_thumbnailer_create_image_data();
     m_video_thumbnailer->thumbnail_size = 400 * qApp->devicePixelRatio();
+    m_idleThumbnailers.push_back(m_video_thumbnailer);
     m_bInitThumb = true;
 }
 
@@ -14,6 +14,7 @@
 #include <mutex>
 #include <QDateTime>
 #include <deque>
+#include <vector>
 #include <QImage>
 #include <libffmpegthumbnailer/videothumbnailerc.h>
 
@@ -100,6 +101,8 @@ private:
     struct MovieInfo parseFromFile(const QFileInfo &fi);
     explicit MovieService(QObject *parent = nullptr);
     void initThumb();
+    video_thumbnailer *acquireThumbnailer();
+    void releaseThumbnailer(video_thumbnailer *thumbnailer);
     void initFFmpeg();
     QString libPath(const QString &strlib);
 private slots:
@@ -115,6 +118,7 @@ private:
 
     video_thumbnailer *m_video_thumbnailer = nullptr;
     image_data *m_image_data = nullptr;
+    std::vector<video_thumbnailer *> m_idleThumbnailers;    // 空闲的缩略图生成器，多线程各自取用
 
     QMutex m_bufferMutex;
     std::deque<std::pair<QUrl, MovieInfo>> m_movieInfoBuffer;
@@ -0,0 +1,285 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "thumbnailcachegc.h"
+#include "imagedataservice.h"
+#include "configsetter.h"
+#include "dbmanager/dbmanager.h"
+#include "unionimage/baseutils.h"
+#include "unionimage/unionimage_global.h"
+#include "utils/cachefile.h"
+#include "utils/workscheduler.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+const QString SETTINGS_GROUP = "Thumbnail";
+const QString SETTINGS_CACHE_BUDGET = "CacheBudgetMB";
+// 默认缓存空间预算
+const qint64 DEFAULT_BUDGET_MB = 2048;
+// 超出预算时淘汰到预算的比例，避免每次生成少量缩略图后再次淘汰
+const double LOW_WATERMARK = 0.9;
+// 单个时间片的耗时上限及时间片之间的间隔
+const int SLICE_MSECS = 20;
+const int SLICE_INTERVAL = 50;
+
+// 缩略图文件名：32位MD5，可选的 "_scale" (旧版本等比例缩略图)，可选的 "_级别"
+const QRegularExpression THUMBNAIL_NAME("^([0-9a-f]{32})(_scale)?(?:_(\\d+))?\\.png$");
+// 原子写入的临时文件：目标文件名.进程号.序号.tmp ，超过该时长仍存在的为写入中途退出遗留
+const QRegularExpression TEMP_NAME("\\.\\d+\\.\\d+\\.tmp$");
+const qint64 TEMP_EXPIRE_SECS = 60 * 60;
+}
+
+ThumbnailCacheGC *ThumbnailCacheGC::instance()
+{
+    static ThumbnailCacheGC ins;
+    return &ins;
+}
+
+ThumbnailCacheGC::ThumbnailCacheGC(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ThumbnailCacheGC::~ThumbnailCacheGC()
+{
+}
+
+void ThumbnailCacheGC::start()
+{
+    bool expected = false;
+    if (!m_running.compare_exchange_strong(expected, true)) {
+        return;
+    }
+
+    WorkScheduler::instance()->submit(WorkScheduler::Background, [this]() {
+        // 回收站中的图片按删除后的存放路径及原路径读取缩略图
+        QStringList livePaths = DBManager::instance()->getAllPaths();
+        for (const DBImgInfo &info : DBManager::instance()->getAllTrashInfos(false)) {
+            livePaths << info.filePath
+                      << Libutils::base::getDeleteFullPath(Libutils::base::hashByString(info.filePath), DBImgInfo::getFileNameFromFilePath(info.filePath));
+        }
+
+        begin(livePaths, albumGlobal::CACHE_PATH, budgetBytes());
+        runSlice();
+    }, WorkCancelToken(), [this]() {
+        m_running = false;
+    });
+}
+
+qint64 ThumbnailCacheGC::budgetBytes() const
+{
+    return LibConfigSetter::instance()->value(SETTINGS_GROUP, SETTINGS_CACHE_BUDGET, DEFAULT_BUDGET_MB).toLongLong() * 1024 * 1024;
+}
+
+void ThumbnailCacheGC::setBudgetBytes(qint64 bytes)
+{
+    LibConfigSetter::instance()->setValue(SETTINGS_GROUP, SETTINGS_CACHE_BUDGET, qMax<qint64>(1, bytes / 1024 / 1024));
+}
+
+bool ThumbnailCacheGC::isOverBudget() const
+{
+    return m_cacheBytes >= 0 && m_cacheBytes >= budgetBytes();
+}
+
+void ThumbnailCacheGC::runSlice()
+{
+    WorkScheduler::instance()->submit(WorkScheduler::Background, [this]() {
+        if (!step(SLICE_MSECS)) {
+            QMetaObject::invokeMethod(this, [this]() {
+                QTimer::singleShot(SLICE_INTERVAL, this, &ThumbnailCacheGC::runSlice);
+            }, Qt::QueuedConnection);
+            return;
+        }
+
+        qDebug() << QString("Thumbnail cache gc finished, scanned:%1 orphans:%2 legacy:%3 temp:%4 evicted:%5 size:%6MB -> %7MB")
+                 .arg(m_stats.scannedFiles).arg(m_stats.removedOrphans).arg(m_stats.removedLegacy).arg(m_stats.removedTemp)
+                 .arg(m_stats.evictedFiles)
+                 .arg(m_stats.bytesBefore / 1024 / 1024).arg(m_stats.bytesAfter / 1024 / 1024);
+        m_running = false;
+        emit finished();
+    }, WorkCancelToken(), [this]() {
+        m_running = false;
+    });
+}
+
+void ThumbnailCacheGC::begin(const QStringList &livePaths, const QString &cacheRoot, qint64 budget)
+{
+    m_cacheRoot = QDir::cleanPath(cacheRoot);
+    m_budget = budget;
+    m_livePaths = QSet<QString>(livePaths.begin(), livePaths.end());
+    m_liveDirs.clear();
+    for (const QString &path : livePaths) {
+        m_liveDirs.insert(QFileInfo(path).path());
+    }
+
+    m_iterator.reset(new QDirIterator(m_cacheRoot, {"*.png", "*" + CacheFile::tempSuffix()}, QDir::Files, QDirIterator::Subdirectories));
+    m_orphanBases.clear();
+    m_groups.clear();
+    m_evictQueue.clear();
+    m_evictIndex = 0;
+    m_totalBytes = 0;
+    m_touchedDirs.clear();
+    m_stats = Stats();
+    m_phase = Scan;
+}
+
+bool ThumbnailCacheGC::step(int msecs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < msecs) {
+        if (Scan == m_phase) {
+            if (!scanNext()) {
+                // 扫描完成，超出预算时按最近使用时间由旧到新淘汰
+                if (m_totalBytes > m_budget) {
+                    m_evictQueue.reserve(m_groups.size());
+                    for (const Group &group : m_groups) {
+                        m_evictQueue << group;
+                    }
+                    std::sort(m_evictQueue.begin(), m_evictQueue.end(), [](const Group &left, const Group &right) {
+                        return left.lastUsed < right.lastUsed;
+                    });
+                }
+                m_groups.clear();
+                m_phase = Evict;
+            }
+        } else if (Evict == m_phase) {
+            if (!evictNext()) {
+                finish();
+            }
+        } else {
+            break;
+        }
+    }
+    return Done == m_phase || Idle == m_phase;
+}
+
+// 处理下一个文件，全部处理完成时返回 false
+bool ThumbnailCacheGC::scanNext()
+{
+    if (!m_iterator->hasNext()) {
+        return false;
+    }
+
+    const QString filePath = m_iterator->next();
+    const QFileInfo info = m_iterator->fileInfo();
+    if (TEMP_NAME.match(info.fileName()).hasMatch()) {
+        if (info.lastModified().secsTo(QDateTime::currentDateTime()) > TEMP_EXPIRE_SECS) {
+            removeFile(filePath);
+            ++m_stats.removedTemp;
+        }
+        return true;
+    }
+
+    const QRegularExpressionMatch match = THUMBNAIL_NAME.match(info.fileName());
+    // 同一目录下的数据库、帧索引等其它文件不处理
+    if (!match.hasMatch()) {
+        return true;
+    }
+
+    ++m_stats.scannedFiles;
+    m_stats.bytesBefore += info.size();
+
+    // 不带级别的为旧版本缩略图，不再使用
+    if (match.capturedLength(3) == 0 || match.capturedLength(2) > 0) {
+        removeFile(filePath);
+        ++m_stats.removedLegacy;
+        return true;
+    }
+
+    const QString base = info.path() + "/" + match.captured(1);
+    if (isOrphan(base, filePath)) {
+        removeFile(filePath);
+        ++m_stats.removedOrphans;
+        return true;
+    }
+
+    Group &group = m_groups[base];
+    group.files << filePath;
+    group.bytes += info.size();
+    group.lastUsed = qMax(group.lastUsed, qMax(info.lastRead().toMSecsSinceEpoch(), info.lastModified().toMSecsSinceEpoch()));
+    m_totalBytes += info.size();
+    return true;
+}
+
+// 淘汰最久未使用的图片，已低于预算时返回 false
+bool ThumbnailCacheGC::evictNext()
+{
+    if (m_totalBytes <= m_budget * LOW_WATERMARK || m_evictIndex >= m_evictQueue.size()) {
+        return false;
+    }
+
+    const Group &group = m_evictQueue.at(m_evictIndex++);
+    for (const QString &filePath : group.files) {
+        removeFile(filePath);
+    }
+    m_totalBytes -= group.bytes;
+    m_stats.evictedFiles += group.files.size();
+    return true;
+}
+
+void ThumbnailCacheGC::finish()
+{
+    // 按原图目录建立的缓存目录清空后一并删除，避免目录数量持续增长
+    QDir dir;
+    for (const QString &path : m_touchedDirs) {
+        for (QString emptyDir = path; emptyDir.size() > m_cacheRoot.size() && dir.rmdir(emptyDir);) {
+            emptyDir = QFileInfo(emptyDir).path();
+        }
+    }
+
+    m_stats.bytesAfter = m_totalBytes;
+    m_cacheBytes = m_totalBytes;
+    m_iterator.reset();
+    m_livePaths.clear();
+    m_liveDirs.clear();
+    m_orphanBases.clear();
+    m_evictQueue.clear();
+    m_touchedDirs.clear();
+    m_phase = Done;
+}
+
+/**
+ * @brief 判断缩略图是否失效：所在目录对应的原图目录中没有有效图片，
+ *      或记录的原图不在数据库中、已不存在、生成后已被修改(缩略图文件名由原图内容决定，修改后会生成新的缩略图)
+ */
+bool ThumbnailCacheGC::isOrphan(const QString &base, const QString &filePath)
+{
+    auto itr = m_orphanBases.constFind(base);
+    if (itr != m_orphanBases.constEnd()) {
+        return itr.value();
+    }
+
+    bool orphan = true;
+    const QString sourceDir = QFileInfo(base).path().mid(m_cacheRoot.size());
+    if (m_liveDirs.contains(sourceDir)) {
+        QString srcPath;
+        qint64 srcModified = 0;
+        if (ImageDataService::readThumbnailSource(filePath, srcPath, srcModified) && m_livePaths.contains(srcPath)) {
+            const QFileInfo srcInfo(srcPath);
+            orphan = !srcInfo.exists() || srcInfo.lastModified().toSecsSinceEpoch() != srcModified;
+        }
+    }
+
+    m_orphanBases.insert(base, orphan);
+    return orphan;
+}
+
+void ThumbnailCacheGC::removeFile(const QString &filePath)
+{
+    if (QFile::remove(filePath)) {
+        m_touchedDirs.insert(QFileInfo(filePath).path());
+    }
+}
@@ -0,0 +1,105 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef THUMBNAILCACHEGC_H
+#define THUMBNAILCACHEGC_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+class QDirIterator;
+
+/**
+ * @brief 缩略图缓存清理
+ * @details 对照 ImageTable3/TrashTable3 删除原图已删除、移动或内容已变更的缩略图、旧版本格式的缩略图
+ *      及写入中途退出遗留的临时文件，
+ *      剩余缩略图超出空间预算时，按图片(全部级别)最近访问时间由旧到新淘汰，直至低于预算的90%。
+ *      清理分为多个时间片在 WorkScheduler 的 Background 类任务中执行，每个时间片的耗时有上限，
+ *      时间片之间留有间隔，不会长时间占用磁盘。
+ */
+class ThumbnailCacheGC : public QObject
+{
+    Q_OBJECT
+public:
+    struct Stats {
+        int scannedFiles = 0;       // 扫描的缩略图文件数量
+        int removedOrphans = 0;     // 原图已删除、移动或内容已变更
+        int removedLegacy = 0;      // 旧版本格式
+        int removedTemp = 0;        // 写入中途退出遗留的临时文件
+        int evictedFiles = 0;       // 超出空间预算淘汰
+        qint64 bytesBefore = 0;
+        qint64 bytesAfter = 0;
+    };
+
+    static ThumbnailCacheGC *instance();
+
+    // 从数据库读取有效图片并开始分段清理，已在运行时忽略
+    void start();
+    bool isRunning() const { return m_running; }
+
+    // 缓存空间预算，保存在配置文件中
+    qint64 budgetBytes() const;
+    void setBudgetBytes(qint64 bytes);
+    // 最近一次清理后的缓存大小，尚未清理时返回-1
+    qint64 cacheBytes() const { return m_cacheBytes; }
+    bool isOverBudget() const;
+
+    // 分段清理：begin() 后反复调用 step() 直到返回 true ，二者需在同一线程中依次调用
+    void begin(const QStringList &livePaths, const QString &cacheRoot, qint64 budget);
+    bool step(int msecs);
+    Stats stats() const { return m_stats; }
+
+signals:
+    void finished();
+
+private:
+    explicit ThumbnailCacheGC(QObject *parent = nullptr);
+    ~ThumbnailCacheGC() override;
+
+    // 同一图片各级别的缩略图
+    struct Group {
+        QStringList files;
+        qint64 bytes = 0;
+        qint64 lastUsed = 0;
+    };
+
+    enum Phase {
+        Idle,
+        Scan,
+        Evict,
+        Done,
+    };
+
+    void runSlice();
+    bool scanNext();
+    bool evictNext();
+    void finish();
+    bool isOrphan(const QString &base, const QString &filePath);
+    void removeFile(const QString &filePath);
+
+    Phase m_phase = Idle;
+    QString m_cacheRoot;
+    qint64 m_budget = 0;
+    std::unique_ptr<QDirIterator> m_iterator;
+    QSet<QString> m_livePaths;
+    QSet<QString> m_liveDirs;
+    QHash<QString, bool> m_orphanBases;     // 已判断过的图片，避免各级别重复读取文件头
+    QHash<QString, Group> m_groups;
+    QVector<Group> m_evictQueue;
+    int m_evictIndex = 0;
+    qint64 m_totalBytes = 0;
+    QSet<QString> m_touchedDirs;            // 有文件删除的目录，结束时删除其中的空目录
+    Stats m_stats;
+
+    std::atomic<qint64> m_cacheBytes{-1};
+    std::atomic_bool m_running{false};
+};
+
+#endif // THUMBNAILCACHEGC_H
@@ -0,0 +1,356 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "thumbnailpregenerator.h"
+#include "imagedataservice.h"
+#include "thumbnailcachegc.h"
+#include "configsetter.h"
+#include "dbmanager/dbmanager.h"
+#include "unionimage/baseutils.h"
+#include "utils/metrics.h"
+
+#include <QCoreApplication>
+#include <QDBusInterface>
+#include <QDBusReply>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QTimer>
+
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const QString SETTINGS_GROUP = "Thumbnail";
+const QString SETTINGS_PREGENERATE_HEAD = "PregenerateHead";
+const QString SETTINGS_PREGENERATE_CHECKPOINT = "PregenerateCheckpoint";
+const QString SETTINGS_PREGENERATE_FINISHED = "PregenerateFinished";
+
+// 每处理若干张图片保存一次断点
+const int CHECKPOINT_INTERVAL = 50;
+// 限流状态的检查间隔
+const int THROTTLE_CHECK_INTERVAL = 2000;
+// 暂停后重试的间隔
+const int PAUSE_RETRY_INTERVAL = 60 * 1000;
+// 等待用户空闲期间检查是否停止的间隔
+const int STOP_CHECK_INTERVAL = 100;
+// 无输入超过该时长视为用户空闲
+const qint64 SESSION_IDLE_MSECS = 60 * 1000;
+// 每个逻辑CPU的平均负载超过该值时暂停
+const double MAX_LOAD_PER_CPU = 0.7;
+
+#ifdef Q_OS_LINUX
+// glibc 未提供 ioprio 定义，取值见 linux/ioprio.h
+const int IOPRIO_WHO_PROCESS = 1;
+const int IOPRIO_CLASS_IDLE = 3;
+const int IOPRIO_CLASS_SHIFT = 13;
+#endif
+
+// 将当前线程设为最低的CPU及IO优先级
+void setBackgroundPriority()
+{
+#ifdef Q_OS_LINUX
+    const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), 19) != 0) {
+        qWarning() << "ThumbnailPregenerator: setpriority failed";
+    }
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0) {
+        qWarning() << "ThumbnailPregenerator: ioprio_set failed";
+    }
+#endif
+}
+
+// 是否使用电池供电
+bool onBattery()
+{
+    const QDir powerSupply("/sys/class/power_supply");
+    for (const QString &name : powerSupply.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile typeFile(powerSupply.filePath(name + "/type"));
+        QFile statusFile(powerSupply.filePath(name + "/status"));
+        if (typeFile.open(QIODevice::ReadOnly) && typeFile.readAll().trimmed() == "Battery"
+                && statusFile.open(QIODevice::ReadOnly) && statusFile.readAll().trimmed() == "Discharging") {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 每个逻辑CPU的1分钟平均负载，读取失败时返回0
+double loadPerCpu()
+{
+    QFile file("/proc/loadavg");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    bool ok = false;
+    const double load = file.readLine().split(' ').value(0).toDouble(&ok);
+    return ok ? load / qMax(1, QThread::idealThreadCount()) : 0;
+}
+
+// 用户无输入的时长，会话不支持时返回-1
+qint64 sessionIdleMsecs()
+{
+    QDBusInterface screenSaver("org.freedesktop.ScreenSaver", "/org/freedesktop/ScreenSaver", "org.freedesktop.ScreenSaver");
+    if (!screenSaver.isValid()) {
+        return -1;
+    }
+
+    QDBusReply<uint> reply = screenSaver.call("GetSessionIdleTime");
+    return reply.isValid() ? reply.value() : -1;
+}
+}
+
+ThumbnailPregenerator *ThumbnailPregenerator::instance()
+{
+    static ThumbnailPregenerator ins;
+    return &ins;
+}
+
+ThumbnailPregenerator::ThumbnailPregenerator(QObject *parent)
+    : QObject(parent)
+    , m_generator(new ReadThumbnailManager(this))
+{
+    // 单线程且不回收，降低后的优先级只作用于该线程
+    m_pool.setMaxThreadCount(1);
+    m_pool.setExpiryTimeout(-1);
+    m_pool.setObjectName("ThumbnailPregenerator");
+
+    if (qApp) {
+        connect(qApp, &QCoreApplication::aboutToQuit, this, &ThumbnailPregenerator::stop);
+    }
+}
+
+void ThumbnailPregenerator::start()
+{
+    // 运行期间再次启动(如导入完成)，当前一轮结束后重新检查
+    m_pending = true;
+    bool expected = false;
+    if (!m_running.compare_exchange_strong(expected, true)) {
+        return;
+    }
+
+    m_stop = false;
+    m_pool.start([this]() {
+        setBackgroundPriority();
+        while (m_pending.exchange(false) && !m_stop) {
+            runPass();
+        }
+        m_running = false;
+        emit finished();
+    });
+}
+
+void ThumbnailPregenerator::stop()
+{
+    m_stop = true;
+    m_pool.waitForDone();
+}
+
+ThumbnailPregenerator::Throttle ThumbnailPregenerator::currentThrottle()
+{
+    if (onBattery() || loadPerCpu() > MAX_LOAD_PER_CPU) {
+        return Pause;
+    }
+
+    const qint64 idleMsecs = sessionIdleMsecs();
+    return idleMsecs >= 0 && idleMsecs < SESSION_IDLE_MSECS ? WaitIdle : Run;
+}
+
+bool ThumbnailPregenerator::hasThumbnail(const QString &path)
+{
+    // 各级从大到小依次保存，最小级别存在即已生成显示所需的级别，更大的级别在放大显示时生成
+    const QString thumbnailPath = Libutils::base::filePathToThumbnailPath(path);
+    return QFileInfo::exists(ImageDataService::getLevelPath(thumbnailPath, ImageDataService::thumbnailLevels().first()));
+}
+
+double ThumbnailPregenerator::coverage(const QStringList &paths)
+{
+    if (paths.isEmpty()) {
+        return 1;
+    }
+
+    int covered = 0;
+    for (const QString &path : paths) {
+        if (hasThumbnail(path)) {
+            ++covered;
+        }
+    }
+    return static_cast<double>(covered) / paths.size();
+}
+
+int ThumbnailPregenerator::generate(const QStringList &paths)
+{
+    int generated = 0;
+    for (const QString &path : paths) {
+        if (m_stop) {
+            break;
+        }
+        if (generateOne(path)) {
+            ++generated;
+        }
+    }
+    return generated;
+}
+
+// 缺少缩略图时生成，返回是否生成了缩略图
+bool ThumbnailPregenerator::generateOne(const QString &path)
+{
+    if (hasThumbnail(path) || !QFileInfo::exists(path)) {
+        return false;
+    }
+
+    ALBUM_METRICS_SCOPE("thumbnail.pregenerate");
+    //锁定文件操作权限，之后不等待界面，避免与等待本线程的界面加载互相等待
+    DBManager::m_fileMutex.lockForRead();
+    //界面正在生成该图片时跳过
+    if (!ReadThumbnailManager::tryAcquireGenerating(path)) {
+        DBManager::m_fileMutex.unlock();
+        return false;
+    }
+
+    bool generated = false;
+    if (!hasThumbnail(path)) {
+        const QString thumbnailPath = Libutils::base::filePathToThumbnailPath(path);
+        generated = !m_generator->generateThumbnails(path, thumbnailPath, ImageDataService::thumbnailLevels().first()).isNull();
+    }
+    ReadThumbnailManager::releaseGenerating(path);
+    DBManager::m_fileMutex.unlock();
+    return generated;
+}
+
+void ThumbnailPregenerator::saveCheckpoint(const QString &path)
+{
+    LibConfigSetter::instance()->setValue(SETTINGS_GROUP, SETTINGS_PREGENERATE_CHECKPOINT, path);
+}
+
+/**
+ * @brief 按导入时间从新到旧生成缺少的缩略图
+ *      图片库未变化时从上次的断点继续，全部完成后不再检查；
+ *      有新导入或删除的图片时从头检查，已有缩略图的图片仅判断文件是否存在
+ */
+void ThumbnailPregenerator::runPass()
+{
+    // 缓存已超出空间预算时不再预先生成，浏览时按需生成
+    if (ThumbnailCacheGC::instance()->isOverBudget()) {
+        qDebug() << "Thumbnail pregenerate skipped, cache over budget:" << ThumbnailCacheGC::instance()->cacheBytes() / 1024 / 1024 << "MB";
+        return;
+    }
+
+    const QList<QPair<QString, QString>> rows = DBManager::instance()->getPathsByImportTime();
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    // 最新的导入时间及图片数量，任一变化即认为图片库有变化
+    const QString head = rows.first().second + "/" + QString::number(rows.size());
+    LibConfigSetter *config = LibConfigSetter::instance();
+    const bool sameHead = config->value(SETTINGS_GROUP, SETTINGS_PREGENERATE_HEAD).toString() == head;
+    if (sameHead && config->value(SETTINGS_GROUP, SETTINGS_PREGENERATE_FINISHED, false).toBool()) {
+        return;
+    }
+
+    int from = 0;
+    if (sameHead) {
+        const QString checkpoint = config->value(SETTINGS_GROUP, SETTINGS_PREGENERATE_CHECKPOINT).toString();
+        for (int i = 0; i < rows.size() && !checkpoint.isEmpty(); ++i) {
+            if (rows.at(i).first == checkpoint) {
+                from = i + 1;
+                break;
+            }
+        }
+    } else {
+        config->setValue(SETTINGS_GROUP, SETTINGS_PREGENERATE_HEAD, head);
+        config->setValue(SETTINGS_GROUP, SETTINGS_PREGENERATE_FINISHED, false);
+        saveCheckpoint(QString());
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QElapsedTimer throttleTimer;
+    Throttle throttle = currentThrottle();
+    throttleTimer.start();
+
+    // 断点之前的图片可能已被缓存清理删除，覆盖率按实际存在的缩略图统计
+    int covered = 0;
+    for (int i = 0; i < from; ++i) {
+        covered += hasThumbnail(rows.at(i).first) ? 1 : 0;
+    }
+
+    int generated = 0;
+    qint64 generateMsecs = 0;
+    int index = from;
+    bool paused = false;
+    for (; index < rows.size() && !m_stop; ++index) {
+        if (throttleTimer.elapsed() > THROTTLE_CHECK_INTERVAL) {
+            throttle = currentThrottle();
+            throttleTimer.restart();
+        }
+        // 用户正在操作时不生成，等待空闲后继续
+        while (WaitIdle == throttle && !m_stop) {
+            QThread::msleep(STOP_CHECK_INTERVAL);
+            if (throttleTimer.elapsed() > THROTTLE_CHECK_INTERVAL) {
+                throttle = currentThrottle();
+                throttleTimer.restart();
+            }
+        }
+        if (m_stop) {
+            break;
+        }
+        if (Pause == throttle) {
+            paused = true;
+            break;
+        }
+
+        const QString &path = rows.at(index).first;
+        QElapsedTimer itemTimer;
+        itemTimer.start();
+        if (generateOne(path)) {
+            ++generated;
+            generateMsecs += itemTimer.elapsed();
+            ALBUM_METRICS_COUNT("thumbnail.pregenerated", 1);
+        }
+        covered += hasThumbnail(path) ? 1 : 0;
+
+        if ((index + 1) % CHECKPOINT_INTERVAL == 0) {
+            saveCheckpoint(path);
+            emit progress(covered, rows.size());
+        }
+    }
+
+    // 断点之前的图片在之前的处理中已完成
+    if (index > from) {
+        saveCheckpoint(rows.at(index - 1).first);
+    }
+    if (index >= rows.size()) {
+        config->setValue(SETTINGS_GROUP, SETTINGS_PREGENERATE_FINISHED, true);
+    }
+    // 未处理的图片可能已由界面加载时生成
+    for (int i = index; i < rows.size(); ++i) {
+        covered += hasThumbnail(rows.at(i).first) ? 1 : 0;
+    }
+    emit progress(covered, rows.size());
+
+    qDebug() << QString("Thumbnail pregenerate %1, processed:%2/%3 coverage:%4% generated:%5 throughput:%6/s cost:%7ms")
+             .arg(paused ? "paused" : (m_stop ? "stopped" : "finished"))
+             .arg(index)
+             .arg(rows.size())
+             .arg(100.0 * covered / rows.size(), 0, 'f', 1)
+             .arg(generated)
+             .arg(generateMsecs > 0 ? generated * 1000.0 / generateMsecs : 0, 0, 'f', 1)
+             .arg(timer.elapsed());
+
+    // 暂停后稍后重试
+    if (paused) {
+        QMetaObject::invokeMethod(this, [this]() {
+            QTimer::singleShot(PAUSE_RETRY_INTERVAL, this, &ThumbnailPregenerator::start);
+        }, Qt::QueuedConnection);
+    }
+}
@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef THUMBNAILPREGENERATOR_H
+#define THUMBNAILPREGENERATOR_H
+
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <atomic>
+
+class ReadThumbnailManager;
+
+/**
+ * @brief 空闲时在后台预先生成缩略图，避免打开新导入的大量图片时长时间显示空白
+ * @details 按 ImageTable3 中导入时间从新到旧的顺序依次生成缺少的缩略图(全部级别)。
+ *      在独立的线程中以最低的CPU(nice 19)及IO(idle)优先级执行，进程内不可恢复原优先级，
+ *      因此不使用 WorkScheduler 的共享线程。
+ *      使用电池供电或系统负载较高时暂停，稍后重试；用户正在操作时等待空闲后继续。
+ *      界面正在加载的图片由界面生成，与界面共用正在生成的图片集合，同一图片不会重复解码。
+ *      处理进度定时保存，重启后从断点继续，图片库有变化时从头检查。
+ */
+class ThumbnailPregenerator : public QObject
+{
+    Q_OBJECT
+public:
+    enum Throttle {
+        Run = 0,    // 系统空闲，连续生成
+        WaitIdle,   // 用户正在操作，等待空闲后继续
+        Pause,      // 电池供电或负载过高，暂停后重试
+    };
+
+    static ThumbnailPregenerator *instance();
+
+    // 启动后台生成，已在运行时忽略
+    void start();
+    // 停止并等待当前图片完成，保存断点
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    // 当前系统状态对应的限流方式
+    static Throttle currentThrottle();
+    // 图片是否已生成缩略图
+    static bool hasThumbnail(const QString &path);
+    // paths 中已生成缩略图的比例(0-1)
+    static double coverage(const QStringList &paths);
+
+    // 按顺序生成 paths 中缺少的缩略图，不做限流，返回生成的数量
+    int generate(const QStringList &paths);
+
+signals:
+    // 处理进度，covered 为已有缩略图的图片数量
+    void progress(int covered, int total);
+    void finished();
+
+private:
+    explicit ThumbnailPregenerator(QObject *parent = nullptr);
+
+    void runPass();
+    bool generateOne(const QString &path);
+    void saveCheckpoint(const QString &path);
+
+    QThreadPool m_pool;
+    ReadThumbnailManager *m_generator;
+    std::atomic_bool m_running{false};
+    std::atomic_bool m_stop{false};
+    std::atomic_bool m_pending{false};
+};
+
+#endif // THUMBNAILPREGENERATOR_H
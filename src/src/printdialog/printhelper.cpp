@@ -13,15 +13,41 @@
 #include <QCoreApplication>
 #include <QImageReader>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTimer>
 
 #include <DApplication>
 
 
 #include "printhelper.h"
 #include "unionimage/unionimage.h"
+#include "utils/metrics.h"
 
 
 
+// 预览时缓存的页面数量，超出后释放最早绘制的页面
+static const int sc_PreviewCacheCount = 4;
+
+/**
+ * @brief 读取当前进程的常驻内存(KB)，读取失败返回0
+ */
+static qint64 residentMemoryKB()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return 0;
+    }
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith("VmRSS:")) {
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    return 0;
+}
+
 PrintHelper *PrintHelper::m_Printer = nullptr;
 
 PrintHelper *PrintHelper::getIntance()
@@ -98,33 +124,22 @@ static QAction *hookToolBarActionIcons(QToolBar *bar, QAction **pageSetupAction
 void PrintHelper::showPrintDialog(const QStringList &paths, QWidget *parent)
 {
     Q_UNUSED(parent)
-    m_re->m_paths.clear();
-    m_re->m_imgs.clear();
+    QElapsedTimer timer;
+    timer.start();
 
-    m_re->m_paths = paths;
-    QStringList tempExsitPaths;//保存存在的图片路径
-    QImage imgTemp;
-    for (const QString &path : paths) {
-        QString errMsg;
-        QImageReader imgReadreder(path);
-        if (imgReadreder.imageCount() > 1) {
-            for (int imgindex = 0; imgindex < imgReadreder.imageCount(); imgindex++) {
-                imgReadreder.jumpToImage(imgindex);
-                m_re->m_imgs << imgReadreder.read();
-            }
-        } else {
-            //QImage不应该多次赋值，所以换到这里来，修复style问题
-            QImage img;
-            LibUnionImage_NameSpace::loadStaticImageFromFile(path, img, errMsg);
-            if (!img.isNull()) {
-                m_re->m_imgs << img;
-            }
-        }
-        tempExsitPaths << paths;
+    // 仅读取文件头获取页数，图片在绘制页面时按需解码
+    m_re->setPaths(paths);
+    QStringList tempExsitPaths = m_re->m_paths;//保存存在的图片路径
+    qDebug() << QString("Print %1 images, %2 pages, prepare cost %3 ms")
+             .arg(tempExsitPaths.size()).arg(m_re->pageCount()).arg(timer.elapsed());
 
-    }
-    //看图采用同步,因为只有一张图片
     DPrintPreviewDialog printDialog2(nullptr);
+    // 对话框进入事件循环后记录打开耗时(含首次预览绘制)
+    QTimer::singleShot(0, &printDialog2, [timer]() {
+        static LatencyHistogram *const histogram = MetricsRegistry::instance()->histogram("print.timeToDialog");
+        histogram->record(static_cast<quint64>(timer.nsecsElapsed() / 1000));
+        qInfo() << QString("Print dialog shown in %1 ms").arg(timer.elapsed());
+    });
 #if (DTK_VERSION_MAJOR > 5 \
     || (DTK_VERSION_MAJOR >=5 && DTK_VERSION_MINOR > 4) \
     || (DTK_VERSION_MAJOR >= 5 && DTK_VERSION_MINOR >= 4 && DTK_VERSION_PATCH >= 10))//5.4.4暂时没有合入
@@ -138,19 +153,28 @@ void PrintHelper::showPrintDialog(const QStringList &paths, QWidget *parent)
         }
     }
 #endif
+
+#if PRINT_ASYNC_PREVIEW
+    // 异步预览仅请求绘制可见页面，打印时按页范围请求
+    printDialog2.setAsynPreview(m_re->pageCount());
+    connect(&printDialog2, SIGNAL(paintRequested(DPrinter *, const QVector<int> &)),
+            m_re, SLOT(paintRequestAsync(DPrinter *, const QVector<int> &)));
+#else
     connect(&printDialog2, SIGNAL(paintRequested(DPrinter *)),
             m_re, SLOT(paintRequestSync(DPrinter *)));
+#endif
 
 #ifndef USE_TEST
     printDialog2.exec();
 #else
     printDialog2.show();
 #endif
-    m_re->m_paths.clear();
-    m_re->m_imgs.clear();
+    m_re->reportPeakMemory();
+    m_re->clear();
 }
 
 RequestedSlot::RequestedSlot(QObject *parent)
+    : m_pageCache(sc_PreviewCacheCount)
 {
     Q_UNUSED(parent)
 }
@@ -160,37 +184,164 @@ RequestedSlot::~RequestedSlot()
 
 }
 
-void RequestedSlot::paintRequestSync(DPrinter *_printer)
+/**
+ * @brief 设置打印的图片路径，多页图的每一帧作为单独的页面，不存在的文件将被忽略
+ */
+void RequestedSlot::setPaths(const QStringList &paths)
 {
-    //由于之前再度修改了打印的逻辑，导致了相同图片不在被显示，多余多页tiff来说不合理
-    QPainter painter(_printer);
-    int indexNum = 0;
-    for (QImage img : m_imgs) {
-        if (!img.isNull()) {
-            painter.setRenderHint(QPainter::Antialiasing);
-            painter.setRenderHint(QPainter::SmoothPixmapTransform);
-            QRectF wRect = _printer->pageRect(QPrinter::DevicePixel);
-            //修复bug98129，打印不完全问题，ratio应该是适应宽或者高，不应该直接适应宽
-            qreal ratio = 0.0;
-            qDebug() << wRect;
-            ratio = wRect.width() * 1.0 / img.width();
-            if (qreal(wRect.height() - img.height() * ratio) > 0) {
-                painter.drawImage(QRectF(0, abs(qreal(wRect.height() - img.height() * ratio)) / 2,
-                                         wRect.width(), img.height() * ratio), img);
-            } else {
-                ratio = wRect.height() * 1.0 / img.height();
-                painter.drawImage(QRectF(qreal(wRect.width() - img.width() * ratio) / 2, 0,
-                                         img.width() * ratio, wRect.height()), img);
+    clear();
+
+    for (const QString &path : paths) {
+        if (!QFileInfo::exists(path)) {
+            continue;
+        }
+        m_paths << path;
+
+        QImageReader imgReadreder(path);
+        int imageCount = imgReadreder.imageCount();
+        if (imageCount > 1) {
+            for (int imgindex = 0; imgindex < imageCount; imgindex++) {
+                m_pages << PrintPage {path, imgindex};
             }
+        } else {
+            m_pages << PrintPage {path, -1};
+        }
+    }
+
+    m_baseMemory = residentMemoryKB();
+    m_peakMemory = m_baseMemory;
+}
+
+void RequestedSlot::clear()
+{
+    m_paths.clear();
+    m_pages.clear();
+    m_pageCache.clear();
+}
+
+int RequestedSlot::pageCount() const
+{
+    return m_pages.size();
+}
+
+void RequestedSlot::reportPeakMemory()
+{
+    ALBUM_METRICS_COUNT("print.pages", static_cast<quint64>(m_pages.size()));
+    qInfo() << QString("Print %1 pages, peak memory %2 KB (+%3 KB)")
+            .arg(m_pages.size()).arg(m_peakMemory).arg(qMax<qint64>(0, m_peakMemory - m_baseMemory));
+}
 
+/**
+ * @brief 页面绘制后采样常驻内存，此时解码的页面图像仍未释放
+ */
+void RequestedSlot::sampleMemory()
+{
+    m_peakMemory = qMax(m_peakMemory, residentMemoryKB());
+}
 
+/**
+ * @brief 按打印设备分辨率解码第 \a index 页，图片长边不超过页面长边 \a targetSize ，
+ *      解码结果放入少量页面缓存中，超出后最早绘制的页面被释放
+ */
+QImage RequestedSlot::loadPage(int index, const QSize &targetSize)
+{
+    // 图片可能包含旋转信息，以页面长边作为解码尺寸上限
+    const int maxEdge = qMax(targetSize.width(), targetSize.height());
+    if (QImage *cached = m_pageCache.object(index)) {
+        if (qMax(cached->width(), cached->height()) >= maxEdge || cached->text("FullSize") == "true") {
+            return *cached;
         }
-        indexNum++;
-        if (indexNum != m_imgs.size()) {
-            _printer->newPage();
+    }
+
+    const PrintPage &page = m_pages.at(index);
+    QImage img;
+    bool fullSize = true;
+
+    QImageReader reader(page.path);
+    reader.setAutoTransform(true);
+    if (page.frameIndex >= 0) {
+        reader.jumpToImage(page.frameIndex);
+    }
+    QSize imageSize = reader.size();
+    if (imageSize.isValid() && qMax(imageSize.width(), imageSize.height()) > maxEdge) {
+        // 支持缩放解码的格式(如JPEG)可直接以较低分辨率解码
+        reader.setScaledSize(imageSize.scaled(maxEdge, maxEdge, Qt::KeepAspectRatio));
+        fullSize = false;
+    }
+    img = reader.read();
 
+    if (img.isNull() && page.frameIndex < 0) {
+        QString errMsg;
+        LibUnionImage_NameSpace::loadStaticImageFromFile(page.path, img, errMsg);
+        fullSize = true;
+        if (!img.isNull() && qMax(img.width(), img.height()) > maxEdge) {
+            img = img.scaled(maxEdge, maxEdge, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            fullSize = false;
+        }
+    }
+
+    if (!img.isNull()) {
+        img.setText("FullSize", fullSize ? "true" : "false");
+        m_pageCache.insert(index, new QImage(img));
+    } else {
+        qWarning() << "Load print page failed:" << page.path << page.frameIndex;
+    }
+    return img;
+}
+
+void RequestedSlot::paintPage(QPainter &painter, DPrinter *_printer, int index)
+{
+    QRectF wRect = _printer->pageRect(QPrinter::DevicePixel);
+    QImage img = loadPage(index, wRect.size().toSize());
+    if (img.isNull()) {
+        return;
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    //修复bug98129，打印不完全问题，ratio应该是适应宽或者高，不应该直接适应宽
+    qreal ratio = 0.0;
+    ratio = wRect.width() * 1.0 / img.width();
+    if (qreal(wRect.height() - img.height() * ratio) > 0) {
+        painter.drawImage(QRectF(0, abs(qreal(wRect.height() - img.height() * ratio)) / 2,
+                                 wRect.width(), img.height() * ratio), img);
+    } else {
+        ratio = wRect.height() * 1.0 / img.height();
+        painter.drawImage(QRectF(qreal(wRect.width() - img.width() * ratio) / 2, 0,
+                                 img.width() * ratio, wRect.height()), img);
+    }
+    sampleMemory();
+}
+
+void RequestedSlot::paintRequestSync(DPrinter *_printer)
+{
+    //由于之前再度修改了打印的逻辑，导致了相同图片不在被显示，多余多页tiff来说不合理
+    QPainter painter(_printer);
+    for (int index = 0; index < m_pages.size(); index++) {
+        paintPage(painter, _printer, index);
+        if (index + 1 != m_pages.size()) {
+            _printer->newPage();
         }
     }
     painter.end();
 }
 
+/**
+ * @brief 按页绘制，\a pageRange 为从1开始的页码
+ */
+void RequestedSlot::paintRequestAsync(DPrinter *_printer, const QVector<int> &pageRange)
+{
+    QPainter painter(_printer);
+    for (int i = 0; i < pageRange.size(); i++) {
+        int index = pageRange.at(i) - 1;
+        if (index < 0 || index >= m_pages.size()) {
+            continue;
+        }
+
+        paintPage(painter, _printer, index);
+        if (i + 1 != pageRange.size()) {
+            _printer->newPage();
+        }
+    }
+    painter.end();
+}
@@ -6,24 +6,56 @@
 #define PRINTHELPER_H
 
 #include <QObject>
+#include <QCache>
+#include <QImage>
 
 #include <dprintpreviewwidget.h>
 #include <dprintpreviewdialog.h>
 DWIDGET_USE_NAMESPACE
+
+class QPainter;
+
+// DTK 支持按页异步预览(仅绘制预览中可见的页面)
+#define PRINT_ASYNC_PREVIEW (DTK_VERSION_MAJOR > 5 || (DTK_VERSION_MAJOR == 5 && DTK_VERSION_MINOR >= 6))
+
 //重构printhelper，因为dtk更新
 //绘制图片处理类
+//打印页面仅记录图片路径及帧索引，绘制时按打印机分辨率解码，仅缓存少量最近绘制的页面
 class RequestedSlot : public QObject
 {
     Q_OBJECT
 public:
     explicit RequestedSlot(QObject *parent = nullptr);
     ~RequestedSlot();
+
+    struct PrintPage {
+        QString path;
+        int frameIndex = -1;    // 多页图的帧索引，-1表示非多页图
+    };
+
+    void setPaths(const QStringList &paths);
+    void clear();
+    int pageCount() const;
+    // 输出打印过程中相对打开前的内存峰值增量
+    void reportPeakMemory();
+
 private slots:
     void paintRequestSync(DPrinter *_printer);
+    void paintRequestAsync(DPrinter *_printer, const QVector<int> &pageRange);
+
+private:
+    void paintPage(QPainter &painter, DPrinter *_printer, int index);
+    QImage loadPage(int index, const QSize &targetSize);
+    void sampleMemory();
 
 public:
     QStringList m_paths;
-    QList<QImage> m_imgs;
+
+private:
+    QList<PrintPage> m_pages;
+    QCache<int, QImage> m_pageCache;    // 最近绘制的页面，预览刷新时无需重复解码
+    qint64 m_baseMemory = 0;            // 设置打印图片时的常驻内存(KB)
+    qint64 m_peakMemory = 0;            // 绘制页面后采样的常驻内存峰值(KB)
 };
 class PrintHelper : public QObject
 {
@@ -7,6 +7,10 @@
 #include "configsetter.h"
 #include "imageengine/movieservice.h"
 #include "dbmanager/dbmanager.h"
+#include "utils/metrics.h"
+#include "imagedata/multiframeindex.h"
+#include "utils/imagescaler.h"
+#include "imageengine/collectioncovercache.h"
 #include <QPainter>
 
 const QString SETTINGS_GROUP = "Thumbnail";
@@ -21,15 +25,17 @@ ThumbnailLoad::ThumbnailLoad()
 
 QImage ThumbnailLoad::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
+    ALBUM_METRICS_SCOPE("provider.thumbnail.requestImage");
     QString tempPath = LibUnionImage_NameSpace::localPath(id);
     QImage Img;
     QString error;
 
     QMutexLocker _locker(&m_mutex);
     if (!m_imgMap.keys().contains(tempPath)) {
+        ALBUM_METRICS_COUNT("provider.thumbnail.cacheMiss", 1);
         LibUnionImage_NameSpace::loadStaticImageFromFile(tempPath, Img, error);
         // 保存图片比例缩放
-        QImage reImg = Img.scaled(100, 100, Qt::KeepAspectRatio);
+        QImage reImg = ImageScaler::scaled(Img, QSize(100, 100), Qt::KeepAspectRatio);
         m_imgMap[tempPath] = reImg;
         return reImg;
     } else {
@@ -355,7 +361,6 @@ void ViewLoad::reloadImageCache(const QString &path)
 MultiImageLoad::MultiImageLoad()
     : QQuickImageProvider(QQuickImageProvider::Image)
 {
-    m_imageCache.setMaxCost(256);
 }
 
 /**
@@ -393,37 +398,9 @@ QImage MultiImageLoad::requestImage(const QString &id, QSize *size, const QSize
     int frame = checkId.right(checkId.size() - index - s_tagFrame.size()).toInt();
 
     QString tempPath = LibUnionImage_NameSpace::localPath(path);
-    QImage img;
-
-    // 数据变更前加锁
-    QMutexLocker _locker(&m_mutex);
-    if (tempPath != m_imageReader.fileName()
-            || !m_imageReader.canRead()) {
-        // 重新设置图像读取类
-        m_imageReader.setFileName(tempPath);
-    }
-
-    // 获取图像数据
-    auto key = qMakePair(tempPath, frame);
-    bool hasThumbnail = m_imageCache.contains(key);
-    if (hasThumbnail && useThumbnail) {
-        // 返回缓存缩略图信息
-        img = m_imageCache.object(key)->imgThumbnail;
-    } else {
-        if (m_imageReader.jumpToImage(frame)) {
-            // 读取图像数据
-            img = m_imageReader.read();
-            // 判断是否正常读取
-            if (img.isNull()) {
-                return img;
-            }
-
-            // 不存在缩略图信息，缓存图片
-            if (!hasThumbnail) {
-                m_imageCache.insert(key, new CacheImage(img));
-            }
-        }
-    }
+    // 帧索引及预览缓存内部加锁，此处无需额外加锁
+    QImage img = useThumbnail ? MultiFrameIndex::instance()->framePreview(tempPath, frame, QSize(100, 100))
+                              : MultiFrameIndex::instance()->readFrame(tempPath, frame);
 
     // 调整图像大小
     if (!img.isNull() && img.size() != requestedSize && requestedSize.width() > 0 && requestedSize.height() > 0) {
@@ -446,14 +423,7 @@ QPixmap MultiImageLoad::requestPixmap(const QString &id, QSize *size, const QSiz
 int MultiImageLoad::getImageWidth(const QString &path, int frameIndex)
 {
     QString tempPath = LibUnionImage_NameSpace::localPath(path);
-    auto key = qMakePair(tempPath, frameIndex);
-
-    QMutexLocker _locker(&m_mutex);
-    CacheImage *cache = m_imageCache.object(key);
-    if (cache) {
-        return cache->originSize.width();
-    }
-    return 0;
+    return qMax(0, MultiFrameIndex::instance()->frameSize(tempPath, frameIndex).width());
 }
 
 /**
@@ -462,14 +432,7 @@ int MultiImageLoad::getImageWidth(const QString &path, int frameIndex)
 int MultiImageLoad::getImageHeight(const QString &path, int frameIndex)
 {
     QString tempPath = LibUnionImage_NameSpace::localPath(path);
-    auto key = qMakePair(tempPath, frameIndex);
-
-    QMutexLocker _locker(&m_mutex);
-    CacheImage *cache = m_imageCache.object(key);
-    if (cache) {
-        return cache->originSize.height();
-    }
-    return 0;
+    return qMax(0, MultiFrameIndex::instance()->frameSize(tempPath, frameIndex).height());
 }
 
 /**
@@ -506,26 +469,7 @@ double MultiImageLoad::getFitWindowScale(const QString &path, double WindowWidth
 void MultiImageLoad::removeImageCache(const QString &path)
 {
     QString tempPath = LibUnionImage_NameSpace::localPath(path);
-    QMutexLocker _locker(&m_mutex);
-    // 移除关联的图像
-    QList<QPair<QString, int> > keys = m_imageCache.keys();
-    for (auto itr = keys.begin(); itr != keys.end(); ++itr) {
-        if (itr->first == tempPath) {
-            m_imageCache.remove(*itr);
-        }
-    }
-    // 移除图像读取类
-    if (m_imageReader.fileName() == tempPath) {
-        m_imageReader.setDevice(nullptr);
-    }
-}
-
-MultiImageLoad::CacheImage::CacheImage(const QImage &img)
-{
-    // 缩略图大小
-    static const QSize s_ThumbnailSize(100, 100);
-    imgThumbnail = img.scaled(s_ThumbnailSize);
-    originSize = img.size();
+    MultiFrameIndex::instance()->remove(tempPath);
 }
 
 ImagePublisher::ImagePublisher(QObject *parent)
@@ -562,68 +506,22 @@ int ImagePublisher::getLoadMode()
 //将图片裁剪为方图，逻辑与原来一样
 QImage ImagePublisher::clipToRect(const QImage &src)
 {
-    auto tImg = src;
-
-    if (!tImg.isNull() && 0 != tImg.height() && 0 != tImg.width() && (tImg.height() / tImg.width()) < 10 && (tImg.width() / tImg.height()) < 10) {
-        bool cache_exist = false;
-        if (tImg.height() != THUMBNAIL_MAX_SIZE && tImg.width() != THUMBNAIL_MAX_SIZE) {
-            if (tImg.height() >= tImg.width()) {
-                cache_exist = true;
-                tImg = tImg.scaledToWidth(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            } else if (tImg.height() <= tImg.width()) {
-                cache_exist = true;
-                tImg = tImg.scaledToHeight(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            }
-        }
-        if (!cache_exist) {
-            if ((static_cast<float>(tImg.height()) / (static_cast<float>(tImg.width()))) > 3) {
-                tImg = tImg.scaledToWidth(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            } else {
-                tImg = tImg.scaledToHeight(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            }
-        }
-    }
-
-    if (!tImg.isNull()) {
-        int width = tImg.width();
-        int height = tImg.height();
-        if (abs((width - height) * 10 / width) >= 1) {
-            QRect rect = tImg.rect();
-            int x = rect.x() + width / 2;
-            int y = rect.y() + height / 2;
-            if (width > height) {
-                x = x - height / 2;
-                y = 0;
-                tImg = tImg.copy(x, y, height, height);
-            } else {
-                y = y - width / 2;
-                x = 0;
-                tImg = tImg.copy(x, y, width, width);
-            }
-        }
-    }
-
-    return tImg;
+    //缩放与裁切一次完成，不生成原尺寸的中间图
+    return ImageScaler::clipToSquare(src, THUMBNAIL_MAX_SIZE);
 }
 
 //将图片按比例缩小
 QImage ImagePublisher::addPadAndScaled(const QImage &src)
 {
-    auto result = src.convertToFormat(QImage::Format_RGBA8888);
-
-    if (result.height() > result.width()) {
-        result = result.scaledToHeight(THUMBNAIL_MAX_SIZE, Qt::SmoothTransformation);
-    } else {
-        result = result.scaledToWidth(THUMBNAIL_MAX_SIZE, Qt::SmoothTransformation);
-    }
-
-    return result;
+    auto result = ImageScaler::scaled(src, QSize(THUMBNAIL_MAX_SIZE, THUMBNAIL_MAX_SIZE), Qt::KeepAspectRatio);
+    return result.convertToFormat(QImage::Format_RGBA8888);
 }
 
 //图片请求类
 //警告：这个函数将会被多线程执行，需要确保它是可重入的
 QImage ImagePublisher::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
+    ALBUM_METRICS_SCOPE("provider.publisher.requestImage");
     //id的前几个字符是强制刷新用的，需要排除出去
     auto startIndex = id.indexOf('_') + 1;
 
@@ -662,6 +560,7 @@ CollectionPublisher::CollectionPublisher()
 //id: random_Y_2022_0 random_M_2022_6
 QImage CollectionPublisher::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
+    ALBUM_METRICS_SCOPE("provider.collection.requestImage");
     auto tokens = id.split("_");
 
     QImage result;
@@ -690,21 +589,8 @@ QImage CollectionPublisher::requestImage(const QString &id, QSize *size, const Q
 
 QImage CollectionPublisher::createYearImage(const QString &year)
 {
-    auto paths = DBManager::instance()->getYearPaths(year, 1);
-    if (paths.isEmpty()) {
-        return QImage();
-    }
-    auto picPath = paths.at(0);
-
-    //TODO: 异常处理：裂图问题
-
-    //加载原图
-    QImage image;
-    QString error;
-    LibUnionImage_NameSpace::loadStaticImageFromFile(picPath, image, error);
-    image = image.scaled(outputWidth, outputHeight, Qt::KeepAspectRatioByExpanding);
-
-    return image;
+    //封面预先合成并缓存，该年图片未变化时不再解码原图
+    return CollectionCoverCache::yearCover(year, QSize(outputWidth, outputHeight));
 }
 
 QImage CollectionPublisher::createMonthCellImage(const QString &path, const CollectionPublisher::ImageSize &sizeType)
@@ -724,14 +610,11 @@ QImage CollectionPublisher::createMonthCellImage(const QString &path, const Coll
     else if (ImageSize_Split_Fifth == sizeType)
         requestSize = QSize(outputWidth / 5, static_cast<int>(outputHeight * (1 - 0.618)));
 
-    //1.加载原图
-    QImage image;
-    QString error;
-    if (LibUnionImage_NameSpace::isVideo(path))
-        image = MovieService::instance()->getMovieCover(QUrl::fromLocalFile(path));
-    else
-        LibUnionImage_NameSpace::loadStaticImageFromFile(path, image, error);
-    image = image.scaled(outputWidth, outputHeight, Qt::KeepAspectRatioByExpanding);
+    //1.加载图片，缩略图缓存足够大时不解码原图
+    QImage image = CollectionCoverCache::sourceImage(path, requestSize);
+    if (image.isNull()) {
+        return image;
+    }
 
     // 2.根据比例裁剪
     image = clipHelper(image, requestSize.width(), requestSize.height());
@@ -782,6 +665,15 @@ QImage CollectionPublisher::clipHelper(const QImage &image, int width, int heigh
 
 void AsyncImageResponseAlbum::run()
 {
+    static LatencyHistogram *const queueWait = MetricsRegistry::instance()->histogram("provider.async.queueWait");
+    queueWait->record(static_cast<quint64>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                               std::chrono::steady_clock::now() - m_requestTime).count()));
+    ALBUM_METRICS_SCOPE("provider.async.run");
+    if (m_cancelToken.isCancelled()) {
+        emit finished();
+        return;
+    }
+
     //id的前几个字符是强制刷新用的，需要排除出去
     auto startIndex = m_id.indexOf('_') + 1;
 
@@ -811,62 +703,15 @@ void AsyncImageResponseAlbum::run()
 //将图片裁剪为方图，逻辑与原来一样
 QImage AsyncImageResponseAlbum::clipToRect(const QImage &src)
 {
-    auto tImg = src;
-
-    if (!tImg.isNull() && 0 != tImg.height() && 0 != tImg.width() && (tImg.height() / tImg.width()) < 10 && (tImg.width() / tImg.height()) < 10) {
-        bool cache_exist = false;
-        if (tImg.height() != THUMBNAIL_MAX_SIZE && tImg.width() != THUMBNAIL_MAX_SIZE) {
-            if (tImg.height() >= tImg.width()) {
-                cache_exist = true;
-                tImg = tImg.scaledToWidth(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            } else if (tImg.height() <= tImg.width()) {
-                cache_exist = true;
-                tImg = tImg.scaledToHeight(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            }
-        }
-        if (!cache_exist) {
-            if ((static_cast<float>(tImg.height()) / (static_cast<float>(tImg.width()))) > 3) {
-                tImg = tImg.scaledToWidth(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            } else {
-                tImg = tImg.scaledToHeight(THUMBNAIL_MAX_SIZE,  Qt::FastTransformation);
-            }
-        }
-    }
-
-    if (!tImg.isNull()) {
-        int width = tImg.width();
-        int height = tImg.height();
-        if (abs((width - height) * 10 / width) >= 1) {
-            QRect rect = tImg.rect();
-            int x = rect.x() + width / 2;
-            int y = rect.y() + height / 2;
-            if (width > height) {
-                x = x - height / 2;
-                y = 0;
-                tImg = tImg.copy(x, y, height, height);
-            } else {
-                y = y - width / 2;
-                x = 0;
-                tImg = tImg.copy(x, y, width, width);
-            }
-        }
-    }
-
-    return tImg;
+    //缩放与裁切一次完成，不生成原尺寸的中间图
+    return ImageScaler::clipToSquare(src, THUMBNAIL_MAX_SIZE);
 }
 
 //将图片按比例缩小
 QImage AsyncImageResponseAlbum::addPadAndScaled(const QImage &src)
 {
-    auto result = src.convertToFormat(QImage::Format_RGBA8888);
-
-    if (result.height() > result.width()) {
-        result = result.scaledToHeight(THUMBNAIL_MAX_SIZE, Qt::SmoothTransformation);
-    } else {
-        result = result.scaledToWidth(THUMBNAIL_MAX_SIZE, Qt::SmoothTransformation);
-    }
-
-    return result;
+    auto result = ImageScaler::scaled(src, QSize(THUMBNAIL_MAX_SIZE, THUMBNAIL_MAX_SIZE), Qt::KeepAspectRatio);
+    return result.convertToFormat(QImage::Format_RGBA8888);
 }
 
 AsyncImageProviderAlbum::AsyncImageProviderAlbum(QObject *parent)
@@ -5,14 +5,16 @@
 #ifndef THUMBNAILLOAD_H
 #define THUMBNAILLOAD_H
 
+#include "utils/workscheduler.h"
+
 #include <QQuickImageProvider>
 #include <QQuickWindow>
 #include <QImageReader>
 #include <QImage>
 #include <QCache>
 #include <QMutex>
-#include <QThreadPool>
 
+#include <chrono>
 #include <deque>
 
 //大图预览下的小图
@@ -81,19 +83,6 @@ public:
 
     // 移除缓存的图片大小信息
     void removeImageCache(const QString &path);
-
-private:
-    QMutex              m_mutex;
-    QImageReader        m_imageReader;      // 图像读取类
-
-    // 缓存图片信息
-    struct CacheImage {
-        QImage  imgThumbnail;   // 图片缩略图
-        QSize   originSize;     // 原始图片大小
-
-        explicit CacheImage(const QImage &img);
-    };
-    QCache<QPair<QString, int>, CacheImage> m_imageCache;   // 缩略图缓存(默认最多缓存256组图像)
 };
 
 //缩略图
@@ -176,7 +165,7 @@ class AsyncImageResponseAlbum : public QQuickImageResponse, public QRunnable
 {
 public:
     AsyncImageResponseAlbum(const QString &id, const QSize &requestedSize)
-        : m_id(id), m_requestedSize(requestedSize)
+        : m_id(id), m_requestedSize(requestedSize), m_requestTime(std::chrono::steady_clock::now())
     {
         setAutoDelete(false);
     }
@@ -186,6 +175,12 @@ public:
         return QQuickTextureFactory::textureFactoryForImage(m_image);
     }
 
+    // 图片已不需要显示(如快速滚动划出可见区域)，未执行时跳过加载
+    void cancel() override
+    {
+        m_cancelToken.cancel();
+    }
+
     void run() override;
 
     void setLoadMode(int mod)
@@ -202,6 +197,8 @@ private:
     QString m_id;
     QSize m_requestedSize;
     QImage m_image;
+    std::chrono::steady_clock::time_point m_requestTime;  // 请求时间，用于统计排队耗时
+    WorkCancelToken m_cancelToken;
 
     int m_loadMode;
 };
@@ -216,7 +213,7 @@ public:
     {
         AsyncImageResponseAlbum *response = new AsyncImageResponseAlbum(id, requestedSize);
         response->setLoadMode(m_loadMode);
-        pool.start(response);
+        WorkScheduler::instance()->start(WorkScheduler::Visible, response);
         return response;
     }
 
@@ -229,8 +226,6 @@ public:
 private:
     //加载模式控制，requestImage是由QML引擎多线程调用，此处需要采用原子锁，防止崩溃
     std::atomic_int m_loadMode;
-
-    QThreadPool pool;
 };
 //异步缩略图_end
 
@@ -0,0 +1,581 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "atlasimageitem.h"
+#include "qimageitem.h"
+#include "../imageengine/imagedataservice.h"
+
+#include "../utils/metrics.h"
+
+#include <QCache>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QPainter>
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QSGRenderNode>
+#include <QSGRendererInterface>
+#include <QSGTexture>
+#include <QSGTextureMaterial>
+#include <QSharedPointer>
+#include <QTimer>
+
+#include <cmath>
+
+namespace {
+
+// 单个窗口最多缓存的缩略图纹理数量，超出后按LRU淘汰(仍被节点引用的纹理不会被释放)
+const int MAX_CACHE_TEXTURE_COUNT = 1024;
+// 圆角每个角的分段数上限，圆角较小时按半径减少
+const int MAX_CORNER_SEGMENTS = 8;
+
+/**
+ * @brief 窗口级别的缩略图纹理缓存，以 QImage::cacheKey() 为索引。
+ * @warning 除创建和销毁外，仅允许在对应窗口的渲染线程中访问
+ */
+class AtlasTextureCache
+{
+public:
+    static AtlasTextureCache *cacheForWindow(QQuickWindow *window);
+
+    QSharedPointer<QSGTexture> texture(const QImage &image);
+    void clear();
+    bool isEmpty() const { return m_textures.isEmpty(); }
+
+private:
+    explicit AtlasTextureCache(QQuickWindow *window);
+
+    QQuickWindow *m_window;
+    QCache<qint64, QSharedPointer<QSGTexture>> m_textures;
+    QElapsedTimer m_renderTimer;    // 单帧渲染耗时，仅在渲染线程访问
+    QElapsedTimer m_frameTimer;     // 相邻两帧的间隔
+};
+
+QMutex s_cacheMutex;
+QHash<QQuickWindow *, AtlasTextureCache *> s_caches;
+
+AtlasTextureCache::AtlasTextureCache(QQuickWindow *window)
+    : m_window(window)
+    , m_textures(MAX_CACHE_TEXTURE_COUNT)
+{
+}
+
+AtlasTextureCache *AtlasTextureCache::cacheForWindow(QQuickWindow *window)
+{
+    QMutexLocker _locker(&s_cacheMutex);
+    AtlasTextureCache *cache = s_caches.value(window);
+    if (!cache) {
+        cache = new AtlasTextureCache(window);
+        s_caches.insert(window, cache);
+
+        // 渲染停止或场景图失效时(如窗口隐藏、关闭、图形上下文丢失)，在渲染线程释放所有纹理
+        QObject::connect(window, &QQuickWindow::sceneGraphAboutToStop, window, [cache]() {
+            cache->clear();
+        }, Qt::DirectConnection);
+        QObject::connect(window, &QQuickWindow::sceneGraphInvalidated, window, [cache]() {
+            cache->clear();
+        }, Qt::DirectConnection);
+        // 记录帧耗时及帧间隔，通过指标快照对比不同渲染后端及改动前后的滚动流畅度
+        QObject::connect(window, &QQuickWindow::beforeRendering, window, [cache]() {
+            cache->m_renderTimer.start();
+        }, Qt::DirectConnection);
+        QObject::connect(window, &QQuickWindow::afterRendering, window, [cache]() {
+            static LatencyHistogram *const s_renderHistogram = MetricsRegistry::instance()->histogram("render.frame");
+            if (cache->m_renderTimer.isValid()) {
+                s_renderHistogram->record(static_cast<quint64>(cache->m_renderTimer.nsecsElapsed() / 1000));
+            }
+        }, Qt::DirectConnection);
+        QObject::connect(window, &QQuickWindow::frameSwapped, window, [cache]() {
+            static LatencyHistogram *const s_intervalHistogram = MetricsRegistry::instance()->histogram("render.frameInterval");
+            if (cache->m_frameTimer.isValid()) {
+                s_intervalHistogram->record(static_cast<quint64>(cache->m_frameTimer.nsecsElapsed() / 1000));
+            }
+            cache->m_frameTimer.start();
+        }, Qt::DirectConnection);
+        // 窗口销毁前场景图已失效，此时缓存已为空，只释放缓存对象本身，不在GUI线程释放纹理
+        QObject::connect(window, &QObject::destroyed, [window]() {
+            QMutexLocker locker(&s_cacheMutex);
+            AtlasTextureCache *cache = s_caches.take(window);
+            if (cache && !cache->isEmpty()) {
+                // 场景图未正常停止，放弃释放，避免在GUI线程中释放纹理
+                qWarning() << "AtlasTextureCache: textures not released before window destroyed";
+                return;
+            }
+            delete cache;
+        });
+    }
+    return cache;
+}
+
+QSharedPointer<QSGTexture> AtlasTextureCache::texture(const QImage &image)
+{
+    const qint64 key = image.cacheKey();
+    if (QSharedPointer<QSGTexture> *cached = m_textures.object(key)) {
+        return *cached;
+    }
+
+    // 允许放入图集，小尺寸缩略图会被合并到共享纹理中，无需为每个委托单独创建纹理
+    ALBUM_METRICS_COUNT("render.textureUpload", 1);
+    QSharedPointer<QSGTexture> texture(m_window->createTextureFromImage(image, QQuickWindow::TextureCanUseAtlas));
+    if (texture) {
+        m_textures.insert(key, new QSharedPointer<QSGTexture>(texture));
+    }
+    return texture;
+}
+
+void AtlasTextureCache::clear()
+{
+    m_textures.clear();
+}
+
+/**
+ * @brief 圆角纹理节点，持有共享纹理引用，节点在渲染线程销毁，保证纹理在渲染线程释放。
+ *      圆角直接由几何形状(以中心点为顶点的三角形)实现，不需要 layer 及遮罩效果，节点仍可与同一图集的其它节点合批
+ */
+class AtlasImageNode : public QSGGeometryNode
+{
+public:
+    AtlasImageNode()
+        : m_geometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0, 0, QSGGeometry::UnsignedShortType)
+    {
+        m_geometry.setDrawingMode(QSGGeometry::DrawTriangles);
+        setGeometry(&m_geometry);
+        setMaterial(&m_material);
+        setOpaqueMaterial(&m_opaqueMaterial);
+    }
+
+    void setTexture(const QSharedPointer<QSGTexture> &newTexture, qint64 key)
+    {
+        texture = newTexture;
+        cacheKey = key;
+        m_material.setTexture(texture.data());
+        m_opaqueMaterial.setTexture(texture.data());
+        markDirty(DirtyMaterial);
+    }
+
+    void setFiltering(QSGTexture::Filtering filtering)
+    {
+        if (m_material.filtering() != filtering) {
+            m_material.setFiltering(filtering);
+            m_opaqueMaterial.setFiltering(filtering);
+            markDirty(DirtyMaterial);
+        }
+    }
+
+    /**
+     * @brief 以圆角矩形显示纹理中的 \a sourceRect (图像像素坐标)到 \a rect ，\a radius 为圆角半径
+     */
+    void updateGeometry(const QRectF &rect, const QRectF &sourceRect, qreal radius)
+    {
+        radius = qBound<qreal>(0, radius, qMin(rect.width(), rect.height()) / 2);
+        const int segments = radius > 0 ? qBound(1, static_cast<int>(radius / 2), MAX_CORNER_SEGMENTS) : 0;
+        // 中心点 + 四个角各 segments+1 个边缘点，每个边缘点与下一个边缘点、中心点构成一个三角形
+        const int edgeCount = 4 * (segments + 1);
+        m_geometry.allocate(1 + edgeCount, 3 * edgeCount);
+
+        // 图像坐标映射为纹理坐标，纹理位于图集中时只占其中一部分
+        const QRectF subRect = texture->normalizedTextureSubRect();
+        const QSize textureSize = texture->textureSize();
+        const qreal left = subRect.x() + sourceRect.x() / textureSize.width() * subRect.width();
+        const qreal top = subRect.y() + sourceRect.y() / textureSize.height() * subRect.height();
+        const qreal scaleX = sourceRect.width() / textureSize.width() * subRect.width() / rect.width();
+        const qreal scaleY = sourceRect.height() / textureSize.height() * subRect.height() / rect.height();
+
+        QSGGeometry::TexturedPoint2D *vertices = m_geometry.vertexDataAsTexturedPoint2D();
+        auto setVertex = [&](int index, qreal x, qreal y) {
+            vertices[index].set(static_cast<float>(x), static_cast<float>(y),
+                                static_cast<float>(left + (x - rect.x()) * scaleX),
+                                static_cast<float>(top + (y - rect.y()) * scaleY));
+        };
+
+        setVertex(0, rect.center().x(), rect.center().y());
+        // 依次为右下、左下、左上、右上角，每个角从0到90度
+        const QPointF centers[4] = {
+            QPointF(rect.right() - radius, rect.bottom() - radius),
+            QPointF(rect.left() + radius, rect.bottom() - radius),
+            QPointF(rect.left() + radius, rect.top() + radius),
+            QPointF(rect.right() - radius, rect.top() + radius),
+        };
+        int index = 1;
+        for (int corner = 0; corner < 4; ++corner) {
+            for (int i = 0; i <= segments; ++i) {
+                const qreal angle = (corner + (segments > 0 ? qreal(i) / segments : 0)) * M_PI / 2;
+                setVertex(index++, centers[corner].x() + radius * std::cos(angle), centers[corner].y() + radius * std::sin(angle));
+            }
+        }
+
+        quint16 *indices = m_geometry.indexDataAsUShort();
+        for (int i = 0; i < edgeCount; ++i) {
+            indices[3 * i] = 0;
+            indices[3 * i + 1] = static_cast<quint16>(1 + i);
+            indices[3 * i + 2] = static_cast<quint16>(1 + (i + 1) % edgeCount);
+        }
+
+        markDirty(DirtyGeometry);
+    }
+
+    QSharedPointer<QSGTexture> texture;
+    qint64 cacheKey = 0;
+
+private:
+    QSGGeometry m_geometry;
+    QSGTextureMaterial m_material;
+    QSGOpaqueTextureMaterial m_opaqueMaterial;
+};
+
+/**
+ * @brief 软件渲染后端使用的节点。software 后端不绘制自定义材质的几何节点，
+ *      改为在渲染节点中用 QPainter 直接绘制图像，圆角由画刷填充圆角矩形实现，无需纹理
+ */
+class SoftwareImageNode : public QSGRenderNode
+{
+public:
+    explicit SoftwareImageNode(QQuickWindow *window)
+        : m_window(window)
+    {
+    }
+
+    void update(const QImage &image, const QRectF &rect, const QRectF &sourceRect, qreal radius, bool smooth)
+    {
+        m_image = image;
+        m_rect = rect;
+        m_sourceRect = sourceRect;
+        m_radius = qBound<qreal>(0, radius, qMin(rect.width(), rect.height()) / 2);
+        m_smooth = smooth;
+        markDirty(DirtyMaterial);
+    }
+
+    void render(const RenderState *state) override
+    {
+        QPainter *painter = static_cast<QPainter *>(
+                                m_window->rendererInterface()->getResource(m_window, QSGRendererInterface::PainterResource));
+        if (!painter || m_image.isNull() || m_sourceRect.isEmpty()) {
+            return;
+        }
+
+        // 裁剪区域需在设置变换前设置
+        const QRegion *clipRegion = state->clipRegion();
+        if (clipRegion && !clipRegion->isEmpty()) {
+            painter->setClipRegion(*clipRegion, Qt::ReplaceClip);
+        }
+        painter->setTransform(matrix()->toTransform());
+        painter->setOpacity(inheritedOpacity());
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, m_smooth);
+
+        if (m_radius <= 0) {
+            painter->drawImage(m_rect, m_image, m_sourceRect);
+            return;
+        }
+
+        QTransform brushTransform;
+        brushTransform.translate(m_rect.x(), m_rect.y());
+        brushTransform.scale(m_rect.width() / m_sourceRect.width(), m_rect.height() / m_sourceRect.height());
+        brushTransform.translate(-m_sourceRect.x(), -m_sourceRect.y());
+        QBrush brush(m_image);
+        brush.setTransform(brushTransform);
+
+        painter->setRenderHint(QPainter::Antialiasing, true);
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(brush);
+        painter->drawRoundedRect(m_rect, m_radius, m_radius);
+    }
+
+    StateFlags changedStates() const override
+    {
+        return {};
+    }
+
+    RenderingFlags flags() const override
+    {
+        return BoundedRectRendering;
+    }
+
+    QRectF rect() const override
+    {
+        return m_rect;
+    }
+
+private:
+    QQuickWindow *m_window;
+    QImage m_image;
+    QRectF m_rect;
+    QRectF m_sourceRect;
+    qreal m_radius = 0;
+    bool m_smooth = false;
+};
+
+} // namespace
+
+AtlasImageItem::AtlasImageItem(QQuickItem *parent)
+    : QQuickItem(parent)
+    , m_smooth(false)
+    , m_fillMode(AtlasImageItem::Stretch)
+{
+    setFlag(ItemHasContents, true);
+}
+
+AtlasImageItem::~AtlasImageItem()
+{
+}
+
+void AtlasImageItem::setImage(const QImage &image)
+{
+    bool oldImageNull = m_image.isNull();
+    m_image = image;
+
+    QRect oldPaintedRect = m_paintedRect;
+    updatePaintedRect();
+    // 若图片显示方式从方图变为原始比例，需要延迟刷新图片，以便比例切换动画能正常显示
+    if (ImageDataService::instance()->getLoadMode() == 1
+            && (m_paintedRect.width() < oldPaintedRect.width() || m_paintedRect.height() < oldPaintedRect.height())) {
+        QTimer::singleShot(100, this, [=] {
+            update();
+        });
+    } else {
+        update();
+    }
+
+    Q_EMIT nativeWidthChanged();
+    Q_EMIT nativeHeightChanged();
+    Q_EMIT imageChanged();
+    if (oldImageNull != m_image.isNull()) {
+        Q_EMIT nullChanged();
+    }
+}
+
+QImage AtlasImageItem::image() const
+{
+    return m_image;
+}
+
+void AtlasImageItem::resetImage()
+{
+    setImage(QImage());
+}
+
+void AtlasImageItem::setSmooth(const bool smooth)
+{
+    if (smooth == m_smooth) {
+        return;
+    }
+    m_smooth = smooth;
+    update();
+}
+
+bool AtlasImageItem::smooth() const
+{
+    return m_smooth;
+}
+
+int AtlasImageItem::nativeWidth() const
+{
+    return m_image.size().width() / m_image.devicePixelRatio();
+}
+
+int AtlasImageItem::nativeHeight() const
+{
+    return m_image.size().height() / m_image.devicePixelRatio();
+}
+
+int AtlasImageItem::paintedWidth() const
+{
+    return m_paintedRect.width();
+}
+
+int AtlasImageItem::paintedHeight() const
+{
+    return m_paintedRect.height();
+}
+
+AtlasImageItem::FillMode AtlasImageItem::fillMode() const
+{
+    return m_fillMode;
+}
+
+void AtlasImageItem::setFillMode(AtlasImageItem::FillMode mode)
+{
+    if (mode == m_fillMode) {
+        return;
+    }
+
+    m_fillMode = mode;
+    updatePaintedRect();
+    update();
+    Q_EMIT fillModeChanged();
+}
+
+bool AtlasImageItem::isNull() const
+{
+    return m_image.isNull();
+}
+
+qreal AtlasImageItem::radius() const
+{
+    return m_radius;
+}
+
+void AtlasImageItem::setRadius(qreal radius)
+{
+    if (qFuzzyCompare(radius, m_radius)) {
+        return;
+    }
+
+    m_radius = radius;
+    update();
+    Q_EMIT radiusChanged();
+}
+
+qreal AtlasImageItem::clipWidth() const
+{
+    return m_clipWidth;
+}
+
+void AtlasImageItem::setClipWidth(qreal width)
+{
+    if (qFuzzyCompare(width, m_clipWidth)) {
+        return;
+    }
+
+    m_clipWidth = width;
+    update();
+    Q_EMIT clipWidthChanged();
+}
+
+qreal AtlasImageItem::clipHeight() const
+{
+    return m_clipHeight;
+}
+
+void AtlasImageItem::setClipHeight(qreal height)
+{
+    if (qFuzzyCompare(height, m_clipHeight)) {
+        return;
+    }
+
+    m_clipHeight = height;
+    update();
+    Q_EMIT clipHeightChanged();
+}
+
+// 图片为空时，显示撕裂图
+const QImage &AtlasImageItem::displayImage() const
+{
+    return m_image.isNull() ? QImageItem::damageImage() : m_image;
+}
+
+/**
+ * @brief 在渲染线程中更新场景图节点，GUI线程此时处于阻塞状态，可安全访问成员数据。
+ *      仅当图像变更时才从纹理缓存中获取纹理，其它情况只更新节点区域。
+ */
+QSGNode *AtlasImageItem::updatePaintNode(QSGNode *oldNode, QQuickItem::UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+    const QImage &img = displayImage();
+    if (img.isNull() || m_paintedRect.isEmpty() || !window()) {
+        delete oldNode;
+        return nullptr;
+    }
+
+    // 显示区域再按居中的裁剪尺寸截取(比例切换动画)，图像源区域按相同比例截取
+    QRectF rect = m_paintedRect;
+    QRectF sourceRect = m_sourceRect;
+    if (m_clipWidth >= 0 || m_clipHeight >= 0) {
+        QRectF clipRect = boundingRect();
+        if (m_clipWidth >= 0) {
+            clipRect.setWidth(m_clipWidth);
+        }
+        if (m_clipHeight >= 0) {
+            clipRect.setHeight(m_clipHeight);
+        }
+        clipRect.moveCenter(boundingRect().center());
+        const QRectF visible = rect.intersected(clipRect);
+        if (visible.isEmpty()) {
+            delete oldNode;
+            return nullptr;
+        }
+        const qreal scaleX = sourceRect.width() / rect.width();
+        const qreal scaleY = sourceRect.height() / rect.height();
+        sourceRect = QRectF(sourceRect.x() + (visible.x() - rect.x()) * scaleX, sourceRect.y() + (visible.y() - rect.y()) * scaleY,
+                            visible.width() * scaleX, visible.height() * scaleY);
+        rect = visible;
+    }
+
+    // 渲染后端在窗口生命周期内不变，旧节点的类型与当前后端一致
+    if (window()->rendererInterface()->graphicsApi() == QSGRendererInterface::Software) {
+        SoftwareImageNode *node = static_cast<SoftwareImageNode *>(oldNode);
+        if (!node) {
+            node = new SoftwareImageNode(window());
+        }
+        node->update(img, rect, sourceRect, m_radius, m_smooth);
+        return node;
+    }
+
+    AtlasImageNode *node = static_cast<AtlasImageNode *>(oldNode);
+    if (!node) {
+        node = new AtlasImageNode;
+    }
+
+    if (!node->texture || node->cacheKey != img.cacheKey()) {
+        QSharedPointer<QSGTexture> texture = AtlasTextureCache::cacheForWindow(window())->texture(img);
+        if (!texture) {
+            delete node;
+            return nullptr;
+        }
+        node->setTexture(texture, img.cacheKey());
+    }
+
+    node->setFiltering(m_smooth ? QSGTexture::Linear : QSGTexture::Nearest);
+    node->updateGeometry(rect, sourceRect, m_radius);
+
+    return node;
+}
+
+void AtlasImageItem::updatePaintedRect()
+{
+    const QImage &img = displayImage();
+    const QRectF bounds = boundingRect();
+    // 缩略图按原比例存储，方图模式仅显示其中的裁切区域，切换模式无需重新生成缩略图
+    const QRectF imageRect = m_image.isNull() ? QRectF(img.rect()) : QRectF(ImageDataService::instance()->thumbnailDisplayRect(img));
+    const QSizeF imageSize = imageRect.size();
+
+    QRectF destRect = bounds;
+    QRectF sourceRect = imageRect;
+
+    switch (m_fillMode) {
+    case PreserveAspectFit: {
+        QSizeF scaled = imageSize;
+        scaled.scale(bounds.size(), Qt::KeepAspectRatio);
+        destRect = QRectF(QPoint(0, 0), scaled);
+        destRect.moveCenter(bounds.center().toPoint());
+        break;
+    }
+    case PreserveAspectCrop: {
+        // 场景图节点不做裁剪，直接在纹理坐标上截取居中的可见部分
+        QSizeF scaled = bounds.size();
+        scaled.scale(imageSize, Qt::KeepAspectRatio);
+        sourceRect = QRectF(QPointF(0, 0), scaled);
+        sourceRect.moveCenter(imageRect.center());
+        break;
+    }
+    case Stretch:
+    default:
+        break;
+    }
+
+    m_sourceRect = sourceRect;
+    if (destRect.toRect() != m_paintedRect) {
+        m_paintedRect = destRect.toRect();
+        Q_EMIT paintedHeightChanged();
+        Q_EMIT paintedWidthChanged();
+    }
+}
+
+void AtlasImageItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    updatePaintedRect();
+    update();
+}
@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: 2023 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef ATLASIMAGEITEM_H
+#define ATLASIMAGEITEM_H
+
+#include <QImage>
+#include <QQuickItem>
+
+/**
+ * @brief 基于场景图的缩略图显示控件
+ *      与 QImageItem 不同，不通过 QPainter 绘制到独立的 FBO 中，而是直接生成 QSGImageNode ，
+ *      纹理由每个窗口共享的纹理缓存提供，并允许放入场景图的纹理图集(atlas)中。
+ *      同一张缩略图只上传一次，滚动时复用的委托不会重复创建纹理，同一图集内的节点可合批绘制。
+ *      圆角由节点几何形状实现，不需要 layer 及 OpacityMask 等效果(会为每个委托单独渲染到 FBO)。
+ *      llvmpipe 等基于 RHI 的后端使用同一节点；软件渲染(software)后端不绘制自定义材质的几何节点，
+ *      改为使用 QSGRenderNode 通过 QPainter 绘制，不经过纹理缓存。
+ *      帧耗时及帧间隔记录在 render.frame/render.frameInterval 指标中，用于对比滚动时的渲染开销
+ *      在 QML 中注册的标识为 "AtlasImageItem"
+ */
+class AtlasImageItem : public QQuickItem
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QImage image READ image WRITE setImage NOTIFY imageChanged RESET resetImage)
+    Q_PROPERTY(bool smooth READ smooth WRITE setSmooth)
+    Q_PROPERTY(int nativeWidth READ nativeWidth NOTIFY nativeWidthChanged)
+    Q_PROPERTY(int nativeHeight READ nativeHeight NOTIFY nativeHeightChanged)
+    Q_PROPERTY(int paintedWidth READ paintedWidth NOTIFY paintedWidthChanged)
+    Q_PROPERTY(int paintedHeight READ paintedHeight NOTIFY paintedHeightChanged)
+    Q_PROPERTY(FillMode fillMode READ fillMode WRITE setFillMode NOTIFY fillModeChanged)
+    Q_PROPERTY(bool null READ isNull NOTIFY nullChanged)
+    // 圆角半径
+    Q_PROPERTY(qreal radius READ radius WRITE setRadius NOTIFY radiusChanged)
+    // 居中的裁剪区域尺寸，小于0时不裁剪，用于显示比例切换时的过渡动画
+    Q_PROPERTY(qreal clipWidth READ clipWidth WRITE setClipWidth NOTIFY clipWidthChanged)
+    Q_PROPERTY(qreal clipHeight READ clipHeight WRITE setClipHeight NOTIFY clipHeightChanged)
+
+public:
+    enum FillMode {
+        Stretch, // the image is scaled to fit
+        PreserveAspectFit, // the image is scaled uniformly to fit without cropping
+        PreserveAspectCrop, // the image is scaled uniformly to fill, cropping if necessary
+    };
+    Q_ENUM(FillMode)
+
+    explicit AtlasImageItem(QQuickItem *parent = nullptr);
+    ~AtlasImageItem() override;
+
+    void setImage(const QImage &image);
+    QImage image() const;
+    void resetImage();
+
+    void setSmooth(const bool smooth);
+    bool smooth() const;
+
+    int nativeWidth() const;
+    int nativeHeight() const;
+
+    int paintedWidth() const;
+    int paintedHeight() const;
+
+    FillMode fillMode() const;
+    void setFillMode(FillMode mode);
+
+    bool isNull() const;
+
+    qreal radius() const;
+    void setRadius(qreal radius);
+
+    qreal clipWidth() const;
+    void setClipWidth(qreal width);
+    qreal clipHeight() const;
+    void setClipHeight(qreal height);
+
+Q_SIGNALS:
+    void nativeWidthChanged();
+    void nativeHeightChanged();
+    void fillModeChanged();
+    void imageChanged();
+    void nullChanged();
+    void paintedWidthChanged();
+    void paintedHeightChanged();
+    void radiusChanged();
+    void clipWidthChanged();
+    void clipHeightChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    const QImage &displayImage() const;
+
+private:
+    QImage m_image;
+    bool m_smooth;
+    FillMode m_fillMode;
+    QRect m_paintedRect;    // 显示区域(裁剪后)
+    QRectF m_sourceRect;    // 对应的图像源区域
+    qreal m_radius = 0;
+    qreal m_clipWidth = -1;
+    qreal m_clipHeight = -1;
+
+private Q_SLOTS:
+    void updatePaintedRect();
+};
+
+#endif // ATLASIMAGEITEM_H
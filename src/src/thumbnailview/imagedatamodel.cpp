@@ -17,6 +17,7 @@ ImageDataModel::ImageDataModel(QObject *parent)
     , m_dayToken("")
 {
     connect(AlbumControl::instance(), &AlbumControl::deviceAlbumInfoLoadFinished, this, &ImageDataModel::onDeviceDataLoaded);
+    connect(AlbumControl::instance(), &AlbumControl::deviceAlbumInfoLoadProgress, this, &ImageDataModel::onDeviceDataLoaded);
 }
 
 QHash<int, QByteArray> ImageDataModel::roleNames() const
@@ -39,6 +39,11 @@ void QImageItem::initDamage()
     s_damage = DDciIcon::fromTheme("photo_breach").pixmap(1, 200, theme).toImage();
 }
 
+const QImage &QImageItem::damageImage()
+{
+    return s_damage;
+}
+
 void QImageItem::setImage(const QImage &image)
 {
     bool oldImageNull = m_image.isNull();
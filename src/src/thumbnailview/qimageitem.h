@@ -40,6 +40,7 @@ public:
     ~QImageItem() override;
 
     static void initDamage();
+    static const QImage &damageImage();
     void setImage(const QImage &image);
     QImage image() const;
     void resetImage();
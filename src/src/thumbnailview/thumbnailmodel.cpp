@@ -26,6 +26,12 @@ ThumbnailModel::ThumbnailModel(QObject *parent)
 
     // 图片数据服务有图片加载成功，通知model刷新界面
     connect(ImageDataService::instance(), &ImageDataService::gotImage, this, &ThumbnailModel::showPreview, Qt::ConnectionType::QueuedConnection);
+    // 缩略图显示级别变化，通知界面重新获取缩略图
+    connect(ImageDataService::instance(), &ImageDataService::thumbnailLevelChanged, this, [this]() {
+        if (rowCount() > 0) {
+            Q_EMIT dataChanged(index(0, 0), index(rowCount() - 1, 0), {Roles::Thumbnail});
+        }
+    }, Qt::ConnectionType::QueuedConnection);
 }
 
 ThumbnailModel::~ThumbnailModel()
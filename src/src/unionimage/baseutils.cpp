@@ -8,6 +8,11 @@
 #include <fcntl.h>
 #include <fstream>
 #include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#include <cerrno>
 
 #include <QApplication>
 #include <QClipboard>
@@ -406,6 +411,169 @@ QString hashByData(const QString &str)
     return stHashValue;
 }
 
+/**
+ * @brief 根据文件大小及首尾各64K内容生成hash，与文件路径无关。
+ *      外接设备(MTP/USB)读取代价较高，不读取完整文件，用于快速判断文件内容是否相同
+ * @return 文件无法读取时返回空字符串
+ */
+QString hashByContent(const QString &filePath)
+{
+    static const qint64 s_sampleSize = 64 * 1024;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    const qint64 fileSize = file.size();
+    hash.addData(QByteArray::number(fileSize));
+    hash.addData(file.read(s_sampleSize));
+    if (fileSize > s_sampleSize * 2) {
+        file.seek(fileSize - s_sampleSize);
+    }
+    hash.addData(file.read(s_sampleSize));
+
+    return hash.result().toHex();
+}
+
+/**
+ * @brief 逐块比较两个文件的内容。hashByContent 只采样首尾，相同的hash只说明可能重复，
+ *      判定为重复文件(跳过拷贝)前需要用本函数确认
+ * @return 两个文件均可读且内容完全一致时返回true
+ */
+bool sameFileContent(const QString &lhsPath, const QString &rhsPath)
+{
+    static const qint64 s_blockSize = 1024 * 1024;
+
+    QFile lhs(lhsPath);
+    QFile rhs(rhsPath);
+    if (!lhs.open(QIODevice::ReadOnly) || !rhs.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+
+    while (!lhs.atEnd()) {
+        const QByteArray lhsBlock = lhs.read(s_blockSize);
+        const QByteArray rhsBlock = rhs.read(s_blockSize);
+        if (lhsBlock.isEmpty() || lhsBlock != rhsBlock) {
+            return false;
+        }
+    }
+    return rhs.atEnd();
+}
+
+/**
+ * @brief 拷贝 \a srcPath 到 \a dstPath ，目标文件已存在时覆盖
+ *      1.同一文件系统且支持reflink(btrfs/xfs等)时共享数据块，不实际拷贝
+ *      2.使用 copy_file_range 在内核中拷贝，无需经过用户态缓冲区
+ *      3.均不支持(如跨文件系统的旧内核、FUSE)时回退为分块读写
+ */
+bool copyFileFast(const QString &srcPath, const QString &dstPath, const std::function<bool(qint64)> &progress)
+{
+    static const qint64 s_chunkSize = 8 * 1024 * 1024;
+
+    int srcFd = ::open(QFile::encodeName(srcPath).constData(), O_RDONLY | O_CLOEXEC);
+    if (srcFd < 0) {
+        return false;
+    }
+    struct stat srcStat;
+    if (fstat(srcFd, &srcStat) != 0) {
+        ::close(srcFd);
+        return false;
+    }
+    int dstFd = ::open(QFile::encodeName(dstPath).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, srcStat.st_mode & 0777);
+    if (dstFd < 0) {
+        ::close(srcFd);
+        return false;
+    }
+
+    bool bSuccess = true;
+    if (ioctl(dstFd, FICLONE, srcFd) == 0) {
+        if (progress) {
+            bSuccess = progress(srcStat.st_size);
+        }
+    } else {
+        bool useKernelCopy = true;
+        qint64 copied = 0;
+        QByteArray buffer;
+        while (copied < srcStat.st_size) {
+            ssize_t ret = -1;
+            if (useKernelCopy) {
+                ret = copy_file_range(srcFd, nullptr, dstFd, nullptr, static_cast<size_t>(s_chunkSize), 0);
+                if (ret < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP) && copied == 0) {
+                    useKernelCopy = false;
+                    continue;
+                }
+                //部分文件系统(如FUSE、procfs)未拷贝完就返回0，两端偏移已随拷贝前进，从当前位置回退为分块读写
+                if (ret == 0) {
+                    useKernelCopy = false;
+                    continue;
+                }
+            } else {
+                if (buffer.isEmpty()) {
+                    buffer.resize(1024 * 1024);
+                }
+                ret = ::read(srcFd, buffer.data(), static_cast<size_t>(buffer.size()));
+                if (ret > 0 && ::write(dstFd, buffer.constData(), static_cast<size_t>(ret)) != ret) {
+                    ret = -1;
+                }
+            }
+
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            // 未达到源文件大小就读不到数据(源文件被截断或设备异常)，视为拷贝失败
+            if (ret <= 0) {
+                bSuccess = false;
+                break;
+            }
+
+            copied += ret;
+            if (progress && !progress(ret)) {
+                bSuccess = false;
+                break;
+            }
+        }
+    }
+
+    ::close(srcFd);
+    if (::close(dstFd) != 0) {
+        bSuccess = false;
+    }
+    return bSuccess;
+}
+
+/**
+ * @brief 根据 \a path 所在块设备是否为机械硬盘返回建议的并发IO数，
+ *      机械硬盘并发读写会导致频繁寻道，固态硬盘及内存文件系统可适当提高并发
+ */
+int ioParallelBudget(const QString &path)
+{
+    static const int s_rotationalBudget = 2;
+    static const int s_solidBudget = 4;
+
+    struct stat pathStat;
+    if (stat(QFile::encodeName(path).constData(), &pathStat) != 0) {
+        return s_rotationalBudget;
+    }
+
+    // 分区设备需查询所属磁盘的队列信息
+    const QString sysPath = QString("/sys/dev/block/%1:%2").arg(major(pathStat.st_dev)).arg(minor(pathStat.st_dev));
+    QFile rotational(sysPath + "/queue/rotational");
+    if (!rotational.exists()) {
+        rotational.setFileName(sysPath + "/../queue/rotational");
+    }
+    if (!rotational.open(QIODevice::ReadOnly)) {
+        // 非块设备(tmpfs等)
+        return QDir(sysPath).exists() ? s_rotationalBudget : s_solidBudget;
+    }
+
+    return rotational.readAll().trimmed() == "1" ? s_rotationalBudget : s_solidBudget;
+}
+
 bool onMountDevice(const QString &path)
 {
     return (path.startsWith("/media/") || path.startsWith("/run/media/"));
@@ -9,6 +9,8 @@
 #include <QTimer>
 #include <QColor>
 
+#include <functional>
+
 #define V23_FILEMANAGER_DAEMON_SERVICE      "org.deepin.filemanager.server"
 #define V23_FILEMANAGER_DAEMON_PATH         "/org/deepin/filemanager/server/DeviceManager"
 #define V23_FILEMANAGER_DAEMON_INTERFACE    "org.deepin.filemanager.server.DeviceManager"
@@ -216,6 +218,14 @@ bool        checkMimeUrls(const QList<QUrl> &urls);
 QString     hash(const QString &str);
 QString     hashByString(const QString &str);
 QString     hashByData(const QString &str);
+//根据文件大小及首尾内容生成hash，与路径无关，用于导入去重
+QString     hashByContent(const QString &filePath);
+//逐块比较文件内容，hashByContent 命中后确认是否真正重复
+bool        sameFileContent(const QString &lhsPath, const QString &rhsPath);
+//拷贝文件，优先使用reflink及copy_file_range由内核完成拷贝，progress 参数为本次拷贝的字节数，返回false时中止拷贝
+bool        copyFileFast(const QString &srcPath, const QString &dstPath, const std::function<bool(qint64)> &progress = nullptr);
+//根据路径所在块设备类型返回建议的并发IO数
+int         ioParallelBudget(const QString &path);
 QString     mkMutiDir(const QString &path);
 //根据源文件路径生产缩略图路径
 QString     filePathToThumbnailPath(const QString &filePath, QString dataHash = "");
@@ -0,0 +1,288 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "filetypecache.h"
+#include "unionimage.h"
+#include "imageutils.h"
+#include "utils/workscheduler.h"
+
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMimeDatabase>
+#include <QSet>
+#include <QtSvg/QSvgRenderer>
+
+namespace LibUnionImage_NameSpace {
+
+namespace {
+// 内容匹配时读取的文件头长度，与 QMimeDatabase 读取的长度一致
+const qint64 MIME_HEADER_SIZE = 16384;
+// 可能包含多帧的格式(后缀及内容匹配的MIME类型)，其它格式均为单帧，无需再解析帧数
+const QSet<QString> MULTI_FRAME_SUFFIXES {"gif", "webp", "tif", "tiff", "ico", "cur", "icns", "heic", "heif", "avif", "jxl"};
+const QSet<QString> MULTI_FRAME_MIME_TYPES {"image/gif", "image/webp", "image/tiff", "image/vnd.microsoft.icon", "image/x-icns",
+                                            "image/heif", "image/avif", "image/jxl"};
+}
+
+FileTypeCache *FileTypeCache::instance()
+{
+    static FileTypeCache cache;
+    return &cache;
+}
+
+bool FileTypeCache::isImage(const QString &path)
+{
+    return lookup(path).flags & Image;
+}
+
+bool FileTypeCache::isVideo(const QString &path)
+{
+    return lookup(path).flags & Video;
+}
+
+bool FileTypeCache::imageSupportRead(const QString &path)
+{
+    // 与 Libutils::image::imageSupportRead 一致，以文件后缀判断，不再额外解析图片尺寸
+    const QString suffix = QFileInfo(path).suffix().toUpper();
+    return "X3F" != suffix && unionImageSupportFormat().contains(suffix);
+}
+
+imageViewerSpace::ImageType FileTypeCache::imageType(const QString &path)
+{
+    return static_cast<imageViewerSpace::ImageType>(lookup(path).imageType);
+}
+
+QList<bool> FileTypeCache::testFiles(const QStringList &paths, TypeFlag flag)
+{
+    // 用户等待结果(如打开图片时扫描所在目录)，按可见任务并行
+    QVector<bool> flags(paths.size());
+    WorkScheduler::instance()->parallelFor(WorkScheduler::Visible, paths.size(), [this, &paths, &flags, flag](int i) {
+        flags[i] = lookup(paths.at(i)).flags & flag;
+    });
+    return QList<bool>(flags.begin(), flags.end());
+}
+
+QMap<QString, ItemType> FileTypeCache::classifyFiles(const QStringList &paths)
+{
+    // 判断时需读取文件头，IO 与 MIME 匹配并行执行
+    QVector<int> types(paths.size(), ItemTypeNull);
+    WorkScheduler::instance()->parallelFor(WorkScheduler::Visible, paths.size(), [this, &paths, &types](int i) {
+        if (imageSupportRead(paths.at(i))) {
+            types[i] = ItemTypePic;
+        } else if (isVideo(paths.at(i))) {
+            types[i] = ItemTypeVideo;
+        }
+    });
+
+    QMap<QString, ItemType> result;
+    for (int i = 0; i < paths.size(); ++i) {
+        if (ItemTypeNull != types.at(i)) {
+            result.insert(paths.at(i), static_cast<ItemType>(types.at(i)));
+        }
+    }
+    return result;
+}
+
+QMap<QString, ItemType> FileTypeCache::classifyDirectory(const QString &dir, bool recursive)
+{
+    QStringList paths;
+    QDirIterator dirIterator(dir, QDir::Files, recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+    while (dirIterator.hasNext()) {
+        paths << dirIterator.next();
+    }
+
+    return classifyFiles(paths);
+}
+
+QStringList FileTypeCache::restore(const QList<FileTypeRecord> &records)
+{
+    // 在调用线程中检查文件是否存在，不持有锁
+    QList<FileTypeRecord> existing;
+    QStringList missing;
+    for (const FileTypeRecord &record : records) {
+        if (QFileInfo::exists(record.filePath)) {
+            existing << record;
+        } else {
+            missing << record.filePath;
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    for (const FileTypeRecord &record : existing) {
+        // 旧版本按需判断的记录可能不完整，需重新判断
+        if ((record.known & AllFlags) != AllFlags || m_entries.contains(record.filePath)) {
+            continue;
+        }
+
+        Entry entry;
+        entry.modified = record.modified;
+        entry.size = record.size;
+        entry.known = record.known;
+        entry.flags = record.flags;
+        entry.imageType = record.imageType;
+        m_entries.insert(record.filePath, entry);
+    }
+
+    return missing;
+}
+
+QList<FileTypeRecord> FileTypeCache::takeDirtyRecords()
+{
+    QList<FileTypeRecord> records;
+    QWriteLocker locker(&m_lock);
+    for (const QString &path : m_dirtyPaths) {
+        auto itr = m_entries.constFind(path);
+        if (itr == m_entries.constEnd()) {
+            continue;
+        }
+
+        FileTypeRecord record;
+        record.filePath = path;
+        record.modified = itr->modified;
+        record.size = itr->size;
+        record.known = itr->known;
+        record.flags = itr->flags;
+        record.imageType = itr->imageType;
+        records << record;
+    }
+    m_dirtyPaths.clear();
+
+    return records;
+}
+
+QStringList FileTypeCache::takeRemovedPaths()
+{
+    QWriteLocker locker(&m_lock);
+    QStringList paths = m_removedPaths.values();
+    m_removedPaths.clear();
+    return paths;
+}
+
+FileTypeCache::Entry FileTypeCache::lookup(const QString &path)
+{
+    Entry entry;
+    if (path.isEmpty()) {
+        return entry;
+    }
+
+    QFileInfo info(path);
+    if (!info.exists()) {
+        // 文件不存在时(如仅判断后缀)不缓存，已有的缓存项在下次保存时从数据库删除
+        m_lock.lockForRead();
+        const bool cached = m_entries.contains(path);
+        m_lock.unlock();
+        if (cached) {
+            QWriteLocker locker(&m_lock);
+            if (m_entries.remove(path) > 0) {
+                m_dirtyPaths.remove(path);
+                m_removedPaths.insert(path);
+            }
+        }
+        detect(path, entry);
+        return entry;
+    }
+
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    const qint64 size = info.size();
+    {
+        QReadLocker locker(&m_lock);
+        auto itr = m_entries.constFind(path);
+        if (itr != m_entries.constEnd() && itr->modified == modified && itr->size == size) {
+            return itr.value();
+        }
+    }
+
+    // 判断过程不加锁，并发判断同一文件时结果一致，仅重复计算
+    detect(path, entry);
+    entry.modified = modified;
+    entry.size = size;
+
+    QWriteLocker locker(&m_lock);
+    m_entries.insert(path, entry);
+    m_dirtyPaths.insert(path);
+    m_removedPaths.remove(path);
+
+    return entry;
+}
+
+/**
+ * @brief 打开文件一次，读取的文件头同时用于图片、视频的内容匹配，帧数由同一文件设备读取，
+ *      全部判断结果一次得到
+ */
+void FileTypeCache::detect(const QString &path, Entry &entry)
+{
+    entry.known = AllFlags;
+    entry.flags = 0;
+    entry.imageType = imageViewerSpace::ImageTypeBlank;
+
+    QByteArray header;
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        header = file.read(MIME_HEADER_SIZE);
+    }
+
+    QMimeDatabase db;
+    const QMimeType mt = db.mimeTypeForData(header);
+    const QMimeType mt1 = db.mimeTypeForFile(path, QMimeDatabase::MatchExtension);
+    if (mt.name().startsWith("image/") || mt.name().startsWith("video/x-mng") ||
+            mt1.name().startsWith("image/") || mt1.name().startsWith("video/x-mng")) {
+        entry.flags |= Image;
+    }
+
+    // 与 Libutils::image::isVideo 一致：按后缀判断，ts 文件可能为翻译文件，结合内容精确判断
+    const QString strType = QFileInfo(path).suffix().toLower();
+    if ("ts" == strType) {
+        if (db.mimeTypeForFileNameAndData(path, header).name() == "video/mp2t") {
+            entry.flags |= Video;
+        }
+    } else if (Libutils::image::m_videoFiletypes.contains(strType)) {
+        entry.flags |= Video;
+    }
+
+    //新增获取图片是属于静态图还是动态图还是多页图
+    if (!file.isOpen()) {
+        return;
+    }
+    if (!(entry.flags & Image)) {
+        entry.imageType = imageViewerSpace::ImageTypeStatic;
+        return;
+    }
+
+    //只有svg文件才需要加载判断是否为有效的矢量图
+    if (strType == "svg") {
+        entry.imageType = QSvgRenderer().load(path) ? imageViewerSpace::ImageTypeSvg : imageViewerSpace::ImageTypeStatic;
+        return;
+    }
+
+    //mng 总是动图，无需解析帧数
+    if (strType == "mng" || mt.name().startsWith("video/x-mng") || mt1.name().startsWith("video/x-mng")) {
+        entry.imageType = imageViewerSpace::ImageTypeDynamic;
+        return;
+    }
+
+    //解决bug57394 【专业版1031】【看图】【5.6.3.74】【修改引入】pic格式图片变为翻页状态，不为动图且首张显示序号为0
+    //单帧格式不再解析帧数
+    if (!MULTI_FRAME_SUFFIXES.contains(strType) && !MULTI_FRAME_MIME_TYPES.contains(mt.name())) {
+        entry.imageType = imageViewerSpace::ImageTypeStatic;
+        return;
+    }
+
+    //由内容判断实际格式，后缀与内容不符(如改了后缀的gif)时仍能得到正确的帧数
+    file.seek(0);
+    QImageReader imgreader(&file);
+    imgreader.setDecideFormatFromContent(true);
+    const int nSize = imgreader.imageCount();
+    const QByteArray format = imgreader.format();
+    if (nSize > 1 && (format == "gif" || format == "webp" || strType == "gif" || strType == "webp")) {
+        entry.imageType = imageViewerSpace::ImageTypeDynamic;
+    } else if (nSize > 1) {
+        entry.imageType = imageViewerSpace::ImageTypeMulti;
+    } else {
+        entry.imageType = imageViewerSpace::ImageTypeStatic;
+    }
+}
+
+}
@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef FILETYPECACHE_H
+#define FILETYPECACHE_H
+
+#include "unionimage_global.h"
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+namespace LibUnionImage_NameSpace {
+
+// 文件类型判断结果，用于持久化保存
+struct FileTypeRecord {
+    QString filePath;
+    qint64 modified = 0;            // 文件修改时间(毫秒)
+    qint64 size = 0;                // 文件大小
+    int known = 0;                  // 已完成判断的类型标志
+    int flags = 0;                  // 判断结果
+    int imageType = imageViewerSpace::ImageTypeBlank;
+};
+
+/**
+ * @brief 文件类型判断缓存
+ *      isImage / isVideo / getImageType 的判断结果以 (路径, 修改时间, 大小) 为键缓存，
+ *      首次判断时只打开并读取一次文件头，同时得到全部结果，文件内容未变化时不再重复读取。
+ *      imageSupportRead 仅按后缀判断，代价低于查询缓存，不缓存。
+ *      判断结果可通过 restore() / takeDirtyRecords() / takeRemovedPaths() 与数据库同步，线程安全。
+ */
+class FileTypeCache
+{
+public:
+    enum TypeFlag {
+        Image = 0x1,            // isImage
+        Video = 0x2,            // isVideo
+        ImageTypeKnown = 0x8,   // getImageType，结果保存在 imageType 中
+        AllFlags = Image | Video | ImageTypeKnown,
+    };
+
+    static FileTypeCache *instance();
+
+    bool isImage(const QString &path);
+    bool isVideo(const QString &path);
+    bool imageSupportRead(const QString &path);
+    imageViewerSpace::ImageType imageType(const QString &path);
+
+    // 批量并行判断 flag 对应的类型，返回结果与 paths 顺序一致
+    QList<bool> testFiles(const QStringList &paths, TypeFlag flag);
+    // 批量并行判断文件类型，返回支持的图片(ItemTypePic)和视频(ItemTypeVideo)，不支持的文件不包含在结果中
+    QMap<QString, ItemType> classifyFiles(const QStringList &paths);
+    // 列举目录并批量判断文件类型
+    QMap<QString, ItemType> classifyDirectory(const QString &dir, bool recursive);
+
+    // 载入数据库中保存的判断结果，已存在的缓存项不会被覆盖；返回文件已不存在的记录路径，需从数据库删除
+    QStringList restore(const QList<FileTypeRecord> &records);
+    // 取出自上次调用后新增或变更的判断结果，用于写入数据库
+    QList<FileTypeRecord> takeDirtyRecords();
+    // 取出自上次调用后发现文件已不存在的路径，用于从数据库删除
+    QStringList takeRemovedPaths();
+
+private:
+    FileTypeCache() = default;
+
+    struct Entry {
+        qint64 modified = 0;
+        qint64 size = 0;
+        int known = 0;
+        int flags = 0;
+        int imageType = imageViewerSpace::ImageTypeBlank;
+    };
+
+    // 获取缓存项，缓存无效时重新判断
+    Entry lookup(const QString &path);
+    static void detect(const QString &path, Entry &entry);
+
+    QReadWriteLock m_lock;
+    QHash<QString, Entry> m_entries;
+    QSet<QString> m_dirtyPaths;
+    QSet<QString> m_removedPaths;
+};
+
+}
+
+#endif // FILETYPECACHE_H
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "unionimage.h"
+#include "filetypecache.h"
 
 #include <QObject>
 #include <QMutex>
@@ -18,11 +19,13 @@
 #include <QMimeDatabase>
 #include <QtSvg/QSvgRenderer>
 #include <QDir>
+#include <QSaveFile>
 #include <QDebug>
 
 #include "unionimage/imageutils.h"
 
 #include <cstring>
+#include <atomic>
 
 #define SAVE_QUAITY_VALUE 100
 
@@ -122,6 +125,7 @@ public:
     QHash<QString, int> m_movie_formats;
     QStringList m_canSave;
     QStringList m_qtrotate;
+    std::atomic_bool m_exifRotate {true};    // JPEG 旋转时是否仅修改EXIF方向标记
 };
 
 static UnionImage_Private union_image_private;
@@ -477,6 +481,163 @@ QImage adjustImageToRealPosition(const QImage &image, int orientation)
     return result;
 }
 
+UNIONIMAGESHARED_EXPORT void setExifRotateEnabled(bool enable)
+{
+    union_image_private.m_exifRotate = enable;
+}
+
+UNIONIMAGESHARED_EXPORT bool exifRotateEnabled()
+{
+    return union_image_private.m_exifRotate;
+}
+
+/**
+ * @brief 计算旋转后的EXIF方向标记
+ * @param orientation   当前方向标记(1~8)
+ * @param angel         顺时针旋转角度，需为90的倍数
+ */
+static int rotatedOrientation(int orientation, int angel)
+{
+    // 顺时针旋转90度后的方向标记，下标为当前方向标记
+    static const int s_rotateCW[9] = {1, 6, 7, 8, 5, 2, 3, 4, 1};
+
+    if (orientation < 1 || orientation > 8) {
+        orientation = 1;
+    }
+    int steps = ((angel / 90) % 4 + 4) % 4;
+    while (steps-- > 0) {
+        orientation = s_rotateCW[orientation];
+    }
+    return orientation;
+}
+
+/**
+ * @brief 通过修改EXIF方向标记无损旋转JPEG图片，不解码、不重新编码图像数据，保留全部EXIF信息
+ *      图片已包含方向标记时仅修改该字段；无EXIF信息时插入仅包含方向标记的EXIF段；
+ *      包含EXIF信息但无方向标记时返回false，由调用者使用像素旋转
+ * @param angel     顺时针旋转角度，需为90的倍数
+ * @param path      源文件路径
+ * @param savePath  保存路径
+ * @param erroMsg   错误信息
+ */
+static bool rotateJpegByExifOrientation(int angel, const QString &path, const QString &savePath, QString &erroMsg)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        erroMsg = "open file failed:" + path;
+        return false;
+    }
+    QByteArray data = file.readAll();
+    file.close();
+
+    auto readU16 = [&data](int pos, bool bigEndian) -> int {
+        const uchar *p = reinterpret_cast<const uchar *>(data.constData()) + pos;
+        return bigEndian ? (p[0] << 8 | p[1]) : (p[1] << 8 | p[0]);
+    };
+    auto readU32 = [&data](int pos, bool bigEndian) -> quint32 {
+        const uchar *p = reinterpret_cast<const uchar *>(data.constData()) + pos;
+        return bigEndian ? (quint32(p[0]) << 24 | quint32(p[1]) << 16 | quint32(p[2]) << 8 | p[3])
+               : (quint32(p[3]) << 24 | quint32(p[2]) << 16 | quint32(p[1]) << 8 | p[0]);
+    };
+
+    if (data.size() < 4 || uchar(data.at(0)) != 0xFF || uchar(data.at(1)) != 0xD8) {
+        erroMsg = "not a jpeg file";
+        return false;
+    }
+
+    int orientationPos = -1;     // 方向标记数值在文件中的位置
+    bool bigEndian = true;
+    bool hasExif = false;
+    int insertPos = 2;           // 无EXIF时的插入位置，JFIF(APP0)段之后
+    int pos = 2;
+    while (pos + 4 <= data.size() && uchar(data.at(pos)) == 0xFF) {
+        const uchar marker = uchar(data.at(pos + 1));
+        // SOS 之后为图像数据，不再包含元数据段
+        if (marker == 0xDA || marker == 0xD9) {
+            break;
+        }
+        const int length = readU16(pos + 2, true);
+        const int segStart = pos + 4;
+        if (length < 2 || pos + 2 + length > data.size()) {
+            erroMsg = "invalid jpeg segment";
+            return false;
+        }
+
+        if (marker == 0xE0 && pos == insertPos) {
+            insertPos = pos + 2 + length;
+        } else if (marker == 0xE1 && length >= 16 && data.mid(segStart, 6) == QByteArray("Exif\0\0", 6)) {
+            hasExif = true;
+            const int tiff = segStart + 6;
+            const int segEnd = pos + 2 + length;
+            const QByteArray byteOrder = data.mid(tiff, 2);
+            if (byteOrder != "MM" && byteOrder != "II") {
+                break;
+            }
+            bigEndian = byteOrder == "MM";
+            if (readU16(tiff + 2, bigEndian) != 42) {
+                break;
+            }
+            // 偏移量按无符号数校验，避免异常数据回绕为负数后越界读取
+            const quint32 ifd0Offset = readU32(tiff + 4, bigEndian);
+            if (ifd0Offset > quint32(segEnd - tiff - 2)) {
+                break;
+            }
+            const int ifd0 = tiff + int(ifd0Offset);
+            const int count = readU16(ifd0, bigEndian);
+            for (int i = 0; i < count && ifd0 + 2 + (i + 1) * 12 <= segEnd; ++i) {
+                const int entry = ifd0 + 2 + i * 12;
+                // Orientation, SHORT
+                if (readU16(entry, bigEndian) == 0x0112 && readU16(entry + 2, bigEndian) == 3) {
+                    orientationPos = entry + 8;
+                    break;
+                }
+            }
+            break;
+        }
+        pos += 2 + length;
+    }
+
+    if (orientationPos >= 0) {
+        int orientation = rotatedOrientation(readU16(orientationPos, bigEndian), angel);
+        data[orientationPos] = char(bigEndian ? 0 : orientation);
+        data[orientationPos + 1] = char(bigEndian ? orientation : 0);
+
+        // 原文件仅需改写方向标记所在的两个字节
+        if (savePath == path) {
+            QFile out(path);
+            if (out.open(QIODevice::ReadWrite) && out.seek(orientationPos)
+                    && out.write(data.constData() + orientationPos, 2) == 2) {
+                return true;
+            }
+            erroMsg = "write exif orientation failed:" + out.errorString();
+            return false;
+        }
+    } else if (!hasExif) {
+        // 插入仅包含方向标记的EXIF段(大端序)
+        const int orientation = rotatedOrientation(1, angel);
+        const char exifSegment[] = {
+            char(0xFF), char(0xE1), 0x00, 0x22,             // APP1, 长度34
+            'E', 'x', 'i', 'f', 0x00, 0x00,
+            'M', 'M', 0x00, 0x2A, 0x00, 0x00, 0x00, 0x08,   // TIFF头，IFD0偏移8
+            0x00, 0x01,                                     // 1个条目
+            0x01, 0x12, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, // Orientation, SHORT, 1
+            0x00, char(orientation), 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00                          // 无下一个IFD
+        };
+        data.insert(insertPos, exifSegment, sizeof(exifSegment));
+    } else {
+        erroMsg = "exif without orientation tag";
+        return false;
+    }
+
+    QSaveFile out(savePath);
+    if (!out.open(QIODevice::WriteOnly) || out.write(data) != data.size() || !out.commit()) {
+        erroMsg = "save rotated jpeg failed:" + out.errorString();
+        return false;
+    }
+    return true;
+}
+
 UNIONIMAGESHARED_EXPORT bool rotateImageFIle(int angel, const QString &path, QString &erroMsg, const QString &targetPath)
 {
     if (angel % 90 != 0) {
@@ -488,6 +649,14 @@ UNIONIMAGESHARED_EXPORT bool rotateImageFIle(int angel, const QString &path, QSt
     QString savePath = targetPath.isEmpty() ? path : targetPath;
 
     QString format = detectImageFormat(path);
+    // JPEG 优先通过EXIF方向标记无损旋转，失败时使用像素旋转
+    if (format == "JPG" && union_image_private.m_exifRotate) {
+        if (rotateJpegByExifOrientation(angel, path, savePath, erroMsg)) {
+            return true;
+        }
+        qDebug() << "rotate by exif orientation failed, fallback to pixel rotation:" << erroMsg;
+    }
+
     if (format == "SVG") {
         QImage image_copy;
         if (!loadStaticImageFromFile(path, image_copy, erroMsg)) {
@@ -633,43 +802,8 @@ UNIONIMAGESHARED_EXPORT int getOrientation(const QString &path)
 
 imageViewerSpace::ImageType getImageType(const QString &imagepath)
 {
-    imageViewerSpace::ImageType type = imageViewerSpace::ImageType::ImageTypeBlank;
-    //新增获取图片是属于静态图还是动态图还是多页图
-    if (!imagepath.isEmpty()) {
-        QFileInfo fi(imagepath);
-        if (!fi.exists()) {
-            // 文件不存在返回空
-            return imageViewerSpace::ImageTypeBlank;
-        }
-
-        QString strType = fi.suffix().toLower();
-        //解决bug57394 【专业版1031】【看图】【5.6.3.74】【修改引入】pic格式图片变为翻页状态，不为动图且首张显示序号为0
-        QMimeDatabase db;
-        QMimeType mt = db.mimeTypeForFile(imagepath, QMimeDatabase::MatchContent);
-        QMimeType mt1 = db.mimeTypeForFile(imagepath, QMimeDatabase::MatchExtension);
-        QString path1 = mt.name();
-        QString path2 = mt1.name();
-
-        QImageReader imgreader(imagepath);
-        int nSize = imgreader.imageCount();
-        //
-        if (strType == "svg" && QSvgRenderer().load(imagepath)) {
-            type = imageViewerSpace::ImageTypeSvg;
-        } else if ((strType == "mng")
-                   || ((strType == "gif") && nSize > 1)
-                   || (strType == "webp" && nSize > 1)
-                   || ((mt.name().startsWith("image/gif")) && nSize > 1)
-                   || ((mt1.name().startsWith("image/gif")) && nSize > 1)
-                   || ((mt.name().startsWith("video/x-mng")))
-                   || ((mt1.name().startsWith("video/x-mng")))) {
-            type = imageViewerSpace::ImageTypeDynamic;
-        } else if (nSize > 1) {
-            type = imageViewerSpace::ImageTypeMulti;
-        } else {
-            type = imageViewerSpace::ImageTypeStatic;
-        }
-    }
-    return type;
+    //新增获取图片是属于静态图还是动态图还是多页图，结果缓存至文件变更
+    return FileTypeCache::instance()->imageType(imagepath);
 }
 
 imageViewerSpace::PathType getPathType(const QString &imagepath)
@@ -827,12 +961,12 @@ UNIONIMAGESHARED_EXPORT QFileInfoList getImagesAndVideoInfo(const QString &dir,
 
 UNIONIMAGESHARED_EXPORT bool isVideo(QString path)
 {
-    return Libutils::image::isVideo(path);
+    return FileTypeCache::instance()->isVideo(path);
 }
 
 UNIONIMAGESHARED_EXPORT bool imageSupportRead(const QString &path)
 {
-    return Libutils::image::imageSupportRead(path);
+    return FileTypeCache::instance()->imageSupportRead(path);
 }
 
 UNIONIMAGESHARED_EXPORT void getAllDirInDir(const QDir &dir, QFileInfoList &result)
@@ -849,18 +983,11 @@ UNIONIMAGESHARED_EXPORT void getAllDirInDir(const QDir &dir, QFileInfoList &resu
 
 UNIONIMAGESHARED_EXPORT bool isImage(const QString &path)
 {
-    bool bRet = false;
     //路径为空直接跳出
-    if (!path.isEmpty()) {
-        QMimeDatabase db;
-        QMimeType mt = db.mimeTypeForFile(path, QMimeDatabase::MatchContent);
-        QMimeType mt1 = db.mimeTypeForFile(path, QMimeDatabase::MatchExtension);
-        if (mt.name().startsWith("image/") || mt.name().startsWith("video/x-mng") ||
-                mt1.name().startsWith("image/") || mt1.name().startsWith("video/x-mng")) {
-            bRet = true;
-        }
+    if (path.isEmpty()) {
+        return false;
     }
-    return bRet;
+    return FileTypeCache::instance()->isImage(path);
 }
 
 UNIONIMAGESHARED_EXPORT QString localPath(const QUrl &url)
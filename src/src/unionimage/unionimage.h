@@ -126,6 +126,15 @@ UNIONIMAGESHARED_EXPORT bool rotateImage(int angel, QImage &image);
  */
 UNIONIMAGESHARED_EXPORT bool rotateImageFIle(int angel, const QString &path, QString &erroMsg, const QString &targetPath = {});
 
+/**
+ * @brief setExifRotateEnabled
+ * @param[in]           enable  是否启用
+ * 设置 rotateImageFIle 旋转JPEG图片时是否仅修改EXIF方向标记(无损，不重新编码)，默认启用
+ * 关闭后使用像素旋转并重新编码，适用于不支持EXIF方向标记的外部程序
+ */
+UNIONIMAGESHARED_EXPORT void setExifRotateEnabled(bool enable);
+UNIONIMAGESHARED_EXPORT bool exifRotateEnabled();
+
 /**
  * @brief rotateImageFIle
  * @param[in]           angel
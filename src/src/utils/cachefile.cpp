@@ -0,0 +1,193 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "cachefile.h"
+#include "configsetter.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <array>
+#include <atomic>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace {
+const QString SETTINGS_GROUP = "Thumbnail";
+const QString SETTINGS_SYNC_POLICY = "SyncPolicy";
+
+// "ALBC"
+const quint32 HEADER_MAGIC = 0x43424c41;
+const int HEADER_SIZE = 12;
+
+std::atomic_int s_syncPolicy{-1};
+std::atomic_uint s_tempCounter{0};
+
+const std::array<quint32, 256> &crcTable()
+{
+    static const std::array<quint32, 256> table = []() {
+        std::array<quint32, 256> result{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            }
+            result[i] = crc;
+        }
+        return result;
+    }();
+    return table;
+}
+
+// 写入全部数据，被信号中断时继续
+bool writeAll(int fd, const char *data, qint64 size)
+{
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, static_cast<size_t>(size));
+        if (written < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+// 持久化目录项，使重命名在断电后保留
+void syncDir(const QByteArray &dirPath)
+{
+    const int fd = ::open(dirPath.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+}
+
+namespace CacheFile {
+
+int headerSize()
+{
+    return HEADER_SIZE;
+}
+
+QString tempSuffix()
+{
+    return ".tmp";
+}
+
+quint32 crc32(const char *data, qint64 size)
+{
+    const std::array<quint32, 256> &table = crcTable();
+    quint32 crc = 0xFFFFFFFFu;
+    for (qint64 i = 0; i < size; ++i) {
+        crc = table[(crc ^ static_cast<uchar>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+QByteArray addHeader(const QByteArray &payload)
+{
+    QByteArray data(HEADER_SIZE, Qt::Uninitialized);
+    qToLittleEndian<quint32>(HEADER_MAGIC, data.data());
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), data.data() + 4);
+    qToLittleEndian<quint32>(crc32(payload.constData(), payload.size()), data.data() + 8);
+    return data + payload;
+}
+
+bool hasHeader(const QByteArray &data)
+{
+    return data.size() >= HEADER_SIZE && qFromLittleEndian<quint32>(data.constData()) == HEADER_MAGIC;
+}
+
+bool checkHeader(const QByteArray &data, QByteArray &payload)
+{
+    if (!hasHeader(data)) {
+        return false;
+    }
+
+    const quint32 size = qFromLittleEndian<quint32>(data.constData() + 4);
+    const quint32 crc = qFromLittleEndian<quint32>(data.constData() + 8);
+    if (size != static_cast<quint32>(data.size() - HEADER_SIZE)
+            || crc != crc32(data.constData() + HEADER_SIZE, size)) {
+        return false;
+    }
+
+    payload = data.mid(HEADER_SIZE);
+    return true;
+}
+
+bool writeAtomic(const QString &filePath, const QByteArray &data)
+{
+    return writeAtomic(filePath, data, syncPolicy());
+}
+
+/**
+ * @brief 写入同目录下的临时文件后重命名，临时文件名包含进程号及序号，多个线程或进程同时写入同一文件时互不影响
+ */
+bool writeAtomic(const QString &filePath, const QByteArray &data, SyncPolicy policy)
+{
+    const QByteArray path = QFile::encodeName(filePath);
+    const QByteArray tempPath = path + '.' + QByteArray::number(::getpid()) + '.'
+                                + QByteArray::number(s_tempCounter++) + QFile::encodeName(tempSuffix());
+
+    const int fd = ::open(tempPath.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        qWarning() << "CacheFile: open failed:" << tempPath << strerror(errno);
+        return false;
+    }
+
+    bool ok = writeAll(fd, data.constData(), data.size());
+    if (ok && policy >= SyncData) {
+        ok = ::fdatasync(fd) == 0;
+    }
+    ok = ::close(fd) == 0 && ok;
+    if (ok) {
+        ok = ::rename(tempPath.constData(), path.constData()) == 0;
+    }
+    if (!ok) {
+        qWarning() << "CacheFile: write failed:" << filePath << strerror(errno);
+        ::unlink(tempPath.constData());
+        return false;
+    }
+
+    if (policy >= SyncFull) {
+        syncDir(QFile::encodeName(QFileInfo(filePath).absolutePath()));
+    }
+    return true;
+}
+
+bool readChecked(const QString &filePath, QByteArray &payload)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    return checkHeader(file.readAll(), payload);
+}
+
+SyncPolicy syncPolicy()
+{
+    int policy = s_syncPolicy;
+    if (policy < 0) {
+        policy = qBound<int>(NoSync, LibConfigSetter::instance()->value(SETTINGS_GROUP, SETTINGS_SYNC_POLICY, NoSync).toInt(), SyncFull);
+        s_syncPolicy = policy;
+    }
+    return static_cast<SyncPolicy>(policy);
+}
+
+void setSyncPolicy(SyncPolicy policy)
+{
+    s_syncPolicy = policy;
+}
+
+}
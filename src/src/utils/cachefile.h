@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef CACHEFILE_H
+#define CACHEFILE_H
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @brief 缓存文件(缩略图、帧索引)的原子写入及校验
+ * @details 写入时先写到同目录下的临时文件，再重命名为目标文件，目标路径上只会出现完整的旧文件或新文件；
+ *      内容前附加 12 字节的文件头(魔数、内容长度、CRC32)，断电等原因导致文件系统中留下不完整的内容时，
+ *      读取方校验失败后重新生成。临时文件由缓存清理删除。
+ */
+namespace CacheFile {
+
+// 重命名前的落盘方式
+enum SyncPolicy {
+    NoSync = 0,     // 不主动落盘，依赖读取时校验，断电后可能需要重新生成
+    SyncData,       // 重命名前 fdatasync 临时文件
+    SyncFull,       // 另外 fsync 所在目录，重命名本身也持久化
+};
+
+// 文件头长度
+int headerSize();
+// 临时文件后缀
+QString tempSuffix();
+
+// 在内容前附加文件头
+QByteArray addHeader(const QByteArray &payload);
+// 是否以文件头开始，不带文件头的为旧版本写入的文件
+bool hasHeader(const QByteArray &data);
+// 校验文件头并取出内容，长度或校验值不一致时返回 false
+bool checkHeader(const QByteArray &data, QByteArray &payload);
+
+// 原子写入 data 到 filePath ，失败时不改变原文件
+bool writeAtomic(const QString &filePath, const QByteArray &data, SyncPolicy policy);
+bool writeAtomic(const QString &filePath, const QByteArray &data);
+// 读取文件并校验文件头，文件不存在或校验失败时返回 false
+bool readChecked(const QString &filePath, QByteArray &payload);
+
+// 默认落盘方式，读取配置文件 Thumbnail/SyncPolicy ，默认为 NoSync
+SyncPolicy syncPolicy();
+// 仅作用于当前进程，不写入配置文件
+void setSyncPolicy(SyncPolicy policy);
+
+quint32 crc32(const char *data, qint64 size);
+
+}
+
+#endif // CACHEFILE_H
@@ -0,0 +1,252 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "devicefileindex.h"
+#include "devicehelper.h"
+#include "unionimage/unionimage.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+
+namespace {
+const quint32 INDEX_FILE_MAGIC = 0x44414958; // "DAIX"
+const quint32 INDEX_FILE_VERSION = 1;
+// 首次扫描时回调部分结果的间隔
+const qint64 PROGRESS_INTERVAL_MS = 1000;
+
+// 路径与挂载点相同或位于其下，"/media/foobar" 不属于 "/media/foo"
+bool isUnderMountPoint(const QString &path, const QString &mountPoint)
+{
+    if (!path.startsWith(mountPoint)) {
+        return false;
+    }
+    return path.size() == mountPoint.size() || mountPoint.endsWith('/') || path.at(mountPoint.size()) == '/';
+}
+}
+
+/*!
+   \class DeviceFileIndex::DeviceFileIndex
+   \brief 外接设备文件索引
+   \details 每个目录记录修改时间，目录中新增、删除、重命名文件都会更新目录修改时间，
+        重新扫描时修改时间未变化的目录直接复用上次的文件列表，只需获取目录属性而不必列举内容，
+        对于 MTP 等列举目录代价很高的设备可大幅减少扫描时间。
+   \note 子目录中的变化不会影响父目录修改时间，因此仍需遍历全部子目录。
+ */
+DeviceFileIndex::DeviceFileIndex(const QString &devicePath, const QString &deviceKey)
+    : m_devicePath(devicePath)
+    , m_deviceKey(deviceKey)
+{
+    while (m_devicePath.size() > 1 && m_devicePath.endsWith('/')) {
+        m_devicePath.chop(1);
+    }
+}
+
+QString DeviceFileIndex::indexFilePath() const
+{
+    if (m_deviceKey.isEmpty()) {
+        return QString();
+    }
+
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+           + "/deepin/deepin-album/device-index/" + m_deviceKey;
+}
+
+DeviceFileIndex::FileTypeMap DeviceFileIndex::load()
+{
+    FileTypeMap result;
+    QString path = indexFilePath();
+    if (path.isEmpty()) {
+        return result;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != INDEX_FILE_MAGIC || version != INDEX_FILE_VERSION) {
+        qWarning() << "Invalid device index file:" << path;
+        return result;
+    }
+
+    qint32 dirCount = 0;
+    stream >> dirCount;
+    for (qint32 i = 0; i < dirCount && stream.status() == QDataStream::Ok; ++i) {
+        QString relPath;
+        DirEntry entry;
+        stream >> relPath >> entry.modified >> entry.subDirs >> entry.files;
+        m_dirs.insert(relPath, entry);
+
+        const QString absDir = relPath.isEmpty() ? m_devicePath : m_devicePath + "/" + relPath;
+        for (const auto &fileItem : entry.files) {
+            result.insert(absDir + "/" + fileItem.first, static_cast<ItemType>(fileItem.second));
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Device index file corrupted:" << path;
+        m_dirs.clear();
+        return FileTypeMap();
+    }
+
+    return result;
+}
+
+DeviceFileIndex::FileTypeMap DeviceFileIndex::scan(const ProgressFunc &progress)
+{
+    QElapsedTimer timer;
+    timer.start();
+    qint64 lastProgress = 0;
+    int listedCount = 0;
+
+    FileTypeMap result;
+    QHash<QString, DirEntry> newDirs;
+    QStringList pendingDirs {QString()};
+
+    while (!pendingDirs.isEmpty()) {
+        const QString relPath = pendingDirs.takeLast();
+        const QString absDir = relPath.isEmpty() ? m_devicePath : m_devicePath + "/" + relPath;
+
+        QFileInfo dirInfo(absDir);
+        if (!dirInfo.isDir()) {
+            continue;
+        }
+
+        DirEntry entry;
+        const QDateTime modified = dirInfo.lastModified();
+        entry.modified = modified.isValid() ? modified.toMSecsSinceEpoch() : 0;
+
+        auto cached = m_dirs.constFind(relPath);
+        if (entry.modified != 0 && cached != m_dirs.constEnd() && cached->modified == entry.modified) {
+            // 目录未变化，复用上次结果
+            entry = cached.value();
+        } else {
+            listedCount++;
+            const QFileInfoList children = QDir(absDir).entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+            for (const QFileInfo &child : children) {
+                if (child.isDir()) {
+                    if (!child.isSymLink()) {
+                        entry.subDirs << child.fileName();
+                    }
+                    continue;
+                }
+
+                ItemType type = classifyBySuffix(child.fileName());
+                if (ItemTypeNull != type) {
+                    entry.files << qMakePair(child.fileName(), static_cast<int>(type));
+                }
+            }
+        }
+
+        for (const auto &fileItem : entry.files) {
+            result.insert(absDir + "/" + fileItem.first, static_cast<ItemType>(fileItem.second));
+        }
+        for (const QString &subDir : entry.subDirs) {
+            pendingDirs << (relPath.isEmpty() ? subDir : relPath + "/" + subDir);
+        }
+        newDirs.insert(relPath, entry);
+
+        if (progress && timer.elapsed() - lastProgress > PROGRESS_INTERVAL_MS) {
+            lastProgress = timer.elapsed();
+            progress(result);
+        }
+    }
+
+    qDebug() << QString("Device scan finished, path:%1 dirs:%2 listed:%3 files:%4 cost:%5ms")
+             .arg(m_devicePath).arg(newDirs.size()).arg(listedCount).arg(result.size()).arg(timer.elapsed());
+
+    m_dirs = newDirs;
+    return result;
+}
+
+bool DeviceFileIndex::save() const
+{
+    QString path = indexFilePath();
+    if (path.isEmpty()) {
+        return false;
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Save device index failed:" << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream << INDEX_FILE_MAGIC << INDEX_FILE_VERSION << static_cast<qint32>(m_dirs.size());
+    for (auto itr = m_dirs.constBegin(); itr != m_dirs.constEnd(); ++itr) {
+        stream << itr.key() << itr->modified << itr->subDirs << itr->files;
+    }
+
+    return file.commit();
+}
+
+QString DeviceFileIndex::deviceKeyForPath(const QString &devicePath)
+{
+    QString identity;
+    QString mountPoint;
+    for (const QString &deviceId : DeviceHelper::instance()->getAllDeviceIds()) {
+        QVariantMap deviceInfo = DeviceHelper::instance()->loadDeviceInfo(deviceId);
+        QString devMountPoint = deviceInfo.value("MountPoint").toString();
+        if (devMountPoint.isEmpty() || devMountPoint.size() <= mountPoint.size() || !isUnderMountPoint(devicePath, devMountPoint)) {
+            continue;
+        }
+
+        mountPoint = devMountPoint;
+        // 块设备使用文件系统UUID，协议设备(MTP/PTP)Id中包含设备序列号
+        identity = deviceInfo.value("IdUUID").toString();
+        if (identity.isEmpty()) {
+            identity = deviceId;
+        }
+    }
+
+    if (identity.isEmpty()) {
+        return QString();
+    }
+
+    // 同一设备可能以不同子目录加载(如手机的DCIM目录)，需要区分
+    return LibUnionImage_NameSpace::hashByString(identity + devicePath.mid(mountPoint.size()));
+}
+
+ItemType DeviceFileIndex::classifyBySuffix(const QString &fileName)
+{
+    static const QSet<QString> s_imageSuffixes = [] {
+        QSet<QString> suffixes;
+        for (const QString &format : LibUnionImage_NameSpace::unionImageSupportFormat()) {
+            suffixes.insert(format.toLower());
+        }
+        return suffixes;
+    }();
+    static const QSet<QString> s_videoSuffixes = [] {
+        QSet<QString> suffixes;
+        for (const QString &format : LibUnionImage_NameSpace::videoFiletypes()) {
+            suffixes.insert(format.toLower());
+        }
+        return suffixes;
+    }();
+
+    int index = fileName.lastIndexOf('.');
+    if (index < 0) {
+        return ItemTypeNull;
+    }
+
+    const QString suffix = fileName.mid(index + 1).toLower();
+    if (s_imageSuffixes.contains(suffix)) {
+        return ItemTypePic;
+    } else if (s_videoSuffixes.contains(suffix)) {
+        return ItemTypeVideo;
+    }
+    return ItemTypeNull;
+}
@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DEVICEFILEINDEX_H
+#define DEVICEFILEINDEX_H
+
+#include "unionimage/unionimage_global.h"
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+// 外接设备文件索引
+// 以设备标识(文件系统UUID或协议设备Id)持久化保存每个目录的修改时间及其中的图片/视频列表，
+// 重新插入设备时仅重新列举修改时间变化的目录，文件类型仅根据后缀判断，不读取文件内容
+class DeviceFileIndex
+{
+public:
+    using FileTypeMap = QMap<QString, ItemType>;
+    using ProgressFunc = std::function<void(const FileTypeMap &)>;
+
+    // deviceKey 为空时不读写持久化索引
+    DeviceFileIndex(const QString &devicePath, const QString &deviceKey);
+
+    // 读取上次保存的索引，返回上次扫描的文件列表
+    FileTypeMap load();
+    // 增量扫描设备，progress 不为空时周期性回调当前已扫描的部分结果
+    FileTypeMap scan(const ProgressFunc &progress = nullptr);
+    // 保存扫描结果
+    bool save() const;
+
+    // 根据设备路径获取设备标识，需在主线程调用(DeviceHelper 非线程安全)
+    static QString deviceKeyForPath(const QString &devicePath);
+    // 仅通过文件后缀判断文件类型
+    static ItemType classifyBySuffix(const QString &fileName);
+
+private:
+    struct DirEntry {
+        qint64 modified = 0;                // 目录修改时间，为0表示无效，每次均需重新列举
+        QStringList subDirs;                // 子目录名称
+        QList<QPair<QString, int>> files;   // 文件名称及类型
+    };
+
+    QString indexFilePath() const;
+
+    QString m_devicePath;
+    QString m_deviceKey;
+    QHash<QString, DirEntry> m_dirs;        // 相对路径-目录信息
+};
+
+#endif // DEVICEFILEINDEX_H
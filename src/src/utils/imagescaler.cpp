@@ -0,0 +1,442 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "imagescaler.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ALBUM_SCALER_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// 定点权重，每个输出像素的权重之和为 1 << WEIGHT_BITS
+const int WEIGHT_BITS = 14;
+const int WEIGHT_ONE = 1 << WEIGHT_BITS;
+// 纵向结果保留8位小数存为16位，横向合并后右移 WEIGHT_BITS + 8 位
+const int COLUMN_SHIFT = WEIGHT_BITS - 8;
+const int OUTPUT_SHIFT = WEIGHT_BITS + 8;
+
+/**
+ * @brief 一个方向上的面积平均权重表，输出 i 覆盖源区间 [i * scale, (i + 1) * scale)
+ */
+struct FilterTable {
+    std::vector<int> starts;        // 每个输出的首个源像素
+    std::vector<int> counts;        // 每个输出的源像素个数
+    std::vector<int> offsets;       // 每个输出在 weights 中的起始位置
+    std::vector<quint16> weights;
+};
+
+FilterTable areaTable(int srcSize, int dstSize)
+{
+    FilterTable table;
+    table.starts.reserve(dstSize);
+    table.counts.reserve(dstSize);
+    table.offsets.reserve(dstSize);
+
+    const double scale = static_cast<double>(srcSize) / dstSize;
+    for (int i = 0; i < dstSize; ++i) {
+        const double begin = i * scale;
+        const double end = (i + 1) * scale;
+        const int first = std::min(srcSize - 1, static_cast<int>(std::floor(begin)));
+        const int last = std::max(first, std::min(srcSize - 1, static_cast<int>(std::ceil(end)) - 1));
+
+        table.starts.push_back(first);
+        table.counts.push_back(last - first + 1);
+        table.offsets.push_back(static_cast<int>(table.weights.size()));
+
+        // 按累计覆盖长度取整后相减，保证权重之和恰好为 WEIGHT_ONE
+        int previous = 0;
+        for (int k = first; k <= last; ++k) {
+            int cumulative = WEIGHT_ONE;
+            if (k < last) {
+                cumulative = static_cast<int>(std::lround((std::min(end, k + 1.0) - begin) / scale * WEIGHT_ONE));
+            }
+            table.weights.push_back(static_cast<quint16>(cumulative - previous));
+            previous = cumulative;
+        }
+    }
+    return table;
+}
+
+/**
+ * @brief 纵向合并：column[i] = sum(weights[t] * rows[t][i])，rows[t] = src + t * stride
+ *      每段列的全部源行在寄存器中累加，结果保留8位小数
+ */
+typedef void (*ReduceColumnsFunc)(const uchar *src, qsizetype stride, const quint16 *weights, int taps, quint16 *column, int n);
+
+void reduceColumnsScalar(const uchar *src, qsizetype stride, const quint16 *weights, int taps, quint16 *column, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        quint32 sum = 0;
+        for (int t = 0; t < taps; ++t) {
+            sum += static_cast<quint32>(src[t * stride + i]) * weights[t];
+        }
+        column[i] = static_cast<quint16>((sum + (1u << (COLUMN_SHIFT - 1))) >> COLUMN_SHIFT);
+    }
+}
+
+#if defined(__SSE2__)
+void reduceColumnsSse2(const uchar *src, qsizetype stride, const quint16 *weights, int taps, quint16 *column, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (COLUMN_SHIFT - 1));
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i acc[4] = {zero, zero, zero, zero};
+        for (int t = 0; t < taps; ++t) {
+            const __m128i w = _mm_set1_epi16(static_cast<short>(weights[t]));
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + t * stride + i));
+            const __m128i halves[2] = {_mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero)};
+            for (int h = 0; h < 2; ++h) {
+                // 16位乘法的低位与高位交织即为32位乘积
+                const __m128i lo = _mm_mullo_epi16(halves[h], w);
+                const __m128i hi = _mm_mulhi_epu16(halves[h], w);
+                acc[h * 2] = _mm_add_epi32(acc[h * 2], _mm_unpacklo_epi16(lo, hi));
+                acc[h * 2 + 1] = _mm_add_epi32(acc[h * 2 + 1], _mm_unpackhi_epi16(lo, hi));
+            }
+        }
+        // SSE2 没有无符号的32位转16位，偏移到有符号范围后转换再还原
+        for (int h = 0; h < 2; ++h) {
+            const __m128i a = _mm_sub_epi32(_mm_srli_epi32(_mm_add_epi32(acc[h * 2], round), COLUMN_SHIFT), bias32);
+            const __m128i b = _mm_sub_epi32(_mm_srli_epi32(_mm_add_epi32(acc[h * 2 + 1], round), COLUMN_SHIFT), bias32);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(column + i + h * 8), _mm_xor_si128(_mm_packs_epi32(a, b), bias16));
+        }
+    }
+    reduceColumnsScalar(src + i, stride, weights, taps, column + i, n - i);
+}
+#endif
+
+#if defined(ALBUM_SCALER_AVX2)
+__attribute__((target("avx2"))) void reduceColumnsAvx2(const uchar *src, qsizetype stride, const quint16 *weights, int taps, quint16 *column, int n)
+{
+    const __m256i round = _mm256_set1_epi32(1 << (COLUMN_SHIFT - 1));
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // unpack 按128位分别交织，acc0 为 [0-3, 8-11] ，acc1 为 [4-7, 12-15] ，packus 后恰好恢复顺序
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        for (int t = 0; t < taps; ++t) {
+            const __m256i w = _mm256_set1_epi16(static_cast<short>(weights[t]));
+            const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + t * stride + i)));
+            const __m256i lo = _mm256_mullo_epi16(v, w);
+            const __m256i hi = _mm256_mulhi_epu16(v, w);
+            acc0 = _mm256_add_epi32(acc0, _mm256_unpacklo_epi16(lo, hi));
+            acc1 = _mm256_add_epi32(acc1, _mm256_unpackhi_epi16(lo, hi));
+        }
+        acc0 = _mm256_srli_epi32(_mm256_add_epi32(acc0, round), COLUMN_SHIFT);
+        acc1 = _mm256_srli_epi32(_mm256_add_epi32(acc1, round), COLUMN_SHIFT);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(column + i), _mm256_packus_epi32(acc0, acc1));
+    }
+    reduceColumnsScalar(src + i, stride, weights, taps, column + i, n - i);
+}
+#endif
+
+#if defined(__ARM_NEON)
+void reduceColumnsNeon(const uchar *src, qsizetype stride, const quint16 *weights, int taps, quint16 *column, int n)
+{
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint32x4_t acc[4] = {vdupq_n_u32(0), vdupq_n_u32(0), vdupq_n_u32(0), vdupq_n_u32(0)};
+        for (int t = 0; t < taps; ++t) {
+            const uint8x16_t v = vld1q_u8(src + t * stride + i);
+            const uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+            const uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+            acc[0] = vmlal_n_u16(acc[0], vget_low_u16(lo), weights[t]);
+            acc[1] = vmlal_n_u16(acc[1], vget_high_u16(lo), weights[t]);
+            acc[2] = vmlal_n_u16(acc[2], vget_low_u16(hi), weights[t]);
+            acc[3] = vmlal_n_u16(acc[3], vget_high_u16(hi), weights[t]);
+        }
+        vst1q_u16(column + i, vcombine_u16(vrshrn_n_u32(acc[0], COLUMN_SHIFT), vrshrn_n_u32(acc[1], COLUMN_SHIFT)));
+        vst1q_u16(column + i + 8, vcombine_u16(vrshrn_n_u32(acc[2], COLUMN_SHIFT), vrshrn_n_u32(acc[3], COLUMN_SHIFT)));
+    }
+    reduceColumnsScalar(src + i, stride, weights, taps, column + i, n - i);
+}
+#endif
+
+/**
+ * @brief 横向合并一行纵向结果，通道数作为模板参数，内层循环的累加值可以保存在寄存器中
+ */
+template <int BPP>
+void reduceRow(const FilterTable &xTable, const quint16 *column, uchar *out, int dstWidth)
+{
+    for (int x = 0; x < dstWidth; ++x) {
+        const quint16 *weights = xTable.weights.data() + xTable.offsets[x];
+        const quint16 *in = column + xTable.starts[x] * BPP;
+        const int count = xTable.counts[x];
+        quint32 sum[BPP] = {};
+        for (int t = 0; t < count; ++t) {
+            for (int c = 0; c < BPP; ++c) {
+                sum[c] += static_cast<quint32>(weights[t]) * in[t * BPP + c];
+            }
+        }
+        for (int c = 0; c < BPP; ++c) {
+            out[x * BPP + c] = static_cast<uchar>((sum[c] + (1u << (OUTPUT_SHIFT - 1))) >> OUTPUT_SHIFT);
+        }
+    }
+}
+
+typedef void (*ReduceRowFunc)(const FilterTable &xTable, const quint16 *column, uchar *out, int dstWidth);
+
+#if defined(__SSE2__)
+void reduceRowSse2(const FilterTable &xTable, const quint16 *column, uchar *out, int dstWidth)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (OUTPUT_SHIFT - 1));
+    for (int x = 0; x < dstWidth; ++x) {
+        const quint16 *weights = xTable.weights.data() + xTable.offsets[x];
+        const quint16 *in = column + xTable.starts[x] * 4;
+        const int count = xTable.counts[x];
+        __m128i sum = zero;
+        for (int t = 0; t < count; ++t) {
+            const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + t * 4));
+            const __m128i w = _mm_set1_epi16(static_cast<short>(weights[t]));
+            sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(_mm_mullo_epi16(v, w), _mm_mulhi_epu16(v, w)));
+        }
+        sum = _mm_srli_epi32(_mm_add_epi32(sum, round), OUTPUT_SHIFT);
+        sum = _mm_packs_epi32(sum, zero);
+        sum = _mm_packus_epi16(sum, zero);
+        const quint32 pixel = static_cast<quint32>(_mm_cvtsi128_si32(sum));
+        memcpy(out + x * 4, &pixel, sizeof(pixel));
+    }
+}
+#endif
+
+#if defined(__ARM_NEON)
+void reduceRowNeon(const FilterTable &xTable, const quint16 *column, uchar *out, int dstWidth)
+{
+    for (int x = 0; x < dstWidth; ++x) {
+        const quint16 *weights = xTable.weights.data() + xTable.offsets[x];
+        const quint16 *in = column + xTable.starts[x] * 4;
+        const int count = xTable.counts[x];
+        uint32x4_t sum = vdupq_n_u32(0);
+        for (int t = 0; t < count; ++t) {
+            sum = vmlal_n_u16(sum, vld1_u16(in + t * 4), weights[t]);
+        }
+        // 加上舍入值后分两次截断右移，与一次右移 OUTPUT_SHIFT 位结果相同
+        sum = vaddq_u32(sum, vdupq_n_u32(1u << (OUTPUT_SHIFT - 1)));
+        const uint16x4_t shifted = vshrn_n_u32(sum, 16);
+        const uint8x8_t pixel = vshrn_n_u16(vcombine_u16(shifted, shifted), OUTPUT_SHIFT - 16);
+        vst1_lane_u32(reinterpret_cast<uint32_t *>(out + x * 4), vreinterpret_u32_u8(pixel), 0);
+    }
+}
+#endif
+
+struct Kernel {
+    const char *name;
+    ReduceColumnsFunc reduceColumns;
+    ReduceRowFunc reduceRow4;       // 4通道的横向合并
+};
+
+std::vector<Kernel> supportedKernels()
+{
+    std::vector<Kernel> result;
+#if defined(ALBUM_SCALER_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        result.push_back({"avx2", reduceColumnsAvx2, reduceRowSse2});
+    }
+#endif
+#if defined(__SSE2__)
+    result.push_back({"sse2", reduceColumnsSse2, reduceRowSse2});
+#endif
+#if defined(__ARM_NEON)
+    result.push_back({"neon", reduceColumnsNeon, reduceRowNeon});
+#endif
+    result.push_back({"scalar", reduceColumnsScalar, reduceRow<4>});
+    return result;
+}
+
+// 按优先级排列，首个即为默认实现
+const std::vector<Kernel> &kernelList()
+{
+    static const std::vector<Kernel> kernels = supportedKernels();
+    return kernels;
+}
+
+std::atomic<const Kernel *> &activeKernel()
+{
+    static std::atomic<const Kernel *> kernel(&kernelList().front());
+    return kernel;
+}
+
+/**
+ * @brief 面积平均缩小，src 指向裁切区域左上角，bpp 为每像素字节数(每通道8位)
+ */
+void scaleArea(const uchar *src, qsizetype srcStride, int bpp, int srcWidth, int srcHeight,
+               uchar *dst, qsizetype dstStride, int dstWidth, int dstHeight)
+{
+    const FilterTable xTable = areaTable(srcWidth, dstWidth);
+    const FilterTable yTable = areaTable(srcHeight, dstHeight);
+    const Kernel *kernel = activeKernel().load(std::memory_order_relaxed);
+    const int rowBytes = srcWidth * bpp;
+    std::vector<quint16> column(static_cast<size_t>(rowBytes));
+
+    for (int y = 0; y < dstHeight; ++y) {
+        // 纵向：按权重合并覆盖的源行
+        kernel->reduceColumns(src + yTable.starts[y] * srcStride, srcStride, yTable.weights.data() + yTable.offsets[y],
+                      yTable.counts[y], column.data(), rowBytes);
+
+        // 横向：合并覆盖的源列
+        uchar *out = dst + y * dstStride;
+        switch (bpp) {
+        case 4:
+            kernel->reduceRow4(xTable, column.data(), out, dstWidth);
+            break;
+        case 3:
+            reduceRow<3>(xTable, column.data(), out, dstWidth);
+            break;
+        default:
+            reduceRow<1>(xTable, column.data(), out, dstWidth);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 可直接按字节处理的格式返回每像素字节数，否则返回0
+ *      非预乘的透明格式直接平均会在透明边缘产生杂色，需先转换为预乘格式
+ */
+int bytesPerPixel(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGBX8888:
+    case QImage::Format_RGBA8888_Premultiplied:
+        return 4;
+    case QImage::Format_RGB888:
+    case QImage::Format_BGR888:
+        return 3;
+    case QImage::Format_Grayscale8:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+QImage::Format workingFormat(const QImage &image)
+{
+    if (QImage::Format_RGBA8888 == image.format()) {
+        return QImage::Format_RGBA8888_Premultiplied;
+    }
+    return image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+}
+
+}
+
+namespace ImageScaler {
+
+QImage scaled(const QImage &src, const QSize &size)
+{
+    return cropScaled(src, src.rect(), size);
+}
+
+QImage scaled(const QImage &src, const QSize &size, Qt::AspectRatioMode mode)
+{
+    if (src.isNull()) {
+        return src;
+    }
+    return cropScaled(src, src.rect(), src.size().scaled(size, mode));
+}
+
+QImage cropScaled(const QImage &src, const QRect &rect, const QSize &size)
+{
+    const QRect srcRect = rect.intersected(src.rect());
+    if (src.isNull() || srcRect.isEmpty() || size.isEmpty()) {
+        return QImage();
+    }
+    if (srcRect.size() == size) {
+        return srcRect == src.rect() ? src : src.copy(srcRect);
+    }
+    // 放大不在此处理
+    if (size.width() > srcRect.width() || size.height() > srcRect.height()) {
+        return src.copy(srcRect).scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    QImage source = src;
+    QRect area = srcRect;
+    int bpp = bytesPerPixel(source.format());
+    if (0 == bpp) {
+        // 仅转换裁切区域
+        source = (srcRect == src.rect() ? src : src.copy(srcRect)).convertToFormat(workingFormat(src));
+        area = source.rect();
+        bpp = bytesPerPixel(source.format());
+    }
+
+    QImage result(size, source.format());
+    if (result.isNull()) {
+        qWarning() << "ImageScaler: failed to allocate" << size;
+        return result;
+    }
+    result.setColorSpace(source.colorSpace());
+
+    scaleArea(source.constScanLine(area.y()) + area.x() * bpp, source.bytesPerLine(), bpp, area.width(), area.height(),
+              result.bits(), result.bytesPerLine(), size.width(), size.height());
+    return result;
+}
+
+QImage clipToSquare(const QImage &src, int size)
+{
+    if (src.isNull() || 0 == src.width() || 0 == src.height()) {
+        return src;
+    }
+
+    const int width = src.width();
+    const int height = src.height();
+    const int side = qMin(width, height);
+
+    QRect rect = src.rect();
+    if (qAbs((width - height) * 10 / width) >= 1) {
+        rect = QRect((width - side) / 2, (height - side) / 2, side, side);
+    }
+
+    // 过长或过宽的图片不缩放
+    if (height / width >= 10 || width / height >= 10) {
+        return rect == src.rect() ? src : src.copy(rect);
+    }
+    return cropScaled(src, rect, rect.size().scaled(size, size, Qt::KeepAspectRatioByExpanding));
+}
+
+QStringList kernels()
+{
+    QStringList names;
+    for (const Kernel &kernel : kernelList()) {
+        names << kernel.name;
+    }
+    return names;
+}
+
+QString currentKernel()
+{
+    return activeKernel().load()->name;
+}
+
+bool setKernel(const QString &name)
+{
+    for (const Kernel &kernel : kernelList()) {
+        if (name == kernel.name) {
+            activeKernel().store(&kernel);
+            return true;
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IMAGESCALER_H
+#define IMAGESCALER_H
+
+#include <QImage>
+#include <QStringList>
+
+/**
+ * @brief 缩略图缩小，按面积平均(box)计算，缩小时效果与 Qt::SmoothTransformation 相当
+ * @details 先纵向累加源图行，再横向合并，纵向累加按运行时检测的指令集(AVX2/SSE2/NEON)执行；
+ *      裁切区域直接从源图读取，不生成原尺寸的中间图。
+ *      直接处理 RGB32/ARGB32_Premultiplied/RGBA8888_Premultiplied/RGBX8888/RGB888/BGR888/Grayscale8，
+ *      其余格式先转换为预乘格式；放大时退回 QImage::scaled(Qt::SmoothTransformation)。
+ */
+namespace ImageScaler {
+
+// 将 src 缩放为 size，不保持比例
+QImage scaled(const QImage &src, const QSize &size);
+// 将 src 按 mode 缩放到 size
+QImage scaled(const QImage &src, const QSize &size, Qt::AspectRatioMode mode);
+// 将 src 中的 rect 区域缩放为 size，裁切与缩放一次完成
+QImage cropScaled(const QImage &src, const QRect &rect, const QSize &size);
+
+// 缩略图方图：短边缩放到 size 并居中裁切为方图，长宽相差不足10%时保留原比例，
+// 长宽比超过10的图片仅裁切不缩放
+QImage clipToSquare(const QImage &src, int size);
+
+// 可用的纵向累加实现及当前使用的实现，用于基准测试对比
+QStringList kernels();
+QString currentKernel();
+bool setKernel(const QString &name);
+
+}
+
+#endif // IMAGESCALER_H
@@ -0,0 +1,194 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "metrics.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QSocketNotifier>
+
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+// SIGUSR1 信号处理中仅写入管道，在主线程中输出快照
+int s_signalPipe[2] = {-1, -1};
+
+void onDumpSignal(int)
+{
+    char byte = 1;
+    ssize_t ret = ::write(s_signalPipe[1], &byte, sizeof(byte));
+    Q_UNUSED(ret);
+}
+}
+
+void LatencyHistogram::record(quint64 micros)
+{
+    m_buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(micros, std::memory_order_relaxed);
+
+    quint64 currentMax = m_max.load(std::memory_order_relaxed);
+    while (micros > currentMax && !m_max.compare_exchange_weak(currentMax, micros, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+quint64 LatencyHistogram::percentile(double percent) const
+{
+    quint64 total = count();
+    if (0 == total) {
+        return 0;
+    }
+
+    quint64 target = qMax<quint64>(1, static_cast<quint64>(total * qBound(0.0, percent, 100.0) / 100.0 + 0.5));
+    quint64 accumulated = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        accumulated += m_buckets[i].load(std::memory_order_relaxed);
+        if (accumulated >= target) {
+            return bucketLowerBound(i);
+        }
+    }
+    return max();
+}
+
+/**
+ * @brief 小于16的值每个值一个桶，其余按最高位所在的2的幂区间分组，组内按其后4位划分子桶
+ */
+int LatencyHistogram::bucketIndex(quint64 micros)
+{
+    if (micros < static_cast<quint64>(SubBucketCount)) {
+        return static_cast<int>(micros);
+    }
+
+    int exponent = 63 - __builtin_clzll(micros);
+    if (exponent > MaxExponent) {
+        return BucketCount - 1;
+    }
+    int subBucket = static_cast<int>((micros >> (exponent - SubBucketBits)) & (SubBucketCount - 1));
+    return (exponent - SubBucketBits + 1) * SubBucketCount + subBucket;
+}
+
+quint64 LatencyHistogram::bucketLowerBound(int index)
+{
+    if (index < SubBucketCount) {
+        return static_cast<quint64>(index);
+    }
+
+    int exponent = index / SubBucketCount + SubBucketBits - 1;
+    quint64 subBucket = static_cast<quint64>(index % SubBucketCount);
+    return (SubBucketCount + subBucket) << (exponent - SubBucketBits);
+}
+
+MetricsRegistry *MetricsRegistry::instance()
+{
+    // 不释放，保证退出过程中其他线程记录时指标仍有效
+    static MetricsRegistry *ins = new MetricsRegistry;
+    return ins;
+}
+
+MetricsCounter *MetricsRegistry::counter(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    MetricsCounter *&item = m_counters[name];
+    if (!item) {
+        item = new MetricsCounter;
+    }
+    return item;
+}
+
+LatencyHistogram *MetricsRegistry::histogram(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    LatencyHistogram *&item = m_histograms[name];
+    if (!item) {
+        item = new LatencyHistogram;
+    }
+    return item;
+}
+
+QVariantMap MetricsRegistry::snapshot()
+{
+    QVariantMap result;
+    QMutexLocker locker(&m_mutex);
+    for (auto itr = m_counters.constBegin(); itr != m_counters.constEnd(); ++itr) {
+        result.insert(itr.key(), itr.value()->value());
+    }
+
+    for (auto itr = m_histograms.constBegin(); itr != m_histograms.constEnd(); ++itr) {
+        const LatencyHistogram *histogram = itr.value();
+        QVariantMap item;
+        item.insert("count", histogram->count());
+        item.insert("sum", histogram->sum());
+        item.insert("max", histogram->max());
+        item.insert("p50", histogram->percentile(50));
+        item.insert("p90", histogram->percentile(90));
+        item.insert("p99", histogram->percentile(99));
+        result.insert(itr.key(), item);
+    }
+    return result;
+}
+
+QString MetricsRegistry::dumpText()
+{
+    QStringList lines;
+    QMutexLocker locker(&m_mutex);
+    for (auto itr = m_counters.constBegin(); itr != m_counters.constEnd(); ++itr) {
+        lines << QString("%1 %2").arg(itr.key()).arg(itr.value()->value());
+    }
+
+    for (auto itr = m_histograms.constBegin(); itr != m_histograms.constEnd(); ++itr) {
+        const LatencyHistogram *histogram = itr.value();
+        quint64 count = histogram->count();
+        lines << QString("%1 count=%2 avg=%3us p50=%4us p90=%5us p99=%6us max=%7us")
+                 .arg(itr.key()).arg(count)
+                 .arg(count > 0 ? histogram->sum() / count : 0)
+                 .arg(histogram->percentile(50)).arg(histogram->percentile(90))
+                 .arg(histogram->percentile(99)).arg(histogram->max());
+    }
+    return lines.join('\n');
+}
+
+void MetricsRegistry::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    for (MetricsCounter *item : m_counters) {
+        item->reset();
+    }
+    for (LatencyHistogram *item : m_histograms) {
+        item->reset();
+    }
+}
+
+void MetricsRegistry::installSignalDump()
+{
+    if (s_signalPipe[0] >= 0 || ::pipe2(s_signalPipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        return;
+    }
+
+    QSocketNotifier *notifier = new QSocketNotifier(s_signalPipe[0], QSocketNotifier::Read, qApp);
+    QObject::connect(notifier, &QSocketNotifier::activated, qApp, [this]() {
+        char buffer[16];
+        while (::read(s_signalPipe[0], buffer, sizeof(buffer)) > 0) {
+        }
+
+        qInfo().noquote() << "Metrics dump:\n" + dumpText();
+    });
+
+    struct sigaction action = {};
+    action.sa_handler = onDumpSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+}
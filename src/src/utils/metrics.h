@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+
+#include <atomic>
+#include <chrono>
+
+// 计数器，多线程累加无锁
+class MetricsCounter
+{
+public:
+    void add(quint64 value = 1) { m_value.fetch_add(value, std::memory_order_relaxed); }
+    quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+    void reset() { m_value.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value{0};
+};
+
+/**
+ * @brief 耗时分布直方图(微秒)，记录无锁
+ *      采用 HDR 直方图的对数线性分桶，每个2的幂区间划分为16个子桶，相对误差约6%，
+ *      内存固定，不随记录数增长
+ */
+class LatencyHistogram
+{
+public:
+    void record(quint64 micros);
+    void reset();
+
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    quint64 sum() const { return m_sum.load(std::memory_order_relaxed); }
+    quint64 max() const { return m_max.load(std::memory_order_relaxed); }
+    // 百分位数(0~100)，返回所在子桶的下界
+    quint64 percentile(double percent) const;
+
+private:
+    static const int SubBucketBits = 4;
+    static const int SubBucketCount = 1 << SubBucketBits;
+    static const int MaxExponent = 39;  // 约6天，超出的记录计入最后一个子桶
+    static const int BucketCount = (MaxExponent - SubBucketBits + 2) * SubBucketCount;
+
+    static int bucketIndex(quint64 micros);
+    static quint64 bucketLowerBound(int index);
+
+    std::atomic<quint64> m_buckets[BucketCount] {};
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sum{0};
+    std::atomic<quint64> m_max{0};
+};
+
+/**
+ * @brief 进程内性能指标注册表
+ *      指标按名称注册后地址不变，调用处通过静态变量缓存指针，记录过程不加锁；
+ *      快照通过 DBus(ApplicationAdaptor) 获取，收到 SIGUSR1 时输出到日志
+ */
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry *instance();
+
+    MetricsCounter *counter(const QString &name);
+    LatencyHistogram *histogram(const QString &name);
+
+    // 各指标快照，直方图包含 count/sum/max/p50/p90/p99(微秒)
+    QVariantMap snapshot();
+    // 文本格式的快照，每行一个指标
+    QString dumpText();
+    void reset();
+
+    // 注册 SIGUSR1 处理，收到信号时输出文本快照到日志
+    void installSignalDump();
+
+private:
+    MetricsRegistry() = default;
+
+    QMutex m_mutex;
+    QMap<QString, MetricsCounter *> m_counters;
+    QMap<QString, LatencyHistogram *> m_histograms;
+};
+
+// 作用域计时，析构时记录到直方图
+class MetricsScopedTimer
+{
+public:
+    explicit MetricsScopedTimer(LatencyHistogram *histogram)
+        : m_histogram(histogram)
+        , m_start(std::chrono::steady_clock::now())
+    {
+    }
+    ~MetricsScopedTimer()
+    {
+        m_histogram->record(static_cast<quint64>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                     std::chrono::steady_clock::now() - m_start).count()));
+    }
+
+private:
+    LatencyHistogram *m_histogram;
+    std::chrono::steady_clock::time_point m_start;
+
+    Q_DISABLE_COPY(MetricsScopedTimer)
+};
+
+#define ALBUM_METRICS_CONCAT_IMPL(a, b) a##b
+#define ALBUM_METRICS_CONCAT(a, b) ALBUM_METRICS_CONCAT_IMPL(a, b)
+
+// 统计当前作用域耗时，name 为指标名称，同一调用处仅在首次执行时注册
+#define ALBUM_METRICS_SCOPE(name) \
+    static LatencyHistogram *const ALBUM_METRICS_CONCAT(_metricsHistogram, __LINE__) = MetricsRegistry::instance()->histogram(name); \
+    MetricsScopedTimer ALBUM_METRICS_CONCAT(_metricsTimer, __LINE__)(ALBUM_METRICS_CONCAT(_metricsHistogram, __LINE__))
+
+// 统计当前函数耗时，指标名称为 prefix.函数名
+#define ALBUM_METRICS_FUNCTION(prefix) ALBUM_METRICS_SCOPE(QString(prefix ".") + __func__)
+
+// 计数器累加
+#define ALBUM_METRICS_COUNT(name, value) \
+    do { \
+        static MetricsCounter *const _metricsCounter = MetricsRegistry::instance()->counter(name); \
+        _metricsCounter->add(value); \
+    } while (0)
+
+#endif // METRICS_H
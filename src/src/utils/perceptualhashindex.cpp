@@ -0,0 +1,405 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "perceptualhashindex.h"
+#include "dbmanager/dbmanager.h"
+#include "imageengine/imagedataservice.h"
+#include "unionimage/baseutils.h"
+#include "utils/rotateimagehelper.h"
+#include "utils/workscheduler.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImageReader>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+// 每批计算并写入数据库的图片数量
+const int INDEX_BATCH_SIZE = 100;
+// 缩略图不存在时，从原图解码的尺寸，只需满足9x8的采样
+const int SOURCE_DECODE_SIZE = 64;
+// 退出时等待执行中批次结束的最长时间
+const unsigned long QUIT_WAIT_MS = 3000;
+
+// 枚举与 value 汉明距离不超过 radius 的所有16位值
+void enumerateNeighbors(quint16 value, int radius, int startBit, QVector<quint16> &result)
+{
+    result << value;
+    if (radius <= 0) {
+        return;
+    }
+
+    for (int bit = startBit; bit < 16; ++bit) {
+        enumerateNeighbors(static_cast<quint16>(value ^ (1u << bit)), radius - 1, bit + 1, result);
+    }
+}
+}
+
+int MultiIndexHashTable::insert(quint64 hash)
+{
+    int id = m_hashes.size();
+    m_hashes << hash;
+    for (int i = 0; i < SegmentCount; ++i) {
+        m_tables[i][static_cast<quint16>(hash >> (i * 16))] << id;
+    }
+    return id;
+}
+
+QVector<int> MultiIndexHashTable::query(quint64 hash, int radius) const
+{
+    radius = qBound(0, radius, static_cast<int>(MaxRadius));
+    // 汉明距离不超过 radius 时，至少有一段的距离不超过 radius / SegmentCount
+    const int segmentRadius = radius / SegmentCount;
+
+    QVector<int> candidates;
+    QVector<quint16> neighbors;
+    for (int i = 0; i < SegmentCount; ++i) {
+        neighbors.clear();
+        enumerateNeighbors(static_cast<quint16>(hash >> (i * 16)), segmentRadius, 0, neighbors);
+        for (quint16 neighbor : neighbors) {
+            auto itr = m_tables[i].constFind(neighbor);
+            if (itr != m_tables[i].constEnd()) {
+                candidates << itr.value();
+            }
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    QVector<int> result;
+    for (int id : candidates) {
+        if (distance(m_hashes.at(id), hash) <= radius) {
+            result << id;
+        }
+    }
+    return result;
+}
+
+void MultiIndexHashTable::clear()
+{
+    m_hashes.clear();
+    for (int i = 0; i < SegmentCount; ++i) {
+        m_tables[i].clear();
+    }
+}
+
+int MultiIndexHashTable::distance(quint64 left, quint64 right)
+{
+    return qPopulationCount(left ^ right);
+}
+
+PerceptualHashIndex::PerceptualHashIndex(QObject *parent)
+    : QObject(parent)
+{
+    // 旋转后图片内容变化，需重新计算
+    connect(RotateImageHelper::instance(), &RotateImageHelper::rotateImageFinished, this, [this](const QString &path, bool ret) {
+        if (ret) {
+            invalidate({path});
+        }
+    });
+
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+        // 取消后执行中的批次跳过剩余图片，未执行的批次由调度器丢弃，最多等待 QUIT_WAIT_MS
+        m_cancelToken.cancel();
+        QMutexLocker locker(&m_stateMutex);
+        if (m_running && !m_idle.wait(&m_stateMutex, QUIT_WAIT_MS)) {
+            qWarning() << "Perceptual hash index is still running at exit";
+        }
+    });
+}
+
+PerceptualHashIndex *PerceptualHashIndex::instance()
+{
+    static PerceptualHashIndex ins;
+    return &ins;
+}
+
+/**
+ * @brief 计算 \a image 的差异哈希(dHash)
+ *      与缩略图的裁切方式一致，宽高差异较大时先裁切中心的正方形区域，
+ *      再缩放为9x8灰度图，每行相邻像素比较得到64位哈希
+ */
+quint64 PerceptualHashIndex::dHash(const QImage &image)
+{
+    if (image.isNull()) {
+        return 0;
+    }
+
+    QImage square = image;
+    int width = image.width();
+    int height = image.height();
+    if (abs((width - height) * 10 / width) >= 1) {
+        int side = qMin(width, height);
+        square = image.copy((width - side) / 2, (height - side) / 2, side, side);
+    }
+
+    QImage gray = square.scaled(9, 8, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                  .convertToFormat(QImage::Format_Grayscale8);
+
+    quint64 hash = 0;
+    for (int y = 0; y < 8; ++y) {
+        const uchar *line = gray.constScanLine(y);
+        for (int x = 0; x < 8; ++x) {
+            hash = (hash << 1) | (line[x] > line[x + 1] ? 1 : 0);
+        }
+    }
+    return hash;
+}
+
+bool PerceptualHashIndex::hashFile(const QString &path, quint64 &hash)
+{
+    QImage image;
+    // 使用最小级别的方图缩略图，足够计算哈希
+    QString thumbnailPath = ImageDataService::getLevelPath(Libutils::base::filePathToThumbnailPath(path),
+                                                           ImageDataService::thumbnailLevels().first());
+    if (QFileInfo::exists(thumbnailPath)) {
+        ImageDataService::loadThumbnailFile(thumbnailPath, image);
+    }
+
+    // 缩略图尚未生成时按缩小尺寸解码原图，JPEG等格式可直接以低分辨率解码
+    if (image.isNull()) {
+        QImageReader reader(path);
+        reader.setAutoTransform(true);
+        QSize size = reader.size();
+        if (size.isValid()) {
+            reader.setScaledSize(size.scaled(SOURCE_DECODE_SIZE, SOURCE_DECODE_SIZE, Qt::KeepAspectRatioByExpanding));
+        }
+        image = reader.read();
+    }
+
+    if (image.isNull()) {
+        return false;
+    }
+
+    hash = dHash(image);
+    return true;
+}
+
+void PerceptualHashIndex::startIndexing()
+{
+    bool expected = false;
+    if (!m_running.compare_exchange_strong(expected, true)) {
+        return;
+    }
+
+    m_cancelToken = WorkCancelToken();
+    scheduleBatch();
+}
+
+void PerceptualHashIndex::invalidate(const QStringList &paths)
+{
+    if (paths.isEmpty()) {
+        return;
+    }
+
+    DBManager::instance()->clearPerceptualHashes(paths);
+
+    QWriteLocker locker(&m_lock);
+    for (const QString &path : paths) {
+        auto itr = m_pathIds.find(path);
+        if (itr != m_pathIds.end()) {
+            m_paths[itr.value()].clear();
+            m_pathIds.erase(itr);
+        }
+    }
+}
+
+QStringList PerceptualHashIndex::findSimilar(const QString &path, int radius)
+{
+    QStringList result;
+    {
+        QReadLocker locker(&m_lock);
+        auto itr = m_pathIds.constFind(path);
+        if (itr == m_pathIds.constEnd()) {
+            return result;
+        }
+
+        for (int id : m_table.query(m_table.hashAt(itr.value()), radius)) {
+            if (id != itr.value() && !m_paths.at(id).isEmpty()) {
+                result << m_paths.at(id);
+            }
+        }
+    }
+
+    // 过滤已删除的文件
+    result.erase(std::remove_if(result.begin(), result.end(), [](const QString &similarPath) {
+        return !QFileInfo::exists(similarPath);
+    }), result.end());
+    return result;
+}
+
+/**
+ * @brief 查找所有相似图片分组，相似关系具有传递性，A与B相似、B与C相似时A、B、C归为一组
+ */
+QList<QStringList> PerceptualHashIndex::findDuplicates(int radius)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QHash<int, QStringList> groups;
+    int indexedCount = 0;
+    {
+        QReadLocker locker(&m_lock);
+        indexedCount = m_pathIds.size();
+        const int count = m_table.size();
+        QVector<int> parent(count);
+        std::iota(parent.begin(), parent.end(), 0);
+        auto findRoot = [&parent](int id) {
+            while (parent[id] != id) {
+                parent[id] = parent[parent[id]];
+                id = parent[id];
+            }
+            return id;
+        };
+
+        for (int id = 0; id < count; ++id) {
+            if (m_paths.at(id).isEmpty()) {
+                continue;
+            }
+            for (int other : m_table.query(m_table.hashAt(id), radius)) {
+                if (other > id && !m_paths.at(other).isEmpty()) {
+                    parent[findRoot(other)] = findRoot(id);
+                }
+            }
+        }
+
+        for (int id = 0; id < count; ++id) {
+            if (!m_paths.at(id).isEmpty()) {
+                groups[findRoot(id)] << m_paths.at(id);
+            }
+        }
+    }
+
+    QList<QStringList> result;
+    for (QStringList &group : groups) {
+        if (group.size() < 2) {
+            continue;
+        }
+        group.erase(std::remove_if(group.begin(), group.end(), [](const QString &path) {
+            return !QFileInfo::exists(path);
+        }), group.end());
+        if (group.size() >= 2) {
+            result << group;
+        }
+    }
+
+    qDebug() << QString("Find duplicates, images:%1 groups:%2 radius:%3 cost:%4ms")
+             .arg(indexedCount).arg(result.size()).arg(radius).arg(timer.elapsed());
+    return result;
+}
+
+/**
+ * @brief 索引分为多个短任务，每个任务处理一批后重新排队，不会长时间占用后台线程，
+ *      期间配置写回、缓存清理等其他后台任务可以穿插执行
+ */
+void PerceptualHashIndex::scheduleBatch()
+{
+    WorkScheduler::instance()->submit(WorkScheduler::Background, [this]() {
+        if (!m_cancelToken.isCancelled() && runBatch()) {
+            scheduleBatch();
+        } else {
+            finishIndexing();
+        }
+    }, m_cancelToken, [this]() {
+        m_indexTimer.invalidate();
+        setIdle();
+    });
+}
+
+/**
+ * @brief 处理一批未计算哈希的图片，首次执行时载入已保存的哈希及待处理列表，返回是否还有剩余
+ */
+bool PerceptualHashIndex::runBatch()
+{
+    if (!m_indexTimer.isValid()) {
+        m_indexTimer.start();
+        if (!m_loaded) {
+            const auto savedHashes = DBManager::instance()->getPerceptualHashes();
+            QWriteLocker locker(&m_lock);
+            for (const auto &item : savedHashes) {
+                addHash(item.first, item.second);
+            }
+            m_loaded = true;
+        }
+
+        m_pending = DBManager::instance()->getPathsWithoutPerceptualHash();
+        m_pendingPos = 0;
+        m_hashedCount = 0;
+    }
+
+    if (m_pendingPos >= m_pending.size()) {
+        return false;
+    }
+
+    const QStringList batch = m_pending.mid(m_pendingPos, INDEX_BATCH_SIZE);
+    m_pendingPos += batch.size();
+    //在调度器的后台任务中并行计算，与其他后台任务共用并发上限
+    QVector<QPair<QString, quint64>> results(batch.size());
+    WorkScheduler::instance()->parallelFor(WorkScheduler::Background, batch.size(), [&batch, &results](int i) {
+        quint64 hash = 0;
+        if (hashFile(batch.at(i), hash)) {
+            results[i] = qMakePair(batch.at(i), hash);
+        }
+    }, 0, m_cancelToken);
+
+    QList<QPair<QString, quint64>> hashes;
+    for (const auto &item : results) {
+        if (!item.first.isEmpty()) {
+            hashes << item;
+        }
+    }
+    DBManager::instance()->updatePerceptualHashes(hashes);
+
+    {
+        QWriteLocker locker(&m_lock);
+        for (const auto &item : hashes) {
+            addHash(item.first, item.second);
+        }
+    }
+    m_hashedCount += hashes.size();
+
+    emit indexProgress(m_pendingPos, m_pending.size());
+    return m_pendingPos < m_pending.size();
+}
+
+void PerceptualHashIndex::finishIndexing()
+{
+    {
+        QReadLocker locker(&m_lock);
+        qDebug() << QString("Perceptual hash index finished, indexed:%1 pending:%2 hashed:%3 cost:%4ms")
+                 .arg(m_pathIds.size()).arg(m_pending.size()).arg(m_hashedCount).arg(m_indexTimer.elapsed());
+    }
+
+    m_pending.clear();
+    m_indexTimer.invalidate();
+    setIdle();
+    emit indexFinished();
+}
+
+/**
+ * @brief 标记索引结束，唤醒退出时的等待
+ */
+void PerceptualHashIndex::setIdle()
+{
+    QMutexLocker locker(&m_stateMutex);
+    m_running = false;
+    m_idle.wakeAll();
+}
+
+// 调用时需持有写锁
+void PerceptualHashIndex::addHash(const QString &path, quint64 hash)
+{
+    auto itr = m_pathIds.find(path);
+    if (itr != m_pathIds.end()) {
+        m_paths[itr.value()].clear();
+    }
+
+    m_pathIds[path] = m_table.insert(hash);
+    m_paths << path;
+}
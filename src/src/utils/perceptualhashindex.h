@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef PERCEPTUALHASHINDEX_H
+#define PERCEPTUALHASHINDEX_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QStringList>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "utils/workscheduler.h"
+
+#include <atomic>
+
+/**
+ * @brief 64位感知哈希的多索引哈希表
+ *      将哈希拆分为4段16位，两个哈希的汉明距离不超过 r 时，至少有一段的距离不超过 r/4 ，
+ *      查询时仅需在各段中枚举该范围内的值，候选集远小于全表，适合大量哈希的相似查询
+ */
+class MultiIndexHashTable
+{
+public:
+    // 插入哈希，返回该哈希的编号
+    int insert(quint64 hash);
+    // 查询与 hash 汉明距离不超过 radius 的所有编号
+    QVector<int> query(quint64 hash, int radius) const;
+    quint64 hashAt(int id) const { return m_hashes.at(id); }
+    int size() const { return m_hashes.size(); }
+    void clear();
+
+    static int distance(quint64 left, quint64 right);
+
+    // 支持的最大查询半径，更大的半径每段需枚举的值过多
+    static const int MaxRadius = 11;
+
+private:
+    static const int SegmentCount = 4;
+
+    QVector<quint64> m_hashes;
+    QHash<quint16, QVector<int>> m_tables[SegmentCount];
+};
+
+/**
+ * @brief 图片感知哈希(dHash)索引，用于查找重复及相似图片
+ *      后台使用已生成的缩略图计算哈希并保存到数据库，启动时从数据库载入，仅计算新增图片
+ */
+class PerceptualHashIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static PerceptualHashIndex *instance();
+
+    // 默认判定为相似图片的汉明距离
+    static const int DefaultRadius = 6;
+
+    // 计算图片的dHash，图片为空时返回0
+    static quint64 dHash(const QImage &image);
+    // 计算文件的dHash，优先使用已生成的缩略图，失败时返回false
+    static bool hashFile(const QString &path, quint64 &hash);
+
+    // 启动后台索引，已在运行时忽略
+    void startIndexing();
+    // 文件内容变更(如旋转)，清除保存的哈希，下次索引时重新计算
+    void invalidate(const QStringList &paths);
+
+    // 查找与 path 相似的图片，不包含 path 自身
+    QStringList findSimilar(const QString &path, int radius = DefaultRadius);
+    // 查找所有相似图片分组，每组至少两张
+    QList<QStringList> findDuplicates(int radius = DefaultRadius);
+
+signals:
+    // 索引进度，处理过程中定时通知
+    void indexProgress(int finished, int total);
+    void indexFinished();
+
+private:
+    explicit PerceptualHashIndex(QObject *parent = nullptr);
+
+    void scheduleBatch();
+    bool runBatch();
+    void finishIndexing();
+    void setIdle();
+    void addHash(const QString &path, quint64 hash);
+
+    QReadWriteLock m_lock;
+    MultiIndexHashTable m_table;
+    QStringList m_paths;                // 编号对应的文件路径，失效的编号路径为空
+    QHash<QString, int> m_pathIds;
+    bool m_loaded = false;              // 数据库中的哈希已载入
+
+    // 索引过程中的状态，同时只有一个批次任务在执行
+    QStringList m_pending;              // 待计算哈希的图片
+    int m_pendingPos = 0;
+    int m_hashedCount = 0;
+    QElapsedTimer m_indexTimer;
+
+    std::atomic_bool m_running{false};
+    WorkCancelToken m_cancelToken;      // 退出时取消，未执行的批次及批次内未处理的图片被跳过
+    QMutex m_stateMutex;                // 与 m_idle 配合，退出时等待执行中的批次结束
+    QWaitCondition m_idle;
+};
+
+#endif // PERCEPTUALHASHINDEX_H
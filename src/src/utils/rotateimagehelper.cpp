@@ -5,44 +5,106 @@
 #include "rotateimagehelper.h"
 #include "imagedata/imagefilewatcher.h"
 #include "unionimage/unionimage.h"
+#include "utils/workscheduler.h"
 
 #include <QApplication>
-#include <QQueue>
-#include <QFutureWatcher>
-#include <QTemporaryDir>
-#include <QtConcurrent>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutex>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QWaitCondition>
+
+#include <cerrno>
+#include <cstdio>
+
+// 旋转操作合并等待时间，在此期间对同一文件的多次旋转合并为一次写入
+static const int sc_CommitDelay = 100;
+// 旋转处理速率通知间隔
+static const qint64 sc_ThroughputInterval = 1000;
+// 旋转原图备份目录(缓存目录下)，程序退出时清理
+static const QString sc_OriginalDir = "/rotate-originals/";
+// 有损格式，多次重新编码会累积画质损失，旋转时始终基于原图处理
+static const QSet<QString> sc_LossyFormats {"JPG", "JPEG"};
+
+/**
+   @brief 有损格式图片旋转前的原图备份，记录原图已累计旋转的角度及最近一次写入后的文件状态，
+    文件在外部被修改后备份失效，下次旋转时重新备份
+ */
+struct RotateOriginal
+{
+    QString backupPath;     // 原图备份路径
+    int totalAngle = 0;     // 相对原图累计旋转的角度
+    QDateTime writtenTime;  // 最近一次写入后的修改时间
+    qint64 writtenSize = 0; // 最近一次写入后的文件大小
+};
+
+class RotateOriginalStore
+{
+public:
+    QMutex mutex;
+    QHash<QString, RotateOriginal> originals;
+};
+Q_GLOBAL_STATIC(RotateOriginalStore, rotateOriginalStore)
 
 class RotateImageHelperData
 {
 public:
     explicit RotateImageHelperData();
 
-    QString currentRotateImage;         // 当前操作的
-    QHash<QString, int> rotationCache;  // 已缓存旋转文件列表 <文件路径，缓存旋转角度>
-    QFutureWatcher<void> watcher;       // 异步处理监视器
+    QTimer commitTimer;                 // 延迟提交定时器
 
     // 图片旋转处理队列
     QMutex queueMutex;
-    QQueue<QPair<QString, int>> processQueue;  // 待处理的图片队列
-    QTemporaryDir cacheDir;                    // 临时文件目录
+    QStringList processOrder;           // 待处理的图片，按请求顺序排列
+    QHash<QString, int> pendingAngles;  // 待处理的图片及合并后的旋转角度
+    QSet<QString> processingFiles;      // 正在处理的图片，同一文件不会并行处理
+    int runningWorkers = 0;             // 运行中的处理任务数
+    QWaitCondition workersDone;         // 处理任务全部结束时通知
+    int maxWorkers = 1;                 // 最大并行处理任务数
+
+    // 处理速率统计，以队列由空闲转为忙碌作为一轮统计开始
+    QElapsedTimer batchTimer;
+    int batchFinished = 0;
+    qint64 lastReport = 0;
 };
 
-RotateImageHelperData::RotateImageHelperData() { }
+RotateImageHelperData::RotateImageHelperData()
+{
+    commitTimer.setSingleShot(true);
+    commitTimer.setInterval(sc_CommitDelay);
+    maxWorkers = qBound(1, QThread::idealThreadCount() / 2, 4);
+}
 
 /**
    @class RotateImageHelper
-   @brief 用于异步拷贝文本数据，防止阻塞界面(特别是在节能模式下)
-    原始文件将被存放于临时目录，在程序退出时移除，降低频繁读写文件导致图像质量降低
+   @brief 图片旋转任务队列，在线程池中异步处理，防止阻塞界面(特别是在节能模式下)
+    提交前对同一文件的多次旋转合并为一个角度，合并后为0度的任务直接丢弃；
+    旋转结果先写入同目录下的临时文件，成功后通过重命名原子替换原文件；
+    有损格式首次旋转时备份原图，之后的旋转均基于原图及累计角度重新编码，画质损失不会叠加。
  */
 RotateImageHelper::RotateImageHelper(QObject *parent)
     : QObject { parent }
 {
     connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
-        // 等待拷贝文件结束
-        if (data && data->watcher.isRunning()) {
-            data->watcher.waitForFinished();
-            data->cacheDir.remove();
+        if (!data) {
+            return;
+        }
+
+        // 提交等待中的任务，并等待处理结束，保证旋转结果已写入文件
+        commitPendingRotations();
+        QMutexLocker locker(&(data->queueMutex));
+        while (0 != data->runningWorkers) {
+            data->workersDone.wait(&(data->queueMutex));
         }
+        locker.unlock();
+
+        // 原图备份仅在本次运行中用于避免重复编码
+        QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + sc_OriginalDir).removeRecursively();
     });
 }
 
@@ -53,7 +115,7 @@ RotateImageHelper *RotateImageHelper::instance()
 }
 
 /**
-   @brief 旋转图片文件 \a path 共 \a angle 度
+   @brief 旋转图片文件 \a path 共 \a angle 度，若该文件已有待处理的旋转任务，则合并旋转角度
  */
 void RotateImageHelper::rotateImageFile(const QString &path, int angle)
 {
@@ -76,30 +138,27 @@ void RotateImageHelper::rotateImageFile(const QString &path, int angle)
     // 构造数据结构
     checkDataValid();
 
-    // 记录总旋转角度
-    int &totalAngle = data->rotationCache[path];
-    totalAngle += angle;
-    totalAngle %= 360;
-
-    if (data->watcher.isRunning()) {
-        QMutexLocker locker(&(data->queueMutex));
-        for (auto &proc : data->processQueue) {
-            if (proc.first == path) {
-                proc.second = totalAngle;
-                // 查找数据，插入后退出
-                return;
-            }
+    QMutexLocker locker(&(data->queueMutex));
+    auto itr = data->pendingAngles.find(path);
+    if (itr != data->pendingAngles.end()) {
+        // 合并旋转角度，旋转一周后无需处理
+        itr.value() = (itr.value() + angle) % 360;
+        if (0 == itr.value()) {
+            data->pendingAngles.erase(itr);
+            data->processOrder.removeOne(path);
         }
-        // 未查找到数据，插入队列
-        data->processQueue.enqueue(qMakePair(path, totalAngle));
-
     } else {
-        enqueueRotateTask(path, totalAngle);
+        data->pendingAngles.insert(path, angle);
+        data->processOrder.append(path);
     }
+    locker.unlock();
+
+    // 延迟提交，合并连续的旋转操作
+    data->commitTimer.start();
 }
 
 /**
-   @brief 用于重置旋转记录信息，不会影响在处理中的文件
+   @brief 用于重置旋转处理速率统计，不会影响在处理中的文件
  */
 void RotateImageHelper::resetRotateState()
 {
@@ -107,29 +166,94 @@ void RotateImageHelper::resetRotateState()
         return;
     }
 
-    data->rotationCache.clear();
-    if (!data->watcher.isRunning()) {
-        data->cacheDir.remove();
+    QMutexLocker locker(&(data->queueMutex));
+    data->batchFinished = 0;
+    data->lastReport = 0;
+    if (data->batchTimer.isValid()) {
+        data->batchTimer.restart();
+    }
+}
+
+/**
+   @brief 立即启动处理等待中的旋转任务
+ */
+void RotateImageHelper::commitPendingRotations()
+{
+    if (!data) {
+        return;
     }
+
+    data->commitTimer.stop();
+    startWorkers();
 }
 
 /**
-   @brief 缓存文件 \a cachePath 不存在时，拷贝文件 \a path 到缓存路径 \a cachePath .
-    将缓存文件 \a cachePath 旋转 \a angle 度并保存到 \a path 中
+   @brief 将文件 \a path 旋转 \a angle 度，结果写入同目录下的临时文件后替换原文件
  */
-bool RotateImageHelper::rotateImageImpl(const QString &cachePath, const QString &path, int angle)
+bool RotateImageHelper::rotateImageImpl(const QString &path, int angle)
 {
-    // 拷贝文件到目录
-    if (!QFile::exists(cachePath)) {
-        if (!QFile::copy(path, cachePath))
-            return false;
+    QFileInfo info(path);
+    if (!info.exists()) {
+        return false;
     }
 
+    // 临时文件保留原后缀，保存时根据后缀确定格式
+    const QString tempPath = info.absoluteDir().filePath(
+        QString(".%1.rotate.%2").arg(info.completeBaseName()).arg(info.suffix()));
+
     // 操作前标记动作
     Q_EMIT RotateImageHelper::instance()->recordRotateImage(path);
 
+    // 有损格式基于原图备份旋转累计角度，避免每次旋转都在上次编码结果上再次编码
+    QString sourcePath = path;
+    int sourceAngle = angle;
+    RotateOriginal original;
+    const bool lossy = sc_LossyFormats.contains(LibUnionImage_NameSpace::detectImageFormat(path));
+    if (lossy) {
+        original = prepareOriginal(info);
+        if (!original.backupPath.isEmpty()) {
+            sourcePath = original.backupPath;
+            sourceAngle = (original.totalAngle + angle) % 360;
+        }
+    }
+
     QString errorMsg;
-    bool ret = LibUnionImage_NameSpace::rotateImageFIle(angle, cachePath, errorMsg, path);
+    bool ret = false;
+    if (0 == sourceAngle) {
+        // 旋转回原始方向，直接使用原图，不再编码
+        QFile::remove(tempPath);
+        ret = QFile::copy(sourcePath, tempPath);
+        if (!ret) {
+            errorMsg = QString("restore original failed: %1").arg(sourcePath);
+        }
+    } else {
+        ret = LibUnionImage_NameSpace::rotateImageFIle(sourceAngle, sourcePath, errorMsg, tempPath);
+    }
+    if (ret) {
+        // 保持原文件权限，rename 在同一文件系统内为原子操作
+        QFile::setPermissions(tempPath, QFile::permissions(path));
+        if (0 != std::rename(QFile::encodeName(tempPath).constData(), QFile::encodeName(path).constData())) {
+            errorMsg = QString("replace file failed: %1").arg(qt_error_string(errno));
+            ret = false;
+        }
+    }
+    if (!ret) {
+        QFile::remove(tempPath);
+    }
+
+    if (lossy && !original.backupPath.isEmpty()) {
+        QMutexLocker locker(&(rotateOriginalStore()->mutex));
+        if (ret) {
+            QFileInfo written(path);
+            original.totalAngle = sourceAngle;
+            original.writtenTime = written.lastModified();
+            original.writtenSize = written.size();
+            rotateOriginalStore()->originals.insert(info.absoluteFilePath(), original);
+        } else {
+            rotateOriginalStore()->originals.remove(info.absoluteFilePath());
+            QFile::remove(original.backupPath);
+        }
+    }
 
     // NOTE：处理结束，过滤旋转操作文件更新，旋转图像已在软件中缓存且旋转状态同步，不再从文件中更新读取
     // 保存文件后发送图片更新更新信号，通过监控文件变更触发。文件更新可能滞后，延时一定时间处理
@@ -145,41 +269,110 @@ bool RotateImageHelper::rotateImageImpl(const QString &cachePath, const QString
 }
 
 /**
-   @brief 将文件 \a path 旋转 \a angle 角度任务压入队列中并启动任务
+   @brief 取得文件 \a info 的原图备份，若无备份或文件在上次旋转后被外部修改，以当前文件重新备份，
+    备份失败时返回空路径，此时直接基于当前文件旋转
+ */
+RotateOriginal RotateImageHelper::prepareOriginal(const QFileInfo &info)
+{
+    const QString path = info.absoluteFilePath();
+    QMutexLocker locker(&(rotateOriginalStore()->mutex));
+    RotateOriginal original = rotateOriginalStore()->originals.value(path);
+    if (!original.backupPath.isEmpty()
+            && original.writtenTime == info.lastModified()
+            && original.writtenSize == info.size()
+            && QFile::exists(original.backupPath)) {
+        return original;
+    }
+    locker.unlock();
+
+    const QString dirPath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + sc_OriginalDir;
+    QDir().mkpath(dirPath);
+    original = RotateOriginal();
+    original.backupPath = dirPath + LibUnionImage_NameSpace::hashByString(path) + "." + info.suffix();
+    QFile::remove(original.backupPath);
+    if (!QFile::copy(path, original.backupPath)) {
+        qWarning() << QString("Backup original image failed: %1").arg(path);
+        return RotateOriginal();
+    }
+    return original;
+}
+
+/**
+   @brief 按最大并行数启动旋转处理任务
  */
-void RotateImageHelper::enqueueRotateTask(const QString &path, int angle)
+void RotateImageHelper::startWorkers()
 {
-    // 启动新的旋转处理线程
-    QMutexLocker queueLocker(&(data->queueMutex));
-    data->processQueue.enqueue(qMakePair(path, angle));
-    queueLocker.unlock();
-
-    auto rotateFuture = QtConcurrent::run([this]() {
-        int queueSize = 0;
-        do {
-            QPair<QString, int> currentData;
-
-            QMutexLocker locker(&(data->queueMutex));
-            if (data->processQueue.isEmpty()) {
+    QMutexLocker locker(&(data->queueMutex));
+    if (data->processOrder.isEmpty()) {
+        return;
+    }
+
+    if (0 == data->runningWorkers && !data->batchTimer.isValid()) {
+        data->batchTimer.start();
+        data->batchFinished = 0;
+        data->lastReport = 0;
+    }
+
+    int count = qMin(data->maxWorkers - data->runningWorkers, data->processOrder.size());
+    data->runningWorkers += qMax(0, count);
+    locker.unlock();
+
+    // 退出时调度器丢弃未执行的任务，此时直接在当前线程处理，保证旋转结果写入文件且计数归零
+    for (int i = 0; i < count; ++i) {
+        WorkScheduler::instance()->submit(WorkScheduler::BulkIO, [this]() { processQueue(); }, WorkCancelToken(), [this]() { processQueue(); });
+    }
+}
+
+/**
+   @brief 线程池任务，循环取出不在处理中的文件执行旋转，直至队列中无可处理的文件
+ */
+void RotateImageHelper::processQueue()
+{
+    QMutexLocker locker(&(data->queueMutex));
+    forever {
+        QString path;
+        for (const QString &pending : data->processOrder) {
+            if (!data->processingFiles.contains(pending)) {
+                path = pending;
                 break;
             }
-            currentData = data->processQueue.dequeue();
-            locker.unlock();
-
-            // 执行拷贝文件及旋转
-            QFileInfo file(currentData.first);
-            QString cacheFile = data->cacheDir.filePath(file.fileName());
-            if (!rotateImageImpl(cacheFile, currentData.first, currentData.second)) {
-                qWarning() << qPrintable("Rotate image failed!");
-            }
+        }
+        if (path.isEmpty()) {
+            break;
+        }
 
-            locker.relock();
-            queueSize = data->processQueue.size();
-            locker.unlock();
-        } while (queueSize > 0);
-    });
+        int angle = data->pendingAngles.take(path);
+        data->processOrder.removeOne(path);
+        data->processingFiles.insert(path);
+        locker.unlock();
 
-    data->watcher.setFuture(rotateFuture);
+        rotateImageImpl(path, angle);
+
+        locker.relock();
+        data->processingFiles.remove(path);
+        data->batchFinished++;
+
+        // 每秒通知一次处理速率
+        qint64 elapsed = data->batchTimer.elapsed();
+        if (elapsed - data->lastReport >= sc_ThroughputInterval) {
+            data->lastReport = elapsed;
+            double throughput = data->batchFinished * 1000.0 / qMax<qint64>(elapsed, 1);
+            int remaining = data->processOrder.size() + data->processingFiles.size();
+            Q_EMIT rotateThroughput(throughput, remaining);
+        }
+    }
+
+    data->runningWorkers--;
+    if (0 == data->runningWorkers) {
+        data->workersDone.wakeAll();
+    }
+    if (0 == data->runningWorkers && data->processOrder.isEmpty()) {
+        qint64 elapsed = data->batchTimer.elapsed();
+        qInfo() << QString("Rotate %1 images cost %2 ms, %3 files/s")
+                       .arg(data->batchFinished).arg(elapsed)
+                       .arg(data->batchFinished * 1000.0 / qMax<qint64>(elapsed, 1), 0, 'f', 1);
+        data->batchTimer.invalidate();
+    }
 }
 
 /**
@@ -190,10 +383,7 @@ void RotateImageHelper::checkDataValid()
     if (!data) {
         data.reset(new RotateImageHelperData);
 
-        if (!data->cacheDir.isValid()) {
-            qWarning() << qPrintable("Can not create cache dir :") << data->cacheDir.errorString();
-        }
-
+        connect(&data->commitTimer, &QTimer::timeout, this, &RotateImageHelper::startWorkers);
         connect(this,
                 &RotateImageHelper::recordRotateImage,
                 ImageFileWatcher::instance(),
@@ -8,7 +8,9 @@
 #include <QObject>
 #include <QSharedPointer>
 
+class QFileInfo;
 class RotateImageHelperData;
+struct RotateOriginal;
 class RotateImageHelper : public QObject
 {
     Q_OBJECT
@@ -17,16 +19,22 @@ public:
 
     Q_SLOT void rotateImageFile(const QString &path, int angle);
     Q_SLOT void resetRotateState();
+    // 立即提交等待中的旋转任务，不再等待合并后续的旋转操作
+    Q_SLOT void commitPendingRotations();
 
     Q_SIGNAL void rotateImageFinished(const QString &path, bool ret);
+    // 旋转处理速率(文件数/秒)及剩余任务数，处理过程中每秒通知一次
+    Q_SIGNAL void rotateThroughput(double filesPerSecond, int remaining);
 
-    static bool rotateImageImpl(const QString &cachePath, const QString &path, int angle);
+    static bool rotateImageImpl(const QString &path, int angle);
 
 private:
     explicit RotateImageHelper(QObject *parent = nullptr);
     virtual ~RotateImageHelper() = default;
 
-    void enqueueRotateTask(const QString &path, int angle);
+    static RotateOriginal prepareOriginal(const QFileInfo &info);
+    void startWorkers();
+    void processQueue();
     void checkDataValid();
     // internal 用于异步处理图片旋转状态
     Q_SIGNAL void recordRotateImage(const QString &targetPath);
@@ -0,0 +1,271 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "settingsstore.h"
+#include "cachefile.h"
+#include "metrics.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QTimer>
+#include <QtEndian>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace {
+// 修改后合并写回的延时
+const int FLUSH_DELAY = 1000;
+// 日志记录头：内容长度、CRC32
+const int RECORD_HEADER_SIZE = 8;
+
+std::atomic<quint64> s_nextStoreId{1};
+
+// 线程缓存的快照，同一线程交替读取多个 SettingsStore 时每次切换需在锁内重新获取
+struct ThreadSnapshot {
+    quint64 storeId = 0;
+    quint64 version = 0;
+    std::shared_ptr<const QHash<QString, QVariant>> values;
+};
+thread_local ThreadSnapshot t_snapshot;
+}
+
+SettingsStore::SettingsStore(const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , m_filePath(filePath)
+    , m_id(s_nextStoreId++)
+    , m_flushTimer(new QTimer(this))
+{
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_DELAY);
+    connect(m_flushTimer, &QTimer::timeout, this, [this]() {
+        m_flushScheduled = false;
+        WorkScheduler::instance()->submit(WorkScheduler::Background, [this]() {
+            flush();
+        }, m_flushToken);
+    });
+
+    load();
+}
+
+SettingsStore::~SettingsStore()
+{
+    m_flushToken.cancel();
+    flush();
+
+    if (m_journalFd >= 0) {
+        ::close(m_journalFd);
+    }
+}
+
+QString SettingsStore::journalPath() const
+{
+    return m_filePath + ".journal";
+}
+
+/**
+ * @brief 当前线程缓存的快照，版本号与当前版本一致时直接返回，否则在锁内更新缓存。
+ *      返回的引用在当前线程下一次调用本函数前有效
+ */
+const SettingsStore::Values &SettingsStore::snapshot() const
+{
+    ThreadSnapshot &cached = t_snapshot;
+    if (cached.storeId != m_id || cached.version != m_version.load(std::memory_order_acquire)) {
+        QMutexLocker locker(&m_mutex);
+        cached.storeId = m_id;
+        cached.version = m_version.load(std::memory_order_relaxed);
+        cached.values = m_values;
+    }
+    return *cached.values;
+}
+
+QVariant SettingsStore::value(const QString &key, const QVariant &defaultValue) const
+{
+    const Values &values = snapshot();
+    auto it = values.constFind(key);
+    return it != values.constEnd() ? it.value() : defaultValue;
+}
+
+bool SettingsStore::contains(const QString &key) const
+{
+    return snapshot().contains(key);
+}
+
+bool SettingsStore::setValue(const QString &key, const QVariant &value)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_values->constFind(key);
+        if (it != m_values->constEnd() && it.value() == value) {
+            return false;
+        }
+
+        auto values = std::make_shared<Values>(*m_values);
+        values->insert(key, value);
+        m_values = std::move(values);
+        m_version.fetch_add(1, std::memory_order_release);
+
+        appendJournal(key, value);
+        m_dirtyKeys.insert(key);
+        ++m_sequence;
+    }
+
+    ALBUM_METRICS_COUNT("settings.write", 1);
+    scheduleFlush();
+    return true;
+}
+
+/**
+ * @brief 写回时取修改项及当前快照，写入 INI 文件期间的新修改不受影响，
+ *      写回成功后若期间没有新的修改则清空日志，否则保留日志(重放时后面的记录覆盖前面的)
+ */
+bool SettingsStore::flush()
+{
+    QMutexLocker flushLocker(&m_flushMutex);
+
+    QSet<QString> keys;
+    std::shared_ptr<const Values> values;
+    quint64 sequence = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_dirtyKeys.isEmpty()) {
+            return true;
+        }
+        keys.swap(m_dirtyKeys);
+        values = m_values;
+        sequence = m_sequence;
+    }
+
+    ALBUM_METRICS_SCOPE("settings.flush");
+    QSettings settings(m_filePath, QSettings::IniFormat);
+    for (const QString &key : keys) {
+        settings.setValue(key, values->value(key));
+    }
+    settings.sync();
+
+    QMutexLocker locker(&m_mutex);
+    if (settings.status() != QSettings::NoError) {
+        qWarning() << "SettingsStore: write failed:" << m_filePath << settings.status();
+        m_dirtyKeys.unite(keys);
+        return false;
+    }
+    if (m_sequence == sequence && m_journalFd >= 0) {
+        if (::ftruncate(m_journalFd, 0) != 0) {
+            qWarning() << "SettingsStore: truncate journal failed:" << journalPath() << strerror(errno);
+        }
+    }
+    return true;
+}
+
+bool SettingsStore::isDirty()
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_dirtyKeys.isEmpty();
+}
+
+/**
+ * @brief 读取 INI 文件后重放日志，日志中的配置项仍需写回；
+ *      末尾不完整的记录(写入中途断电)丢弃并截断，之后的记录追加在有效内容之后
+ */
+void SettingsStore::load()
+{
+    auto values = std::make_shared<Values>();
+    QSettings settings(m_filePath, QSettings::IniFormat);
+    for (const QString &key : settings.allKeys()) {
+        values->insert(key, settings.value(key));
+    }
+
+    QByteArray journal;
+    QFile file(journalPath());
+    if (file.open(QIODevice::ReadOnly)) {
+        journal = file.readAll();
+        file.close();
+    }
+
+    int pos = 0;
+    int replayed = 0;
+    while (journal.size() - pos >= RECORD_HEADER_SIZE) {
+        const quint32 size = qFromLittleEndian<quint32>(journal.constData() + pos);
+        const quint32 crc = qFromLittleEndian<quint32>(journal.constData() + pos + 4);
+        if (size > static_cast<quint32>(journal.size() - pos - RECORD_HEADER_SIZE)
+                || CacheFile::crc32(journal.constData() + pos + RECORD_HEADER_SIZE, size) != crc) {
+            break;
+        }
+
+        QDataStream stream(QByteArray::fromRawData(journal.constData() + pos + RECORD_HEADER_SIZE, static_cast<int>(size)));
+        QString key;
+        QVariant value;
+        stream >> key >> value;
+        if (stream.status() != QDataStream::Ok) {
+            break;
+        }
+        values->insert(key, value);
+        m_dirtyKeys.insert(key);
+        pos += RECORD_HEADER_SIZE + static_cast<int>(size);
+        ++replayed;
+    }
+    m_values = values;
+
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    m_journalFd = ::open(QFile::encodeName(journalPath()).constData(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (m_journalFd < 0) {
+        qWarning() << "SettingsStore: open journal failed:" << journalPath() << strerror(errno);
+    } else if (pos < journal.size() && ::ftruncate(m_journalFd, pos) != 0) {
+        qWarning() << "SettingsStore: truncate journal failed:" << journalPath() << strerror(errno);
+    }
+
+    if (replayed > 0) {
+        qDebug() << "SettingsStore: replayed" << replayed << "changes from journal," << journal.size() - pos << "bytes dropped";
+        scheduleFlush();
+    }
+}
+
+void SettingsStore::appendJournal(const QString &key, const QVariant &value)
+{
+    if (m_journalFd < 0) {
+        return;
+    }
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << key << value;
+
+    QByteArray record(RECORD_HEADER_SIZE, Qt::Uninitialized);
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), record.data());
+    qToLittleEndian<quint32>(CacheFile::crc32(payload.constData(), payload.size()), record.data() + 4);
+    record.append(payload);
+
+    //记录需一次写入，进程在两次 write 之间被杀死时重放会在此处截断
+    const char *data = record.constData();
+    qint64 size = record.size();
+    while (size > 0) {
+        const ssize_t written = ::write(m_journalFd, data, static_cast<size_t>(size));
+        if (written < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            qWarning() << "SettingsStore: write journal failed:" << journalPath() << strerror(errno);
+            return;
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+// 定时器属于创建线程，其他线程的修改通过事件队列启动
+void SettingsStore::scheduleFlush()
+{
+    bool expected = false;
+    if (m_flushScheduled.compare_exchange_strong(expected, true)) {
+        QMetaObject::invokeMethod(this, [this]() {
+            m_flushTimer->start();
+        }, Qt::QueuedConnection);
+    }
+}
@@ -0,0 +1,73 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SETTINGSSTORE_H
+#define SETTINGSSTORE_H
+
+#include "workscheduler.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QVariant>
+
+#include <atomic>
+#include <memory>
+
+class QTimer;
+
+/**
+ * @brief 配置文件(INI 格式)的内存存储及合并写回
+ * @details 载入时全部配置项读入内存，读取时取当前快照，不等待写入及写回；
+ *      写入时复制快照后替换(配置项很少，复制代价可忽略)并递增版本号，并追加一条记录到日志文件(一次 write，不等待落盘)。
+ *      每个线程缓存最近读取的快照及其版本号，版本未变化时读取只有一次原子读，不加锁也不修改引用计数；
+ *      版本变化后的首次读取在锁内取新快照。
+ *      修改在 FLUSH_DELAY 内合并，由后台线程通过 QSettings 写回(QSaveFile 原子替换)，
+ *      写回成功且期间没有新的修改时清空日志。进程异常退出后，下次载入时在 INI 内容之上重放日志，
+ *      setValue() 已返回的修改不会丢失。
+ */
+class SettingsStore : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SettingsStore(const QString &filePath, QObject *parent = nullptr);
+    ~SettingsStore() override;
+
+    QString filePath() const { return m_filePath; }
+    QString journalPath() const;
+
+    // key 为 QSettings 格式，如 "Thumbnail/CacheBudgetMB"
+    QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+    bool contains(const QString &key) const;
+    // 值未变化时不记录，返回 false
+    bool setValue(const QString &key, const QVariant &value);
+
+    // 立即写回有修改的配置项，返回是否成功
+    bool flush();
+    bool isDirty();
+
+private:
+    using Values = QHash<QString, QVariant>;
+
+    const Values &snapshot() const;
+    void load();
+    void appendJournal(const QString &key, const QVariant &value);
+    void scheduleFlush();
+
+    QString m_filePath;
+    const quint64 m_id;                         // 进程内唯一标识，用于匹配线程缓存的快照
+    std::shared_ptr<const Values> m_values;     // 当前快照，由 m_mutex 保护
+    std::atomic<quint64> m_version{0};          // 快照版本，每次替换后递增
+    mutable QMutex m_mutex;                     // 快照、写入、日志及修改记录
+    QMutex m_flushMutex;                        // 写回串行执行
+    QSet<QString> m_dirtyKeys;
+    quint64 m_sequence = 0;                     // 修改次数，用于判断写回期间是否有新的修改
+    int m_journalFd = -1;
+    std::atomic_bool m_flushScheduled{false};
+    QTimer *m_flushTimer;
+    WorkCancelToken m_flushToken;
+};
+
+#endif // SETTINGSSTORE_H
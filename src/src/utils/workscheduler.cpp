@@ -0,0 +1,273 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "workscheduler.h"
+#include "globalcontrol.h"
+#include "utils/metrics.h"
+
+#include <QCoreApplication>
+#include <QDeadlineTimer>
+#include <QDebug>
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+const char *const WORK_CLASS_NAMES[WorkScheduler::WorkClassCount] = {"visible", "prefetch", "background", "bulkio"};
+}
+
+WorkScheduler::WorkScheduler(QObject *parent)
+    : QObject(parent)
+{
+    // 逻辑线程数较少的平台仅使用一个后台线程，防止界面卡死；可见任务另有一个专用线程
+    m_workerCount = GlobalControl::enableMultiThread() ? QThread::idealThreadCount() : 1;
+    m_computeThreads = qMax(2, m_workerCount);
+
+    m_limits[Visible] = m_workerCount;
+    m_limits[Prefetch] = qMax(1, m_workerCount / 2);
+    m_limits[Background] = qMax(1, m_workerCount / 4);
+    m_limits[BulkIO] = qBound(1, m_workerCount / 4, 2);
+    m_pool.setMaxThreadCount(m_computeThreads + m_limits[BulkIO]);
+
+    for (int i = 0; i < WorkClassCount; ++i) {
+        m_queueWait[i] = MetricsRegistry::instance()->histogram(QString("scheduler.%1.queueWait").arg(WORK_CLASS_NAMES[i]));
+    }
+
+    qInfo() << "Work scheduler workers:" << m_workerCount << "threads:" << m_pool.maxThreadCount() << "limits:" << m_limits[Visible] << m_limits[Prefetch]
+            << m_limits[Background] << m_limits[BulkIO];
+
+    if (qApp) {
+        // 退出时丢弃未执行的任务(调用 discard 恢复状态)，等待执行中的任务结束
+        connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+            discardAll();
+            m_pool.waitForDone();
+        });
+    }
+}
+
+WorkScheduler *WorkScheduler::instance()
+{
+    // 不释放，退出过程中仍可能有任务提交
+    static WorkScheduler *ins = new WorkScheduler;
+    return ins;
+}
+
+/**
+ * @brief 以 \a workClass 优先级执行 \a runnable ，与 QThreadPool::start() 相同，
+ *      runnable->autoDelete() 为 true 时执行后释放
+ */
+void WorkScheduler::start(WorkClass workClass, QRunnable *runnable)
+{
+    if (!runnable) {
+        return;
+    }
+
+    Task task;
+    task.run = [runnable]() {
+        bool autoDelete = runnable->autoDelete();
+        runnable->run();
+        if (autoDelete) {
+            delete runnable;
+        }
+    };
+    task.discard = [runnable]() {
+        if (runnable->autoDelete()) {
+            delete runnable;
+        }
+    };
+    enqueue(workClass, std::move(task));
+}
+
+/**
+ * @brief 以 \a workClass 优先级执行 \a task ，启动前 \a token 已取消或退出时丢弃并调用 \a discard
+ */
+void WorkScheduler::submit(WorkClass workClass, std::function<void()> task, const WorkCancelToken &token, std::function<void()> discard)
+{
+    Task item;
+    item.run = std::move(task);
+    item.discard = std::move(discard);
+    item.token = token;
+    enqueue(workClass, std::move(item));
+}
+
+/**
+ * @brief 并行执行 \a func(i) ，i 取 [0, \a count) ，取代各模块自建的线程池及 QtConcurrent 的全局线程池，
+ *      使批量任务同样受 \a workClass 的优先级及并发上限约束。
+ *      调用线程与提交的辅助任务共同从同一计数器中领取下一项，辅助任务未能启动(线程已满或退出时被丢弃)时
+ *      由调用线程执行全部项，因此在调度器任务中调用也不会死锁；只等待已被领取的项完成
+ */
+void WorkScheduler::parallelFor(WorkClass workClass, int count, const std::function<void(int)> &func, int maxParallel,
+                                const WorkCancelToken &token)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    struct ParallelState {
+        std::function<void(int)> func;
+        WorkCancelToken token;
+        int count = 0;
+        std::atomic_int next{0};
+        QMutex mutex;
+        QWaitCondition doneCondition;
+        int done = 0;
+    };
+    auto state = std::make_shared<ParallelState>();
+    state->func = func;
+    state->token = token;
+    state->count = count;
+
+    auto drain = [](const std::shared_ptr<ParallelState> &state) {
+        for (int i = state->next++; i < state->count; i = state->next++) {
+            if (!state->token.isCancelled()) {
+                state->func(i);
+            }
+            QMutexLocker locker(&state->mutex);
+            if (++state->done == state->count) {
+                state->doneCondition.wakeAll();
+            }
+        }
+    };
+
+    const int parallel = maxParallel > 0 ? maxParallel : m_limits[workClass] + 1;
+    const int helperCount = qMin(parallel, count) - 1;
+    for (int i = 0; i < helperCount; ++i) {
+        submit(workClass, [state, drain]() {
+            drain(state);
+        });
+    }
+    drain(state);
+
+    QMutexLocker locker(&state->mutex);
+    while (state->done < state->count) {
+        state->doneCondition.wait(&state->mutex);
+    }
+}
+
+bool WorkScheduler::waitForDone(int msecs)
+{
+    QDeadlineTimer deadline = msecs < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(msecs);
+    QMutexLocker locker(&m_mutex);
+    while (m_totalActive > 0 || std::any_of(std::begin(m_queues), std::end(m_queues), [](const std::deque<Task> &queue) {
+               return !queue.empty();
+           })) {
+        if (!m_idleCondition.wait(&m_mutex, deadline)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int WorkScheduler::pendingCount(WorkClass workClass)
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_queues[workClass].size());
+}
+
+int WorkScheduler::activeCount(WorkClass workClass)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_active[workClass];
+}
+
+void WorkScheduler::enqueue(WorkClass workClass, Task &&task)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_quitting) {
+        locker.unlock();
+        if (task.discard) {
+            task.discard();
+        }
+        return;
+    }
+
+    task.queuedTime = std::chrono::steady_clock::now();
+    m_queues[workClass].push_back(std::move(task));
+    dispatch();
+}
+
+/**
+ * @brief 判断 \a workClass 类任务当前是否可以启动，调用前需加锁
+ */
+bool WorkScheduler::canStart(int workClass) const
+{
+    if (m_active[workClass] >= m_limits[workClass]) {
+        return false;
+    }
+
+    // BulkIO 使用独立的线程预算，并发上限即为其线程数
+    if (BulkIO == workClass) {
+        return true;
+    }
+
+    // 为可见任务保留一个计算线程
+    const int computeActive = m_totalActive - m_active[BulkIO];
+    if (Visible == workClass) {
+        return computeActive < m_computeThreads;
+    }
+    return computeActive - m_active[Visible] < m_computeThreads - 1;
+}
+
+/**
+ * @brief 按优先级启动可执行的任务，直至线程用尽或各类任务达到并发上限，调用前需加锁
+ */
+void WorkScheduler::dispatch()
+{
+    for (int workClass = 0; workClass < WorkClassCount; ++workClass) {
+        std::deque<Task> &queue = m_queues[workClass];
+        while (!queue.empty() && canStart(workClass)) {
+            Task task = std::move(queue.front());
+            queue.pop_front();
+            if (task.token.isCancelled()) {
+                if (task.discard) {
+                    task.discard();
+                }
+                continue;
+            }
+
+            m_active[workClass]++;
+            m_totalActive++;
+            m_queueWait[workClass]->record(static_cast<quint64>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                                    std::chrono::steady_clock::now() - task.queuedTime).count()));
+            m_pool.start([this, workClass, run = std::move(task.run)]() {
+                run();
+                finished(workClass);
+            });
+        }
+    }
+
+    if (0 == m_totalActive) {
+        m_idleCondition.wakeAll();
+    }
+}
+
+void WorkScheduler::finished(int workClass)
+{
+    QMutexLocker locker(&m_mutex);
+    m_active[workClass]--;
+    m_totalActive--;
+    dispatch();
+}
+
+/**
+ * @brief 丢弃全部未执行的任务，之后提交的任务同样丢弃
+ */
+void WorkScheduler::discardAll()
+{
+    std::deque<Task> discarded;
+    QMutexLocker locker(&m_mutex);
+    m_quitting = true;
+    for (std::deque<Task> &queue : m_queues) {
+        std::move(queue.begin(), queue.end(), std::back_inserter(discarded));
+        queue.clear();
+    }
+    m_idleCondition.wakeAll();
+    locker.unlock();
+
+    for (Task &task : discarded) {
+        if (task.discard) {
+            task.discard();
+        }
+    }
+}
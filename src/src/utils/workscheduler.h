@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef WORKSCHEDULER_H
+#define WORKSCHEDULER_H
+
+#include <QMutex>
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+
+class LatencyHistogram;
+
+/**
+ * @brief 任务取消标识，拷贝后共享同一状态
+ *      未启动的任务取消后不再执行，已启动的任务需自行检查 isCancelled()
+ */
+class WorkCancelToken
+{
+public:
+    WorkCancelToken()
+        : m_cancelled(std::make_shared<std::atomic_bool>(false))
+    {
+    }
+
+    void cancel() { m_cancelled->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return m_cancelled->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic_bool> m_cancelled;
+};
+
+/**
+ * @brief 统一的后台任务调度器，各图像加载器、导入导出、旋转及索引任务共用同一组工作线程
+ * @details 计算线程数即为整体的CPU预算，任务按优先级分类，每次有空闲线程时优先启动高优先级任务，
+ *      各类任务另有并发上限；始终为 Visible 任务保留一个计算线程，逻辑线程数较少(GlobalControl::enableMultiThread)
+ *      时其他任务仅使用一个线程，另为 Visible 任务保留一个线程。BulkIO 任务主要等待IO，使用独立的线程预算，
+ *      大量导入导出时不占用计算线程。
+ *      退出时丢弃未执行的任务，提交时修改了状态(运行标记、计数等)的任务需传入 discard 回调恢复状态。
+ */
+class WorkScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum WorkClass {
+        Visible = 0,    // 当前界面可见内容，如缩略图、大图加载
+        Prefetch,       // 即将显示的内容，如图片信息预读
+        Background,     // 后台索引，如感知哈希
+        BulkIO,         // 大量文件读写，如导入、导出、旋转
+        WorkClassCount
+    };
+
+    static WorkScheduler *instance();
+
+    // 执行 QRunnable 任务，执行后按 autoDelete() 释放；任务总会执行，取消需由任务自行处理
+    void start(WorkClass workClass, QRunnable *runnable);
+    // 执行函数任务，启动前 token 已取消或退出时丢弃，丢弃时调用 discard(可能在任意线程，其中不能再提交任务)
+    void submit(WorkClass workClass, std::function<void()> task, const WorkCancelToken &token = WorkCancelToken(),
+                std::function<void()> discard = nullptr);
+
+    // 并行执行 func(0) ~ func(count - 1) 并等待全部完成，调用线程同样参与执行；
+    // 同时执行的数量不超过 maxParallel(含调用线程，小于1时为该类任务的并发上限加1)，token 取消后未开始的项不再执行
+    void parallelFor(WorkClass workClass, int count, const std::function<void(int)> &func, int maxParallel = 0,
+                     const WorkCancelToken &token = WorkCancelToken());
+
+    // 等待全部任务完成，msecs 小于0时一直等待
+    bool waitForDone(int msecs = -1);
+
+    // 计算线程数，不包含 BulkIO 的独立线程
+    int workerCount() const { return m_workerCount; }
+    int concurrencyLimit(WorkClass workClass) const { return m_limits[workClass]; }
+    int pendingCount(WorkClass workClass);
+    int activeCount(WorkClass workClass);
+
+private:
+    explicit WorkScheduler(QObject *parent = nullptr);
+
+    struct Task {
+        std::function<void()> run;
+        std::function<void()> discard;    // 未执行即移除时调用
+        WorkCancelToken token;
+        std::chrono::steady_clock::time_point queuedTime;
+    };
+
+    void enqueue(WorkClass workClass, Task &&task);
+    bool canStart(int workClass) const;
+    void dispatch();
+    void finished(int workClass);
+    void discardAll();
+
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QWaitCondition m_idleCondition;
+    std::deque<Task> m_queues[WorkClassCount];
+    int m_active[WorkClassCount] = {};
+    int m_limits[WorkClassCount] = {};
+    int m_totalActive = 0;
+    int m_workerCount = 1;
+    int m_computeThreads = 2;           // 计算线程数，单线程时另有一个 Visible 专用线程
+    bool m_quitting = false;
+    LatencyHistogram *m_queueWait[WorkClassCount] = {};
+};
+
+#endif // WORKSCHEDULER_H
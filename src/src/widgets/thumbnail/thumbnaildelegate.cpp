@@ -7,7 +7,9 @@
 #include "unionimage/imageutils.h"
 #include "unionimage/baseutils.h"
 #include "dbmanager/dbmanager.h"
+#include "dbmanager/dbmanagerasync.h"
 #include "globalstatus.h"
+#include "utils/workscheduler.h"
 //#include "statusbar.h"
 //#include "application.h"
 #include <QDateTime>
@@ -23,6 +25,7 @@
 #include <QMouseEvent>
 #include <QImageReader>
 #include <QApplication>
+#include <QPointer>
 #include <DFontSizeManager>
 #include <DGuiApplicationHelper>
 #include <DStyleOptionButton>
@@ -44,12 +47,18 @@ const int CheckIcon_Size = 20;
 const int NotSupportedOrDamagedWidth = 40;      //损坏图片宽度
 const int NotSupportedOrDamagedHeigh = 40;
 const int FavoriteIconSize = 25;                //收藏图标尺寸
+const int PixmapCacheLimit = 128 * 1024;        //预处理缩略图缓存上限(KB)，默认10MB仅能容纳数张高分屏缩略图
 
 ThumbnailDelegate::ThumbnailDelegate(DelegateType type, QObject *parent)
     : QStyledItemDelegate(parent)
     , m_imageTypeStr(IMAGE_DEFAULTTYPE)
     , m_delegatetype(type)
 {
+    if (QPixmapCache::cacheLimit() < PixmapCacheLimit) {
+        QPixmapCache::setCacheLimit(PixmapCacheLimit);
+    }
+    connect(ImageDataService::instance(), &ImageDataService::gotImage, this, &ThumbnailDelegate::onGotImage, Qt::QueuedConnection);
+    connect(DGuiApplicationHelper::instance(), &DGuiApplicationHelper::themeTypeChanged, this, &ThumbnailDelegate::clearPixmapCache);
 }
 
 void ThumbnailDelegate::setItemSize(QSize size)
@@ -97,12 +106,26 @@ void ThumbnailDelegate::drawImgAndVideo(QPainter *painter, const QStyleOptionVie
     painter->setRenderHints(QPainter::SmoothPixmapTransform |
                             QPainter::Antialiasing);
     QRect backgroundRect = option.rect;
-    QImage img = ImageDataService::instance()->getThumnailImageByPathRealTime(data.filePath, COMMON_STR_TRASH == m_imageTypeStr);
-    if (img.isNull()) {
-        if (data.itemType == ItemTypeVideo) {
-            img = m_videoDefault.toImage();
-        } else {
-            img = m_damagePixmap.toImage();
+
+    // 命中预处理缓存时，无需再查询缩略图服务
+    QPixmap cachedPixmap;
+    QSize cachedImageSize;
+    const bool bCached = findCachedPixmap(data.filePath, option.rect.size(), cachedImageSize, cachedPixmap);
+
+    QImage img;
+    if (!bCached) {
+        img = ImageDataService::instance()->getThumnailImageByPathRealTime(data.filePath, COMMON_STR_TRASH == m_imageTypeStr);
+        // 缩略图按原比例存储，方图模式取裁切区域显示
+        const QRect displayRect = ImageDataService::instance()->thumbnailDisplayRect(img);
+        if (displayRect != img.rect()) {
+            img = img.copy(displayRect);
+        }
+        if (img.isNull()) {
+            if (data.itemType == ItemTypeVideo) {
+                img = m_videoDefault.toImage();
+            } else {
+                img = m_damagePixmap.toImage();
+            }
         }
     }
 
@@ -110,7 +133,7 @@ void ThumbnailDelegate::drawImgAndVideo(QPainter *painter, const QStyleOptionVie
     // painter->setPen(Qt::red);
     // painter->drawRect(backgroundRect);
     // painter->setPen(oldPen);
-    backgroundRect = updatePaintedRect(backgroundRect, img);
+    backgroundRect = updatePaintedRect(backgroundRect, bCached ? cachedImageSize : img.size());
 
     DGuiApplicationHelper::ColorType themeType = DGuiApplicationHelper::instance()->themeType();
     //选中阴影框
@@ -138,7 +161,11 @@ void ThumbnailDelegate::drawImgAndVideo(QPainter *painter, const QStyleOptionVie
     }
 
     QRect pixmapRect;
-    if (img.isNull()) {
+    if (bCached) {
+        // 缓存的缩略图已包含背景和圆角，直接贴图
+        pixmapRect = backgroundRect.adjusted(8, 8, -8, -8);
+        painter->drawPixmap(pixmapRect.topLeft(), cachedPixmap);
+    } else if (img.isNull()) {
         pixmapRect.setX(backgroundRect.x() + backgroundRect.width() / 2 - NotSupportedOrDamagedWidth / 2);
         pixmapRect.setY(backgroundRect.y() + backgroundRect.height() / 2 - NotSupportedOrDamagedHeigh / 2);
         pixmapRect.setWidth(NotSupportedOrDamagedWidth);
@@ -149,34 +176,38 @@ void ThumbnailDelegate::drawImgAndVideo(QPainter *painter, const QStyleOptionVie
         pixmapRect.setWidth(backgroundRect.width() - 16);
         pixmapRect.setHeight(backgroundRect.height() - 16);
     }
-    //2020/6/9 DJH UI 透明图片背景
-    QBrush transparentbrush;
-    if (themeType == DGuiApplicationHelper::LightType) {
-        transparentbrush = QBrush(QColor("#FFFFFF"));
-    } else if (themeType == DGuiApplicationHelper::DarkType) { //#BUG77517，去除下方的虚化代码，改为直接填充黑色
-        transparentbrush = QBrush(QColor("#000000"));
-    }
-    QRect transparentRect(backgroundRect.x() + 8, backgroundRect.y() + 8, backgroundRect.width() - 16, backgroundRect.height() - 16);
-    QPainterPath transparentBp;
-    transparentBp.addRoundedRect(transparentRect, Libutils::common::BORDER_RADIUS, Libutils::common::BORDER_RADIUS);
-    painter->setClipPath(transparentBp);
-    painter->fillRect(transparentRect, transparentbrush);
-
-    QPainterPath bp1;
-    bp1.addRoundedRect(pixmapRect, Libutils::common::BORDER_RADIUS, Libutils::common::BORDER_RADIUS);
-    painter->setClipPath(bp1);
-
-    if (!ImageDataService::instance()->imageIsLoaded(data.filePath, COMMON_STR_TRASH == m_imageTypeStr)) {
-        painter->drawPixmap(pixmapRect, m_default);
-    } else {
-        if (img.isNull()) {
-            if (data.itemType == ItemTypeVideo) {
-                painter->drawPixmap(pixmapRect, m_videoDefault);
+    if (!bCached) {
+        //2020/6/9 DJH UI 透明图片背景
+        QBrush transparentbrush;
+        if (themeType == DGuiApplicationHelper::LightType) {
+            transparentbrush = QBrush(QColor("#FFFFFF"));
+        } else if (themeType == DGuiApplicationHelper::DarkType) { //#BUG77517，去除下方的虚化代码，改为直接填充黑色
+            transparentbrush = QBrush(QColor("#000000"));
+        }
+        QRect transparentRect(backgroundRect.x() + 8, backgroundRect.y() + 8, backgroundRect.width() - 16, backgroundRect.height() - 16);
+        QPainterPath transparentBp;
+        transparentBp.addRoundedRect(transparentRect, Libutils::common::BORDER_RADIUS, Libutils::common::BORDER_RADIUS);
+        painter->setClipPath(transparentBp);
+        painter->fillRect(transparentRect, transparentbrush);
+
+        QPainterPath bp1;
+        bp1.addRoundedRect(pixmapRect, Libutils::common::BORDER_RADIUS, Libutils::common::BORDER_RADIUS);
+        painter->setClipPath(bp1);
+
+        if (!ImageDataService::instance()->imageIsLoaded(data.filePath, COMMON_STR_TRASH == m_imageTypeStr)) {
+            painter->drawPixmap(pixmapRect, m_default);
+        } else {
+            if (img.isNull()) {
+                if (data.itemType == ItemTypeVideo) {
+                    painter->drawPixmap(pixmapRect, m_videoDefault);
+                } else {
+                    painter->drawPixmap(pixmapRect, m_damagePixmap);
+                }
             } else {
-                painter->drawPixmap(pixmapRect, m_damagePixmap);
+                painter->drawPixmap(pixmapRect, QPixmap::fromImage(img));
+                // 本次仍直接绘制，同时在后台生成预处理缩略图，后续绘制直接使用
+                requestCachedPixmap(data.filePath, img, option.rect.size(), pixmapRect.size(), painter->device()->devicePixelRatioF());
             }
-        } else {
-            painter->drawPixmap(pixmapRect, QPixmap::fromImage(img));
         }
     }
 
@@ -309,6 +340,109 @@ void ThumbnailDelegate::onThemeTypeChanged(int themeType)
     }
 }
 
+/**
+ * @brief 接收缩略图加载完成信号，缩略图可能已被重新生成(如图片旋转、保存)，移除 \a path 对应的预处理缓存
+ */
+void ThumbnailDelegate::onGotImage(const QString &path)
+{
+    auto itr = m_pixmapItems.find(path);
+    if (itr != m_pixmapItems.end()) {
+        QPixmapCache::remove(itr->key);
+        m_pixmapItems.erase(itr);
+    }
+}
+
+/**
+ * @brief 查找 \a path 在 \a cellSize 单元格大小下预处理完成的缩略图
+ * @param imageSize 传出原缩略图大小，用于计算绘制区域
+ * @param pixmap    传出预处理完成的缩略图
+ * @return 是否命中缓存
+ */
+bool ThumbnailDelegate::findCachedPixmap(const QString &path, const QSize &cellSize, QSize &imageSize, QPixmap &pixmap) const
+{
+    auto itr = m_pixmapItems.find(path);
+    if (itr == m_pixmapItems.end()) {
+        return false;
+    }
+
+    if (itr->cellSize != cellSize || itr->loadMode != ImageDataService::instance()->getLoadMode()
+            || !QPixmapCache::find(itr->key, &pixmap)) {
+        // 单元格大小、加载模式变更或已被 QPixmapCache 淘汰
+        QPixmapCache::remove(itr->key);
+        m_pixmapItems.erase(itr);
+        return false;
+    }
+
+    imageSize = itr->imageSize;
+    return true;
+}
+
+/**
+ * @brief 在线程池中将缩略图 \a image 预先缩放到 \a targetSize 并处理背景及圆角，
+ *      完成后在主线程转换为 QPixmap 存入缓存，同一图片同时仅处理一次
+ */
+void ThumbnailDelegate::requestCachedPixmap(const QString &path, const QImage &image, const QSize &cellSize, const QSize &targetSize, qreal dpr) const
+{
+    if (targetSize.isEmpty() || m_pendingPixmaps.contains(path)) {
+        return;
+    }
+    m_pendingPixmaps.insert(path);
+
+    const int loadMode = ImageDataService::instance()->getLoadMode();
+    const DGuiApplicationHelper::ColorType themeType = DGuiApplicationHelper::instance()->themeType();
+    const QColor background = themeType == DGuiApplicationHelper::DarkType ? QColor("#000000") : QColor("#FFFFFF");
+    QPointer<ThumbnailDelegate> self(const_cast<ThumbnailDelegate *>(this));
+
+    WorkScheduler::instance()->submit(WorkScheduler::Visible, [self, path, image, cellSize, targetSize, dpr, loadMode, themeType, background]() {
+        QImage result(targetSize * dpr, QImage::Format_ARGB32_Premultiplied);
+        result.setDevicePixelRatio(dpr);
+        result.fill(Qt::transparent);
+
+        QPainter painter(&result);
+        painter.setRenderHints(QPainter::SmoothPixmapTransform | QPainter::Antialiasing);
+        QRect rect(QPoint(0, 0), targetSize);
+        QPainterPath bp;
+        bp.addRoundedRect(rect, Libutils::common::BORDER_RADIUS, Libutils::common::BORDER_RADIUS);
+        painter.setClipPath(bp);
+        painter.fillRect(rect, background);
+        painter.drawImage(rect, image);
+        painter.end();
+
+        QMetaObject::invokeMethod(qApp, [self, path, result, cellSize, imageSize = image.size(), loadMode, themeType]() {
+            if (!self) {
+                return;
+            }
+            self->m_pendingPixmaps.remove(path);
+            // 生成期间加载模式或主题已切换，丢弃结果
+            if (loadMode != ImageDataService::instance()->getLoadMode()
+                    || themeType != DGuiApplicationHelper::instance()->themeType()) {
+                return;
+            }
+
+            auto itr = self->m_pixmapItems.find(path);
+            if (itr != self->m_pixmapItems.end()) {
+                QPixmapCache::remove(itr->key);
+            }
+            PixmapCacheItem item;
+            item.cellSize = cellSize;
+            item.imageSize = imageSize;
+            item.loadMode = loadMode;
+            item.key = QPixmapCache::insert(QPixmap::fromImage(result));
+            self->m_pixmapItems.insert(path, item);
+
+            emit self->sigThumbnailPixmapReady();
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ThumbnailDelegate::clearPixmapCache()
+{
+    for (auto itr = m_pixmapItems.begin(); itr != m_pixmapItems.end(); ++itr) {
+        QPixmapCache::remove(itr->key);
+    }
+    m_pixmapItems.clear();
+}
+
 QSize ThumbnailDelegate::sizeHint(const QStyleOptionViewItem &option,
                                   const QModelIndex &index) const
 {
@@ -331,11 +465,11 @@ DBImgInfo ThumbnailDelegate::itemData(const QModelIndex &index) const
     return data;
 }
 
-QRect ThumbnailDelegate::updatePaintedRect(const QRectF &boundingRect, const QImage& image) const
+QRect ThumbnailDelegate::updatePaintedRect(const QRectF &boundingRect, const QSize &imageSize) const
 {
     QRectF destRect;
 
-    QSizeF scaled = image.size();
+    QSizeF scaled = imageSize;
 
     QSizeF size = boundingRect.size();
     scaled.scale(boundingRect.size(), Qt::KeepAspectRatio);
@@ -365,15 +499,15 @@ bool ThumbnailDelegate::editorEvent(QEvent *event, QAbstractItemModel *model, co
                     img = m_damagePixmap.toImage();
                 }
             }
-            QRect favoriteRect = updatePaintedRect(backgroundRect, img);
+            QRect favoriteRect = updatePaintedRect(backgroundRect, ImageDataService::instance()->thumbnailDisplayRect(img).size());
             favoriteRect.moveTo(favoriteRect.x() + 10, favoriteRect.bottom() - FavoriteIconSize - 10);
             favoriteRect.setSize(QSize(FavoriteIconSize, FavoriteIconSize));
             if (favoriteRect.contains(pos)) {
                 bool bFavorited = DBManager::instance()->isAllImgExistInAlbum(DBManager::SpUID::u_Favorite, QStringList(data.filePath), AlbumDBType::Favourite);
                 if (bFavorited)
-                    DBManager::instance()->removeFromAlbum(DBManager::SpUID::u_Favorite, QStringList() << data.filePath, AlbumDBType::Favourite);
+                    DBManagerAsync::instance()->call([&](DBManager *db) { return db->removeFromAlbum(DBManager::SpUID::u_Favorite, QStringList() << data.filePath, AlbumDBType::Favourite); });
                 else
-                    DBManager::instance()->insertIntoAlbum(DBManager::SpUID::u_Favorite, QStringList() << data.filePath, AlbumDBType::Favourite);
+                    DBManagerAsync::instance()->call([&](DBManager *db) { return db->insertIntoAlbum(DBManager::SpUID::u_Favorite, QStringList() << data.filePath, AlbumDBType::Favourite); });
                 GlobalStatus::instance()->setBRefreshFavoriteIconFlag(!GlobalStatus::instance()->bRefreshFavoriteIconFlag());
             }
         }
@@ -8,6 +8,9 @@
 #include <QObject>
 #include <QDateTime>
 #include <QStyledItemDelegate>
+#include <QPixmapCache>
+#include <QHash>
+#include <QSet>
 #include <QDebug>
 
 #include "unionimage/unionimage_global.h"
@@ -42,6 +45,8 @@ public:
     void drawImgAndVideo(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const;
 private slots:
     void onThemeTypeChanged(int themeType);
+    // 缩略图重新加载后，移除对应的预处理缓存
+    void onGotImage(const QString &path);
 
 protected:
     void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const Q_DECL_OVERRIDE;
@@ -56,11 +61,18 @@ protected:
 
 signals:
     void sigCancelFavorite(const QModelIndex &index);
+    // 预处理缩略图生成完成，通知视图刷新
+    void sigThumbnailPixmapReady();
 //    void sigPageNeedResize(const int &index) const;
 
 private:
     DBImgInfo itemData(const QModelIndex &index) const;
-    QRect updatePaintedRect(const QRectF &boundingRect, const QImage& image) const;
+    QRect updatePaintedRect(const QRectF &boundingRect, const QSize &imageSize) const;
+
+    // 预处理(缩放+圆角)后的缩略图缓存，绘制时只需一次贴图
+    bool findCachedPixmap(const QString &path, const QSize &cellSize, QSize &imageSize, QPixmap &pixmap) const;
+    void requestCachedPixmap(const QString &path, const QImage &image, const QSize &cellSize, const QSize &targetSize, qreal dpr) const;
+    void clearPixmapCache();
 public:
     QString m_imageTypeStr;
 
@@ -76,6 +88,15 @@ private:
     QPixmap m_default;//图片默认图片
     QPixmap m_videoDefault;//视频默认图片
     QPixmap m_damagePixmap;
+
+    struct PixmapCacheItem {
+        QSize cellSize;         // 单元格大小
+        QSize imageSize;        // 原缩略图大小，用于计算绘制区域
+        int loadMode;           // 缩略图加载模式(方图/原始比例)
+        QPixmapCache::Key key;  // 全局 QPixmapCache 索引
+    };
+    mutable QHash<QString, PixmapCacheItem> m_pixmapItems;
+    mutable QSet<QString> m_pendingPixmaps;     // 正在后台预处理的缩略图
 };
 
 #endif // ALBUMDELEGATE_H
@@ -33,6 +33,7 @@
 //#include "ac-desktop-define.h"
 //#include "allpicview/allpicview.h"
 #include "imageengine/imagedataservice.h"
+#include "dbmanager/dbmanagerasync.h"
 //#include "batchoperatewidget.h"
 
 namespace {
@@ -285,6 +286,39 @@ void ThumbnailListView::wheelEvent(QWheelEvent *event)
     DListView::wheelEvent(event);
 }
 
+/**
+ * @brief 绘制列表，设置环境变量 DEEPIN_ALBUM_PAINT_PROFILE 后，
+ *      每绘制 100 帧输出一次平均/最大单帧绘制耗时，用于评估缩略图绘制性能
+ */
+void ThumbnailListView::paintEvent(QPaintEvent *event)
+{
+    static const bool s_profile = qEnvironmentVariableIsSet("DEEPIN_ALBUM_PAINT_PROFILE");
+    if (!s_profile) {
+        DListView::paintEvent(event);
+        return;
+    }
+
+    static int s_frameCount = 0;
+    static qint64 s_totalNsecs = 0;
+    static qint64 s_maxNsecs = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    DListView::paintEvent(event);
+    qint64 elapsed = timer.nsecsElapsed();
+
+    s_frameCount++;
+    s_totalNsecs += elapsed;
+    s_maxNsecs = qMax(s_maxNsecs, elapsed);
+    if (s_frameCount >= 100) {
+        qDebug() << "ThumbnailListView paint time per frame(ms), avg:" << s_totalNsecs / s_frameCount / 1e6
+                 << "max:" << s_maxNsecs / 1e6;
+        s_frameCount = 0;
+        s_totalNsecs = 0;
+        s_maxNsecs = 0;
+    }
+}
+
 QRect ThumbnailListView::visualRect(const QModelIndex &index) const
 {
     //获取当前视图中的item项,找到视图中的index,注意：获取到的index可能不是最大值,但已经足够了
@@ -444,6 +478,7 @@ void ThumbnailListView::initConnections()
     //connect(GlobalStatus::instance(), &GlobalStatus::thumbnailSizeLevelChanged, this, &ThumbnailListView::onThumbnailSizeLevelChanged);
     connect(GlobalStatus::instance(), &GlobalStatus::cellBaseWidthChanged, this, &ThumbnailListView::onCellBaseWidthChanged);
     connect(m_delegate, &ThumbnailDelegate::sigCancelFavorite, this, &ThumbnailListView::onCancelFavorite);
+    connect(m_delegate, &ThumbnailDelegate::sigThumbnailPixmapReady, viewport(), QOverload<>::of(&QWidget::update));
 
     //connect(ImageEngineApi::instance(), &ImageEngineApi::sigOneImgReady, this, &ThumbnailListView::slotOneImgReady);
     //connect(ImageEngineApi::instance(), &ImageEngineApi::sigReloadAfterFilterEnd, this, &ThumbnailListView::sltReloadAfterFilterEnd);
@@ -1137,7 +1172,7 @@ void ThumbnailListView::onCancelFavorite(const QModelIndex &index)
     DBImgInfo info = index.data(Qt::DisplayRole).value<DBImgInfo>();
     str << info.filePath;
     //通知其它界面更新取消收藏
-    DBManager::instance()->removeFromAlbum(DBManager::SpUID::u_Favorite, str, AlbumDBType::Favourite);
+    DBManagerAsync::instance()->call([&](DBManager *db) { return db->removeFromAlbum(DBManager::SpUID::u_Favorite, str, AlbumDBType::Favourite); });
 }
 
 void ThumbnailListView::resizeEvent(QResizeEvent *e)
@@ -158,6 +158,7 @@ protected:
     void showEvent(QShowEvent *event) Q_DECL_OVERRIDE;
     void hideEvent(QHideEvent *event) Q_DECL_OVERRIDE;
     void wheelEvent(QWheelEvent *event) Q_DECL_OVERRIDE;
+    void paintEvent(QPaintEvent *event) Q_DECL_OVERRIDE;
     //重写该函数是为了获取当前视图中最大的model index，该函数和paint同步
     QRect visualRect(const QModelIndex &index) const override;
 
@@ -0,0 +1,107 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "dbmanager/dbmanager.h"
+#include "unionimage/unionimage.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QUrl>
+
+namespace {
+const int ROW_COUNT = 200000;
+// 相册中的图片为每 ALBUM_INTERVAL 行一张
+const int ALBUM_INTERVAL = 10;
+// 合成数据中最近的拍摄日期
+const QString BENCH_DAY = "2024-01-01";
+
+int s_albumUID = -1;
+
+// 200k 行的图片表及包含其中 1/ALBUM_INTERVAL 的相册
+int ensureAlbum()
+{
+    BenchFixtures::ensureImageRows(ROW_COUNT);
+    if (s_albumUID < 0) {
+        const QStringList allPaths = DBManager::instance()->getAllPaths();
+        QStringList paths;
+        for (int i = 0; i < allPaths.size(); i += ALBUM_INTERVAL) {
+            paths << allPaths.at(i);
+        }
+        s_albumUID = DBManager::instance()->createAlbum("bench-aggregate", paths);
+    }
+    return s_albumUID;
+}
+
+const char *methodLabel(int method)
+{
+    return 0 == method ? "list_then_count" : "sql_count";
+}
+}
+
+/**
+ * @brief 相册中图片的数量。range(0): 0 取出相册全部数据后逐个判断类型(原有方式)，1 COUNT 查询
+ */
+static void BM_Aggregate_AlbumCount(benchmark::State &state)
+{
+    const int method = static_cast<int>(state.range(0));
+    const int UID = ensureAlbum();
+    for (auto _ : state) {
+        if (0 == method) {
+            int count = 0;
+            for (const DBImgInfo &info : DBManager::instance()->getInfosByAlbum(UID, false)) {
+                if (info.itemType != ItemTypeVideo) {
+                    ++count;
+                }
+            }
+            benchmark::DoNotOptimize(count);
+        } else {
+            benchmark::DoNotOptimize(DBManager::instance()->getItemsCountByAlbum(UID, ItemTypePic));
+        }
+    }
+    state.SetLabel(methodLabel(method));
+}
+BENCHMARK(BM_Aggregate_AlbumCount)->DenseRange(0, 1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+ * @brief 某一天图片的数量。range(0): 0 取出当天路径后逐个按文件判断类型(原有方式)，1 COUNT 查询
+ */
+static void BM_Aggregate_DayCount(benchmark::State &state)
+{
+    const int method = static_cast<int>(state.range(0));
+    BenchFixtures::ensureImageRows(ROW_COUNT);
+    for (auto _ : state) {
+        if (0 == method) {
+            int count = 0;
+            for (const QString &path : DBManager::instance()->getDayPaths(BENCH_DAY)) {
+                if (LibUnionImage_NameSpace::isImage(QUrl(path).toLocalFile())) {
+                    ++count;
+                }
+            }
+            benchmark::DoNotOptimize(count);
+        } else {
+            benchmark::DoNotOptimize(DBManager::instance()->getDayCount(BENCH_DAY, ItemTypePic));
+        }
+    }
+    state.SetLabel(methodLabel(method));
+}
+BENCHMARK(BM_Aggregate_DayCount)->DenseRange(0, 1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+ * @brief 全部视频的数量。range(0): 0 取出全部视频路径后计数，1 按类型索引 COUNT
+ */
+static void BM_Aggregate_TypeCount(benchmark::State &state)
+{
+    const int method = static_cast<int>(state.range(0));
+    BenchFixtures::ensureImageRows(ROW_COUNT);
+    for (auto _ : state) {
+        if (0 == method) {
+            benchmark::DoNotOptimize(DBManager::instance()->getAllPaths(ItemTypeVideo).size());
+        } else {
+            benchmark::DoNotOptimize(DBManager::instance()->getImgsCount(ItemTypeVideo));
+        }
+    }
+    state.SetLabel(methodLabel(method));
+}
+BENCHMARK(BM_Aggregate_TypeCount)->DenseRange(0, 1)->Unit(benchmark::kMillisecond)->UseRealTime();
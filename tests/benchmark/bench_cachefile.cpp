@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "imageengine/imagedataservice.h"
+#include "utils/cachefile.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QBuffer>
+#include <QFile>
+
+namespace {
+const QSize THUMBNAIL_SIZE(256, 341);
+const int WRITE_COUNT = 64;
+
+// 编码后的缩略图，内容由 seed 决定
+QByteArray thumbnailData(int seed)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    BenchFixtures::syntheticImage(seed, THUMBNAIL_SIZE).save(&buffer, "PNG");
+    return data;
+}
+
+QString policyName(int policy)
+{
+    switch (policy) {
+    case CacheFile::NoSync:
+        return "atomic_nosync";
+    case CacheFile::SyncData:
+        return "atomic_fdatasync";
+    case CacheFile::SyncFull:
+        return "atomic_fsync_dir";
+    default:
+        return "direct";
+    }
+}
+}
+
+/**
+ * @brief 不同落盘方式的写入吞吐量，range(0) 为 CacheFile::SyncPolicy ，3 为原有的直接写入目标文件
+ */
+static void BM_CacheFile_Write(benchmark::State &state)
+{
+    const int policy = static_cast<int>(state.range(0));
+    const QString dir = BenchFixtures::dataDir("cachefile_write");
+    QVector<QByteArray> payloads;
+    for (int i = 0; i < WRITE_COUNT; ++i) {
+        payloads << CacheFile::addHeader(thumbnailData(i));
+    }
+
+    qint64 bytes = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < WRITE_COUNT; ++i) {
+            const QString path = dir + QString("/%1.png").arg(i);
+            if (policy > CacheFile::SyncFull) {
+                QFile file(path);
+                if (file.open(QIODevice::WriteOnly)) {
+                    file.write(payloads.at(i));
+                }
+            } else {
+                CacheFile::writeAtomic(path, payloads.at(i), static_cast<CacheFile::SyncPolicy>(policy));
+            }
+            bytes += payloads.at(i).size();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * WRITE_COUNT);
+    state.SetBytesProcessed(bytes);
+    state.SetLabel(policyName(policy).toStdString());
+}
+BENCHMARK(BM_CacheFile_Write)->DenseRange(0, 3)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+ * @brief 读取缩略图的耗时，range(0) 为 1 时校验文件头，为 0 时为不带文件头的旧文件
+ */
+static void BM_CacheFile_Read(benchmark::State &state)
+{
+    const bool checked = state.range(0);
+    const QString path = BenchFixtures::dataDir("cachefile_read") + (checked ? "/checked.png" : "/plain.png");
+    const QByteArray data = thumbnailData(0);
+    CacheFile::writeAtomic(path, checked ? CacheFile::addHeader(data) : data, CacheFile::NoSync);
+
+    for (auto _ : state) {
+        QImage image;
+        benchmark::DoNotOptimize(ImageDataService::loadThumbnailFile(path, image));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(checked ? "checked" : "plain");
+}
+BENCHMARK(BM_CacheFile_Read)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
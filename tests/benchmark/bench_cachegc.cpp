@@ -0,0 +1,119 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "imageengine/imagedataservice.h"
+#include "imageengine/thumbnailcachegc.h"
+#include "imageengine/thumbnailpregenerator.h"
+#include "unionimage/baseutils.h"
+#include "unionimage/unionimage_global.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+
+namespace {
+const QSize PHOTO_SIZE(1600, 1200);
+// 旧版本遗留的缩略图数量
+const int LEGACY_COUNT = 20000;
+// 每个时间片的耗时上限，与应用中一致
+const int SLICE_MSECS = 20;
+
+// 遗留的旧版本缩略图(不带级别)，内容不影响清理
+void writeLegacyThumbnails(const QString &dir, int count)
+{
+    QDir().mkpath(dir);
+    for (int i = 0; i < count; ++i) {
+        const QString name = QCryptographicHash::hash("legacy" + QByteArray::number(i), QCryptographicHash::Md5).toHex();
+        QFile file(dir + "/" + name + ".png");
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(QByteArray(256, '\0'));
+        }
+    }
+}
+
+// 有效图片全部级别缩略图的大小
+qint64 liveBytes(const QStringList &levelPaths)
+{
+    qint64 bytes = 0;
+    for (const QString &path : levelPaths) {
+        bytes += QFileInfo(path).size();
+    }
+    return bytes;
+}
+
+// 按需加载时判断缩略图是否存在的平均耗时(微秒)
+double lookupMicros(const QStringList &levelPaths)
+{
+    QElapsedTimer timer;
+    timer.start();
+    int found = 0;
+    for (const QString &path : levelPaths) {
+        found += QFileInfo::exists(path) ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(found);
+    return levelPaths.isEmpty() ? 0 : timer.nsecsElapsed() / 1000.0 / levelPaths.size();
+}
+}
+
+/**
+ * @brief 图片库变动后的缓存清理，range(0) 为有效图片数量，另有同样数量的图片已从图片库删除，
+ *      并遗留 LEGACY_COUNT 个旧版本缩略图；空间预算为有效缩略图的一半，以触发淘汰。
+ *      slices 为清理所需的时间片数量，cache_mb_before/after 为清理前后的缓存大小，
+ *      lookup_us_before/after 为清理前后查找单个缩略图的平均耗时
+ */
+static void BM_ThumbnailCacheGC_AfterChurn(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    const QStringList livePaths = BenchFixtures::imageSet("cachegc_live", count, PHOTO_SIZE);
+    const QStringList removedPaths = BenchFixtures::imageSet("cachegc_removed", count, PHOTO_SIZE);
+    const QString cacheRoot = albumGlobal::CACHE_PATH;
+    const QString legacyDir = cacheRoot + QFileInfo(livePaths.first()).path();
+
+    QStringList levelPaths;
+    for (const QString &path : livePaths) {
+        const QString thumbnailPath = Libutils::base::filePathToThumbnailPath(path);
+        for (int level : ImageDataService::thumbnailLevels()) {
+            levelPaths << ImageDataService::getLevelPath(thumbnailPath, level);
+        }
+    }
+
+    ThumbnailCacheGC *gc = ThumbnailCacheGC::instance();
+    int slices = 0;
+    double lookupBefore = 0;
+    double lookupAfter = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        ThumbnailPregenerator::instance()->generate(livePaths);
+        ThumbnailPregenerator::instance()->generate(removedPaths);
+        writeLegacyThumbnails(legacyDir, LEGACY_COUNT);
+        const qint64 budget = liveBytes(levelPaths) / 2;
+        lookupBefore = lookupMicros(levelPaths);
+        state.ResumeTiming();
+
+        gc->begin(livePaths, cacheRoot, budget);
+        for (slices = 1; !gc->step(SLICE_MSECS); ++slices) {
+        }
+
+        state.PauseTiming();
+        lookupAfter = lookupMicros(levelPaths);
+        state.ResumeTiming();
+    }
+
+    const ThumbnailCacheGC::Stats stats = gc->stats();
+    state.SetItemsProcessed(state.iterations() * stats.scannedFiles);
+    state.counters["slices"] = slices;
+    state.counters["orphans"] = stats.removedOrphans;
+    state.counters["legacy"] = stats.removedLegacy;
+    state.counters["evicted"] = stats.evictedFiles;
+    state.counters["cache_mb_before"] = stats.bytesBefore / 1024.0 / 1024.0;
+    state.counters["cache_mb_after"] = stats.bytesAfter / 1024.0 / 1024.0;
+    state.counters["lookup_us_before"] = lookupBefore;
+    state.counters["lookup_us_after"] = lookupAfter;
+}
+BENCHMARK(BM_ThumbnailCacheGC_AfterChurn)->Arg(64)->Iterations(3)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "dbmanager/dbmanager.h"
+#include "imageengine/collectioncovercache.h"
+#include "imageengine/thumbnailpregenerator.h"
+#include "unionimage/unionimage.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QDir>
+#include <QElapsedTimer>
+
+namespace {
+const QSize PHOTO_SIZE(4000, 3000);
+const QSize COVER_SIZE(1000, 618);
+// 图片库跨越的年数及每年的图片数量
+const int YEAR_COUNT = 20;
+const int PER_YEAR = 4;
+const int FIRST_YEAR = 2005;
+// 首屏可见的年视图卡片数量
+const int FIRST_FRAME_CARDS = 3;
+// 用于使某一年内容变化的额外图片
+const QString EXTRA_PATH = "/bench/collection/extra.jpg";
+
+QStringList s_years;
+
+// 图片库：每年 PER_YEAR 张，已生成缩略图
+void ensureLibrary()
+{
+    if (!s_years.isEmpty()) {
+        return;
+    }
+
+    const QStringList paths = BenchFixtures::imageSet("collection", YEAR_COUNT * PER_YEAR, PHOTO_SIZE);
+    DBImgInfoList infos;
+    for (int i = 0; i < paths.size(); ++i) {
+        DBImgInfo info;
+        info.filePath = paths.at(i);
+        info.itemType = ItemTypePic;
+        info.time = QDateTime(QDate(FIRST_YEAR + i / PER_YEAR, 6, 1 + i % PER_YEAR), QTime(12, 0));
+        info.changeTime = info.time;
+        info.importTime = QDateTime::currentDateTime();
+        infos << info;
+    }
+    DBManager::instance()->insertImgInfos(infos);
+    ThumbnailPregenerator::instance()->generate(paths);
+
+    for (int i = YEAR_COUNT - 1; i >= 0; --i) {
+        s_years << QString::number(FIRST_YEAR + i);
+    }
+}
+
+// 原有方式：每次解码该年第一张图片的原图
+QImage decodeYearImage(const QString &year)
+{
+    const QStringList paths = DBManager::instance()->getYearPaths(year, 1);
+    if (paths.isEmpty()) {
+        return QImage();
+    }
+    QImage image;
+    QString error;
+    LibUnionImage_NameSpace::loadStaticImageFromFile(paths.first(), image, error);
+    return image.scaled(COVER_SIZE, Qt::KeepAspectRatioByExpanding);
+}
+
+// 使第一年的图片有增删，封面版本变化
+void toggleExtraRow()
+{
+    static bool s_inserted = false;
+    if (s_inserted) {
+        DBManager::instance()->removeImgInfosNoSignal({EXTRA_PATH});
+    } else {
+        DBImgInfo info;
+        info.filePath = EXTRA_PATH;
+        info.itemType = ItemTypePic;
+        info.time = QDateTime(QDate(FIRST_YEAR + YEAR_COUNT - 1, 12, 1), QTime(12, 0));
+        info.changeTime = info.time;
+        info.importTime = QDateTime::currentDateTime();
+        DBManager::instance()->insertImgInfos({info});
+    }
+    s_inserted = !s_inserted;
+}
+}
+
+/**
+ * @brief 年视图首帧时间：依次获取全部年份的封面，ttff_ms 为首屏 FIRST_FRAME_CARDS 张卡片的耗时，
+ *      pass_ms 为滚动浏览全部年份一遍的耗时。
+ *      range(0): 0 每次解码原图(原有方式)，1 无缓存时合成封面，2 读取缓存的封面，3 仅一年内容变化
+ */
+static void BM_CollectionCover_YearView(benchmark::State &state)
+{
+    const int method = static_cast<int>(state.range(0));
+    ensureLibrary();
+
+    QElapsedTimer timer;
+    qint64 firstFrameNs = 0;
+    qint64 passNs = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        if (1 == method) {
+            QDir(CollectionCoverCache::cacheDir()).removeRecursively();
+        } else if (3 == method) {
+            toggleExtraRow();
+        }
+        state.ResumeTiming();
+
+        timer.start();
+        for (int i = 0; i < s_years.size(); ++i) {
+            if (0 == method) {
+                benchmark::DoNotOptimize(decodeYearImage(s_years.at(i)));
+            } else {
+                benchmark::DoNotOptimize(CollectionCoverCache::yearCover(s_years.at(i), COVER_SIZE));
+            }
+            if (FIRST_FRAME_CARDS - 1 == i) {
+                firstFrameNs += timer.nsecsElapsed();
+            }
+        }
+        passNs += timer.nsecsElapsed();
+    }
+    state.SetItemsProcessed(state.iterations() * s_years.size());
+
+    static const char *const labels[] = {"decode_original", "cold_cache", "warm_cache", "one_year_changed"};
+    state.SetLabel(labels[method]);
+    state.counters["ttff_ms"] = firstFrameNs / 1e6 / state.iterations();
+    state.counters["pass_ms"] = passNs / 1e6 / state.iterations();
+}
+BENCHMARK(BM_CollectionCover_YearView)->DenseRange(0, 3)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "albumControl.h"
+#include "imageengine/imageenginethread.h"
+#include "unionimage/baseutils.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QEvent>
+#include <QFile>
+#include <QFileInfo>
+#include <QThreadPool>
+
+// 测试数据位于 BenchFixtures 的临时目录下，TMPDIR 指向 tmpfs 或 ext4 时分别测试对应的文件系统
+namespace {
+QString sizedDataFile(qint64 size)
+{
+    return BenchFixtures::dataFile(QString("data_%1.bin").arg(size), size);
+}
+}
+
+// 单文件拷贝: 0 QFile::copy，1 copyFileFast
+static void BM_Export_CopyFile(benchmark::State &state)
+{
+    const QString src = sizedDataFile(64 * 1024 * 1024);
+    const QString dst = BenchFixtures::dataDir("copy") + "/copy.bin";
+    const bool fast = state.range(0) != 0;
+
+    for (auto _ : state) {
+        QFile::remove(dst);
+        bool ret = fast ? Libutils::base::copyFileFast(src, dst) : QFile::copy(src, dst);
+        if (!ret) {
+            state.SkipWithError("copy failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * 64LL * 1024 * 1024);
+    state.SetLabel(fast ? "copyFileFast" : "QFile::copy");
+}
+BENCHMARK(BM_Export_CopyFile)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 导出线程整体耗时，每轮导出到新目录
+static void BM_Export_ExportFilesThread(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    const QStringList paths = BenchFixtures::imageSet("export-src", count, QSize(1600, 1200));
+    const QString targetDir = BenchFixtures::rootDir() + "/export-dst";
+    AlbumControl::instance();
+
+    qint64 totalBytes = 0;
+    for (const QString &path : paths) {
+        totalBytes += QFileInfo(path).size();
+    }
+
+    QThreadPool pool;
+    for (auto _ : state) {
+        state.PauseTiming();
+        QDir(targetDir).removeRecursively();
+        state.ResumeTiming();
+
+        ExportFilesThread *exportThread = new ExportFilesThread;
+        exportThread->setData(paths, targetDir);
+        pool.start(exportThread);
+        pool.waitForDone();
+
+        state.PauseTiming();
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+        state.ResumeTiming();
+    }
+    state.SetBytesProcessed(state.iterations() * totalBytes);
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_Export_ExportFilesThread)->Arg(200)->Unit(benchmark::kMillisecond)->UseRealTime();
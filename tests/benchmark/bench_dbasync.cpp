@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "dbmanager/dbmanager.h"
+#include "dbmanager/dbmanagerasync.h"
+#include "utils/metrics.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+namespace {
+const int IMPORT_FILE_COUNT = 50000;
+const int IMPORT_CHUNK_SIZE = 100;
+const int REFRESH_INTERVAL = 10;     // 每导入若干批刷新一次界面计数
+const int IMPORT_ALBUM_UID = 4;
+
+DBImgInfoList makeImportRows(int begin, int count)
+{
+    DBImgInfoList infos;
+    QDateTime now = QDateTime::currentDateTime();
+    for (int i = begin; i < begin + count; ++i) {
+        DBImgInfo info;
+        info.filePath = QString("/bench/async/%1/img_%2.jpg").arg(i / 1000).arg(i);
+        info.time = now.addSecs(-60LL * i);
+        info.changeTime = info.time;
+        info.importTime = now;
+        info.itemType = ItemTypePic;
+        infos << info;
+    }
+    return infos;
+}
+
+QStringList pathsOf(const DBImgInfoList &infos)
+{
+    QStringList paths;
+    for (const DBImgInfo &info : infos) {
+        paths << info.filePath;
+    }
+    return paths;
+}
+}
+
+/**
+ * @brief 导入 5 万个文件时界面线程的阻塞时间，导入结果按每批100个文件交给界面线程写入数据库，
+ *      期间定时读取图片数量刷新界面。统计每批写入及读取在界面线程上的阻塞时长。
+ *      0 直接调用 DBManager ，1 通过 DBManagerAsync 提交
+ */
+static void BM_DBAsync_ImportStall(benchmark::State &state)
+{
+    const bool async = state.range(0) != 0;
+    QList<DBImgInfoList> chunks;
+    QStringList allPaths;
+    for (int begin = 0; begin < IMPORT_FILE_COUNT; begin += IMPORT_CHUNK_SIZE) {
+        chunks << makeImportRows(begin, IMPORT_CHUNK_SIZE);
+        allPaths += pathsOf(chunks.last());
+    }
+
+    LatencyHistogram stall;
+    double totalStallMs = 0;
+    for (auto _ : state) {
+        int chunkIndex = 0;
+        for (const DBImgInfoList &chunk : chunks) {
+            QStringList paths = pathsOf(chunk);
+            auto start = std::chrono::steady_clock::now();
+            if (async) {
+                DBManagerAsync::instance()->insertImgInfos(chunk);
+                DBManagerAsync::instance()->insertIntoAlbum(IMPORT_ALBUM_UID, paths, AlbumDBType::AutoImport);
+                if (0 == ++chunkIndex % REFRESH_INTERVAL) {
+                    DBManagerAsync::instance()->run([](DBManager *db) {
+                        return db->getImgsCount(ItemTypePic);
+                    });
+                }
+            } else {
+                DBManager::instance()->insertImgInfos(chunk);
+                DBManager::instance()->insertIntoAlbum(IMPORT_ALBUM_UID, paths, AlbumDBType::AutoImport);
+                if (0 == ++chunkIndex % REFRESH_INTERVAL) {
+                    benchmark::DoNotOptimize(DBManager::instance()->getImgsCount(ItemTypePic));
+                }
+            }
+            auto blocked = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            stall.record(static_cast<quint64>(blocked));
+            totalStallMs += blocked / 1000.0;
+        }
+
+        // 写入完成的时间计入总耗时，但不属于界面线程的阻塞
+        if (async) {
+            DBManagerAsync::instance()->waitForDone();
+        }
+
+        state.PauseTiming();
+        DBManager::instance()->removeFromAlbum(IMPORT_ALBUM_UID, allPaths, AlbumDBType::AutoImport);
+        DBManager::instance()->removeImgInfosNoSignal(allPaths);
+        state.ResumeTiming();
+    }
+
+    state.counters["stall_total_ms"] = totalStallMs / static_cast<double>(state.iterations());
+    state.counters["stall_p99_us"] = static_cast<double>(stall.percentile(99));
+    state.counters["stall_max_us"] = static_cast<double>(stall.max());
+    state.SetItemsProcessed(state.iterations() * IMPORT_FILE_COUNT);
+    state.SetLabel(async ? "DBManagerAsync" : "DBManager");
+}
+BENCHMARK(BM_DBAsync_ImportStall)->Arg(0)->Arg(1)->Iterations(3)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "albumControl.h"
+#include "dbmanager/dbmanager.h"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+DBImgInfoList makeInsertRows(int count)
+{
+    DBImgInfoList infos;
+    QDateTime now = QDateTime::currentDateTime();
+    for (int i = 0; i < count; ++i) {
+        DBImgInfo info;
+        info.filePath = QString("/bench/insert/%1/img_%2.jpg").arg(i / 1000).arg(i);
+        info.time = now.addSecs(-3600LL * i);
+        info.changeTime = info.time;
+        info.importTime = now;
+        infos << info;
+    }
+    return infos;
+}
+
+void applyRowCounts(benchmark::internal::Benchmark *bench)
+{
+    bench->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+}
+
+// 批量插入，每轮结束后删除插入的数据，不计入耗时
+static void BM_DBManager_InsertImgInfos(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    const DBImgInfoList infos = makeInsertRows(count);
+    QStringList paths;
+    for (const DBImgInfo &info : infos) {
+        paths << info.filePath;
+    }
+
+    for (auto _ : state) {
+        DBManager::instance()->insertImgInfos(infos);
+
+        state.PauseTiming();
+        DBManager::instance()->removeImgInfosNoSignal(paths);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_DBManager_InsertImgInfos)->Apply(applyRowCounts);
+
+static void BM_DBManager_GetAllPaths(benchmark::State &state)
+{
+    BenchFixtures::ensureImageRows(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(DBManager::instance()->getAllPaths());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DBManager_GetAllPaths)->Apply(applyRowCounts);
+
+static void BM_DBManager_GetAllInfosSort(benchmark::State &state)
+{
+    BenchFixtures::ensureImageRows(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(DBManager::instance()->getAllInfosSort());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DBManager_GetAllInfosSort)->Apply(applyRowCounts);
+
+static void BM_DBManager_GetImgsCount(benchmark::State &state)
+{
+    BenchFixtures::ensureImageRows(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(DBManager::instance()->getImgsCount(ItemTypePic));
+    }
+}
+BENCHMARK(BM_DBManager_GetImgsCount)->Apply(applyRowCounts);
+
+static void BM_DBManager_GetInfosByTimeline(benchmark::State &state)
+{
+    BenchFixtures::ensureImageRows(static_cast<int>(state.range(0)));
+    const QList<QDateTime> timelines = DBManager::instance()->getAllTimelines();
+    if (timelines.isEmpty()) {
+        state.SkipWithError("no timeline");
+        return;
+    }
+
+    int index = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(DBManager::instance()->getInfosByTimeline(timelines.at(index)));
+        index = (index + 1) % timelines.size();
+    }
+}
+BENCHMARK(BM_DBManager_GetInfosByTimeline)->Apply(applyRowCounts);
+
+// 时间线标题，0:全部 1:年 2:月 3:日 4:已导入
+static void BM_AlbumControl_GetTimelinesTitle(benchmark::State &state)
+{
+    BenchFixtures::ensureImageRows(static_cast<int>(state.range(0)));
+    const auto timeEnum = static_cast<AlbumControl::TimeLineEnum>(state.range(1));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(AlbumControl::instance()->getTimelinesTitle(timeEnum));
+    }
+}
+BENCHMARK(BM_AlbumControl_GetTimelinesTitle)
+    ->ArgsProduct({{10000, 100000}, {AlbumControl::Day, AlbumControl::Import}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "unionimage/unionimage.h"
+#include "utils/rotateimagehelper.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QFile>
+#include <QFileInfo>
+
+namespace {
+const QSize PHOTO_SIZE(4000, 3000);
+}
+
+// JPEG旋转: 0 解码旋转后重新编码，1 修改EXIF方向标记
+static void BM_RotateImageHelper_RotateJpeg(benchmark::State &state)
+{
+    const bool exifRotate = state.range(0) != 0;
+    const QString path = BenchFixtures::dataDir("rotate") + (exifRotate ? "/exif.jpg" : "/pixel.jpg");
+    if (!QFile::exists(path)) {
+        BenchFixtures::syntheticImage(0, PHOTO_SIZE).save(path, "JPG", 90);
+    }
+
+    LibUnionImage_NameSpace::setExifRotateEnabled(exifRotate);
+    for (auto _ : state) {
+        if (!RotateImageHelper::rotateImageImpl(path, 90)) {
+            state.SkipWithError("rotate failed");
+            break;
+        }
+    }
+    LibUnionImage_NameSpace::setExifRotateEnabled(true);
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["outputBytes"] = QFileInfo(path).size();
+    state.SetLabel(exifRotate ? "exif" : "pixel");
+}
+BENCHMARK(BM_RotateImageHelper_RotateJpeg)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "unionimage/baseutils.h"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+QString sizedDataFile(qint64 size)
+{
+    return BenchFixtures::dataFile(QString("data_%1.bin").arg(size), size);
+}
+}
+
+static void BM_Base_HashByData(benchmark::State &state)
+{
+    const QString path = sizedDataFile(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Libutils::base::hashByData(path));
+    }
+    // 仅读取文件前1M
+    state.SetBytesProcessed(state.iterations() * qMin<qint64>(state.range(0), 1024 * 1024));
+}
+BENCHMARK(BM_Base_HashByData)->Arg(64 * 1024)->Arg(1024 * 1024)->Arg(16 * 1024 * 1024);
+
+// 未传入hash时需读取文件内容计算
+static void BM_Base_FilePathToThumbnailPath(benchmark::State &state)
+{
+    const QString path = sizedDataFile(4 * 1024 * 1024);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Libutils::base::filePathToThumbnailPath(path));
+    }
+}
+BENCHMARK(BM_Base_FilePathToThumbnailPath);
+
+static void BM_Base_FilePathToThumbnailPathWithHash(benchmark::State &state)
+{
+    const QString path = sizedDataFile(4 * 1024 * 1024);
+    const QString dataHash = Libutils::base::hashByData(path);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Libutils::base::filePathToThumbnailPath(path, dataHash));
+    }
+}
+BENCHMARK(BM_Base_FilePathToThumbnailPathWithHash);
@@ -0,0 +1,22 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "unionimage/filetypecache.h"
+
+#include <benchmark/benchmark.h>
+
+// 目录分类，首轮填充文件类型缓存，之后的轮次命中缓存
+static void BM_FileTypeCache_ClassifyDirectory(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    BenchFixtures::imageSet(QString("scan-%1").arg(count), count, QSize(64, 48), count / 100);
+    const QString dir = BenchFixtures::dataDir(QString("scan-%1").arg(count));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(LibUnionImage_NameSpace::FileTypeCache::instance()->classifyDirectory(dir, true));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_FileTypeCache_ClassifyDirectory)->Arg(1000)->Arg(10000)->Arg(50000)->Unit(benchmark::kMillisecond)->UseRealTime();
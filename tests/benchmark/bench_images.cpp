@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "imageengine/imagedataservice.h"
+#include "unionimage/unionimage.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QFile>
+
+namespace {
+const QSize PHOTO_SIZE(4000, 3000);
+
+void removeThumbnails(const QStringList &paths)
+{
+    for (const QString &path : paths) {
+        for (const QString &thumbnailPath : ImageDataService::instance()->thumbnailFilePaths(path)) {
+            QFile::remove(thumbnailPath);
+        }
+    }
+}
+}
+
+// 缩略图生成，range(1)为0时每轮删除缩略图缓存(冷启动)，为1时复用已生成的缩略图
+static void BM_ReadThumbnailManager_ReadThumbnail(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    const bool cached = state.range(1) != 0;
+    const QStringList paths = BenchFixtures::imageSet("thumbnail", count, PHOTO_SIZE);
+
+    ReadThumbnailManager manager;
+    if (cached) {
+        for (const QString &path : paths) {
+            manager.addLoadPath(path);
+        }
+        manager.readThumbnail();
+    }
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        if (!cached) {
+            removeThumbnails(paths);
+        }
+        for (const QString &path : paths) {
+            manager.addLoadPath(path);
+        }
+        state.ResumeTiming();
+
+        manager.readThumbnail();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetLabel(cached ? "cached" : "generate");
+}
+BENCHMARK(BM_ReadThumbnailManager_ReadThumbnail)
+    ->Args({32, 0})
+    ->Args({32, 1})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// 目录扫描，文件类型判断结果在首轮之后已缓存
+static void BM_UnionImage_GetImagesAndVideoInfo(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    BenchFixtures::imageSet(QString("scan-%1").arg(count), count, QSize(64, 48), count / 100);
+    const QString dir = BenchFixtures::dataDir(QString("scan-%1").arg(count));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(LibUnionImage_NameSpace::getImagesAndVideoInfo(dir, true));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_UnionImage_GetImagesAndVideoInfo)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "imageengine/imagedataservice.h"
+#include "unionimage/baseutils.h"
+#include "unionimage/unionimage.h"
+#include "utils/imagescaler.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QElapsedTimer>
+#include <QFile>
+
+namespace {
+const QSize PHOTO_SIZE(4000, 3000);
+// 图片库规模，解码原图较慢，按样本耗时推算
+const int LIBRARY_SIZE = 50000;
+const int SAMPLE_COUNT = 16;
+
+QString levelPath(const QString &path, int level)
+{
+    return ImageDataService::getLevelPath(Libutils::base::filePathToThumbnailPath(path), level);
+}
+}
+
+/**
+ * @brief 切换加载模式(方图/等比例)后重新得到全库缩略图的耗时，library_s 为推算的 50k 图片库总耗时。
+ *      range(0): 0 调整前，缩略图固化了加载模式，切换后需解码原图重新生成；
+ *      1 从磁盘读取与模式无关的缩略图并计算显示区域；2 缩略图已在内存中，仅计算显示区域
+ */
+static void BM_ThumbnailMode_Switch(benchmark::State &state)
+{
+    const int method = static_cast<int>(state.range(0));
+    const QStringList paths = BenchFixtures::imageSet("loadmode", SAMPLE_COUNT, PHOTO_SIZE);
+    const int level = ImageDataService::instance()->thumbnailLevel();
+
+    if (!QFile::exists(levelPath(paths.last(), level))) {
+        ReadThumbnailManager manager;
+        for (const QString &path : paths) {
+            manager.addLoadPath(path);
+        }
+        manager.readThumbnail();
+    }
+
+    QVector<QImage> thumbnails;
+    for (const QString &path : paths) {
+        QImage image;
+        ImageDataService::loadThumbnailFile(levelPath(path, level), image);
+        thumbnails << image;
+    }
+
+    const int itemCount = 2 == method ? LIBRARY_SIZE : SAMPLE_COUNT;
+    QElapsedTimer timer;
+    qint64 elapsed = 0;
+    for (auto _ : state) {
+        timer.start();
+        for (int i = 0; i < itemCount; ++i) {
+            const QString &path = paths.at(i % SAMPLE_COUNT);
+            if (0 == method) {
+                QImage image;
+                QString errMsg;
+                LibUnionImage_NameSpace::loadStaticImageFromFile(path, image, errMsg);
+                benchmark::DoNotOptimize(ImageScaler::clipToSquare(image, level));
+            } else if (1 == method) {
+                QImage image;
+                ImageDataService::loadThumbnailFile(levelPath(path, level), image);
+                benchmark::DoNotOptimize(ImageDataService::instance()->thumbnailDisplayRect(image));
+            } else {
+                benchmark::DoNotOptimize(ImageDataService::instance()->thumbnailDisplayRect(thumbnails.at(i % SAMPLE_COUNT)));
+            }
+        }
+        elapsed += timer.nsecsElapsed();
+    }
+    state.SetItemsProcessed(state.iterations() * itemCount);
+
+    const double perItemNs = static_cast<double>(elapsed) / (state.iterations() * itemCount);
+    state.counters["library_s"] = perItemNs * LIBRARY_SIZE / 1e9;
+    state.SetLabel(0 == method ? "regenerate" : (1 == method ? "neutral-disk" : "neutral-memory"));
+}
+BENCHMARK(BM_ThumbnailMode_Switch)->DenseRange(0, 2)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,49 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "testsupport.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QApplication>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+const char *BENCH_HOME_ENV = "DEEPIN_ALBUM_BENCH_HOME";
+}
+
+int main(int argc, char *argv[])
+{
+    if (!TestSupport::ensureTemporaryHome(BENCH_HOME_ENV, "deepin-album-bench", argv)) {
+        return 1;
+    }
+    TestSupport::prepareEnvironment();
+
+    QApplication app(argc, argv);
+    TestSupport::initApplication(app);
+
+    // 默认以 JSON 格式输出，便于不同版本的结果对比
+    std::vector<char *> args(argv, argv + argc);
+    bool hasFormat = false;
+    for (char *arg : args) {
+        hasFormat = hasFormat || strncmp(arg, "--benchmark_format", strlen("--benchmark_format")) == 0;
+    }
+    static char jsonFormat[] = "--benchmark_format=json";
+    if (!hasFormat) {
+        args.push_back(jsonFormat);
+    }
+    int benchArgc = static_cast<int>(args.size());
+
+    benchmark::Initialize(&benchArgc, args.data());
+    if (benchmark::ReportUnrecognizedArguments(benchArgc, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    TestSupport::removeTemporaryHome(BENCH_HOME_ENV, "DEEPIN_ALBUM_BENCH_KEEP");
+    return 0;
+}
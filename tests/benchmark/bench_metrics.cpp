@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "unionimage/unionimage.h"
+#include "utils/metrics.h"
+
+#include <benchmark/benchmark.h>
+
+// 单次作用域计时开销(取时两次 + 直方图记录)
+static void BM_Metrics_ScopedTimer(benchmark::State &state)
+{
+    for (auto _ : state) {
+        ALBUM_METRICS_SCOPE("bench.scopedTimer");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Metrics_ScopedTimer)->ThreadRange(1, 8);
+
+static void BM_Metrics_Counter(benchmark::State &state)
+{
+    for (auto _ : state) {
+        ALBUM_METRICS_COUNT("bench.counter", 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Metrics_Counter)->ThreadRange(1, 8);
+
+// 缩略图解码路径对比: 0 不计时，1 计时，两者之差即为埋点开销
+static void BM_Metrics_ThumbnailDecode(benchmark::State &state)
+{
+    const bool instrumented = state.range(0) != 0;
+    const QString path = BenchFixtures::imageSet("metrics", 1, QSize(400, 300)).first();
+
+    QImage image;
+    QString errMsg;
+    for (auto _ : state) {
+        if (instrumented) {
+            ALBUM_METRICS_SCOPE("bench.thumbnailDecode");
+            LibUnionImage_NameSpace::loadStaticImageFromFile(path, image, errMsg);
+        } else {
+            LibUnionImage_NameSpace::loadStaticImageFromFile(path, image, errMsg);
+        }
+        benchmark::DoNotOptimize(image);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(instrumented ? "instrumented" : "plain");
+}
+BENCHMARK(BM_Metrics_ThumbnailDecode)->Arg(0)->Arg(1);
@@ -0,0 +1,164 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "imageengine/imagedataservice.h"
+#include "unionimage/baseutils.h"
+#include "unionimage/unionimage.h"
+#include "utils/imagescaler.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QtMath>
+
+namespace {
+const QSize PHOTO_SIZE(4000, 3000);
+const QSize SCREEN_SIZE(1920, 1080);
+const int IMAGE_COUNT = 16;
+// 分级前所有缩放等级共用的缩略图尺寸
+const int LEGACY_SIZE = 180;
+
+QStringList mipImages()
+{
+    return BenchFixtures::imageSet("mip", IMAGE_COUNT, PHOTO_SIZE);
+}
+
+QString legacyPath(const QString &path)
+{
+    return BenchFixtures::dataDir("mip-legacy") + "/" + QFileInfo(path).completeBaseName() + ".png";
+}
+
+QString levelPath(const QString &path, int level)
+{
+    return ImageDataService::getLevelPath(Libutils::base::filePathToThumbnailPath(path), level);
+}
+
+// 分级前的生成方式：解码后生成单一尺寸缩略图
+void generateLegacy(const QStringList &paths)
+{
+    for (const QString &path : paths) {
+        QImage image;
+        QString errMsg;
+        if (LibUnionImage_NameSpace::loadStaticImageFromFile(path, image, errMsg)) {
+            ImageScaler::clipToSquare(image, LEGACY_SIZE).save(legacyPath(path), "PNG");
+        }
+    }
+}
+
+// 界面加载时的生成方式：一次解码生成不大于当前显示级别的各级
+void generateLevels(const QStringList &paths)
+{
+    ReadThumbnailManager manager;
+    for (const QString &path : paths) {
+        manager.addLoadPath(path);
+    }
+    manager.readThumbnail();
+}
+
+// 滚动测试覆盖全部缩放等级，需要全部级别(较大级别在界面放大显示时才会生成)
+void ensureThumbnails(const QStringList &paths)
+{
+    if (!QFile::exists(legacyPath(paths.last()))) {
+        generateLegacy(paths);
+    }
+    const int maxLevel = ImageDataService::thumbnailLevels().last();
+    ReadThumbnailManager manager;
+    for (const QString &path : paths) {
+        if (!QFile::exists(levelPath(path, maxLevel))) {
+            manager.generateThumbnails(path, Libutils::base::filePathToThumbnailPath(path), maxLevel);
+        }
+    }
+}
+}
+
+/**
+ * @brief 缩略图生成耗时及磁盘占用，range(0) 为0时生成单一 180px 缩略图，为1时一次解码生成不大于当前显示级别的各级
+ */
+static void BM_ThumbnailMip_Generate(benchmark::State &state)
+{
+    const bool mip = state.range(0) != 0;
+    const QStringList paths = mipImages();
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (const QString &path : paths) {
+            QFile::remove(legacyPath(path));
+            for (const QString &thumbnailPath : ImageDataService::instance()->thumbnailFilePaths(path)) {
+                QFile::remove(thumbnailPath);
+            }
+        }
+        state.ResumeTiming();
+
+        if (mip) {
+            generateLevels(paths);
+        } else {
+            generateLegacy(paths);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * paths.size());
+
+    // 每张图片的平均磁盘占用
+    qint64 totalBytes = 0;
+    if (mip) {
+        for (int level : ImageDataService::thumbnailLevels()) {
+            qint64 levelBytes = 0;
+            for (const QString &path : paths) {
+                levelBytes += QFileInfo(levelPath(path, level)).size();
+            }
+            state.counters[QString("bytes_%1").arg(level).toStdString()] = static_cast<double>(levelBytes) / paths.size();
+            totalBytes += levelBytes;
+        }
+    } else {
+        for (const QString &path : paths) {
+            totalBytes += QFileInfo(legacyPath(path)).size();
+        }
+    }
+    state.counters["bytes_total"] = static_cast<double>(totalBytes) / paths.size();
+    state.SetLabel(mip ? "mip" : "single-180");
+}
+BENCHMARK(BM_ThumbnailMip_Generate)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+ * @brief 滚动一屏的耗时(近似帧耗时)：从磁盘缓存读取一屏可见缩略图并缩放到网格大小。
+ *      range(0) 为界面缩放等级(0-9)，range(1) 为0时使用单一 180px 缩略图，为1时使用对应级别
+ */
+static void BM_ThumbnailMip_ScrollFrame(benchmark::State &state)
+{
+    const int zoomLevel = static_cast<int>(state.range(0));
+    const bool mip = state.range(1) != 0;
+    const QStringList paths = mipImages();
+    ensureThumbnails(paths);
+
+    // 与 GlobalStatus 中网格大小及级别的选择方式一致
+    const int cellWidth = 80 + zoomLevel * 10;
+    const int displaySize = qCeil(cellWidth * 1.25);
+    const int level = mip ? ImageDataService::thumbnailLevelForSize(displaySize) : LEGACY_SIZE;
+    const int visibleCount = (SCREEN_SIZE.width() / cellWidth) * (SCREEN_SIZE.height() / cellWidth + 1);
+
+    QStringList files;
+    for (const QString &path : paths) {
+        files << (mip ? levelPath(path, level) : legacyPath(path));
+    }
+
+    qint64 frameBytes = 0;
+    for (auto _ : state) {
+        frameBytes = 0;
+        for (int i = 0; i < visibleCount; ++i) {
+            QImage image(files.at(i % files.size()), "PNG");
+            frameBytes += image.sizeInBytes();
+            benchmark::DoNotOptimize(image.scaled(displaySize, displaySize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * visibleCount);
+
+    state.counters["level"] = level;
+    state.counters["visible"] = visibleCount;
+    state.counters["frame_mb"] = frameBytes / (1024.0 * 1024.0);
+    // 缩略图小于显示尺寸时需要放大，显示发虚
+    state.counters["upscaled"] = level < displaySize ? 1 : 0;
+    state.SetLabel(mip ? "mip" : "single-180");
+}
+BENCHMARK(BM_ThumbnailMip_ScrollFrame)->ArgsProduct({benchmark::CreateDenseRange(0, 9, 3), {0, 1}})->Unit(benchmark::kMillisecond);
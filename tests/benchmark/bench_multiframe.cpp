@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "imagedata/multiframeindex.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QDataStream>
+#include <QFile>
+#include <QImageReader>
+#include <QRandomGenerator>
+
+namespace {
+const int TIFF_PAGE_COUNT = 300;
+const QSize TIFF_PAGE_SIZE(400, 560);
+
+/**
+ * @brief 生成未压缩的8位灰度多页 TIFF ，模拟扫描文档。
+ *      QImageWriter 只能写入单页 TIFF ，此处直接按格式写出，每页为一个条带
+ */
+QString multiPageTiff()
+{
+    const QString path = BenchFixtures::dataDir("multiframe") + "/scan.tif";
+    if (QFile::exists(path)) {
+        return path;
+    }
+
+    const quint16 entryCount = 9;
+    const quint32 width = static_cast<quint32>(TIFF_PAGE_SIZE.width());
+    const quint32 height = static_cast<quint32>(TIFF_PAGE_SIZE.height());
+    const quint32 dataSize = width * height;
+    const quint32 ifdSize = 2 + entryCount * 12 + 4;
+    const quint32 pageSize = dataSize + ifdSize;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return QString();
+    }
+    QDataStream stream(&file);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.writeRawData("II", 2);
+    stream << quint16(42) << quint32(8 + dataSize);
+
+    for (int page = 0; page < TIFF_PAGE_COUNT; ++page) {
+        const quint32 dataOffset = 8 + page * pageSize;
+        QImage image = BenchFixtures::syntheticImage(page, TIFF_PAGE_SIZE).convertToFormat(QImage::Format_Grayscale8);
+        for (int y = 0; y < image.height(); ++y) {
+            stream.writeRawData(reinterpret_cast<const char *>(image.constScanLine(y)), image.width());
+        }
+
+        auto writeEntry = [&stream](quint16 tag, quint16 type, quint32 value) {
+            stream << tag << type << quint32(1);
+            if (3 == type) {
+                stream << quint16(value) << quint16(0);
+            } else {
+                stream << value;
+            }
+        };
+        stream << entryCount;
+        writeEntry(256, 4, width);          // ImageWidth
+        writeEntry(257, 4, height);         // ImageLength
+        writeEntry(258, 3, 8);              // BitsPerSample
+        writeEntry(259, 3, 1);              // Compression: none
+        writeEntry(262, 3, 1);              // Photometric: BlackIsZero
+        writeEntry(273, 4, dataOffset);     // StripOffsets
+        writeEntry(277, 3, 1);              // SamplesPerPixel
+        writeEntry(278, 4, height);         // RowsPerStrip
+        writeEntry(279, 4, dataSize);       // StripByteCounts
+        stream << quint32(page + 1 < TIFF_PAGE_COUNT ? dataOffset + pageSize + dataSize : 0);
+    }
+    return path;
+}
+}
+
+// 打开文件并读取首帧及总帧数: 0 QImageReader，1 帧索引(首次解析)，2 帧索引(读取持久化索引)
+static void BM_MultiFrame_FirstFrame(benchmark::State &state)
+{
+    const int mode = static_cast<int>(state.range(0));
+    const QString path = multiPageTiff();
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        if (1 == mode) {
+            MultiFrameIndex::instance()->remove(path);
+        } else if (2 == mode) {
+            MultiFrameIndex::instance()->clear();
+        }
+        state.ResumeTiming();
+
+        if (0 == mode) {
+            QImageReader reader(path);
+            benchmark::DoNotOptimize(reader.imageCount());
+            benchmark::DoNotOptimize(reader.read());
+        } else {
+            benchmark::DoNotOptimize(MultiFrameIndex::instance()->frameCount(path));
+            benchmark::DoNotOptimize(MultiFrameIndex::instance()->readFrame(path, 0));
+        }
+    }
+    state.SetLabel(0 == mode ? "QImageReader" : (1 == mode ? "index-parse" : "index-persisted"));
+}
+BENCHMARK(BM_MultiFrame_FirstFrame)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+// 随机帧读取: 0 QImageReader::jumpToImage，1 帧索引直接定位
+static void BM_MultiFrame_RandomFrame(benchmark::State &state)
+{
+    const bool indexed = state.range(0) != 0;
+    const QString path = multiPageTiff();
+    MultiFrameIndex::instance()->frameCount(path);
+
+    QRandomGenerator random(1);
+    for (auto _ : state) {
+        int frame = static_cast<int>(random.bounded(TIFF_PAGE_COUNT));
+        if (indexed) {
+            benchmark::DoNotOptimize(MultiFrameIndex::instance()->readFrame(path, frame));
+        } else {
+            QImageReader reader(path);
+            reader.jumpToImage(frame);
+            benchmark::DoNotOptimize(reader.read());
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(indexed ? "index" : "QImageReader");
+}
+BENCHMARK(BM_MultiFrame_RandomFrame)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// 页面条滚动时的帧预览，预览已缓存
+static void BM_MultiFrame_PreviewCached(benchmark::State &state)
+{
+    const QString path = multiPageTiff();
+    const QSize previewSize(100, 100);
+    for (int i = 0; i < TIFF_PAGE_COUNT; ++i) {
+        MultiFrameIndex::instance()->framePreview(path, i, previewSize);
+    }
+
+    int frame = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MultiFrameIndex::instance()->framePreview(path, frame, previewSize));
+        frame = (frame + 1) % TIFF_PAGE_COUNT;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MultiFrame_PreviewCached);
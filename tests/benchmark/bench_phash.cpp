@@ -0,0 +1,149 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "utils/perceptualhashindex.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QBuffer>
+#include <QRandomGenerator>
+
+namespace {
+const int PHASH_BASE_COUNT = 200;
+
+enum VariantType {
+    VariantResized,         // 缩小为一半
+    VariantRecompressed,    // 低质量重新压缩
+    VariantCropped,         // 四周各裁掉5%
+    VariantCount
+};
+
+QImage makeVariant(const QImage &base, int type)
+{
+    switch (type) {
+    case VariantResized:
+        return base.scaled(base.size() / 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    case VariantRecompressed: {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        base.save(&buffer, "JPG", 30);
+        return QImage::fromData(data, "JPG");
+    }
+    case VariantCropped:
+    default: {
+        int dx = base.width() / 20;
+        int dy = base.height() / 20;
+        return base.copy(dx, dy, base.width() - 2 * dx, base.height() - 2 * dy);
+    }
+    }
+}
+
+// 原图哈希及各变体的哈希，变体 i 对应原图 i / VariantCount
+struct PHashFixture {
+    QVector<quint64> baseHashes;
+    QVector<quint64> variantHashes;
+};
+
+const PHashFixture &phashFixture()
+{
+    static const PHashFixture fixture = [] {
+        PHashFixture result;
+        for (int i = 0; i < PHASH_BASE_COUNT; ++i) {
+            QImage base = BenchFixtures::syntheticImage(i, QSize(1024, 768));
+            result.baseHashes << PerceptualHashIndex::dHash(base);
+            for (int type = 0; type < VariantCount; ++type) {
+                result.variantHashes << PerceptualHashIndex::dHash(makeVariant(base, type));
+            }
+        }
+        return result;
+    }();
+    return fixture;
+}
+}
+
+// 以变体查询原图的准确率及召回率，结果以计数器输出
+static void BM_PerceptualHash_PrecisionRecall(benchmark::State &state)
+{
+    const int radius = static_cast<int>(state.range(0));
+    const PHashFixture &fixture = phashFixture();
+
+    MultiIndexHashTable table;
+    for (quint64 hash : fixture.baseHashes) {
+        table.insert(hash);
+    }
+
+    int truePositive = 0;
+    int returned = 0;
+    for (auto _ : state) {
+        truePositive = 0;
+        returned = 0;
+        for (int i = 0; i < fixture.variantHashes.size(); ++i) {
+            const QVector<int> ids = table.query(fixture.variantHashes.at(i), radius);
+            returned += ids.size();
+            truePositive += ids.contains(i / VariantCount) ? 1 : 0;
+        }
+    }
+
+    state.counters["precision"] = returned > 0 ? static_cast<double>(truePositive) / returned : 0;
+    state.counters["recall"] = static_cast<double>(truePositive) / fixture.variantHashes.size();
+    state.SetItemsProcessed(state.iterations() * fixture.variantHashes.size());
+}
+BENCHMARK(BM_PerceptualHash_PrecisionRecall)->DenseRange(2, 10, 2);
+
+static void BM_PerceptualHash_DHash(benchmark::State &state)
+{
+    const QImage image = BenchFixtures::syntheticImage(0, QSize(256, 256));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PerceptualHashIndex::dHash(image));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PerceptualHash_DHash);
+
+// 大图库单次查询延时，随机哈希模拟无关图片
+static void BM_PerceptualHash_Query(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    const int radius = static_cast<int>(state.range(1));
+    QRandomGenerator random(1);
+    MultiIndexHashTable table;
+    for (int i = 0; i < count; ++i) {
+        table.insert(random.generate64());
+    }
+
+    int index = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(table.query(table.hashAt(index), radius));
+        index = (index + 1) % count;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PerceptualHash_Query)->ArgsProduct({{10000, 200000}, {4, 6, 10}});
+
+// 查找全部相似图片(逐个查询全表)的耗时
+static void BM_PerceptualHash_QueryAll(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    const int radius = static_cast<int>(state.range(1));
+    QRandomGenerator random(1);
+    MultiIndexHashTable table;
+    for (int i = 0; i < count; ++i) {
+        table.insert(random.generate64());
+    }
+
+    for (auto _ : state) {
+        int matched = 0;
+        for (int id = 0; id < count; ++id) {
+            matched += table.query(table.hashAt(id), radius).size();
+        }
+        benchmark::DoNotOptimize(matched);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_PerceptualHash_QueryAll)
+    ->Args({200000, PerceptualHashIndex::DefaultRadius})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
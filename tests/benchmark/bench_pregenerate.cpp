@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "imageengine/imagedataservice.h"
+#include "imageengine/thumbnailpregenerator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QFile>
+
+namespace {
+const QSize PHOTO_SIZE(4000, 3000);
+}
+
+/**
+ * @brief 后台预生成吞吐量(张/秒)，range(0) 为图片数量，每轮开始前删除缩略图，
+ *      coverage_before/coverage_after 为生成前后的覆盖率
+ */
+static void BM_ThumbnailPregenerator_Generate(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    const QStringList paths = BenchFixtures::imageSet("pregenerate", count, PHOTO_SIZE);
+
+    double coverageBefore = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        // 保留前一半图片的缩略图，模拟部分已浏览过的图片库
+        for (int i = count / 2; i < count; ++i) {
+            for (const QString &thumbnailPath : ImageDataService::instance()->thumbnailFilePaths(paths.at(i))) {
+                QFile::remove(thumbnailPath);
+            }
+        }
+        coverageBefore = ThumbnailPregenerator::coverage(paths);
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(ThumbnailPregenerator::instance()->generate(paths));
+    }
+    state.SetItemsProcessed(state.iterations() * (count - count / 2));
+
+    state.counters["coverage_before"] = coverageBefore * 100;
+    state.counters["coverage_after"] = ThumbnailPregenerator::coverage(paths) * 100;
+}
+BENCHMARK(BM_ThumbnailPregenerator_Generate)->Arg(32)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+ * @brief 覆盖率统计及限流状态检查的耗时，均在处理过程中定时执行
+ */
+static void BM_ThumbnailPregenerator_Coverage(benchmark::State &state)
+{
+    const QStringList paths = BenchFixtures::imageSet("pregenerate", 32, PHOTO_SIZE);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ThumbnailPregenerator::coverage(paths));
+    }
+    state.SetItemsProcessed(state.iterations() * paths.size());
+}
+BENCHMARK(BM_ThumbnailPregenerator_Coverage)->Unit(benchmark::kMicrosecond);
+
+static void BM_ThumbnailPregenerator_Throttle(benchmark::State &state)
+{
+    ThumbnailPregenerator::Throttle throttle = ThumbnailPregenerator::Run;
+    for (auto _ : state) {
+        throttle = ThumbnailPregenerator::currentThrottle();
+        benchmark::DoNotOptimize(throttle);
+    }
+    state.SetLabel(ThumbnailPregenerator::Pause == throttle ? "pause" : (ThumbnailPregenerator::WaitIdle == throttle ? "wait_idle" : "run"));
+}
+BENCHMARK(BM_ThumbnailPregenerator_Throttle)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "unionimage/imageutils.h"
+#include "utils/imagescaler.h"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+const QSize PHOTO_SIZE(4000, 3000);
+const int PHOTO_SEED = 41;
+
+QImage detailedPhoto(QImage::Format format)
+{
+    return BenchFixtures::detailedImage(PHOTO_SEED, PHOTO_SIZE, format);
+}
+
+// 调整前的 clipToRect：最近邻缩放后裁切
+QImage legacyClipToRect(const QImage &src)
+{
+    QImage image = src.height() >= src.width() ? src.scaledToWidth(THUMBNAIL_MAX_SIZE, Qt::FastTransformation)
+                                               : src.scaledToHeight(THUMBNAIL_MAX_SIZE, Qt::FastTransformation);
+    const int side = qMin(image.width(), image.height());
+    return image.copy((image.width() - side) / 2, (image.height() - side) / 2, side, side);
+}
+
+const QImage::Format FORMATS[] = {QImage::Format_RGB32, QImage::Format_ARGB32_Premultiplied, QImage::Format_RGB888};
+}
+
+/**
+ * @brief 缩略图方图裁切: 0 调整前(最近邻缩放后裁切)，1 QImage 平滑缩放后裁切，2 ImageScaler 裁切缩放
+ */
+static void BM_Scaler_ClipToSquare(benchmark::State &state)
+{
+    const int mode = static_cast<int>(state.range(0));
+    const QImage photo = detailedPhoto(QImage::Format_RGB32);
+    for (auto _ : state) {
+        if (0 == mode) {
+            benchmark::DoNotOptimize(legacyClipToRect(photo));
+        } else if (1 == mode) {
+            QImage scaled = photo.scaledToHeight(THUMBNAIL_MAX_SIZE, Qt::SmoothTransformation);
+            benchmark::DoNotOptimize(scaled.copy((scaled.width() - scaled.height()) / 2, 0, scaled.height(), scaled.height()));
+        } else {
+            benchmark::DoNotOptimize(ImageScaler::clipToSquare(photo, THUMBNAIL_MAX_SIZE));
+        }
+    }
+    state.SetLabel(0 == mode ? "legacy-fast" : (1 == mode ? "qt-smooth" : "ImageScaler"));
+}
+BENCHMARK(BM_Scaler_ClipToSquare)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief 按比例缩小到缩略图尺寸，range(0) 为格式序号，range(1) 为0时使用 QImage::scaled ，
+ *      否则为 ImageScaler::kernels() 中的序号加1
+ */
+static void BM_Scaler_Scaled(benchmark::State &state)
+{
+    const QImage photo = detailedPhoto(FORMATS[state.range(0)]);
+    const QSize size(THUMBNAIL_MAX_SIZE, THUMBNAIL_MAX_SIZE);
+    const int kernel = static_cast<int>(state.range(1)) - 1;
+    const QStringList kernels = ImageScaler::kernels();
+    if (kernel >= kernels.size()) {
+        state.SkipWithError("kernel not supported on this CPU");
+        return;
+    }
+
+    const QString defaultKernel = ImageScaler::currentKernel();
+    if (kernel >= 0) {
+        ImageScaler::setKernel(kernels.at(kernel));
+    }
+    for (auto _ : state) {
+        if (kernel < 0) {
+            benchmark::DoNotOptimize(photo.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+        } else {
+            benchmark::DoNotOptimize(ImageScaler::scaled(photo, size, Qt::KeepAspectRatio));
+        }
+    }
+    ImageScaler::setKernel(defaultKernel);
+
+    state.SetItemsProcessed(state.iterations() * PHOTO_SIZE.width() * PHOTO_SIZE.height());
+    state.SetLabel(QString("%1 %2").arg(state.range(0)).arg(kernel < 0 ? "qt-smooth" : kernels.at(kernel)).toStdString());
+}
+BENCHMARK(BM_Scaler_Scaled)->ArgsProduct({{0, 1, 2}, {0, 1, 2, 3}})->Unit(benchmark::kMillisecond);
@@ -0,0 +1,109 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "unionimage/unionimage.h"
+#include "utils/metrics.h"
+#include "utils/workscheduler.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QThread>
+#include <QThreadPool>
+
+namespace {
+const int SCROLL_REQUEST_COUNT = 64;
+const int SCROLL_REQUEST_INTERVAL_MS = 2;
+
+void decodeImage(const QString &path, const QSize &scaledSize)
+{
+    QImage image;
+    QString errMsg;
+    LibUnionImage_NameSpace::loadStaticImageFromFile(path, image, errMsg);
+    benchmark::DoNotOptimize(image.scaled(scaledSize, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+}
+}
+
+/**
+ * @brief 导入过程中滚动缩略图的延时，导入任务持续解码大图，同时每隔2ms请求一张缩略图，
+ *      统计缩略图从请求到完成的 p50/p99 。
+ *      0 所有任务共用一个 QThreadPool(调整前的方式)，1 通过 WorkScheduler 按优先级调度
+ */
+static void BM_Scheduler_ScrollDuringImport(benchmark::State &state)
+{
+    const bool scheduled = state.range(0) != 0;
+    const QStringList photos = BenchFixtures::imageSet("scheduler-photo", 8, QSize(4000, 3000));
+    const QStringList thumbnails = BenchFixtures::imageSet("scheduler-thumbnail", SCROLL_REQUEST_COUNT, QSize(400, 300));
+    WorkScheduler *scheduler = WorkScheduler::instance();
+    const int importTaskCount = scheduler->workerCount() * 8;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(scheduler->workerCount());
+    LatencyHistogram latency;
+
+    for (auto _ : state) {
+        WorkCancelToken importToken;
+        for (int i = 0; i < importTaskCount; ++i) {
+            const QString path = photos.at(i % photos.size());
+            auto importTask = [path]() { decodeImage(path, QSize(256, 256)); };
+            if (scheduled) {
+                scheduler->submit(WorkScheduler::BulkIO, importTask, importToken);
+            } else {
+                pool.start(importTask);
+            }
+        }
+
+        std::atomic_int finished{0};
+        for (const QString &path : thumbnails) {
+            auto requestTime = std::chrono::steady_clock::now();
+            auto visibleTask = [path, requestTime, &latency, &finished]() {
+                decodeImage(path, QSize(128, 128));
+                latency.record(static_cast<quint64>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                        std::chrono::steady_clock::now() - requestTime).count()));
+                finished++;
+            };
+            if (scheduled) {
+                scheduler->submit(WorkScheduler::Visible, visibleTask);
+            } else {
+                pool.start(visibleTask);
+            }
+            QThread::msleep(SCROLL_REQUEST_INTERVAL_MS);
+        }
+
+        while (finished.load() < SCROLL_REQUEST_COUNT) {
+            QThread::msleep(1);
+        }
+
+        // 滚动结束后取消剩余的导入任务
+        state.PauseTiming();
+        if (scheduled) {
+            importToken.cancel();
+            scheduler->waitForDone();
+        } else {
+            pool.clear();
+            pool.waitForDone();
+        }
+        state.ResumeTiming();
+    }
+
+    state.counters["p50_us"] = static_cast<double>(latency.percentile(50));
+    state.counters["p99_us"] = static_cast<double>(latency.percentile(99));
+    state.counters["max_us"] = static_cast<double>(latency.max());
+    state.SetLabel(scheduled ? "WorkScheduler" : "QThreadPool");
+}
+BENCHMARK(BM_Scheduler_ScrollDuringImport)->Arg(0)->Arg(1)->Iterations(5)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 调度器自身开销: 提交空任务并等待完成
+static void BM_Scheduler_SubmitOverhead(benchmark::State &state)
+{
+    WorkScheduler *scheduler = WorkScheduler::instance();
+    for (auto _ : state) {
+        for (int i = 0; i < 1000; ++i) {
+            scheduler->submit(WorkScheduler::Visible, []() {});
+        }
+        scheduler->waitForDone();
+    }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_Scheduler_SubmitOverhead)->Unit(benchmark::kMicrosecond)->UseRealTime();
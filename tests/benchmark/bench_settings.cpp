@@ -0,0 +1,138 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "utils/settingsstore.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSettings>
+
+namespace {
+const QString SETTINGS_GROUP = "Thumbnail";
+const QString SETTINGS_KEY = "DisplayMode";
+// 其他配置项，使配置文件大小与实际使用时相近
+const int EXTRA_KEY_COUNT = 30;
+
+QString settingsPath(const QString &name)
+{
+    return BenchFixtures::dataDir("settings") + "/" + name + ".conf";
+}
+
+void fillSettings(QSettings &settings)
+{
+    for (int i = 0; i < EXTRA_KEY_COUNT; ++i) {
+        settings.setValue(QString("Group%1/key%2").arg(i % 3).arg(i), i);
+    }
+    settings.setValue(SETTINGS_GROUP + "/" + SETTINGS_KEY, 0);
+    settings.sync();
+}
+
+// 原有方式：共享的 QSettings，读取加锁并切换分组；每次修改在下一次事件循环中写回文件，相当于一次 sync()
+class LegacySettings
+{
+public:
+    explicit LegacySettings(const QString &filePath)
+        : m_settings(filePath, QSettings::IniFormat)
+    {
+        fillSettings(m_settings);
+    }
+
+    QVariant value(const QString &group, const QString &key)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_settings.beginGroup(group);
+        QVariant result = m_settings.value(key);
+        m_settings.endGroup();
+        return result;
+    }
+
+    void setValue(const QString &group, const QString &key, const QVariant &value)
+    {
+        m_settings.beginGroup(group);
+        m_settings.setValue(key, value);
+        m_settings.endGroup();
+        m_settings.sync();
+    }
+
+private:
+    QSettings m_settings;
+    QMutex m_mutex;
+};
+
+LegacySettings *legacySettings()
+{
+    static LegacySettings settings(settingsPath("legacy"));
+    return &settings;
+}
+
+SettingsStore *settingsStore()
+{
+    static SettingsStore *store = []() {
+        QSettings settings(settingsPath("store"), QSettings::IniFormat);
+        fillSettings(settings);
+        return new SettingsStore(settingsPath("store"));
+    }();
+    return store;
+}
+
+const char *methodLabel(int method)
+{
+    return 0 == method ? "qsettings" : "store";
+}
+}
+
+/**
+ * @brief 读取配置项，多个线程同时读取。range(0): 0 原有方式，1 内存存储
+ */
+static void BM_Settings_Read(benchmark::State &state)
+{
+    const int method = static_cast<int>(state.range(0));
+    LegacySettings *legacy = 0 == method ? legacySettings() : nullptr;
+    SettingsStore *store = 0 == method ? nullptr : settingsStore();
+    const QString fullKey = SETTINGS_GROUP + "/" + SETTINGS_KEY;
+
+    for (auto _ : state) {
+        if (legacy) {
+            benchmark::DoNotOptimize(legacy->value(SETTINGS_GROUP, SETTINGS_KEY));
+        } else {
+            benchmark::DoNotOptimize(store->value(fullKey));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(methodLabel(method));
+}
+BENCHMARK(BM_Settings_Read)->DenseRange(0, 1)->ThreadRange(1, 4)->UseRealTime();
+
+/**
+ * @brief 连续修改同一配置项(如拖动缩放滑块)，只计调用线程的耗时。range(0): 0 原有方式，1 内存存储；
+ *      flush_ms 为内存存储在测试结束后一次写回的耗时
+ */
+static void BM_Settings_Write(benchmark::State &state)
+{
+    const int method = static_cast<int>(state.range(0));
+    const QString fullKey = SETTINGS_GROUP + "/" + SETTINGS_KEY;
+
+    int value = 0;
+    for (auto _ : state) {
+        ++value;
+        if (0 == method) {
+            legacySettings()->setValue(SETTINGS_GROUP, SETTINGS_KEY, value);
+        } else {
+            settingsStore()->setValue(fullKey, value);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(methodLabel(method));
+
+    if (1 == method) {
+        QElapsedTimer timer;
+        timer.start();
+        settingsStore()->flush();
+        state.counters["flush_ms"] = timer.nsecsElapsed() / 1e6;
+    }
+}
+BENCHMARK(BM_Settings_Write)->DenseRange(0, 1)->UseRealTime();
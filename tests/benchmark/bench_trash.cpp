@@ -0,0 +1,102 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "dbmanager/dbmanager.h"
+#include "dbmanager/trashmaintainer.h"
+#include "unionimage/baseutils.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QDir>
+#include <QFile>
+
+namespace {
+// 回收站副本已被外部删除的比例(每 MISSING_INTERVAL 个一个)
+const int MISSING_INTERVAL = 20;
+
+// 回收站中的 count 个项目：原文件均已不存在，回收站副本为空文件
+QStringList makeTrash(int count)
+{
+    QDir().mkpath(albumGlobal::DELETE_PATH);
+    const QDateTime now = QDateTime::currentDateTime();
+    DBImgInfoList infos;
+    QStringList paths;
+    for (int i = 0; i < count; ++i) {
+        DBImgInfo info;
+        info.filePath = QString("/bench/trash/%1/img_%2.jpg").arg(i / 1000).arg(i);
+        info.itemType = (i % 10 == 0) ? ItemTypeVideo : ItemTypePic;
+        info.time = now.addDays(-365);
+        info.changeTime = info.time;
+        info.importTime = now.addSecs(-60LL * i);
+        infos << info;
+        paths << info.filePath;
+
+        if (i % MISSING_INTERVAL != 0) {
+            QFile file(Libutils::base::getDeleteFullPath(Libutils::base::hashByString(info.filePath), info.getFileNameFromFilePath()));
+            file.open(QIODevice::WriteOnly);
+        }
+    }
+    DBManager::instance()->insertTrashImgInfos(infos, false);
+    return paths;
+}
+
+// 原有方式：每次读取全部回收站数据并逐个判断回收站副本及原文件是否存在
+int legacyTrashCount(int filterType)
+{
+    DBImgInfoList allTrashInfos = DBManager::instance()->getAllTrashInfos_getRemainDays();
+    int count = 0;
+    for (const DBImgInfo &pinfo : allTrashInfos) {
+        if (!QFile::exists(pinfo.filePath)
+                && !QFile::exists(Libutils::base::getDeleteFullPath(pinfo.pathHash, pinfo.getFileNameFromFilePath()))) {
+            continue;
+        }
+        if (pinfo.remainDays > 0 && (filterType == ItemTypeNull || pinfo.itemType == filterType)) {
+            ++count;
+        }
+    }
+    return count;
+}
+}
+
+/**
+ * @brief 打开回收站界面：获取全部、图片、视频三个数量及全部项目，range(0) 为回收站项目数量。
+ *      range(1): 0 原有方式，1 回收站数据有修改后首次打开(重新维护)，2 使用缓存的结果
+ */
+static void BM_TrashView_Open(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    const int method = static_cast<int>(state.range(1));
+    const QStringList paths = makeTrash(count);
+    if (0 != method) {
+        TrashMaintainer::instance()->refreshNow();
+    }
+
+    int items = 0;
+    for (auto _ : state) {
+        if (0 == method) {
+            benchmark::DoNotOptimize(legacyTrashCount(ItemTypeNull));
+            benchmark::DoNotOptimize(legacyTrashCount(ItemTypePic));
+            benchmark::DoNotOptimize(legacyTrashCount(ItemTypeVideo));
+            items = legacyTrashCount(ItemTypeNull);
+        } else {
+            TrashMaintainer *maintainer = TrashMaintainer::instance();
+            if (1 == method) {
+                //读取不等待维护，此处计入维护本身的耗时
+                maintainer->refreshNow();
+            }
+            benchmark::DoNotOptimize(maintainer->count(ItemTypeNull));
+            benchmark::DoNotOptimize(maintainer->count(ItemTypePic));
+            benchmark::DoNotOptimize(maintainer->count(ItemTypeVideo));
+            items = maintainer->infos().size();
+        }
+    }
+    state.counters["items"] = items;
+    state.SetLabel(0 == method ? "legacy" : (1 == method ? "refresh" : "cached"));
+
+    DBManager::instance()->removeTrashImgInfos(paths);
+}
+BENCHMARK(BM_TrashView_Open)
+->ArgsProduct({{1000, 10000, 50000}, {0, 1, 2}})
+->Unit(benchmark::kMillisecond)->UseRealTime();
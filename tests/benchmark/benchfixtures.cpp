@@ -0,0 +1,153 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "dbmanager/dbmanager.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QRandomGenerator>
+
+namespace BenchFixtures {
+
+namespace {
+// 图片表中合成数据的路径前缀
+const QString QUERY_ROW_PREFIX = "/bench/query";
+
+DBImgInfo makeRow(int index)
+{
+    // 每小时一张，约每月800行；每100张为一次导入
+    static const QDateTime baseTime(QDate(2024, 1, 1), QTime(12, 0));
+    DBImgInfo info;
+    info.filePath = QString("%1/%2/img_%3.jpg").arg(QUERY_ROW_PREFIX).arg(index / 1000).arg(index);
+    info.itemType = (index % 10 == 0) ? ItemTypeVideo : ItemTypePic;
+    info.time = baseTime.addSecs(-3600LL * index);
+    info.changeTime = info.time;
+    info.importTime = baseTime.addSecs(-60LL * (index / 100));
+    return info;
+}
+}
+
+QString rootDir()
+{
+    return QDir::homePath() + "/bench-data";
+}
+
+QString dataDir(const QString &name)
+{
+    QString path = rootDir() + "/" + name;
+    QDir().mkpath(path);
+    return path;
+}
+
+QImage syntheticImage(int seed, const QSize &size)
+{
+    QRandomGenerator random(static_cast<quint32>(seed));
+    QImage image(size, QImage::Format_RGB32);
+
+    QPainter painter(&image);
+    QLinearGradient gradient(0, 0, size.width(), size.height());
+    gradient.setColorAt(0, QColor::fromRgb(random.generate() | 0xff000000));
+    gradient.setColorAt(1, QColor::fromRgb(random.generate() | 0xff000000));
+    painter.fillRect(image.rect(), gradient);
+
+    painter.setPen(Qt::NoPen);
+    for (int i = 0; i < 12; ++i) {
+        painter.setBrush(QColor::fromRgb(random.generate() | 0xff000000));
+        int w = random.bounded(size.width() / 8, size.width() / 2);
+        int h = random.bounded(size.height() / 8, size.height() / 2);
+        painter.drawEllipse(random.bounded(size.width() - w), random.bounded(size.height() - h), w, h);
+    }
+    painter.end();
+
+    return image;
+}
+
+QImage detailedImage(int seed, const QSize &size, QImage::Format format)
+{
+    QImage image = syntheticImage(seed, size);
+    QRandomGenerator random(static_cast<quint32>(seed));
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            const int noise = static_cast<int>(random.bounded(64)) - 32;
+            line[x] = qRgb(qBound(0, qRed(line[x]) + noise, 255), qBound(0, qGreen(line[x]) + noise, 255),
+                           qBound(0, qBlue(line[x]) + noise, 255));
+        }
+    }
+    return image.convertToFormat(format);
+}
+
+QStringList imageSet(const QString &name, int count, const QSize &size, int subDirCount)
+{
+    const QString dir = dataDir(name);
+    subDirCount = qMax(subDirCount, 1);
+
+    // 仅生成一张原型图片，其余文件复制原型，保证大量文件时生成速度
+    QString prototype;
+    QStringList paths;
+    for (int i = 0; i < count; ++i) {
+        QString subDir = QString("%1/dir_%2").arg(dir).arg(i % subDirCount);
+        QString path = QString("%1/img_%2.jpg").arg(subDir).arg(i);
+        paths << path;
+        if (QFile::exists(path)) {
+            continue;
+        }
+
+        QDir().mkpath(subDir);
+        if (count <= 256) {
+            syntheticImage(i, size).save(path, "JPG", 90);
+        } else {
+            if (prototype.isEmpty()) {
+                prototype = dir + "/prototype.jpg";
+                syntheticImage(0, size).save(prototype, "JPG", 90);
+            }
+            QFile::copy(prototype, path);
+        }
+    }
+
+    return paths;
+}
+
+QString dataFile(const QString &name, qint64 size)
+{
+    QString path = dataDir("files") + "/" + name;
+    if (QFileInfo(path).size() == size) {
+        return path;
+    }
+
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QRandomGenerator random(static_cast<quint32>(size));
+        QByteArray block(1024 * 1024, Qt::Uninitialized);
+        for (qint64 written = 0; written < size; written += block.size()) {
+            random.fillRange(reinterpret_cast<quint32 *>(block.data()), block.size() / 4);
+            file.write(block.constData(), qMin<qint64>(block.size(), size - written));
+        }
+    }
+    return path;
+}
+
+void ensureImageRows(int count)
+{
+    static int s_rowCount = 0;
+    if (count > s_rowCount) {
+        DBImgInfoList infos;
+        for (int i = s_rowCount; i < count; ++i) {
+            infos << makeRow(i);
+        }
+        DBManager::instance()->insertImgInfos(infos);
+    } else if (count < s_rowCount) {
+        QStringList paths;
+        for (int i = count; i < s_rowCount; ++i) {
+            paths << makeRow(i).filePath;
+        }
+        DBManager::instance()->removeImgInfosNoSignal(paths);
+    }
+    s_rowCount = count;
+}
+
+}
@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef BENCHFIXTURES_H
+#define BENCHFIXTURES_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief 基准测试的合成数据，全部在运行时生成，不依赖外部文件。
+ *      数据位于独立的临时 HOME 下，同一次运行中按名称复用，运行结束后删除。
+ */
+namespace BenchFixtures {
+
+// 测试数据根目录
+QString rootDir();
+// 根目录下的子目录，不存在时创建
+QString dataDir(const QString &name);
+
+// 生成内容由 seed 决定的合成图片(渐变背景叠加随机色块)，用于模拟照片
+QImage syntheticImage(int seed, const QSize &size);
+// 合成图片叠加逐像素噪声后转换为 format ，模拟细节丰富的照片，缩放滤波的差异主要体现在高频部分
+QImage detailedImage(int seed, const QSize &size, QImage::Format format = QImage::Format_RGB32);
+// 生成 count 张图片，平均分布在 subDirCount 个子目录中，返回所有文件路径
+QStringList imageSet(const QString &name, int count, const QSize &size, int subDirCount = 1);
+// 生成指定大小的随机内容文件
+QString dataFile(const QString &name, qint64 size);
+
+// 将图片表中的合成数据调整为 count 行，供查询类测试使用
+void ensureImageRows(int count);
+
+}
+
+#endif // BENCHFIXTURES_H
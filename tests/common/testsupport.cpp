@@ -0,0 +1,71 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "testsupport.h"
+
+#include <QApplication>
+#include <QDir>
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace {
+// 屏蔽被测代码的调试输出，只保留警告及错误，避免影响计时及结果输出
+void testMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    Q_UNUSED(context);
+    if (type == QtDebugMsg || type == QtInfoMsg) {
+        return;
+    }
+    fprintf(stderr, "%s\n", qPrintable(msg));
+}
+}
+
+namespace TestSupport {
+
+bool ensureTemporaryHome(const char *homeEnv, const char *prefix, char *argv[])
+{
+    if (getenv(homeEnv)) {
+        return true;
+    }
+
+    QByteArray home = QDir::tempPath().toLocal8Bit() + "/" + prefix + "-XXXXXX";
+    if (!mkdtemp(home.data())) {
+        perror("mkdtemp");
+        return false;
+    }
+
+    setenv(homeEnv, home.constData(), 1);
+    setenv("HOME", home.constData(), 1);
+    unsetenv("XDG_DATA_HOME");
+    unsetenv("XDG_CACHE_HOME");
+    unsetenv("XDG_CONFIG_HOME");
+    execv("/proc/self/exe", argv);
+    perror("execv");
+    return false;
+}
+
+void prepareEnvironment()
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    qInstallMessageHandler(testMessageHandler);
+}
+
+void initApplication(QApplication &app)
+{
+    app.setOrganizationName("deepin");
+    app.setApplicationName("deepin-album");
+}
+
+void removeTemporaryHome(const char *homeEnv, const char *keepEnv)
+{
+    if (!getenv(keepEnv)) {
+        QDir(QString::fromLocal8Bit(getenv(homeEnv))).removeRecursively();
+    }
+}
+
+}
@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef TESTSUPPORT_H
+#define TESTSUPPORT_H
+
+class QApplication;
+
+/**
+ * @brief 单元测试与基准测试共用的运行环境准备。
+ *      数据库、缩略图缓存等路径在全局变量初始化时由 HOME 确定，
+ *      因此先创建临时 HOME 并重新执行自身，不会读写用户的相册数据。
+ */
+namespace TestSupport {
+
+// 环境变量 homeEnv 未设置时，创建 /tmp/<prefix>-XXXXXX 作为 HOME 并重新执行自身(成功时不返回)；
+// 已处于临时 HOME 中返回 true，创建或重新执行失败返回 false
+bool ensureTemporaryHome(const char *homeEnv, const char *prefix, char *argv[]);
+// 默认使用 offscreen 平台，并屏蔽被测代码的调试输出，须在创建 QApplication 前调用
+void prepareEnvironment();
+// 设置与应用程序相同的组织及程序名称，使配置及缓存路径一致
+void initApplication(QApplication &app);
+// 删除临时 HOME，设置了环境变量 keepEnv 时保留，便于检查测试数据
+void removeTemporaryHome(const char *homeEnv, const char *keepEnv);
+
+}
+
+#endif // TESTSUPPORT_H
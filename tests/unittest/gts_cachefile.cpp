@@ -0,0 +1,141 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "imageengine/imagedataservice.h"
+#include "unionimage/baseutils.h"
+#include "utils/cachefile.h"
+
+#include <gtest/gtest.h>
+
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+const QSize THUMBNAIL_SIZE(256, 341);
+// 故障注入中反复写入的目标文件数量
+const int TARGET_COUNT = 8;
+// 写入进程被杀死前的最长运行时间(微秒)及重复次数
+const int MAX_KILL_DELAY_US = 20000;
+const int KILL_ROUNDS = 50;
+// 模拟断电损坏的次数
+const int CORRUPT_ROUNDS = 200;
+
+// 带文件头的缩略图，内容由 seed 决定
+QByteArray thumbnailPayload(int seed)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    BenchFixtures::syntheticImage(seed, THUMBNAIL_SIZE).save(&buffer, "PNG");
+    return CacheFile::addHeader(data);
+}
+
+QVector<QByteArray> payloads()
+{
+    static const QVector<QByteArray> s_payloads = [] {
+        QVector<QByteArray> result;
+        for (int i = 0; i < TARGET_COUNT * 2; ++i) {
+            result << thumbnailPayload(i);
+        }
+        return result;
+    }();
+    return s_payloads;
+}
+
+void readThumbnail(const QString &path)
+{
+    ReadThumbnailManager manager;
+    manager.addLoadPath(path);
+    manager.readThumbnail();
+}
+}
+
+/**
+ * @brief 子进程不断原子写入一组缩略图，在随机时刻被 SIGKILL 杀死，之后目标文件必须完整可读或不存在
+ */
+TEST(tst_CacheFile, KillDuringWriteLeavesNoTornFile)
+{
+    const QString dir = BenchFixtures::dataDir("cachefile_kill");
+    const QVector<QByteArray> data = payloads();
+    QStringList targets;
+    for (int i = 0; i < TARGET_COUNT; ++i) {
+        targets << dir + QString("/%1.png").arg(i);
+    }
+
+    QRandomGenerator random(46);
+    for (int round = 0; round < KILL_ROUNDS; ++round) {
+        const pid_t pid = fork();
+        if (0 == pid) {
+            for (int pass = 0;; ++pass) {
+                for (int i = 0; i < TARGET_COUNT; ++i) {
+                    CacheFile::writeAtomic(targets.at(i), data.at((i + pass) % data.size()), CacheFile::NoSync);
+                }
+            }
+        }
+        ASSERT_GT(pid, 0) << "fork failed";
+        usleep(random.bounded(MAX_KILL_DELAY_US));
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+
+        for (const QString &target : targets) {
+            QImage image;
+            EXPECT_TRUE(!QFile::exists(target) || ImageDataService::loadThumbnailFile(target, image))
+                    << "torn file visible: " << target.toStdString();
+        }
+    }
+}
+
+/**
+ * @brief 模拟断电后文件系统中留下的不完整内容(截断、单字节损坏)，读取时必须校验失败
+ */
+TEST(tst_CacheFile, CorruptedFileIsDetected)
+{
+    const QString target = BenchFixtures::dataDir("cachefile_corrupt") + "/corrupt.png";
+    const QVector<QByteArray> data = payloads();
+
+    QRandomGenerator random(46);
+    for (int round = 0; round < CORRUPT_ROUNDS; ++round) {
+        QByteArray content = data.at(random.bounded(data.size()));
+        if (random.bounded(2)) {
+            content.truncate(random.bounded(content.size()));
+        } else {
+            const int index = random.bounded(content.size());
+            content[index] = static_cast<char>(content.at(index) ^ 0x5A);
+        }
+        QFile file(target);
+        ASSERT_TRUE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(content);
+        file.close();
+
+        QImage image;
+        EXPECT_FALSE(ImageDataService::loadThumbnailFile(target, image)) << "round " << round;
+    }
+}
+
+/**
+ * @brief 损坏的缩略图由 ReadThumbnailManager 透明地重新生成
+ */
+TEST(tst_CacheFile, CorruptedThumbnailIsRegenerated)
+{
+    const QStringList sources = BenchFixtures::imageSet("cachefile_source", 1, QSize(1600, 1200));
+    const int level = ImageDataService::instance()->thumbnailLevel();
+    const QString levelPath = ImageDataService::getLevelPath(Libutils::base::filePathToThumbnailPath(sources.first()), level);
+
+    readThumbnail(sources.first());
+    QImage image;
+    ASSERT_TRUE(ImageDataService::loadThumbnailFile(levelPath, image));
+
+    ASSERT_TRUE(QFile::resize(levelPath, QFileInfo(levelPath).size() / 2));
+    EXPECT_FALSE(ImageDataService::loadThumbnailFile(levelPath, image));
+
+    readThumbnail(sources.first());
+    EXPECT_TRUE(ImageDataService::loadThumbnailFile(levelPath, image));
+}
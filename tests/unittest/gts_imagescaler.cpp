@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "unionimage/imageutils.h"
+#include "utils/imagescaler.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace {
+const QSize PHOTO_SIZE(4000, 3000);
+// 与 Qt::SmoothTransformation 结果的最低 PSNR
+const double MIN_PSNR_DB = 35.0;
+
+double psnr(const QImage &left, const QImage &right)
+{
+    const QImage a = left.convertToFormat(QImage::Format_RGB32);
+    const QImage b = right.convertToFormat(QImage::Format_RGB32);
+    if (a.size() != b.size()) {
+        return 0;
+    }
+
+    double squareSum = 0;
+    for (int y = 0; y < a.height(); ++y) {
+        const QRgb *lineA = reinterpret_cast<const QRgb *>(a.constScanLine(y));
+        const QRgb *lineB = reinterpret_cast<const QRgb *>(b.constScanLine(y));
+        for (int x = 0; x < a.width(); ++x) {
+            const int dr = qRed(lineA[x]) - qRed(lineB[x]);
+            const int dg = qGreen(lineA[x]) - qGreen(lineB[x]);
+            const int db = qBlue(lineA[x]) - qBlue(lineB[x]);
+            squareSum += dr * dr + dg * dg + db * db;
+        }
+    }
+    const double mse = squareSum / (3.0 * a.width() * a.height());
+    return mse > 0 ? 10 * std::log10(255.0 * 255.0 / mse) : 99;
+}
+}
+
+class tst_ImageScaler : public testing::TestWithParam<QImage::Format>
+{
+public:
+    void SetUp() override
+    {
+        m_defaultKernel = ImageScaler::currentKernel();
+    }
+    void TearDown() override
+    {
+        ImageScaler::setKernel(m_defaultKernel);
+    }
+
+private:
+    QString m_defaultKernel;
+};
+
+/**
+ * @brief 所有可用的实现结果必须完全相同，且与原有输出(QImage::scaled 平滑缩放)的 PSNR 不低于 MIN_PSNR_DB
+ */
+TEST_P(tst_ImageScaler, KernelsMatchQtSmooth)
+{
+    const QImage photo = BenchFixtures::detailedImage(41, PHOTO_SIZE, GetParam());
+    const QSize sizes[] = {QSize(THUMBNAIL_MAX_SIZE, THUMBNAIL_MAX_SIZE), QSize(100, 100)};
+    const QStringList kernels = ImageScaler::kernels();
+    ASSERT_FALSE(kernels.isEmpty());
+
+    for (const QSize &size : sizes) {
+        const QImage golden = photo.scaled(size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        QImage first;
+        for (const QString &kernel : kernels) {
+            ImageScaler::setKernel(kernel);
+            const QImage result = ImageScaler::scaled(photo, size, Qt::KeepAspectRatioByExpanding);
+            if (first.isNull()) {
+                first = result;
+            } else {
+                EXPECT_TRUE(result == first) << "kernel " << kernel.toStdString() << " differs at " << size.width();
+            }
+        }
+        EXPECT_GE(psnr(golden, first), MIN_PSNR_DB) << "size " << size.width() << "x" << size.height();
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, tst_ImageScaler,
+                         testing::Values(QImage::Format_RGB32, QImage::Format_ARGB32_Premultiplied, QImage::Format_RGB888));
@@ -0,0 +1,30 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "testsupport.h"
+
+#include <gtest/gtest.h>
+
+#include <QApplication>
+
+namespace {
+const char *TEST_HOME_ENV = "DEEPIN_ALBUM_TEST_HOME";
+}
+
+int main(int argc, char *argv[])
+{
+    if (!TestSupport::ensureTemporaryHome(TEST_HOME_ENV, "deepin-album-test", argv)) {
+        return 1;
+    }
+    TestSupport::prepareEnvironment();
+
+    QApplication app(argc, argv);
+    TestSupport::initApplication(app);
+
+    testing::InitGoogleTest(&argc, argv);
+    const int result = RUN_ALL_TESTS();
+
+    TestSupport::removeTemporaryHome(TEST_HOME_ENV, "DEEPIN_ALBUM_TEST_KEEP");
+    return result;
+}
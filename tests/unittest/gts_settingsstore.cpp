@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "benchfixtures.h"
+#include "utils/settingsstore.h"
+
+#include <gtest/gtest.h>
+
+#include <QFile>
+#include <QRandomGenerator>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+// 子进程循环修改的配置项数量、每隔多少次修改写回一次，以及杀死前的最长等待时间
+const int CRASH_KEY_COUNT = 16;
+const int FLUSH_INTERVAL = 100;
+const int MAX_KILL_DELAY_US = 50 * 1000;
+const int KILL_ROUNDS = 50;
+// 并发读取时的读线程数及写入次数
+const int READER_COUNT = 4;
+const int CONCURRENT_WRITES = 2000;
+
+QString crashKey(int index)
+{
+    return QString("Crash/key%1").arg(index % CRASH_KEY_COUNT);
+}
+}
+
+TEST(tst_SettingsStore, ValueAfterSetAndReload)
+{
+    const QString path = BenchFixtures::dataDir("settings_unit") + "/reload.conf";
+    QFile::remove(path);
+    QFile::remove(path + ".journal");
+
+    {
+        SettingsStore store(path);
+        EXPECT_FALSE(store.contains("Thumbnail/DisplayMode"));
+        EXPECT_TRUE(store.setValue("Thumbnail/DisplayMode", 1));
+        EXPECT_FALSE(store.setValue("Thumbnail/DisplayMode", 1));
+        EXPECT_EQ(store.value("Thumbnail/DisplayMode").toInt(), 1);
+        EXPECT_TRUE(store.flush());
+        EXPECT_FALSE(store.isDirty());
+    }
+
+    SettingsStore store(path);
+    EXPECT_EQ(store.value("Thumbnail/DisplayMode").toInt(), 1);
+    EXPECT_EQ(store.value("Thumbnail/Missing", 7).toInt(), 7);
+}
+
+/**
+ * @brief 子进程不断修改配置项并定期写回，每次修改返回后通过管道确认，在随机时刻被 SIGKILL 杀死。
+ *      重新载入后每个配置项必须是最后一次确认的值(或正在进行的下一次修改的值)
+ */
+TEST(tst_SettingsStore, CrashLosesNoConfirmedChange)
+{
+    const QString path = BenchFixtures::dataDir("settings_unit") + "/crash.conf";
+    QRandomGenerator random(42);
+
+    for (int round = 0; round < KILL_ROUNDS; ++round) {
+        QFile::remove(path);
+        QFile::remove(path + ".journal");
+
+        int fds[2];
+        ASSERT_EQ(pipe(fds), 0);
+        const pid_t pid = fork();
+        if (0 == pid) {
+            ::close(fds[0]);
+            SettingsStore store(path);
+            for (qint32 i = 0;; ++i) {
+                store.setValue(crashKey(i), i);
+                if (FLUSH_INTERVAL - 1 == i % FLUSH_INTERVAL) {
+                    store.flush();
+                }
+                if (::write(fds[1], &i, sizeof(i)) != sizeof(i)) {
+                    _exit(1);
+                }
+            }
+        }
+        ::close(fds[1]);
+        if (pid < 0) {
+            ::close(fds[0]);
+            FAIL() << "fork failed";
+        }
+        usleep(random.bounded(MAX_KILL_DELAY_US));
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+
+        qint32 lastConfirmed = -1;
+        qint32 index = 0;
+        while (::read(fds[0], &index, sizeof(index)) == sizeof(index)) {
+            lastConfirmed = index;
+        }
+        ::close(fds[0]);
+
+        SettingsStore store(path);
+        const qint32 inFlight = lastConfirmed + 1;
+        for (int key = 0; key < CRASH_KEY_COUNT; ++key) {
+            const qint32 expected = lastConfirmed < key ? -1 : lastConfirmed - (lastConfirmed - key) % CRASH_KEY_COUNT;
+            const qint32 actual = store.contains(crashKey(key)) ? store.value(crashKey(key)).toInt() : -1;
+            EXPECT_TRUE(actual == expected || (inFlight % CRASH_KEY_COUNT == key && actual == inFlight))
+                    << "round " << round << " key " << key << " expected " << expected << " actual " << actual;
+        }
+    }
+}
+
+/**
+ * @brief 多个线程不加锁读取的同时不断写入，每个读线程看到的值只增不减，写入结束后都能读到最终值
+ */
+TEST(tst_SettingsStore, ConcurrentReadersSeeMonotonicValues)
+{
+    const QString path = BenchFixtures::dataDir("settings_unit") + "/concurrent.conf";
+    QFile::remove(path);
+    QFile::remove(path + ".journal");
+
+    SettingsStore store(path);
+    store.setValue("Concurrent/counter", 0);
+    std::atomic_bool writing{true};
+    std::atomic_int violations{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < READER_COUNT; ++i) {
+        readers.emplace_back([&store, &writing, &violations]() {
+            int last = 0;
+            while (writing) {
+                const int current = store.value("Concurrent/counter").toInt();
+                if (current < last) {
+                    violations++;
+                }
+                last = current;
+            }
+            if (store.value("Concurrent/counter").toInt() != CONCURRENT_WRITES) {
+                violations++;
+            }
+        });
+    }
+
+    for (int i = 1; i <= CONCURRENT_WRITES; ++i) {
+        store.setValue("Concurrent/counter", i);
+    }
+    writing = false;
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(violations.load(), 0);
+}
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2024 UnionTech Software Technology Co., Ltd.
+//
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "utils/workscheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <QVector>
+
+#include <atomic>
+
+namespace {
+const int ITEM_COUNT = 1000;
+}
+
+TEST(tst_WorkScheduler, ParallelForRunsEveryItemOnce)
+{
+    QVector<int> hits(ITEM_COUNT, 0);
+    WorkScheduler::instance()->parallelFor(WorkScheduler::Background, ITEM_COUNT, [&hits](int i) {
+        hits[i]++;
+    });
+
+    for (int i = 0; i < ITEM_COUNT; ++i) {
+        EXPECT_EQ(hits.at(i), 1) << "item " << i;
+    }
+}
+
+/**
+ * @brief 在占满该类并发上限的调度器任务中调用，辅助任务无法启动，由调用线程执行全部项，不能死锁
+ */
+TEST(tst_WorkScheduler, ParallelForInsideSaturatedClass)
+{
+    WorkScheduler *scheduler = WorkScheduler::instance();
+    const int limit = scheduler->concurrencyLimit(WorkScheduler::BulkIO);
+    std::atomic_int finished{0};
+    for (int task = 0; task < limit; ++task) {
+        scheduler->submit(WorkScheduler::BulkIO, [scheduler, &finished]() {
+            std::atomic_int count{0};
+            scheduler->parallelFor(WorkScheduler::BulkIO, ITEM_COUNT, [&count](int) {
+                count++;
+            });
+            if (ITEM_COUNT == count) {
+                finished++;
+            }
+        });
+    }
+
+    ASSERT_TRUE(scheduler->waitForDone(10000));
+    EXPECT_EQ(finished.load(), limit);
+}
+
+TEST(tst_WorkScheduler, ParallelForSkipsItemsAfterCancel)
+{
+    WorkCancelToken token;
+    std::atomic_int count{0};
+    WorkScheduler::instance()->parallelFor(WorkScheduler::Background, ITEM_COUNT, [&count, &token](int) {
+        if (++count == 10) {
+            token.cancel();
+        }
+    }, 1, token);
+
+    EXPECT_EQ(count.load(), 10);
+}